@@ -19,8 +19,10 @@ using namespace sk;
 #include "demo_desktop.h"
 #include "demo_bvh.h"
 #include "demo_aliasing.h"
+#include "tests.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include <string>
 #include <list>
@@ -149,10 +151,19 @@ void log_window() {
 }
 
 #ifndef WINDOWS_UWP
-int main() {
+int main(int argc, char **argv) {
 #else
 int __stdcall wWinMain(void*, void*, wchar_t*, int) {
+	int    argc = 0;
+	char **argv = nullptr;
 #endif
+	bool test_mode = false;
+	bool headless  = false;
+	for (int i = 1; i < argc; i++) {
+		if      (strcmp(argv[i], "-test"    ) == 0) test_mode = true;
+		else if (strcmp(argv[i], "-headless") == 0) headless  = true;
+	}
+
 	log_subscribe(on_log);
 	log_set_filter(log_diagnostic);
 
@@ -160,9 +171,19 @@ int __stdcall wWinMain(void*, void*, wchar_t*, int) {
 	settings.app_name      = "StereoKit C";
 	settings.assets_folder = "Assets";
 	settings.mode          = app_mode_xr;
+	if (test_mode) {
+		settings.mode                    = headless ? app_mode_offscreen : app_mode_simulator;
+		settings.disable_unfocused_sleep = true;
+	}
 	if (!sk_init(settings))
 		return 1;
 
+	if (test_mode) {
+		bool passed = tests_run();
+		sk_shutdown();
+		return passed ? 0 : -1;
+	}
+
 	common_init();
 
 	scene_set_active(demos[8]);
@@ -0,0 +1,911 @@
+#include "tests.h"
+
+#include <stereokit.h>
+#include <stereokit_ui.h>
+using namespace sk;
+
+#include "../../StereoKitC/utils/meshopt_decode.h"
+#include "../../StereoKitC/utils/skpack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <thread>
+
+///////////////////////////////////////////
+
+struct test_t {
+	const char *name;
+	bool      (*run)();
+};
+
+///////////////////////////////////////////
+
+static bool near_eq(float a, float b, float tolerance = 0.001f) {
+	return fabsf(a - b) <= tolerance;
+}
+
+///////////////////////////////////////////
+
+static void test_asset_path(char *out_path, size_t out_size, const char *file) {
+	snprintf(out_path, out_size, "%s/%s", sk_get_settings().assets_folder, file);
+}
+
+///////////////////////////////////////////
+
+static bool test_read_file(const char *path, void **out_data, size_t *out_size) {
+	*out_data = nullptr;
+	*out_size = 0;
+	FILE *fp = fopen(path, "rb");
+	if (fp == nullptr) return false;
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	*out_data = malloc(size > 0 ? size : 1);
+	*out_size = fread(*out_data, 1, size, fp);
+	fclose(fp);
+	return *out_size == (size_t)size;
+}
+
+///////////////////////////////////////////
+
+static bool test_file_exists(const char *path) {
+	FILE *fp = fopen(path, "rb");
+	if (fp != nullptr) fclose(fp);
+	return fp != nullptr;
+}
+
+///////////////////////////////////////////
+// Mesh proximity                        //
+///////////////////////////////////////////
+
+static bool test_mesh_proximity() {
+	mesh_t cube = mesh_gen_cube(vec3_one);
+	ray_t  at   = {};
+
+	bool result =
+		 mesh_closest_point   (cube, vec3{ 2,0,0 }, 5, &at) && near_eq(at.pos.x, 0.5f) && near_eq(at.pos.y, 0) && near_eq(at.pos.z, 0) &&
+		!mesh_closest_point   (cube, vec3{ 2,0,0 }, 1, &at) &&
+		 mesh_sphere_intersect(cube, sphere_t{ vec3{0.7f,0,0}, 0.3f }, &at) &&
+		!mesh_sphere_intersect(cube, sphere_t{ vec3{0.7f,0,0}, 0.1f }, &at) &&
+		 mesh_capsule_intersect(cube, vec3{ 0.7f,-2,0 }, vec3{ 0.7f,2,0 }, 0.25f, &at) &&
+		!mesh_capsule_intersect(cube, vec3{ 0.7f,-2,0 }, vec3{ 0.7f,2,0 }, 0.1f,  &at);
+
+	mesh_release(cube);
+	return result;
+}
+
+///////////////////////////////////////////
+// Skinning                              //
+///////////////////////////////////////////
+
+static bool test_skin_bounds() {
+	// Enough vertices that skinning splits the work into several batches,
+	// the bounds need to cover all of them, and nothing else.
+	const int32_t count = 4800;
+	vert_t   *verts   = (vert_t   *)malloc(sizeof(vert_t  ) * count);
+	vind_t   *inds    = (vind_t   *)malloc(sizeof(vind_t  ) * count);
+	uint16_t *bones   = (uint16_t *)malloc(sizeof(uint16_t) * count * 4);
+	vec4     *weights = (vec4     *)malloc(sizeof(vec4    ) * count);
+	for (int32_t i = 0; i < count; i++) {
+		float x = (i < count / 2 ? 1.0f : 3.0f) + (i % 2);
+		verts  [i] = vert_t{ vec3{x, i * 0.001f, 0}, vec3_forward, vec2{0,0}, color32{255,255,255,255} };
+		inds   [i] = (vind_t)i;
+		weights[i] = vec4{ 1,0,0,0 };
+		bones[i*4+0] = bones[i*4+1] = bones[i*4+2] = bones[i*4+3] = 0;
+	}
+
+	mesh_t mesh = mesh_create();
+	mesh_set_data(mesh, verts, count, inds, count);
+	matrix rest = matrix_identity;
+	mesh_set_skin(mesh, bones, count, weights, count, &rest, 1);
+
+	matrix   pose   = matrix_t(vec3{ 10,0,0 });
+	mesh_update_skin(mesh, &pose, 1);
+	bounds_t bounds = mesh_get_bounds(mesh);
+
+	bool result =
+		near_eq(bounds.center    .x, 12.5f) && near_eq(bounds.dimensions.x, 3) &&
+		near_eq(bounds.center    .y, (count - 1) * 0.0005f) &&
+		near_eq(bounds.dimensions.y, (count - 1) * 0.001f);
+
+	mesh_release(mesh);
+	free(verts);
+	free(inds);
+	free(bones);
+	free(weights);
+	return result;
+}
+
+///////////////////////////////////////////
+// Mesh optimization                     //
+///////////////////////////////////////////
+
+struct test_tri_t {
+	vec3 pos[3];
+};
+
+static int test_vec3_cmp(const vec3 &a, const vec3 &b) {
+	if (a.x != b.x) return a.x < b.x ? -1 : 1;
+	if (a.y != b.y) return a.y < b.y ? -1 : 1;
+	if (a.z != b.z) return a.z < b.z ? -1 : 1;
+	return 0;
+}
+
+static int test_tri_cmp(const void *a, const void *b) {
+	const test_tri_t *tri_a = (const test_tri_t *)a;
+	const test_tri_t *tri_b = (const test_tri_t *)b;
+	for (int32_t i = 0; i < 3; i++) {
+		int cmp = test_vec3_cmp(tri_a->pos[i], tri_b->pos[i]);
+		if (cmp != 0) return cmp;
+	}
+	return 0;
+}
+
+// Reads the mesh's triangles back as a sorted list. Each triangle starts at
+// its smallest corner, which keeps its winding, but not where it started.
+static test_tri_t *test_mesh_tris(mesh_t mesh, int32_t *out_count) {
+	int32_t     count = mesh_get_ind_count(mesh) / 3;
+	test_tri_t *tris  = (test_tri_t *)malloc(sizeof(test_tri_t) * count);
+	for (int32_t t = 0; t < count; t++) {
+		vert_t v[3];
+		mesh_get_triangle(mesh, t, &v[0], &v[1], &v[2]);
+		int32_t first = 0;
+		for (int32_t i = 1; i < 3; i++) {
+			if (test_vec3_cmp(v[i].pos, v[first].pos) < 0) first = i;
+		}
+		for (int32_t i = 0; i < 3; i++) tris[t].pos[i] = v[(first + i) % 3].pos;
+	}
+	qsort(tris, count, sizeof(test_tri_t), test_tri_cmp);
+	*out_count = count;
+	return tris;
+}
+
+static bool test_mesh_optimize() {
+	// A grid with shuffled triangles, and one vertex that nothing uses, so
+	// each of the optimizations has something to do.
+	const int32_t side       = 16;
+	const int32_t vert_count = side * side + 1;
+	const int32_t ind_count  = (side - 1) * (side - 1) * 6;
+	vert_t *verts = (vert_t *)malloc(sizeof(vert_t) * vert_count);
+	vind_t *inds  = (vind_t *)malloc(sizeof(vind_t) * ind_count);
+	for (int32_t i = 0; i < vert_count; i++)
+		verts[i] = vert_t{ vec3{ (float)(i % side), (float)(i / side), (float)(i % 3) }, vec3_forward, vec2{0,0}, color32{255,255,255,255} };
+
+	int32_t at = 0;
+	for (int32_t y = 0; y < side - 1; y++) {
+		for (int32_t x = 0; x < side - 1; x++) {
+			vind_t i = (vind_t)(x + y * side);
+			vind_t quad[6] = { i, (vind_t)(i+1), (vind_t)(i+side), (vind_t)(i+1), (vind_t)(i+side+1), (vind_t)(i+side) };
+			memcpy(&inds[at], quad, sizeof(quad));
+			at += 6;
+		}
+	}
+	uint32_t seed = 1;
+	for (int32_t t = ind_count / 3 - 1; t > 0; t--) {
+		seed = seed * 1664525u + 1013904223u;
+		int32_t swap = (int32_t)((seed >> 8) % (uint32_t)(t + 1));
+		for (int32_t c = 0; c < 3; c++) {
+			vind_t tmp = inds[t*3 + c];
+			inds[t   *3 + c] = inds[swap*3 + c];
+			inds[swap*3 + c] = tmp;
+		}
+	}
+
+	mesh_t mesh = mesh_create();
+	mesh_set_data(mesh, verts, vert_count, inds, ind_count);
+	int32_t     before_count = 0;
+	test_tri_t *before       = test_mesh_tris(mesh, &before_count);
+
+	mesh_optimize(mesh, mesh_optimize_all);
+	assets_block_for_priority(INT_MAX);
+	int32_t     after_count = 0;
+	test_tri_t *after       = test_mesh_tris(mesh, &after_count);
+
+	// Same triangles facing the same way, minus the unused vertex
+	bool result =
+		before_count == after_count &&
+		memcmp(before, after, sizeof(test_tri_t) * before_count) == 0 &&
+		mesh_get_vert_count(mesh) == vert_count - 1;
+
+	mesh_release(mesh);
+	free(before);
+	free(after);
+	free(verts);
+	free(inds);
+	return result;
+}
+
+///////////////////////////////////////////
+// OBJ parsing                           //
+///////////////////////////////////////////
+
+static bool test_obj_relative() {
+	// Negative indices count back from the most recent vertex, so both faces
+	// here should land on their own set of three.
+	const char obj[] =
+		"v 0 0 0\n"
+		"v 1 0 0\n"
+		"v 0 1 0\n"
+		"f -3 -2 -1\n"
+		"v 0 0 2\n"
+		"v 1 0 2\n"
+		"v 1e-30 1 2\n"
+		"f -3 -2 -1\n";
+	model_t model = model_create_mem("sktest_relative.obj", (void*)obj, sizeof(obj) - 1);
+	if (model == nullptr) return false;
+	mesh_t mesh = model_get_mesh(model, 0);
+
+	// The loader may reorder triangles, so just check we get one of each
+	bool found_near = false;
+	bool found_far  = false;
+	bool exp_ok     = false;
+	for (uint32_t t = 0; t < 2; t++) {
+		vert_t a, b, c;
+		if (!mesh_get_triangle(mesh, t, &a, &b, &c)) break;
+		if (a.pos.z != b.pos.z || a.pos.z != c.pos.z) break;
+		if (a.pos.z == 0) found_near = true;
+		if (a.pos.z == 2) {
+			found_far = true;
+			const vert_t *verts[3] = { &a, &b, &c };
+			for (int32_t v = 0; v < 3; v++) {
+				if (verts[v]->pos.y == 1)
+					exp_ok = isfinite(verts[v]->pos.x) && verts[v]->pos.x >= 0 && verts[v]->pos.x < 1e-20f;
+			}
+		}
+	}
+
+	bool result = mesh_get_ind_count(mesh) == 6 && found_near && found_far && exp_ok;
+	mesh_release(mesh);
+	model_release(model);
+	return result;
+}
+
+///////////////////////////////////////////
+// Meshopt decoding                      //
+///////////////////////////////////////////
+
+// Just enough of meshoptimizer's encoders to round-trip data through the
+// decoders. Vertex byte groups take turns with the 0, 2, 4 and 8 bit modes,
+// so every mode gets used no matter what the data looks like.
+
+static uint8_t  test_zigzag8 (uint8_t  delta) { return (uint8_t)((delta << 1) ^ (uint8_t)((int8_t)delta >> 7)); }
+static uint32_t test_zigzag32(uint32_t delta) { return (delta << 1) ^ (uint32_t)((int32_t)delta >> 31); }
+
+static size_t test_meshopt_vbyte(uint8_t *out, uint32_t value) {
+	size_t size = 0;
+	for (; value >= 128; value >>= 7) out[size++] = (uint8_t)(value | 128);
+	out[size++] = (uint8_t)value;
+	return size;
+}
+
+static size_t test_meshopt_group(uint8_t *out, const uint8_t *values, int32_t bits) {
+	const int32_t per_byte = 8 / bits;
+	const uint8_t limit    = (uint8_t)((1 << bits) - 1);
+	uint8_t      *var      = out + 16 / per_byte;
+	memset(out, 0, 16 / per_byte);
+	for (int32_t i = 0; i < 16; i++) {
+		uint8_t enc = values[i] < limit ? values[i] : limit;
+		out[i / per_byte] |= (uint8_t)(enc << (8 - bits - (i % per_byte) * bits));
+		if (enc == limit) *var++ = values[i];
+	}
+	return (size_t)(var - out);
+}
+
+static size_t test_meshopt_encode_vertices(uint8_t *out, const uint8_t *verts, size_t count, size_t stride) {
+	uint8_t *at = out;
+	*at++ = 0xA0;
+
+	size_t block_size = (8192 / stride) & ~(size_t)15;
+	if (block_size > 256) block_size = 256;
+	for (size_t offset = 0; offset < count; offset += block_size) {
+		size_t block_count = count - offset < block_size ? count - offset : block_size;
+		size_t groups      = (block_count + 15) / 16;
+		for (size_t k = 0; k < stride; k++) {
+			uint8_t *header = at;
+			memset(header, 0, (groups + 3) / 4);
+			at += (groups + 3) / 4;
+
+			for (size_t g = 0; g < groups; g++) {
+				uint8_t values[16] = {};
+				bool    zero       = true;
+				for (size_t i = 0; i < 16 && g * 16 + i < block_count; i++) {
+					// The first vertex is its own base, it's stored in the tail
+					size_t  v    = offset + g * 16 + i;
+					uint8_t base = verts[(v == 0 ? 0 : v - 1) * stride + k];
+					values[i] = test_zigzag8((uint8_t)(verts[v * stride + k] - base));
+					zero      = zero && values[i] == 0;
+				}
+				int32_t mode = (int32_t)(g % 4);
+				if (mode == 0 && !zero) mode = 3;
+				header[g / 4] |= (uint8_t)(mode << ((g % 4) * 2));
+				if      (mode == 1) at += test_meshopt_group(at, values, 2);
+				else if (mode == 2) at += test_meshopt_group(at, values, 4);
+				else if (mode == 3) { memcpy(at, values, 16); at += 16; }
+			}
+		}
+	}
+
+	size_t tail = stride < 32 ? 32 : stride;
+	memset(at, 0, tail - stride);
+	memcpy(at + tail - stride, verts, stride);
+	return (size_t)(at + tail - out);
+}
+
+// Every triangle is coded as three explicit indices, the least compact
+// option, but one the decoder has to handle all the same.
+static size_t test_meshopt_encode_triangles(uint8_t *out, const uint32_t *inds, size_t count) {
+	uint8_t *code = out;
+	uint8_t *data = out + 1 + count / 3;
+	uint32_t last = 0;
+	*code++ = 0xE1;
+	for (size_t i = 0; i < count; i += 3) {
+		*code++ = 0xFF;
+		*data++ = 0xFF;
+		for (size_t c = 0; c < 3; c++) {
+			data += test_meshopt_vbyte(data, test_zigzag32(inds[i + c] - last));
+			last  = inds[i + c];
+		}
+	}
+	memset(data, 0, 16);
+	return (size_t)(data + 16 - out);
+}
+
+static size_t test_meshopt_encode_indices(uint8_t *out, const uint32_t *inds, size_t count) {
+	uint8_t *at      = out;
+	uint32_t last[2] = {};
+	*at++ = 0xD1;
+	for (size_t i = 0; i < count; i++) {
+		// Alternating baselines, so both of them get used
+		uint32_t current = (uint32_t)(i % 2);
+		at += test_meshopt_vbyte(at, (test_zigzag32(inds[i] - last[current]) << 1) | current);
+		last[current] = inds[i];
+	}
+	memset(at, 0, 4);
+	return (size_t)(at + 4 - out);
+}
+
+static bool test_inds16_eq(const uint32_t *a, const uint16_t *b, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		if (a[i] != b[i]) return false;
+	}
+	return true;
+}
+
+static bool test_meshopt_codecs() {
+	struct test_vert_t {
+		float   pos[3];
+		uint8_t color[4];
+	};
+	// More than a single 256 vertex block
+	const size_t vert_count = 300;
+	test_vert_t *verts      = (test_vert_t *)malloc(sizeof(test_vert_t) * vert_count);
+	test_vert_t *out_verts  = (test_vert_t *)malloc(sizeof(test_vert_t) * vert_count);
+	uint8_t     *encoded    = (uint8_t     *)malloc(sizeof(test_vert_t) * vert_count * 2 + 1024);
+	for (size_t i = 0; i < vert_count; i++) {
+		verts[i] = test_vert_t{ { i * 0.01f, sinf(i * 0.1f), (float)(i % 7) }, { (uint8_t)i, (uint8_t)(i * 3), 0, 255 } };
+	}
+
+	// Truncated streams have to fail, rather than read past their end
+	size_t size   = test_meshopt_encode_vertices(encoded, (const uint8_t *)verts, vert_count, sizeof(test_vert_t));
+	bool   result =
+		 meshopt_decode_vertices(out_verts, vert_count, sizeof(test_vert_t), encoded, size) &&
+		 memcmp(verts, out_verts, sizeof(test_vert_t) * vert_count) == 0 &&
+		!meshopt_decode_vertices(out_verts, vert_count, sizeof(test_vert_t), encoded, size - 1);
+
+	const size_t ind_count = 60;
+	uint32_t     inds  [ind_count];
+	uint32_t     out_32[ind_count];
+	uint16_t     out_16[ind_count];
+	for (size_t i = 0; i < ind_count; i++) inds[i] = (uint32_t)((i * 7919) % 60000);
+
+	size   = test_meshopt_encode_triangles(encoded, inds, ind_count);
+	result = result &&
+		 meshopt_decode_triangles(out_32, ind_count, 4, encoded, size) && memcmp(inds, out_32, sizeof(out_32)) == 0 &&
+		 meshopt_decode_triangles(out_16, ind_count, 2, encoded, size) && test_inds16_eq(inds, out_16, ind_count) &&
+		!meshopt_decode_triangles(out_32, ind_count, 4, encoded, size - 1);
+
+	size   = test_meshopt_encode_indices(encoded, inds, ind_count);
+	result = result &&
+		 meshopt_decode_indices(out_32, ind_count, 4, encoded, size) && memcmp(inds, out_32, sizeof(out_32)) == 0 &&
+		 meshopt_decode_indices(out_16, ind_count, 2, encoded, size) && test_inds16_eq(inds, out_16, ind_count) &&
+		!meshopt_decode_indices(out_32, ind_count, 4, encoded, size - 1);
+
+	free(verts);
+	free(out_verts);
+	free(encoded);
+	return result;
+}
+
+static bool test_meshopt_filters() {
+	// Octahedral normals: +z, +x, -z from the folded corner, and a 45 degree
+	// tilt between +x and +z.
+	int8_t normals[4][4] = { {0,0,127,0}, {127,0,127,0}, {127,127,127,0}, {64,0,127,0} };
+	meshopt_filter_octahedral(normals, 4, 4);
+	bool result =
+		normals[0][0] == 0   && normals[0][1] == 0 && normals[0][2] == 127 &&
+		normals[1][0] == 127 && normals[1][1] == 0 && normals[1][2] == 0   &&
+		normals[2][0] == 0   && normals[2][1] == 0 && normals[2][2] == -127 &&
+		abs(normals[3][0] - 90) <= 1 && normals[3][1] == 0 && abs(normals[3][2] - 90) <= 1;
+
+	// Quaternions with 12 bit components: identity, where w was dropped, and
+	// 90 degrees around x, where x was dropped.
+	int16_t quats[2][4] = { {0,0,0,2047}, {0,0,2047,2044} };
+	meshopt_filter_quaternion(quats, 2, 8);
+	result = result &&
+		quats[0][0] == 0     && quats[0][1] == 0 && quats[0][2] == 0 && quats[0][3] == 32767 &&
+		abs(quats[1][0] - 23170) <= 1 && quats[1][1] == 0 && quats[1][2] == 0 && abs(quats[1][3] - 23170) <= 1;
+
+	// Exponential floats, a signed 24 bit mantissa under an 8 bit exponent
+	const int32_t mantissa[3] = { 6, -5, 0 };
+	const int32_t exponent[3] = { -2, 3, 0 };
+	const float   expected[3] = { 1.5f, -40, 0 };
+	uint32_t      values  [3];
+	for (int32_t i = 0; i < 3; i++) values[i] = ((uint32_t)exponent[i] << 24) | ((uint32_t)mantissa[i] & 0xFFFFFF);
+	meshopt_filter_exponential(values, 3, 4);
+	for (int32_t i = 0; i < 3; i++) {
+		float value;
+		memcpy(&value, &values[i], sizeof(value));
+		result = result && value == expected[i];
+	}
+	return result;
+}
+
+///////////////////////////////////////////
+// Model cache                           //
+///////////////////////////////////////////
+
+static bool test_cache_hit = false;
+
+static void test_cache_on_log(log_, const char *text) {
+	if (strstr(text, "sktest_cache.obj") && strstr(text, "Loaded from model cache"))
+		test_cache_hit = true;
+}
+
+static bool test_cache_load(const char *file, float expected_z, bool expect_hit) {
+	test_cache_hit = false;
+	model_t model = model_create_file(file);
+	if (model == nullptr) return false;
+
+	mesh_t mesh = model_get_mesh(model, 0);
+	vert_t a, b, c;
+	bool   result = mesh_get_triangle(mesh, 0, &a, &b, &c) && a.pos.z == expected_z && test_cache_hit == expect_hit;
+	mesh_release(mesh);
+	model_release(model);
+	return result;
+}
+
+static bool test_model_cache() {
+	const char *file = "sktest_cache.obj";
+	char source_path[512], cache_path[512];
+	test_asset_path(source_path, sizeof(source_path), file);
+	snprintf(cache_path, sizeof(cache_path), "%s.skcache", source_path);
+	remove(cache_path);
+
+	// Both versions are the same size, so only the content hash can tell
+	// them apart.
+	const char obj_a[] = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+	const char obj_b[] = "v 0 0 3\nv 1 0 3\nv 0 1 3\nf 1 2 3\n";
+
+	bool32_t was_enabled = model_get_load_cache();
+	model_set_load_cache(true);
+	log_subscribe(test_cache_on_log);
+
+	bool result = platform_write_file(source_path, (void*)obj_a, sizeof(obj_a) - 1);
+	// First load parses the source and writes the cache
+	result = result && test_cache_load(file, 0, false) && test_file_exists(cache_path);
+	// Second load comes straight from the cache
+	result = result && test_cache_load(file, 0, true);
+	// A changed source makes the cache stale
+	result = result && platform_write_file(source_path, (void*)obj_b, sizeof(obj_b) - 1);
+	result = result && test_cache_load(file, 3, false);
+	result = result && test_cache_load(file, 3, true);
+
+	// A truncated cache is a miss, not a crash
+	void  *cache_data = nullptr;
+	size_t cache_size = 0;
+	result = result && test_read_file(cache_path, &cache_data, &cache_size);
+	result = result && platform_write_file(cache_path, cache_data, cache_size / 2);
+	result = result && test_cache_load(file, 3, false);
+	free(cache_data);
+
+	log_unsubscribe(test_cache_on_log);
+	model_set_load_cache(was_enabled);
+	remove(cache_path);
+	remove(source_path);
+	return result;
+}
+
+///////////////////////////////////////////
+// Asset packs                           //
+///////////////////////////////////////////
+
+static bool test_lz4() {
+	// Compressible, with enough noise that it isn't one long match
+	const size_t size   = 4000;
+	uint8_t     *src    = (uint8_t *)malloc(size);
+	uint8_t     *dst    = (uint8_t *)malloc(size + 1);
+	size_t       bound  = skpack_lz4_bound(size);
+	uint8_t     *packed = (uint8_t *)malloc(bound);
+	for (size_t i = 0; i < size; i++) src[i] = (uint8_t)(i % 64 < 48 ? i % 7 : (i * 2654435761u) >> 24);
+	size_t packed_size = skpack_lz4_compress(src, size, packed, bound);
+
+	// Truncated input, or the wrong output size, fails instead of reading
+	// or writing past the end.
+	bool result = packed_size > 0 && packed_size < size &&
+		 skpack_lz4_decompress(packed, packed_size,     dst, size) && memcmp(src, dst, size) == 0 &&
+		!skpack_lz4_decompress(packed, packed_size - 1, dst, size) &&
+		!skpack_lz4_decompress(packed, packed_size / 2, dst, size) &&
+		!skpack_lz4_decompress(packed, packed_size, dst, size - 1) &&
+		!skpack_lz4_decompress(packed, packed_size, dst, size + 1);
+
+	// Damage each byte in turn, these can go either way, they just can't
+	// crash.
+	for (size_t i = 0; i < packed_size; i++) {
+		packed[i] ^= 0xFF;
+		skpack_lz4_decompress(packed, packed_size, dst, size);
+		packed[i] ^= 0xFF;
+	}
+
+	free(src);
+	free(dst);
+	free(packed);
+	return result;
+}
+
+///////////////////////////////////////////
+
+// Lays out a pack like the skpack tool does, with the same text stored
+// once LZ4 compressed, and once as-is.
+static const char *test_pack_names[2] = { "sktest_pack/lz4.txt", "sktest_pack/raw.txt" };
+
+static size_t test_pack_build(uint8_t *pack, size_t capacity, const uint8_t *text, size_t text_size) {
+	memset(pack, 0, capacity);
+	skpack_entry_t entries[2] = {};
+	size_t         at         = sizeof(skpack_header_t);
+	for (int32_t i = 0; i < 2; i++) {
+		at = (at + 15) & ~(size_t)15;
+		entries[i].path_hash   = skpack_hash_path(test_pack_names[i], nullptr);
+		entries[i].offset      = at;
+		entries[i].size        = text_size;
+		entries[i].name_offset = i == 0 ? 0 : (uint32_t)strlen(test_pack_names[0]) + 1;
+		if (i == 0) {
+			entries[i].compression = skpack_compression_lz4;
+			entries[i].stored_size = skpack_lz4_compress(text, text_size, pack + at, capacity - at);
+		} else {
+			entries[i].compression = skpack_compression_none;
+			entries[i].stored_size = text_size;
+			memcpy(pack + at, text, text_size);
+			at += 1;
+		}
+		at += entries[i].stored_size;
+	}
+	if (entries[0].path_hash > entries[1].path_hash) {
+		skpack_entry_t tmp = entries[0];
+		entries[0] = entries[1];
+		entries[1] = tmp;
+	}
+
+	skpack_header_t header = {};
+	memcpy(header.magic, "SKPK", 4);
+	header.version     = SKPACK_VERSION;
+	header.entry_count = 2;
+	header.alignment   = 16;
+	header.toc_offset  = (at + 7) & ~(size_t)7;
+	memcpy(pack + header.toc_offset, entries, sizeof(entries));
+	header.names_offset = header.toc_offset + sizeof(entries);
+	header.names_size   = strlen(test_pack_names[0]) + strlen(test_pack_names[1]) + 2;
+	memcpy(pack + header.names_offset,                               test_pack_names[0], strlen(test_pack_names[0]));
+	memcpy(pack + header.names_offset + strlen(test_pack_names[0]) + 1, test_pack_names[1], strlen(test_pack_names[1]));
+	memcpy(pack, &header, sizeof(header));
+	return header.names_offset + header.names_size;
+}
+
+static bool test_pack_mount(const char *path, uint8_t *pack, size_t size) {
+	if (!platform_write_file(path, pack, size) || !assets_mount_pack("sktest.skpack")) return false;
+	assets_unmount_pack("sktest.skpack");
+	return true;
+}
+
+static bool test_pack_read(const char *name, const uint8_t *expected, size_t expected_size) {
+	void  *data   = nullptr;
+	size_t size   = 0;
+	bool   result = platform_read_file(name, &data, &size) && size == expected_size && memcmp(data, expected, size) == 0;
+	free(data);
+	return result;
+}
+
+static bool test_asset_pack() {
+	uint8_t text[1000];
+	for (size_t i = 0; i < sizeof(text); i++) text[i] = (uint8_t)"StereoKit packs assets. "[i % 24];
+
+	char path[512];
+	test_asset_path(path, sizeof(path), "sktest.skpack");
+	const size_t capacity = 4096;
+	uint8_t     *pack     = (uint8_t *)malloc(capacity);
+	size_t       size     = test_pack_build(pack, capacity, text, sizeof(text));
+
+	skpack_header_t *header  = (skpack_header_t *)pack;
+	skpack_entry_t  *entries = (skpack_entry_t  *)(pack + header->toc_offset);
+	skpack_entry_t  *lz4     = entries[0].compression == skpack_compression_lz4 ? &entries[0] : &entries[1];
+
+	// Both kinds of entry read back intact from a good pack
+	bool result = platform_write_file(path, pack, size) && assets_mount_pack("sktest.skpack");
+	result = result &&
+		test_pack_read(test_pack_names[0], text, sizeof(text)) &&
+		test_pack_read(test_pack_names[1], text, sizeof(text));
+	assets_unmount_pack("sktest.skpack");
+
+	// Damaged LZ4 data still mounts, but only that entry fails to read. A
+	// first sequence with no literals can't have anything to match against.
+	uint8_t token = pack[lz4->offset];
+	pack[lz4->offset] = 0x0F;
+	result = result && platform_write_file(path, pack, size) && assets_mount_pack("sktest.skpack");
+	result = result &&
+		!test_pack_read(test_pack_names[0], text, sizeof(text)) &&
+		 test_pack_read(test_pack_names[1], text, sizeof(text));
+	assets_unmount_pack("sktest.skpack");
+	pack[lz4->offset] = token;
+
+	// A pack with a damaged header or table of contents won't mount at all
+	result = result && test_pack_mount(path, pack, size) && !test_pack_mount(path, pack, size / 2);
+
+	uint64_t lz4_size = lz4->size;
+	lz4->size = lz4->stored_size * 1000;
+	result = result && !test_pack_mount(path, pack, size);
+	lz4->size = lz4_size;
+
+	uint64_t lz4_offset = lz4->offset;
+	lz4->offset = size;
+	result = result && !test_pack_mount(path, pack, size);
+	lz4->offset = lz4_offset;
+
+	header->magic[0] = 'X';
+	result = result && !test_pack_mount(path, pack, size);
+
+	remove(path);
+	free(pack);
+	return result;
+}
+
+///////////////////////////////////////////
+// Compressed textures                   //
+///////////////////////////////////////////
+
+static void test_put_u32(uint8_t *data, size_t at, uint32_t value) { memcpy(data + at, &value, sizeof(value)); }
+static void test_put_u64(uint8_t *data, size_t at, uint64_t value) { memcpy(data + at, &value, sizeof(value)); }
+
+static bool test_tex_ktx2() {
+	// A 4x4 RGBA8 sRGB image with a full chain of 3 mips, each mip a
+	// different color.
+	const int32_t mips        = 3;
+	const size_t  header_size = 80;
+	const size_t  level_size  = 24;
+	const color32 colors[mips] = { {255,0,0,255}, {0,255,0,255}, {0,0,255,255} };
+
+	uint8_t file[header_size + level_size * mips + (16 + 4 + 1) * sizeof(color32)] = {};
+	const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	memcpy(file, identifier, sizeof(identifier));
+	test_put_u32(file, 12, 43); // VK_FORMAT_R8G8B8A8_SRGB
+	test_put_u32(file, 16, 1);  // type size
+	test_put_u32(file, 20, 4);  // width
+	test_put_u32(file, 24, 4);  // height
+	test_put_u32(file, 36, 1);  // faces
+	test_put_u32(file, 40, mips);
+
+	size_t at = header_size + level_size * mips;
+	for (int32_t m = 0; m < mips; m++) {
+		int32_t dim  = 4 >> m;
+		size_t  size = dim * dim * sizeof(color32);
+		test_put_u64(file, header_size + level_size * m + 0,  at);
+		test_put_u64(file, header_size + level_size * m + 8,  size);
+		test_put_u64(file, header_size + level_size * m + 16, size);
+		for (int32_t p = 0; p < dim * dim; p++)
+			memcpy(file + at + p * sizeof(color32), &colors[m], sizeof(color32));
+		at += size;
+	}
+
+	tex_t tex = tex_create_mem(file, sizeof(file), true);
+	assets_block_for_priority(INT_MAX);
+
+	color32 mip1[4] = {};
+	bool    result  = tex_get_format(tex) == tex_format_rgba32 && tex_get_width(tex) == 4 && tex_get_mips(tex) == mips;
+	if (result) {
+		tex_get_data_mip(tex, mip1, sizeof(mip1), 1);
+		for (int32_t i = 0; i < 4; i++)
+			result = result && memcmp(&mip1[i], &colors[1], sizeof(color32)) == 0;
+	}
+
+	tex_release(tex);
+	return result;
+}
+
+///////////////////////////////////////////
+
+static bool test_tex_dds() {
+	// A single 4x4 BC1 block that's solid red
+	uint8_t file[128 + 8] = {};
+	test_put_u32(file, 0,  0x20534444); // "DDS "
+	test_put_u32(file, 4,  124);
+	test_put_u32(file, 12, 4);          // height
+	test_put_u32(file, 16, 4);          // width
+	test_put_u32(file, 28, 1);          // mips
+	test_put_u32(file, 80, 0x4);        // fourcc pixel format
+	memcpy(file + 84, "DXT1", 4);
+	file[128] = 0x00; file[129] = 0xF8; // color0, pure red in 565
+	file[130] = 0x1F; file[131] = 0x00; // color1, pure blue
+	// Leaving the indices at 0 selects color0 for every pixel
+
+	tex_t tex = tex_create_mem(file, sizeof(file), true);
+	assets_block_for_priority(INT_MAX);
+
+	// GPUs without BC1 get it decoded on the CPU, we can only read that back
+	tex_format_ format = tex_get_format(tex);
+	bool        result = tex_get_width(tex) == 4 && (format == tex_format_bc1_rgba || format == tex_format_rgba32);
+	if (result && format == tex_format_rgba32) {
+		color32 pixels[16] = {};
+		tex_get_data_mip(tex, pixels, sizeof(pixels), 0);
+		for (int32_t i = 0; i < 16; i++)
+			result = result && pixels[i].r == 255 && pixels[i].g == 0 && pixels[i].b == 0;
+	}
+
+	tex_release(tex);
+	return result;
+}
+
+///////////////////////////////////////////
+// Async upload fences                   //
+///////////////////////////////////////////
+
+static bool test_fences() {
+	mesh_t        mesh       = mesh_create();
+	tex_t         tex        = tex_create(tex_type_image, tex_format_rgba32);
+	asset_fence_t mesh_fence = 0;
+	asset_fence_t tex_fence  = 0;
+
+	std::thread worker([&]() {
+		vert_t  verts[3] = {
+			vert_t{ vec3{0,0,0}, vec3_forward, vec2{0,0}, color32{255,255,255,255} },
+			vert_t{ vec3{1,0,0}, vec3_forward, vec2{1,0}, color32{255,255,255,255} },
+			vert_t{ vec3{0,1,0}, vec3_forward, vec2{0,1}, color32{255,255,255,255} } };
+		vind_t  inds[3]    = { 0, 1, 2 };
+		color32 colors[64] = {};
+		mesh_fence = mesh_set_data_async(mesh, verts, 3, inds, 3);
+		tex_fence  = tex_set_colors_async(tex, 8, 8, colors);
+
+		// The calls copy their data, so it's fine to scribble over it now
+		memset(verts, 0xFF, sizeof(verts));
+		memset(inds,  0xFF, sizeof(inds));
+	});
+	worker.join();
+
+	bool result = mesh_fence != 0 && tex_fence != 0;
+	assets_fence_wait(mesh_fence);
+	assets_fence_wait(tex_fence);
+
+	bounds_t bounds = mesh_get_bounds(mesh);
+	result = result &&
+		assets_fence_finished(mesh_fence) &&
+		assets_fence_finished(tex_fence ) &&
+		assets_fence_finished(0) &&
+		mesh_get_vert_count(mesh) == 3 && mesh_get_ind_count(mesh) == 3 &&
+		near_eq(bounds.dimensions.x, 1) && near_eq(bounds.dimensions.y, 1) &&
+		tex_get_width(tex) == 8;
+
+	mesh_release(mesh);
+	tex_release(tex);
+	return result;
+}
+
+///////////////////////////////////////////
+// Asset dedup                           //
+///////////////////////////////////////////
+
+static bool test_asset_dedup() {
+	char   path[512];
+	void  *data = nullptr;
+	size_t size = 0;
+	test_asset_path(path, sizeof(path), "Radio.glb");
+	if (!test_read_file(path, &data, &size)) { free(data); return false; }
+
+	bool32_t was_enabled = assets_get_dedup();
+	assets_set_dedup(true);
+	assets_dedup_stats_t before = assets_get_dedup_stats();
+
+	// Different names, so the only thing they share is their content
+	model_t a = model_create_mem("sktest_dedup_a.glb", data, size);
+	model_t b = model_create_mem("sktest_dedup_b.glb", data, size);
+	assets_block_for_priority(INT_MAX);
+	assets_dedup_stats_t after = assets_get_dedup_stats();
+
+	bool result = a != nullptr && b != nullptr;
+	if (result) {
+		mesh_t mesh_a = model_get_mesh(a, 0);
+		mesh_t mesh_b = model_get_mesh(b, 0);
+		result =
+			mesh_a == mesh_b &&
+			after.mesh_hits   >  before.mesh_hits &&
+			after.tex_hits    >  before.tex_hits  &&
+			after.bytes_saved >  before.bytes_saved;
+		mesh_release(mesh_a);
+		mesh_release(mesh_b);
+	}
+
+	if (a) model_release(a);
+	if (b) model_release(b);
+	assets_set_dedup(was_enabled);
+	free(data);
+	return result;
+}
+
+///////////////////////////////////////////
+// Frame arena                           //
+///////////////////////////////////////////
+
+static void test_frame_churn() {
+	// Grow the layout stack past its first allocation, and fill the arena
+	// up with other per-frame data.
+	for (int32_t i = 0; i < 40; i++) ui_layout_push(vec3{ 0, (float)i, 0 }, vec2{ 0.1f, 0.1f }, false);
+	for (int32_t i = 0; i < 40; i++) ui_layout_pop();
+	for (int32_t i = 0; i < 2000; i++)
+		line_add(vec3{ 0, i * 0.001f, -1 }, vec3{ 0.1f, i * 0.001f, -1 }, color32{255,255,255,255}, color32{255,255,255,255}, 0.001f);
+}
+
+static bool test_frame_carry() {
+	// A layout left on the stack at the end of a frame has to survive the
+	// frame arena swapping buffers underneath it.
+	ui_layout_push(vec3{ 1, 2, 3 }, vec2{ 0.4f, 0.5f }, false);
+	vec3 at     = ui_layout_at();
+	vec2 remain = ui_layout_remaining();
+
+	bool result = true;
+	for (int32_t i = 0; i < 4 && result; i++) {
+		result = sk_step(test_frame_churn);
+
+		vec3 curr_at     = ui_layout_at();
+		vec2 curr_remain = ui_layout_remaining();
+		result = result &&
+			memcmp(&at,     &curr_at,     sizeof(at    )) == 0 &&
+			memcmp(&remain, &curr_remain, sizeof(remain)) == 0;
+	}
+
+	ui_layout_pop();
+	return result;
+}
+
+///////////////////////////////////////////
+
+static const test_t tests[] = {
+	{ "Mesh proximity",       test_mesh_proximity  },
+	{ "Skinned bounds",       test_skin_bounds     },
+	{ "Mesh optimize",        test_mesh_optimize   },
+	{ "OBJ relative indices", test_obj_relative    },
+	{ "Meshopt codecs",       test_meshopt_codecs  },
+	{ "Meshopt filters",      test_meshopt_filters },
+	{ "Model cache",          test_model_cache     },
+	{ "LZ4",                  test_lz4             },
+	{ "Asset pack",           test_asset_pack      },
+	{ "KTX2 texture",         test_tex_ktx2        },
+	{ "DDS texture",          test_tex_dds         },
+	{ "Async fences",         test_fences          },
+	{ "Asset dedup",          test_asset_dedup     },
+	{ "Frame arena carry",    test_frame_carry     },
+};
+
+bool tests_run() {
+	int32_t count  = (int32_t)(sizeof(tests) / sizeof(tests[0]));
+	int32_t failed = 0;
+	for (int32_t i = 0; i < count; i++) {
+		if (tests[i].run()) {
+			log_infof("Test passed for %s", tests[i].name);
+		} else {
+			log_errf("Test failed for %s!", tests[i].name);
+			failed += 1;
+		}
+	}
+	log_infof("%d/%d tests passed", count - failed, count);
+	return failed == 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Runs each of the automated tests, and returns true if they all passed.
+bool tests_run();
@@ -141,9 +141,14 @@ namespace StereoKit
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_set_keep_data   (IntPtr mesh, [MarshalAs(UnmanagedType.Bool)] bool keep_data);
 		[return: MarshalAs(UnmanagedType.Bool)]
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   mesh_get_keep_data   (IntPtr mesh);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_set_keep_verts  (IntPtr mesh, [MarshalAs(UnmanagedType.Bool)] bool keep_verts);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   mesh_get_keep_verts  (IntPtr mesh);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_set_data        (IntPtr mesh, [In] Vertex[] vertices, int vertex_count, [In] uint[] indices, int index_count, [MarshalAs(UnmanagedType.Bool)] bool calculate_bounds);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern ulong  mesh_set_data_async  (IntPtr mesh, [In] Vertex[] vertices, int vertex_count, [In] uint[] indices, int index_count, [MarshalAs(UnmanagedType.Bool)] bool calculate_bounds);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_set_verts       (IntPtr mesh, [In] Vertex[] vertices, int vertex_count, [MarshalAs(UnmanagedType.Bool)] bool calculate_bounds);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_get_verts       (IntPtr mesh, out IntPtr out_vertices, out int out_vertex_count, Memory reference_mode);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_set_verts_range (IntPtr mesh, int vertex_start, [In] Vertex[] vertices, int vertex_count, [MarshalAs(UnmanagedType.Bool)] bool calculate_bounds);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern int    mesh_get_vert_count  (IntPtr mesh);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_set_inds        (IntPtr mesh, [In] uint[] indices, int index_count);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_get_inds        (IntPtr mesh, out IntPtr out_indices,  out int out_index_count, Memory reference_mode); // [Out, MarshalAs(unmanagedType:UnmanagedType.LPArray, SizeParamIndex=2)]
@@ -157,6 +162,13 @@ namespace StereoKit
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   mesh_ray_intersect   (IntPtr mesh, Ray model_space_ray, out Ray out_pt, out uint out_start_inds, Cull cull_mode);
 		[return: MarshalAs(UnmanagedType.Bool)]
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   mesh_get_triangle    (IntPtr mesh, uint triangle_index, out Vertex a, out Vertex b, out Vertex c);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   mesh_optimize        (IntPtr mesh, MeshOptimize flags);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   mesh_closest_point   (IntPtr mesh, Vec3 model_space_pt, float max_distance, out Ray out_pt, out Vec3 out_barycentric, out uint out_start_inds);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   mesh_sphere_intersect(IntPtr mesh, Sphere model_space_sphere, out Ray out_pt, out Vec3 out_barycentric, out uint out_start_inds);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   mesh_capsule_intersect(IntPtr mesh, Vec3 model_space_pt1, Vec3 model_space_pt2, float radius, out Ray out_pt, out Vec3 out_barycentric, out uint out_start_inds);
 
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr mesh_gen_plane       (Vec2 dimensions, Vec3 plane_normal, Vec3 plane_top_direction, int subdivisions, [MarshalAs(UnmanagedType.Bool)] bool double_sided);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr mesh_gen_circle      (float diameter,  Vec3 plane_normal, Vec3 plane_top_direction, int spokes, [MarshalAs(UnmanagedType.Bool)] bool double_sided);
@@ -192,6 +204,8 @@ namespace StereoKit
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   tex_set_colors          (IntPtr texture, int width, int height, [In] byte[] data);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   tex_set_colors          (IntPtr texture, int width, int height, [In] ushort[] data);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   tex_set_colors          (IntPtr texture, int width, int height, [In] float[] data);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern ulong  tex_set_colors_async    (IntPtr texture, int width, int height, IntPtr data);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern ulong  tex_set_color_arr_async (IntPtr texture, int width, int height, IntPtr[] data, int data_count);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   tex_set_mem             (IntPtr texture, [In] byte[] data, UIntPtr data_size, [MarshalAs(UnmanagedType.Bool)] bool srgb_data, [MarshalAs(UnmanagedType.Bool)] bool blocking, int priority);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void   tex_set_surface         (IntPtr texture, IntPtr native_surface, TexType type, long native_fmt, int width, int height, int surface_count, [MarshalAs(UnmanagedType.Bool)] bool owned);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr tex_get_surface         (IntPtr texture);
@@ -215,6 +229,10 @@ namespace StereoKit
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       tex_set_loading_fallback(IntPtr texture);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       tex_set_error_fallback  (IntPtr texture);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern SphericalHarmonics tex_get_cubemap_lighting(IntPtr cubemap_texture);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       tex_set_memory_budget   (ulong budget_bytes);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern ulong      tex_get_memory_budget   ();
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       tex_set_max_resolution  (int max_size);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern int        tex_get_max_resolution  ();
 		///////////////////////////////////////////
 
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr font_find        (string id);
@@ -364,6 +382,17 @@ namespace StereoKit
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern Bounds model_get_bounds        (IntPtr model);
 		[return: MarshalAs(UnmanagedType.Bool)]
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   model_ray_intersect     (IntPtr model, Ray model_space_ray, out Ray out_pt, Cull cull_mode);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   model_closest_point     (IntPtr model, Vec3 model_space_pt, float max_distance, out Ray out_pt, out IntPtr out_mesh, out Matrix out_matrix, out uint out_start_inds, out Vec3 out_barycentric);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   model_sphere_intersect  (IntPtr model, Sphere model_space_sphere, out Ray out_pt, out IntPtr out_mesh, out Matrix out_matrix, out uint out_start_inds, out Vec3 out_barycentric);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   model_capsule_intersect (IntPtr model, Vec3 model_space_pt1, Vec3 model_space_pt2, float radius, out Ray out_pt, out IntPtr out_mesh, out Matrix out_matrix, out uint out_start_inds, out Vec3 out_barycentric);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void         model_set_load_optimize(MeshOptimize flags);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern MeshOptimize model_get_load_optimize();
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void         model_set_load_cache   ([MarshalAs(UnmanagedType.Bool)] bool enabled, [In] byte[] cache_folder_utf8);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool         model_get_load_cache   ();
 
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void     model_step_anim             (IntPtr model);
 		[return: MarshalAs(UnmanagedType.Bool)]
@@ -417,6 +446,23 @@ namespace StereoKit
 		[return: MarshalAs(UnmanagedType.Bool)]
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool   model_node_info_iterate       (IntPtr model, int node, ref int ref_iterator, out IntPtr out_key_utf8, out IntPtr out_value_utf8);
 
+		///////////////////////////////////////////
+
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr     point_cloud_find            (string id);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr     point_cloud_create_file     ([In] byte[] filename_utf8);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       point_cloud_set_id          (IntPtr cloud, string id);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr     point_cloud_get_id          (IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       point_cloud_addref          (IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       point_cloud_release         (IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern AssetState point_cloud_asset_state     (IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern Bounds     point_cloud_get_bounds      (IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern long       point_cloud_get_point_count (IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       point_cloud_set_point_budget(IntPtr cloud, int max_points);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern int        point_cloud_get_point_budget(IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       point_cloud_set_max_error   (IntPtr cloud, float max_error_pixels);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern float      point_cloud_get_max_error   (IntPtr cloud);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void       point_cloud_draw            (IntPtr cloud, Matrix transform, Color color, RenderLayer layer);
+
 		 ///////////////////////////////////////////
 
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr sprite_find       (string id);
@@ -704,6 +750,22 @@ namespace StereoKit
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern int       assets_count                ();
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern IntPtr    assets_get_index            (int index);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern AssetType assets_get_type             (int index);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool      assets_mount_pack           ([In] byte[] pack_filename_utf8);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool      assets_unmount_pack         ([In] byte[] pack_filename_utf8);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void      assets_set_upload_budget    (float milliseconds);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern float     assets_get_upload_budget    ();
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern AssetsUploadStats assets_get_upload_stats();
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool      assets_fence_finished       (ulong fence);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void      assets_fence_wait           (ulong fence);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void      assets_set_dedup            ([MarshalAs(UnmanagedType.Bool)] bool enabled);
+		[return: MarshalAs(UnmanagedType.Bool)]
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern bool      assets_get_dedup            ();
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern AssetsDedupStats assets_get_dedup_stats();
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern int       assets_memory_report        ([Out] AssetMemory[] out_arr_report, int report_capacity);
+		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void      assets_memory_totals        (AssetType type, out ulong out_cpu_bytes, out ulong out_gpu_bytes);
 		
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern AssetType asset_get_type              (IntPtr asset);
 		[DllImport(dll, CharSet = cSet, CallingConvention = call)] public static extern void      asset_set_id                (IntPtr asset, string id);
@@ -483,6 +483,82 @@ namespace StereoKit
 		/// <summary>A double channel of data that supports 8 bits for the red
 		/// channel and 8 bits for the green channel.</summary>
 		R8g8         = 19,
+		/// <summary>BC1 block compression, 4 bits per-pixel of sRGB color
+		/// with 1 bit alpha. These formats are usually loaded from KTX2 or
+		/// DDS files, and are decoded to rgba32 on the CPU if the GPU can't
+		/// use them directly.</summary>
+		Bc1Rgba           = 20,
+		/// <summary>BC1 block compression with linear color, see
+		/// Bc1Rgba.</summary>
+		Bc1RgbaLinear     = 21,
+		/// <summary>BC3 block compression, 8 bits per-pixel of sRGB color
+		/// with smooth alpha.</summary>
+		Bc3Rgba           = 22,
+		/// <summary>BC3 block compression with linear color, see
+		/// Bc3Rgba.</summary>
+		Bc3RgbaLinear     = 23,
+		/// <summary>BC4 block compression, a single 4 bit per-pixel
+		/// channel.</summary>
+		Bc4R              = 24,
+		/// <summary>BC5 block compression, two channels at 8 bits
+		/// per-pixel. This is a common choice for normal maps.</summary>
+		Bc5Rg             = 25,
+		/// <summary>BC7 block compression, 8 bits per-pixel of high quality
+		/// sRGB color and alpha.</summary>
+		Bc7Rgba           = 26,
+		/// <summary>BC7 block compression with linear color, see
+		/// Bc7Rgba.</summary>
+		Bc7RgbaLinear     = 27,
+		/// <summary>ETC2 block compression, 4 bits per-pixel of sRGB color
+		/// without alpha. This is the common format for mobile
+		/// GPUs.</summary>
+		Etc2Rgb           = 28,
+		/// <summary>ETC2 block compression with linear color, see
+		/// Etc2Rgb.</summary>
+		Etc2RgbLinear     = 29,
+		/// <summary>ETC2 block compression with EAC alpha, 8 bits per-pixel
+		/// of sRGB color and alpha.</summary>
+		Etc2Rgba          = 30,
+		/// <summary>ETC2 with EAC alpha and linear color, see
+		/// Etc2Rgba.</summary>
+		Etc2RgbaLinear    = 31,
+		/// <summary>EAC block compression, a single 4 bit per-pixel
+		/// channel.</summary>
+		Etc2R11           = 32,
+		/// <summary>EAC block compression, two channels at 8 bits
+		/// per-pixel.</summary>
+		Etc2Rg11          = 33,
+		/// <summary>ASTC 4x4 block compression, 8 bits per-pixel of sRGB
+		/// color and alpha. StereoKit can't decode this one on the CPU, so
+		/// it's only usable where the GPU supports it.</summary>
+		Astc4x4Rgba       = 34,
+		/// <summary>ASTC 4x4 block compression with linear color, see
+		/// Astc4x4Rgba.</summary>
+		Astc4x4RgbaLinear = 35,
+	}
+
+	/// <summary>Ways Mesh.Optimize can reorder a Mesh's data to make it
+	/// faster for the GPU to draw. These can be combined as
+	/// bit-flags.</summary>
+	[Flags]
+	public enum MeshOptimize {
+		/// <summary>Leave the Mesh data as-is.</summary>
+		None         = 0,
+		/// <summary>Reorders triangles so vertices already transformed by
+		/// the GPU get re-used as much as possible, reducing vertex shader
+		/// work.</summary>
+		VertexCache  = 1 << 0,
+		/// <summary>Moves clusters of outward facing triangles earlier, so
+		/// they're more likely to occlude the rest of the Mesh. This keeps
+		/// the vertex cache benefits of the previous step.</summary>
+		Overdraw     = 1 << 1,
+		/// <summary>Reorders vertices in the order the triangles first use
+		/// them, and removes unused vertices, so fetching vertex data walks
+		/// through memory in order. This is skipped for skinned
+		/// Meshes.</summary>
+		VertexFetch  = 1 << 2,
+		/// <summary>All of the above.</summary>
+		All          = VertexCache | Overdraw | VertexFetch,
 	}
 
 	/// <summary>How does the shader grab pixels from the texture? Or more
@@ -1263,6 +1339,8 @@ namespace StereoKit
 		Solid,
 		/// <summary>An Anchor.</summary>
 		Anchor,
+		/// <summary>A PointCloud.</summary>
+		PointCloud,
 	}
 
 }
@@ -403,6 +403,74 @@ namespace StereoKit
 	[UnmanagedFunctionPointer(CallingConvention.Cdecl)]
 	public delegate void InputEventCallback(InputSource source, BtnState type, in Pointer pointer);
 
+	/// <summary>A single point in a PointCloud. This is kept small, as
+	/// clouds can easily run into hundreds of millions of points.</summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct CloudPoint
+	{
+		/// <summary>Position of the point, in the cloud's model
+		/// space.</summary>
+		public Vec3    pos;
+		/// <summary>Color of the point.</summary>
+		public Color32 color;
+	}
+
+	/// <summary>How much GPU upload work the asset system has waiting, and
+	/// how much of it was done during the last frame.</summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct AssetsUploadStats
+	{
+		/// <summary>Uploads that are waiting on the main thread.</summary>
+		public int   jobsQueued;
+		/// <summary>Estimated size of the waiting uploads, in bytes. Not
+		/// every upload knows its size, so this can be an
+		/// undercount.</summary>
+		public ulong bytesQueued;
+		/// <summary>Uploads that finished during the last frame.</summary>
+		public int   jobsDone;
+		/// <summary>Bytes uploaded during the last frame.</summary>
+		public ulong bytesDone;
+		/// <summary>Milliseconds the last frame spent on uploads.</summary>
+		public float frameMs;
+	}
+
+	/// <summary>How much memory a single asset is using. Assets that refer
+	/// to other assets, like a Model's Meshes or a Font's Tex, don't
+	/// include them, since those report their own.</summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct AssetMemory
+	{
+		/// <summary>The asset this is about. This doesn't hold a
+		/// reference, so it's only safe to use until the asset is
+		/// released.</summary>
+		public IntPtr    asset;
+		/// <summary>What type of asset this is.</summary>
+		public AssetType type;
+		/// <summary>System memory the asset holds onto, like kept vertex
+		/// data, collision data, decoded audio or animation data.</summary>
+		public ulong     cpuBytes;
+		/// <summary>Estimated GPU memory, like vertex and index buffers,
+		/// texture mips and multisample surfaces.</summary>
+		public ulong     gpuBytes;
+	}
+
+	/// <summary>What content deduplication has saved so far, see
+	/// Assets.Dedup.</summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct AssetsDedupStats
+	{
+		/// <summary>Meshes that were shared instead of being created
+		/// again.</summary>
+		public int   meshHits;
+		/// <summary>Textures that were shared instead of being created
+		/// again.</summary>
+		public int   texHits;
+		/// <summary>Source data that didn't need to be decoded or uploaded
+		/// again. This is vertex and index data for meshes, and encoded
+		/// image data for textures.</summary>
+		public ulong bytesSaved;
+	}
+
 	/// <summary>Pointer is an abstraction of a number of different input 
 	/// sources, and a way to surface input events!</summary>
 	[StructLayout(LayoutKind.Sequential)]
@@ -3,10 +3,18 @@
 #include "mesh.h"
 #include "../sk_math.h"
 #include "../libraries/stref.h"
+#include "../systems/parallel.h"
 
 namespace sk {
 
-array_t<model_t> animation_list = {};
+struct anim_skin_job_t {
+	mesh_t        mesh;
+	const matrix *bone_transforms;
+	int32_t       bone_count;
+};
+
+array_t<model_t>         animation_list = {};
+array_t<anim_skin_job_t> animation_skin_jobs = {};
 
 ///////////////////////////////////////////
 
@@ -218,10 +226,19 @@ void _anim_update_skin(model_t &model) {
 		for (int32_t b = 0; b < model->anim_data.skeletons[i].bone_count; b++) {
 			model->anim_inst.skinned_meshes[i].bone_transforms[b] = model_node_get_transform_model(model, model->anim_data.skeletons[i].bone_to_node_map[b]) * root;
 		}
-		mesh_update_skin(
+		animation_skin_jobs.add({
 			model->anim_inst.skinned_meshes[i].modified_mesh,
 			model->anim_inst.skinned_meshes[i].bone_transforms,
-			model->anim_data.skeletons     [i].bone_count);
+			model->anim_data.skeletons     [i].bone_count });
+	}
+}
+
+///////////////////////////////////////////
+
+void _anim_skin_deform(void *context, int32_t start, int32_t end) {
+	anim_skin_job_t *jobs = (anim_skin_job_t *)context;
+	for (int32_t i = start; i < end; i++) {
+		mesh_skin_deform(jobs[i].mesh, jobs[i].bone_transforms, jobs[i].bone_count);
 	}
 }
 
@@ -344,12 +361,21 @@ anim_data_t anim_data_copy(anim_data_t *data) {
 void anim_step() {
 	animation_list.each(_anim_update_skin);
 	animation_list.clear();
+
+	// Deformation is pure CPU work, so every skinned mesh can be done at the
+	// same time. Uploading to the GPU still needs to happen on this thread.
+	parallel_for(animation_skin_jobs.count, 1, animation_skin_jobs.data, _anim_skin_deform);
+	for (int32_t i = 0; i < animation_skin_jobs.count; i++) {
+		mesh_skin_upload(animation_skin_jobs[i].mesh);
+	}
+	animation_skin_jobs.clear();
 }
 
 ///////////////////////////////////////////
 
 void anim_shutdown() {
-	animation_list.free();
+	animation_list     .free();
+	animation_skin_jobs.free();
 }
 
 } // namespace sk
@@ -0,0 +1,196 @@
+#include "asset_dedup.h"
+#include "../libraries/array.h"
+#include "../libraries/atomic_util.h"
+#include "../libraries/ferr_thread.h"
+
+#include <string.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+struct asset_dedup_entry_t {
+	uint64_t        hash;
+	uint64_t        check;
+	uint64_t        size;
+	asset_header_t *asset;
+};
+
+array_t<asset_dedup_entry_t> asset_dedup_entries = {};
+ft_mutex_t                   asset_dedup_lock    = nullptr;
+bool32_t                     asset_dedup_on      = false;
+assets_dedup_stats_t         asset_dedup_stats   = {};
+
+///////////////////////////////////////////
+
+bool asset_dedup_init() {
+	asset_dedup_lock = ft_mutex_create();
+	return true;
+}
+
+///////////////////////////////////////////
+
+void asset_dedup_shutdown() {
+	asset_dedup_entries.free();
+	ft_mutex_destroy(&asset_dedup_lock);
+	asset_dedup_stats = {};
+}
+
+///////////////////////////////////////////
+
+bool asset_dedup_enabled() {
+	return asset_dedup_on;
+}
+
+///////////////////////////////////////////
+
+// XXH64, it chews through 32 bytes a round, which keeps hashing large
+// textures and vertex buffers cheap next to decoding them.
+static const uint64_t dedup_prime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t dedup_prime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t dedup_prime3 = 0x165667B19E3779F9ULL;
+static const uint64_t dedup_prime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t dedup_prime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t dedup_rotl (uint64_t x, int32_t r) { return (x << r) | (x >> (64 - r)); }
+static inline uint64_t dedup_read8(const uint8_t *p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+static inline uint32_t dedup_read4(const uint8_t *p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+static inline uint64_t dedup_round(uint64_t acc, uint64_t input) { return dedup_rotl(acc + input * dedup_prime2, 31) * dedup_prime1; }
+static inline uint64_t dedup_merge(uint64_t acc, uint64_t val)   { return (acc ^ dedup_round(0, val)) * dedup_prime1 + dedup_prime4; }
+
+uint64_t asset_dedup_hash(const void *data, size_t data_size, uint64_t seed) {
+	const uint8_t *p   = (const uint8_t *)data;
+	const uint8_t *end = p + data_size;
+	uint64_t       h;
+
+	if (data_size >= 32) {
+		uint64_t v1 = seed + dedup_prime1 + dedup_prime2;
+		uint64_t v2 = seed + dedup_prime2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - dedup_prime1;
+		const uint8_t *limit = end - 32;
+		do {
+			v1 = dedup_round(v1, dedup_read8(p)); p += 8;
+			v2 = dedup_round(v2, dedup_read8(p)); p += 8;
+			v3 = dedup_round(v3, dedup_read8(p)); p += 8;
+			v4 = dedup_round(v4, dedup_read8(p)); p += 8;
+		} while (p <= limit);
+		h = dedup_rotl(v1, 1) + dedup_rotl(v2, 7) + dedup_rotl(v3, 12) + dedup_rotl(v4, 18);
+		h = dedup_merge(h, v1);
+		h = dedup_merge(h, v2);
+		h = dedup_merge(h, v3);
+		h = dedup_merge(h, v4);
+	} else {
+		h = seed + dedup_prime5;
+	}
+	h += (uint64_t)data_size;
+
+	for (; p + 8 <= end; p += 8) h = dedup_rotl(h ^ dedup_round(0, dedup_read8(p)), 27) * dedup_prime1 + dedup_prime4;
+	for (; p + 4 <= end; p += 4) h = dedup_rotl(h ^ (dedup_read4(p) * dedup_prime1), 23) * dedup_prime2 + dedup_prime3;
+	for (; p     <  end; p += 1) h = dedup_rotl(h ^ (*p * dedup_prime5), 11) * dedup_prime1;
+
+	h ^= h >> 33; h *= dedup_prime2;
+	h ^= h >> 29; h *= dedup_prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+///////////////////////////////////////////
+
+// Each part is chained into the next one's seed, and the hash mixes in
+// each part's size, so where one part ends and the next starts counts too.
+asset_dedup_key_t asset_dedup_key(const asset_dedup_part_t *parts, int32_t part_count) {
+	asset_dedup_key_t result = {};
+	result.check = dedup_prime3;
+	for (int32_t i = 0; i < part_count; i++) {
+		result.hash   = asset_dedup_hash(parts[i].data, parts[i].size, result.hash);
+		result.check  = asset_dedup_hash(parts[i].data, parts[i].size, result.check);
+		result.size  += parts[i].size;
+	}
+	// 0 marks an asset without a content hash
+	if (result.hash == 0) result.hash = 1;
+	return result;
+}
+
+///////////////////////////////////////////
+
+asset_header_t *asset_dedup_find(asset_type_ type, const asset_dedup_key_t *key) {
+	asset_header_t *result = nullptr;
+	ft_mutex_lock(asset_dedup_lock);
+	int32_t at = asset_dedup_entries.binary_search(&asset_dedup_entry_t::hash, key->hash);
+	// Assets with no references left are on their way out
+	if (at >= 0
+		&& asset_dedup_entries[at].check       == key->check
+		&& asset_dedup_entries[at].size        == key->size
+		&& asset_dedup_entries[at].asset->type == type
+		&& asset_dedup_entries[at].asset->refs >  0) {
+		result = asset_dedup_entries[at].asset;
+		atomic_increment(&result->refs);
+
+		if (type == asset_type_mesh) asset_dedup_stats.mesh_hits += 1;
+		else                         asset_dedup_stats.tex_hits  += 1;
+		asset_dedup_stats.bytes_saved += key->size;
+	}
+	ft_mutex_unlock(asset_dedup_lock);
+	return result;
+}
+
+///////////////////////////////////////////
+
+void asset_dedup_add(asset_header_t *asset, const asset_dedup_key_t *key) {
+	asset_dedup_entry_t entry = {};
+	entry.hash  = key->hash;
+	entry.check = key->check;
+	entry.size  = key->size;
+	entry.asset = asset;
+
+	// A hash collision with different content replaces the older entry, it
+	// just won't be shared anymore.
+	ft_mutex_lock(asset_dedup_lock);
+	asset->content_hash = key->hash;
+	int32_t at = asset_dedup_entries.binary_search(&asset_dedup_entry_t::hash, key->hash);
+	if (at >= 0) {
+		asset_dedup_entries[at] = entry;
+	} else {
+		asset_dedup_entries.insert(~at, entry);
+	}
+	ft_mutex_unlock(asset_dedup_lock);
+}
+
+///////////////////////////////////////////
+
+bool asset_dedup_remove(asset_header_t *asset) {
+	ft_mutex_lock(asset_dedup_lock);
+	if (asset->refs != 0) {
+		ft_mutex_unlock(asset_dedup_lock);
+		return false;
+	}
+	int32_t at = asset_dedup_entries.binary_search(&asset_dedup_entry_t::hash, asset->content_hash);
+	if (at >= 0 && asset_dedup_entries[at].asset == asset)
+		asset_dedup_entries.remove(at);
+	ft_mutex_unlock(asset_dedup_lock);
+	return true;
+}
+
+///////////////////////////////////////////
+
+void assets_set_dedup(bool32_t enabled) {
+	asset_dedup_on = enabled;
+}
+
+///////////////////////////////////////////
+
+bool32_t assets_get_dedup() {
+	return asset_dedup_on;
+}
+
+///////////////////////////////////////////
+
+assets_dedup_stats_t assets_get_dedup_stats() {
+	ft_mutex_lock(asset_dedup_lock);
+	assets_dedup_stats_t result = asset_dedup_stats;
+	ft_mutex_unlock(asset_dedup_lock);
+	return result;
+}
+
+} // namespace sk
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../stereokit.h"
+#include "assets.h"
+
+namespace sk {
+
+// When enabled, meshes and embedded images from model files are looked up
+// by a hash of their content, so identical data that shows up again, like a
+// texture embedded in several glTF files, aliases the asset that already has
+// it instead of being decoded and uploaded a second time. Entries don't hold
+// a reference, they're dropped when the asset is destroyed. Content is keyed
+// by two differently seeded 64 bit hashes and its size, rather than keeping
+// a copy of the bytes around, so an accidental match would need a 128 bit
+// collision.
+
+struct asset_dedup_part_t {
+	const void *data;
+	size_t      size;
+};
+
+struct asset_dedup_key_t {
+	uint64_t hash;
+	uint64_t check;
+	uint64_t size;
+};
+
+bool              asset_dedup_init    ();
+void              asset_dedup_shutdown();
+bool              asset_dedup_enabled ();
+uint64_t          asset_dedup_hash    (const void *data, size_t data_size, uint64_t seed);
+asset_dedup_key_t asset_dedup_key     (const asset_dedup_part_t *parts, int32_t part_count);
+// Returns the asset with a new reference, or nullptr if there isn't one
+asset_header_t   *asset_dedup_find    (asset_type_ type, const asset_dedup_key_t *key);
+void              asset_dedup_add     (asset_header_t *asset, const asset_dedup_key_t *key);
+// False if the asset picked up a new reference through a lookup, in which
+// case it shouldn't be destroyed after all.
+bool              asset_dedup_remove  (asset_header_t *asset);
+
+} // namespace sk
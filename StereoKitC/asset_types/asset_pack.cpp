@@ -0,0 +1,275 @@
+#include "asset_pack.h"
+#include "assets.h"
+#include "../_stereokit.h"
+#include "../sk_memory.h"
+#include "../log.h"
+#include "../utils/skpack.h"
+#include "../libraries/array.h"
+#include "../libraries/stref.h"
+#include "../libraries/ferr_thread.h"
+
+#include <string.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+struct asset_pack_t {
+	char                  *filename;
+	platform_file_map_t    file;
+	const skpack_header_t *header;
+	const skpack_entry_t  *entries;
+	const char            *names;
+	int32_t                refs;
+};
+
+array_t<asset_pack_t*> asset_packs     = {};
+ft_mutex_t             asset_pack_lock = nullptr;
+
+///////////////////////////////////////////
+
+static void asset_pack_destroy(asset_pack_t *pack) {
+	platform_file_unmap(&pack->file);
+	sk_free(pack->filename);
+	sk_free(pack);
+}
+
+///////////////////////////////////////////
+
+void asset_pack_release(void *pack_ptr) {
+	asset_pack_t *pack = (asset_pack_t *)pack_ptr;
+
+	// Assets holding views may outlive the asset system during shutdown, by
+	// then everything is back on one thread and the lock is gone.
+	if (asset_pack_lock) ft_mutex_lock(asset_pack_lock);
+	pack->refs -= 1;
+	bool destroy = pack->refs == 0;
+	if (asset_pack_lock) ft_mutex_unlock(asset_pack_lock);
+
+	if (destroy) asset_pack_destroy(pack);
+}
+
+///////////////////////////////////////////
+
+void asset_pack_shutdown() {
+	ft_mutex_lock(asset_pack_lock);
+	array_t<asset_pack_t*> packs = asset_packs;
+	asset_packs = {};
+	ft_mutex_unlock(asset_pack_lock);
+
+	for (int32_t i = 0; i < packs.count; i++)
+		asset_pack_release(packs[i]);
+	packs.free();
+	ft_mutex_destroy(&asset_pack_lock);
+}
+
+///////////////////////////////////////////
+
+bool asset_pack_init() {
+	asset_pack_lock = ft_mutex_create();
+	return true;
+}
+
+///////////////////////////////////////////
+
+static bool asset_pack_validate(asset_pack_t *pack) {
+	const uint8_t *data = (const uint8_t *)pack->file.data;
+	size_t         size = pack->file.size;
+	if (size < sizeof(skpack_header_t)) return false;
+
+	const skpack_header_t *h = (const skpack_header_t *)data;
+	if (memcmp(h->magic, "SKPK", 4) != 0 || h->version != SKPACK_VERSION) return false;
+	if (h->toc_offset   % 8 != 0 || h->toc_offset > size || (uint64_t)h->entry_count * sizeof(skpack_entry_t) > size - h->toc_offset) return false;
+	if (h->names_offset > size   || h->names_size > size - h->names_offset || h->names_size == 0) return false;
+	if (data[h->names_offset + h->names_size - 1] != '\0') return false;
+
+	const skpack_entry_t *entries = (const skpack_entry_t *)(data + h->toc_offset);
+	for (uint32_t i = 0; i < h->entry_count; i++) {
+		const skpack_entry_t *e = &entries[i];
+		if (i > 0 && entries[i-1].path_hash > e->path_hash)             return false;
+		if (e->offset < sizeof(skpack_header_t) || e->offset > size)    return false;
+		if (e->stored_size > size - e->offset)                          return false;
+		if (e->name_offset >= h->names_size)                            return false;
+		if (e->compression != skpack_compression_none &&
+			e->compression != skpack_compression_lz4)                   return false;
+		if (e->compression == skpack_compression_none && e->stored_size != e->size) return false;
+		// LZ4 can't expand a block by more than ~255x, so anything claiming
+		// more is corrupt, and shouldn't get to size an allocation.
+		if (e->compression == skpack_compression_lz4  && e->size > e->stored_size * 255 + 16) return false;
+	}
+
+	pack->header  = h;
+	pack->entries = entries;
+	pack->names   = (const char *)(data + h->names_offset);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool32_t assets_mount_pack(const char *filename) {
+	if (asset_pack_lock == nullptr) {
+		log_err("assets_mount_pack must be called after sk_init");
+		return false;
+	}
+
+	asset_pack_t *pack = sk_malloc_zero_t(asset_pack_t, 1);
+	pack->filename = assets_file(filename);
+	pack->refs     = 1;
+
+	// Going straight to the file system here, a pack can't live inside
+	// another pack.
+	if (!platform_file_map_disk(pack->filename, &pack->file)) {
+		log_warnf("Asset pack not found: %s", filename);
+		asset_pack_destroy(pack);
+		return false;
+	}
+	if (!asset_pack_validate(pack)) {
+		log_warnf("Asset pack is invalid or from a different version: %s", filename);
+		asset_pack_destroy(pack);
+		return false;
+	}
+
+	// Packs mounted later take priority, so they can patch earlier ones.
+	ft_mutex_lock(asset_pack_lock);
+	asset_packs.add(pack);
+	ft_mutex_unlock(asset_pack_lock);
+
+	log_diagf("Mounted asset pack %s with %u entries", filename, pack->header->entry_count);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool32_t assets_unmount_pack(const char *filename) {
+	if (asset_pack_lock == nullptr) return false;
+
+	char         *pack_file = assets_file(filename);
+	asset_pack_t *pack      = nullptr;
+	ft_mutex_lock(asset_pack_lock);
+	for (int32_t i = asset_packs.count - 1; i >= 0; i--) {
+		if (string_eq(asset_packs[i]->filename, pack_file)) {
+			pack = asset_packs[i];
+			asset_packs.remove(i);
+			break;
+		}
+	}
+	ft_mutex_unlock(asset_pack_lock);
+	sk_free(pack_file);
+
+	if (pack == nullptr) return false;
+	asset_pack_release(pack);
+	return true;
+}
+
+///////////////////////////////////////////
+
+// File names arrive with the assets folder already attached by
+// assets_file, but pack entries are relative to that folder.
+static const char *asset_pack_relative(const char *filename) {
+	const sk_settings_t *settings = sk_get_settings_ref();
+	const char          *folder   = settings->assets_folder;
+	if (folder == nullptr || folder[0] == '\0') return filename;
+
+	size_t len = strlen(folder);
+	if (strncmp(filename, folder, len) != 0) return filename;
+	if (filename[len] == '/' || filename[len] == '\\' || folder[len-1] == '/' || folder[len-1] == '\\')
+		return filename + len;
+	return filename;
+}
+
+///////////////////////////////////////////
+
+// Binary searches the table of contents, then walks any entries that share
+// the same hash to find the one with a matching name. Call with the lock.
+static const skpack_entry_t *asset_pack_find_entry(const asset_pack_t *pack, uint64_t hash, const char *name) {
+	int32_t l = 0, r = (int32_t)pack->header->entry_count;
+	while (l < r) {
+		int32_t mid = (l + r) / 2;
+		if (pack->entries[mid].path_hash < hash) l = mid + 1;
+		else                                     r = mid;
+	}
+	for (int32_t i = l; i < (int32_t)pack->header->entry_count && pack->entries[i].path_hash == hash; i++) {
+		if (strcmp(pack->names + pack->entries[i].name_offset, name) == 0)
+			return &pack->entries[i];
+	}
+	return nullptr;
+}
+
+///////////////////////////////////////////
+
+static asset_pack_t *asset_pack_find(const char *filename, const skpack_entry_t **out_entry) {
+	if (asset_pack_lock == nullptr || asset_packs.count == 0) return nullptr;
+
+	const char *relative = asset_pack_relative(filename);
+	char       *name     = sk_malloc_t(char, strlen(relative) + 1);
+	uint64_t    hash     = skpack_hash_path(relative, name);
+
+	asset_pack_t *result = nullptr;
+	ft_mutex_lock(asset_pack_lock);
+	for (int32_t i = asset_packs.count - 1; i >= 0; i--) {
+		*out_entry = asset_pack_find_entry(asset_packs[i], hash, name);
+		if (*out_entry != nullptr) {
+			result = asset_packs[i];
+			result->refs += 1;
+			break;
+		}
+	}
+	ft_mutex_unlock(asset_pack_lock);
+
+	sk_free(name);
+	return result;
+}
+
+///////////////////////////////////////////
+
+bool asset_pack_exists(const char *filename) {
+	const skpack_entry_t *entry = nullptr;
+	asset_pack_t         *pack  = asset_pack_find(filename, &entry);
+	if (pack == nullptr) return false;
+	asset_pack_release(pack);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool asset_pack_map(const char *filename, platform_file_map_t *out_map) {
+	const skpack_entry_t *entry = nullptr;
+	asset_pack_t         *pack  = asset_pack_find(filename, &entry);
+	if (pack == nullptr) return false;
+
+	const uint8_t *data = (const uint8_t *)pack->file.data + entry->offset;
+
+	// Uncompressed entries are handed out in place, the writer pads each of
+	// them with a 0 byte so they can pass as a platform_read_file buffer.
+	// The view keeps our reference to the pack.
+	if (entry->compression == skpack_compression_none && entry->offset + entry->size < pack->file.size && data[entry->size] == 0) {
+		out_map->data   = (void *)data;
+		out_map->size   = (size_t)entry->size;
+		out_map->handle = pack;
+		out_map->mapped = false;
+		return true;
+	}
+
+	void *result = sk_malloc((size_t)entry->size + 1);
+	bool  valid  = true;
+	if (entry->compression == skpack_compression_lz4) {
+		valid = skpack_lz4_decompress(data, (size_t)entry->stored_size, (uint8_t *)result, (size_t)entry->size);
+	} else {
+		memcpy(result, data, (size_t)entry->size);
+	}
+	((uint8_t *)result)[entry->size] = 0;
+	asset_pack_release(pack);
+
+	if (!valid) {
+		log_warnf("Asset pack entry is corrupt: %s", filename);
+		sk_free(result);
+		return false;
+	}
+	out_map->data   = result;
+	out_map->size   = (size_t)entry->size;
+	out_map->handle = nullptr;
+	out_map->mapped = false;
+	return true;
+}
+
+} // namespace sk
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../platforms/platform.h"
+
+namespace sk {
+
+// Mounted asset packs are checked before the file system whenever a file is
+// read. Uncompressed entries come back as views straight into the pack's
+// mapping, and hold a reference that keeps the pack alive until
+// platform_file_unmap releases it, even if the pack gets unmounted.
+
+bool asset_pack_init    ();
+void asset_pack_shutdown();
+bool asset_pack_exists  (const char *filename);
+bool asset_pack_map     (const char *filename, platform_file_map_t *out_map);
+void asset_pack_release (void *pack);
+
+} // namespace sk
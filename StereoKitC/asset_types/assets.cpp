@@ -9,13 +9,18 @@
 
 #include "mesh.h"
 #include "texture.h"
+#include "texture_stream.h"
 #include "shader.h"
 #include "material.h"
 #include "model.h"
+#include "model_cache.h"
+#include "asset_pack.h"
+#include "asset_dedup.h"
 #include "font.h"
 #include "sprite.h"
 #include "sound.h"
 #include "anchor.h"
+#include "point_cloud.h"
 #include "../platforms/platform.h"
 #include "../systems/physics.h"
 #include "../libraries/stref.h"
@@ -48,6 +53,24 @@ struct asset_thread_t {
 	bool32_t running;
 };
 
+// Copies are bump allocated out of shared blocks, and a block can be reused
+// once every copy in it has been freed. Copies too big for a block get one
+// to themselves.
+struct asset_staging_block_t {
+	uint8_t *memory;
+	size_t   size;
+	size_t   used;
+	int32_t  live;
+};
+
+struct asset_staging_header_t {
+	asset_staging_block_t *block;
+	uint64_t               _pad;
+};
+
+const size_t  assets_staging_block_size = 4 * 1024 * 1024;
+const int32_t assets_staging_max_free   = 4;
+
 ///////////////////////////////////////////
 
 array_t<asset_header_t *>      assets = {};
@@ -55,9 +78,22 @@ array_t<asset_header_t *>      assets_multithread_destroy = {};
 ft_mutex_t                     assets_multithread_destroy_lock = {};
 ft_mutex_t                     assets_job_lock = {};
 array_t<asset_job_t *>         assets_gpu_jobs = {};
+uint64_t                       assets_gpu_jobs_bytes = 0;
+float                          assets_upload_budget_ms = 4;
+uint64_t                       assets_upload_start = 0;
+assets_upload_stats_t          assets_upload_frame = {};
+uint64_t                       assets_gpu_fence_next = 0;
+int64_t                        assets_gpu_fence_done = 0;
+ft_mutex_t                     assets_staging_lock = {};
+asset_staging_block_t         *assets_staging_curr = nullptr;
+array_t<asset_staging_block_t*>assets_staging_free_blocks = {};
 ft_mutex_t                     assets_load_event_lock = {};
 array_t<asset_load_callback_t> assets_load_callbacks = {};
 array_t<asset_header_t *>      assets_load_events = {};
+array_t<asset_load_callback_t> assets_load_call_list = {};
+#if defined(SK_TRACK_MEM)
+uint64_t                       assets_mem_log_time = 0;
+#endif
 
 ///////////////////////////////////////////
 
@@ -106,7 +142,7 @@ void assets_unique_name(asset_type_ type, const char *root_name, char *dest, int
 
 ///////////////////////////////////////////
 
-void *assets_allocate(asset_type_ type) {
+static size_t assets_type_size(asset_type_ type) {
 	size_t size = sizeof(asset_header_t);
 	switch(type) {
 	case asset_type_mesh:     size = sizeof(_mesh_t );    break;
@@ -119,8 +155,16 @@ void *assets_allocate(asset_type_ type) {
 	case asset_type_sound:    size = sizeof(_sound_t);    break;
 	case asset_type_solid:    size = sizeof(_solid_t);    break;
 	case asset_type_anchor:   size = sizeof(_anchor_t);   break;
+	case asset_type_point_cloud: size = sizeof(_point_cloud_t); break;
 	default: log_err("Unimplemented asset type!"); abort();
 	}
+	return size;
+}
+
+///////////////////////////////////////////
+
+void *assets_allocate(asset_type_ type) {
+	size_t size = assets_type_size(type);
 
 	char name[64];
 	snprintf(name, sizeof(name), "auto/asset_%d", assets.count);
@@ -210,6 +254,9 @@ void assets_destroy(asset_header_t *asset) {
 		// break out of here.
 		return;
 	}
+	// Content lookups from the asset threads can also pick up a reference.
+	if (asset->content_hash != 0 && !asset_dedup_remove(asset))
+		return;
 
 	// destroy functions will often zero out their contents for safety, so we
 	// need to free the id text first
@@ -227,6 +274,7 @@ void assets_destroy(asset_header_t *asset) {
 	case asset_type_sound:    sound_destroy   ((sound_t   )asset); break;
 	case asset_type_solid:    solid_destroy   ((solid_t   )asset); break;
 	case asset_type_anchor:   anchor_destroy  ((anchor_t  )asset); break;
+	case asset_type_point_cloud: point_cloud_destroy((point_cloud_t)asset); break;
 	default: log_err("Unimplemented asset type!"); abort();
 	}
 
@@ -300,6 +348,7 @@ void  assets_shutdown_check() {
 			case asset_type_sound:    type_name = "sound_t";    break;
 			case asset_type_solid:    type_name = "solid_t";    break;
 			case asset_type_anchor:   type_name = "anchor_t";   break;
+			case asset_type_point_cloud: type_name = "point_cloud_t"; break;
 			default: break;
 			}
 			log_infof("\t%s (%d): %s", type_name, assets[i]->refs, assets[i]->id_text);
@@ -344,6 +393,7 @@ char *assets_file(const char *file_name) {
 bool assets_init() {
 	assets_multithread_destroy_lock = ft_mutex_create();
 	assets_job_lock                 = ft_mutex_create();
+	assets_staging_lock             = ft_mutex_create();
 	asset_thread_task_mtx           = ft_mutex_create();
 	assets_load_event_lock          = ft_mutex_create();
 	asset_tasks_available           = ft_condition_create();
@@ -359,12 +409,13 @@ bool assets_init() {
 		ft_thread_create(asset_thread, th);
 	}
 
-	return true;
+	return asset_pack_init()
+		&& asset_dedup_init()
+		&& tex_stream_init();
 }
 
 ///////////////////////////////////////////
 
-array_t<asset_load_callback_t> assets_load_call_list = {};
 void assets_step() {
 	// If we have no asset threads for some reason (like WASM), then we'll need
 	// to make sure assets still get loaded here!
@@ -380,15 +431,38 @@ void assets_step() {
 	assets_multithread_destroy.clear();
 	ft_mutex_unlock(assets_multithread_destroy_lock);
 
-	// Do any jobs the assets need on the main thread, like GPU buffer uploads
+	// Do any jobs the assets need on the main thread, like GPU buffer uploads.
+	// A burst of finished loads can be more than one frame has room for, so
+	// jobs run in priority order until the frame's upload budget is spent,
+	// and the rest wait for the next frame. At least one job always runs, so
+	// the queue keeps moving.
+	assets_upload_start = stm_now();
+	assets_upload_frame = {};
 	ft_mutex_lock(assets_job_lock);
-	for (int32_t i = 0; i < assets_gpu_jobs.count; i++) {
-		assets_gpu_jobs[i]->success  = assets_gpu_jobs[i]->asset_job(assets_gpu_jobs[i]->data);
-		assets_gpu_jobs[i]->finished = true;
+	while (assets_gpu_jobs.count > 0 && (assets_upload_frame.jobs_done == 0 || assets_upload_budget_left())) {
+		asset_job_t *job   = assets_gpu_jobs[0];
+		uint64_t     bytes = job->bytes;
+		assets_gpu_jobs.remove(0);
+		assets_gpu_jobs_bytes -= bytes;
+
+		// The job's owner may free it as soon as it's marked finished.
+		// Fire-and-forget jobs have no owner waiting, so they're cleaned up
+		// here, and they finish in the order they were queued.
+		job->success = job->asset_job(job->data);
+		if (job->free_data != nullptr) {
+			atomic_exchange64(&assets_gpu_fence_done, (int64_t)job->fence);
+			job->free_data(job->data);
+			sk_free(job);
+		} else {
+			job->finished = true;
+		}
+		assets_upload_budget_spend(bytes);
 	}
-	assets_gpu_jobs.clear();
 	ft_mutex_unlock(assets_job_lock);
 
+	// Stream in texture mips that were asked for last frame
+	tex_stream_step();
+
 	// Update any on_load event callbacks
 	ft_mutex_lock(assets_load_event_lock);
 	for (int32_t i = 0; i < assets_load_events.count; i++) {
@@ -407,11 +481,20 @@ void assets_step() {
 	assets_load_call_list.each([](const asset_load_callback_t &c) { c.on_load(c.asset, c.context); });
 	assets_load_call_list.clear();
 
-#if defined(SK_DEBUG_MEM)
+#if defined(SK_DEBUG_MEM) || defined(SK_TRACK_MEM)
 	if (input_key(key_p) & button_state_just_active) {
 		sk_mem_log_allocations();
 	}
 #endif
+#if defined(SK_TRACK_MEM)
+	// Log what grew or churned since the last interval, long sessions tend
+	// to reveal leaks this way that a single snapshot won't.
+	uint64_t now = stm_now();
+	if (assets_mem_log_time == 0 || stm_sec(stm_diff(now, assets_mem_log_time)) > 60) {
+		assets_mem_log_time = now;
+		sk_mem_log_changes();
+	}
+#endif
 }
 
 ///////////////////////////////////////////
@@ -436,12 +519,39 @@ void assets_shutdown() {
 	asset_active_tasks.free();
 
 	assets_multithread_destroy.free();
+	// Fire-and-forget jobs that never got to run still need to let go of
+	// their data.
+	for (int32_t i = 0; i < assets_gpu_jobs.count; i++) {
+		if (assets_gpu_jobs[i]->free_data == nullptr) continue;
+		assets_gpu_jobs[i]->free_data(assets_gpu_jobs[i]->data);
+		sk_free(assets_gpu_jobs[i]);
+	}
 	assets_gpu_jobs           .free();
+	assets_gpu_jobs_bytes = 0;
+	assets_gpu_fence_next = 0;
+	assets_gpu_fence_done = 0;
+
+	if (assets_staging_curr != nullptr && assets_staging_curr->live > 0)
+		log_warn("Staging memory is still in use during shutdown!");
+	assets_staging_free_blocks.add(assets_staging_curr);
+	for (int32_t i = 0; i < assets_staging_free_blocks.count; i++) {
+		if (assets_staging_free_blocks[i] == nullptr) continue;
+		sk_free(assets_staging_free_blocks[i]->memory);
+		sk_free(assets_staging_free_blocks[i]);
+	}
+	assets_staging_free_blocks.free();
+	assets_staging_curr = nullptr;
+	ft_mutex_destroy(&assets_staging_lock);
 	ft_mutex_destroy(&assets_multithread_destroy_lock);
 	ft_mutex_destroy(&assets_job_lock);
 	ft_mutex_destroy(&assets_load_event_lock);
 	ft_condition_destroy(&asset_tasks_available);
 
+	model_cache_shutdown();
+	asset_pack_shutdown();
+	asset_dedup_shutdown();
+	tex_stream_shutdown();
+
 	assets_load_call_list.free();
 	assets_load_callbacks.free();
 	assets_load_events   .free();
@@ -454,7 +564,29 @@ void assets_shutdown() {
 
 ///////////////////////////////////////////
 
-bool32_t assets_execute_gpu(bool32_t(*asset_job)(void *data), void *data) {
+// Returns the job's fence, since fire-and-forget jobs may already be gone by
+// the time this returns.
+static uint64_t assets_queue_gpu_job(asset_job_t *job) {
+	uint64_t fence = 0;
+	ft_mutex_lock(assets_job_lock);
+	// Keep the queue sorted by priority, first come first served within the
+	// same priority.
+	int32_t at = assets_gpu_jobs.count;
+	while (at > 0 && assets_gpu_jobs[at - 1]->priority > job->priority)
+		at--;
+	assets_gpu_jobs.insert(at, job);
+	assets_gpu_jobs_bytes += job->bytes;
+	if (job->free_data != nullptr) {
+		job->fence = ++assets_gpu_fence_next;
+		fence      = job->fence;
+	}
+	ft_mutex_unlock(assets_job_lock);
+	return fence;
+}
+
+///////////////////////////////////////////
+
+bool32_t assets_execute_gpu(bool32_t(*asset_job)(void *data), void *data, uint64_t bytes) {
 	if (ft_id_matches(sk_main_thread())) {
 		return asset_job(data);
 	} else {
@@ -462,10 +594,12 @@ bool32_t assets_execute_gpu(bool32_t(*asset_job)(void *data), void *data) {
 		*job = {};
 		job->asset_job = asset_job;
 		job->data      = data;
+		job->bytes     = bytes;
+		// The calling thread is stalled until this finishes, which is worse
+		// than any queued upload waiting a little longer.
+		job->priority  = INT_MIN;
 
-		ft_mutex_lock(assets_job_lock);
-		assets_gpu_jobs.add(job);
-		ft_mutex_unlock(assets_job_lock);
+		assets_queue_gpu_job(job);
 
 		// Block until the GPU thread has had a chance to take care of the job.
 		uint64_t start      = stm_now();
@@ -489,6 +623,28 @@ bool32_t assets_execute_gpu(bool32_t(*asset_job)(void *data), void *data) {
 
 ///////////////////////////////////////////
 
+uint64_t assets_execute_gpu_async(bool32_t(*asset_job)(void *data), void (*free_data)(void *data), void *data, uint64_t bytes) {
+	if (ft_id_matches(sk_main_thread())) {
+		asset_job(data);
+		free_data(data);
+		return 0;
+	}
+
+	// Async jobs all share a priority, so they stay in the order they were
+	// queued, and a fence is finished once the queue has gotten past it.
+	asset_job_t *job = sk_malloc_t(asset_job_t, 1);
+	*job = {};
+	job->asset_job = asset_job;
+	job->free_data = free_data;
+	job->data      = data;
+	job->bytes     = bytes;
+	job->priority  = 0;
+
+	return assets_queue_gpu_job(job);
+}
+
+///////////////////////////////////////////
+
 int32_t assets_current_task() {
 	return asset_tasks_finished;
 }
@@ -507,6 +663,56 @@ int32_t assets_current_task_priority() {
 
 ///////////////////////////////////////////
 
+static void assets_memory_usage(asset_header_t *asset, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	switch (asset->type) {
+	case asset_type_mesh:        mesh_memory_usage       ((mesh_t       )asset, out_cpu_bytes, out_gpu_bytes); break;
+	case asset_type_tex:         tex_memory_usage        ((tex_t        )asset, out_cpu_bytes, out_gpu_bytes); break;
+	case asset_type_material:    material_memory_usage   ((material_t   )asset, out_cpu_bytes, out_gpu_bytes); break;
+	case asset_type_model:       model_memory_usage      ((model_t      )asset, out_cpu_bytes, out_gpu_bytes); break;
+	case asset_type_font:        font_memory_usage       ((font_t       )asset, out_cpu_bytes, out_gpu_bytes); break;
+	case asset_type_sound:       sound_memory_usage      ((sound_t      )asset, out_cpu_bytes, out_gpu_bytes); break;
+	case asset_type_point_cloud: point_cloud_memory_usage((point_cloud_t)asset, out_cpu_bytes, out_gpu_bytes); break;
+	default:
+		*out_cpu_bytes = assets_type_size(asset->type);
+		*out_gpu_bytes = 0;
+		break;
+	}
+	if (asset->id_text != nullptr)
+		*out_cpu_bytes += strlen(asset->id_text) + 1;
+}
+
+///////////////////////////////////////////
+
+int32_t assets_memory_report(asset_memory_t *out_arr_report, int32_t report_capacity) {
+	int32_t count = out_arr_report == nullptr ? 0
+		: report_capacity < assets.count ? report_capacity : assets.count;
+	for (int32_t i = 0; i < count; i++) {
+		asset_memory_t *item = &out_arr_report[i];
+		item->asset = assets[i];
+		item->type  = assets[i]->type;
+		assets_memory_usage(assets[i], &item->cpu_bytes, &item->gpu_bytes);
+	}
+	return assets.count;
+}
+
+///////////////////////////////////////////
+
+void assets_memory_totals(asset_type_ type, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	uint64_t cpu_total = 0;
+	uint64_t gpu_total = 0;
+	for (int32_t i = 0; i < assets.count; i++) {
+		if (type != asset_type_none && assets[i]->type != type) continue;
+		uint64_t cpu, gpu;
+		assets_memory_usage(assets[i], &cpu, &gpu);
+		cpu_total += cpu;
+		gpu_total += gpu;
+	}
+	if (out_cpu_bytes != nullptr) *out_cpu_bytes = cpu_total;
+	if (out_gpu_bytes != nullptr) *out_gpu_bytes = gpu_total;
+}
+
+///////////////////////////////////////////
+
 int32_t assets_count() {
 	return assets.count;
 }
@@ -565,7 +771,9 @@ void asset_release(asset_t asset) {
 void assets_add_task(asset_task_t src_task) {
 	asset_task_t *task = sk_malloc_t(asset_task_t, 1);
 	memcpy(task, &src_task, sizeof(asset_task_t));
-	assets_addref(task->asset);
+	// Tasks without an asset are plain background work, like async file
+	// reads.
+	if (task->asset != nullptr) assets_addref(task->asset);
 
 	ft_mutex_lock(asset_thread_task_mtx);
 
@@ -595,6 +803,14 @@ void assets_add_task(asset_task_t src_task) {
 
 ///////////////////////////////////////////
 
+void assets_add_subtask(asset_task_t *parent, asset_task_t task) {
+	atomic_increment(&parent->join_count);
+	task.join_parent = parent;
+	assets_add_task(task);
+}
+
+///////////////////////////////////////////
+
 int32_t assets_calculate_current_priority() {
 	int32_t result = INT_MAX;
 	for (int32_t i = 0; i < asset_active_tasks.count; i++) {
@@ -619,6 +835,7 @@ asset_task_t* assets_acquire_task() {
 	for (int32_t i = 0; i < asset_thread_tasks.count; i++) {
 		asset_task_t*        task   = asset_thread_tasks[i];
 		asset_load_action_t* action = &task->actions[task->action_curr];
+		if (task->join_count > 0) continue;
 		if (action->thread_affinity != asset_thread_gpu || task->gpu_started == false || task->gpu_job.finished) {
 			result = task;
 			asset_thread_tasks.remove(i);
@@ -658,14 +875,18 @@ void assets_complete_task(asset_task_t* task) {
 
 	// If it was successfully loaded, we'll want to notify on_load, but we do
 	// want to skip this if it was removed because of an issue during load.
-	if (task->asset->state >= asset_state_loaded) {
+	if (task->asset != nullptr && task->asset->state >= asset_state_loaded) {
 		ft_mutex_lock(assets_load_event_lock);
 		assets_load_events.add(task->asset);
 		ft_mutex_unlock(assets_load_event_lock);
 	}
 
 	if (task->free_data != nullptr) task->free_data(task->asset, task->load_data);
-	assets_releaseref_threadsafe(task->asset);
+	if (task->asset != nullptr) assets_releaseref_threadsafe(task->asset);
+
+	// The parent may be waiting on this one before it can continue
+	if (task->join_parent != nullptr && atomic_decrement(&task->join_parent->join_count) == 0)
+		ft_condition_broadcast(asset_tasks_available);
 	sk_free(task);
 }
 
@@ -676,6 +897,123 @@ void assets_task_set_complexity(asset_task_t *task, int32_t complexity) {
 
 ///////////////////////////////////////////
 
+bool assets_upload_budget_left() {
+	return assets_upload_budget_ms <= 0
+		|| stm_ms(stm_since(assets_upload_start)) < assets_upload_budget_ms;
+}
+
+///////////////////////////////////////////
+
+void assets_upload_budget_spend(uint64_t bytes) {
+	assets_upload_frame.jobs_done  += 1;
+	assets_upload_frame.bytes_done += bytes;
+	assets_upload_frame.frame_ms    = (float)stm_ms(stm_since(assets_upload_start));
+}
+
+///////////////////////////////////////////
+
+void assets_set_upload_budget(float milliseconds) {
+	assets_upload_budget_ms = milliseconds;
+}
+
+///////////////////////////////////////////
+
+float assets_get_upload_budget() {
+	return assets_upload_budget_ms;
+}
+
+///////////////////////////////////////////
+
+bool32_t assets_fence_finished(asset_fence_t fence) {
+	// assets_job_lock is held while the GPU jobs run, so this stays off it
+	// to let other threads poll without waiting on a whole frame of uploads.
+	return fence <= (asset_fence_t)atomic_add64(&assets_gpu_fence_done, 0);
+}
+
+///////////////////////////////////////////
+
+void assets_fence_wait(asset_fence_t fence) {
+	if (ft_id_matches(sk_main_thread())) {
+		// Nobody else is going to run the queue while we wait on it
+		while (!assets_fence_finished(fence))
+			assets_step();
+	} else {
+		while (!assets_fence_finished(fence))
+			ft_yield();
+	}
+}
+
+///////////////////////////////////////////
+
+void *assets_staging_alloc(size_t size) {
+	size_t size_16 = (size + 15) & ~(size_t)15;
+	size_t need    = sizeof(asset_staging_header_t) + size_16;
+
+	ft_mutex_lock(assets_staging_lock);
+	asset_staging_block_t *block = nullptr;
+	if (need > assets_staging_block_size) {
+		block = sk_malloc_zero_t(asset_staging_block_t, 1);
+		block->size   = need;
+		block->memory = sk_malloc_t(uint8_t, need);
+	} else {
+		if (assets_staging_curr == nullptr || assets_staging_curr->used + need > assets_staging_curr->size) {
+			// A full block is retired once its last copy is freed, unless
+			// that's already happened.
+			if (assets_staging_curr != nullptr && assets_staging_curr->live == 0) {
+				assets_staging_curr->used = 0;
+			} else if (assets_staging_free_blocks.count > 0) {
+				assets_staging_curr = assets_staging_free_blocks.last();
+				assets_staging_free_blocks.pop();
+			} else {
+				assets_staging_curr = sk_malloc_zero_t(asset_staging_block_t, 1);
+				assets_staging_curr->size   = assets_staging_block_size;
+				assets_staging_curr->memory = sk_malloc_t(uint8_t, assets_staging_block_size);
+			}
+		}
+		block = assets_staging_curr;
+	}
+	asset_staging_header_t *header = (asset_staging_header_t *)(block->memory + block->used);
+	header->block = block;
+	block->used  += need;
+	block->live  += 1;
+	ft_mutex_unlock(assets_staging_lock);
+
+	return header + 1;
+}
+
+///////////////////////////////////////////
+
+void assets_staging_free(void *memory) {
+	if (memory == nullptr) return;
+	asset_staging_block_t *block = ((asset_staging_header_t *)memory - 1)->block;
+
+	ft_mutex_lock(assets_staging_lock);
+	block->live -= 1;
+	if (block->live == 0 && block != assets_staging_curr) {
+		if (block->size == assets_staging_block_size && assets_staging_free_blocks.count < assets_staging_max_free) {
+			block->used = 0;
+			assets_staging_free_blocks.add(block);
+		} else {
+			sk_free(block->memory);
+			sk_free(block);
+		}
+	}
+	ft_mutex_unlock(assets_staging_lock);
+}
+
+///////////////////////////////////////////
+
+assets_upload_stats_t assets_get_upload_stats() {
+	assets_upload_stats_t result = assets_upload_frame;
+	ft_mutex_lock(assets_job_lock);
+	result.jobs_queued  = assets_gpu_jobs.count;
+	result.bytes_queued = assets_gpu_jobs_bytes;
+	ft_mutex_unlock(assets_job_lock);
+	return result;
+}
+
+///////////////////////////////////////////
+
 void asset_step_task() {
 	asset_task_t* task = assets_acquire_task();
 	if (task == nullptr) return;
@@ -700,7 +1038,9 @@ void asset_step_task() {
 			task->gpu_started = true;
 
 			// Set up a job for the GPU thread
-			task->gpu_job.data = task;
+			task->gpu_job.data     = task;
+			task->gpu_job.priority = task->priority;
+			task->gpu_job.bytes    = task->upload_bytes;
 			task->gpu_job.asset_job = [](void* data) {
 				asset_task_t* task = (asset_task_t*)data;
 				asset_load_action_t* action = &task->actions[task->action_curr];
@@ -710,14 +1050,12 @@ void asset_step_task() {
 			};
 
 			// Add the job to the list
-			ft_mutex_lock(assets_job_lock);
-			assets_gpu_jobs.add(&task->gpu_job);
-			ft_mutex_unlock(assets_job_lock);
+			assets_queue_gpu_job(&task->gpu_job);
 		} else if (task->gpu_job.finished) {
 			if (task->gpu_job.success == false) {
 				// On failure, send an error message, and move to
 				// the end of the action list.
-				task->asset->state = asset_state_error;
+				if (task->asset != nullptr) task->asset->state = asset_state_error;
 				if (task->on_failure != nullptr) task->on_failure(task->asset, task->load_data);
 				task->action_curr = task->action_count;
 			}
@@ -725,8 +1063,9 @@ void asset_step_task() {
 				// On success, move to the next action in the task!
 				task->action_curr += 1;
 			}
-			task->gpu_job = {};
-			task->gpu_started = false;
+			task->gpu_job      = {};
+			task->gpu_started  = false;
+			task->upload_bytes = 0;
 		}
 	}
 
@@ -12,6 +12,8 @@ struct asset_header_t {
 	uint64_t     index;
 	int32_t      refs;
 	char        *id_text;
+	// Set when the asset can be found by its content, see asset_dedup.h
+	uint64_t     content_hash;
 };
 
 struct asset_job_t {
@@ -19,6 +21,13 @@ struct asset_job_t {
 	bool32_t  success;
 	void     *data;
 	bool32_t(*asset_job)(void *data);
+	// Lower runs first, and bytes is an estimate for the upload budget
+	int32_t   priority;
+	uint64_t  bytes;
+	// Only set for fire-and-forget jobs, which the queue owns and frees
+	// once they've run.
+	void    (*free_data)(void *data);
+	uint64_t  fence;
 };
 
 typedef enum asset_thread_ {
@@ -45,6 +54,12 @@ struct asset_task_t {
 	int64_t              sort;
 	asset_job_t          gpu_job;
 	bool32_t             gpu_started;
+	// Estimated size of the next GPU action's upload, actions can fill this
+	// in once they know it.
+	uint64_t             upload_bytes;
+	// Subtasks that need to finish before the next action can run
+	int32_t              join_count;
+	asset_task_t        *join_parent;
 };
 
 void *assets_find          (const char *id, asset_type_ type);
@@ -67,10 +82,26 @@ void  assets_on_load_remove(asset_header_t *asset, void (*on_load)(asset_header_
 
 // This function will block execution until `asset_job` is finished, but will
 // ensure it is run on the GPU thread.
-bool32_t assets_execute_gpu        (bool32_t (*asset_job)(void *data), void *data);
+bool32_t assets_execute_gpu        (bool32_t (*asset_job)(void *data), void *data, uint64_t bytes = 0);
+// Queues `asset_job` for the GPU thread without waiting on it, `free_data`
+// is called on the GPU thread once it's done. Returns a fence for the job,
+// or 0 if it could run right away.
+uint64_t assets_execute_gpu_async  (bool32_t (*asset_job)(void *data), void (*free_data)(void *data), void *data, uint64_t bytes);
+// Memory for async jobs to copy their data into, so callers can reuse their
+// own buffers right away. Thread safe.
+void    *assets_staging_alloc      (size_t size);
+void     assets_staging_free       (void *memory);
 void     assets_add_task           (asset_task_t task);
+// Queues work that's part of parent's current action, so it can spread
+// across asset threads. The parent's next action waits until all of its
+// subtasks have completed, successful or not.
+void     assets_add_subtask        (asset_task_t *parent, asset_task_t task);
 void     assets_task_set_complexity(asset_task_t *task, int32_t priority);
 void     assets_block_until        (asset_header_t *asset, asset_state_ state);
+// Main thread GPU work that doesn't go through the job queue, like mip
+// streaming, shares the per-frame upload budget through these.
+bool     assets_upload_budget_left ();
+void     assets_upload_budget_spend(uint64_t bytes);
 
 inline int64_t asset_sort(int32_t priority, int32_t complexity) { return ((int64_t)priority << 32) | ((int64_t)complexity); }
 
@@ -268,6 +268,17 @@ void font_release(font_t font) {
 
 ///////////////////////////////////////////
 
+void font_memory_usage(font_t font, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	// The atlas texture is its own asset, and reports its own GPU memory
+	*out_cpu_bytes = sizeof(_font_t)
+		+ (font->atlas_data != nullptr ? (uint64_t)font->atlas.w * font->atlas.h : 0)
+		+ sizeof(font_glyph_t) * font->update_queue.capacity
+		+ sizeof(int32_t     ) * font->font_ids    .capacity;
+	*out_gpu_bytes = 0;
+}
+
+///////////////////////////////////////////
+
 void font_destroy(font_t font) {
 	int32_t idx = font_list.index_of(font);
 	if (idx >= 0)
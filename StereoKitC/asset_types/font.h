@@ -38,6 +38,7 @@ struct _font_t {
 
 font_t font_create_default();
 void   font_destroy       (font_t font);
+void   font_memory_usage  (font_t font, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
 void   font_update_fonts  ();
 
 const font_char_t *font_get_glyph(font_t font, char32_t character);
@@ -225,6 +225,13 @@ void material_release(material_t material) {
 
 ///////////////////////////////////////////
 
+void material_memory_usage(material_t material, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	*out_cpu_bytes = sizeof(_material_t) + material->args.buffer_size + sizeof(shaderargs_tex_t) * material->args.texture_count;
+	*out_gpu_bytes = skg_buffer_is_valid(&material->args.buffer_gpu) ? material->args.buffer_size : 0;
+}
+
+///////////////////////////////////////////
+
 void material_destroy(material_t material) {
 	if (material->chain) material_release(material->chain);
 	for (int32_t i = 0; i < material->args.texture_count; i++) {
@@ -42,6 +42,7 @@ struct _material_buffer_t {
 };
 
 void   material_destroy          (material_t material);
+void   material_memory_usage     (material_t material, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
 void   material_check_dirty      (material_t material);
 void   material_check_tex_changes(material_t material);
 size_t material_param_size       (material_param_ type);
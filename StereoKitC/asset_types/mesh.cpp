@@ -1,9 +1,14 @@
 #include "../stereokit.h"
+#include "../_stereokit.h"
 #include "../sk_memory.h"
 #include "../sk_math.h"
 #include "../sk_math_dx.h"
 #include "mesh.h"
 #include "assets.h"
+#include "../systems/parallel.h"
+#include "../systems/render.h"
+#include "../utils/mesh_optimize.h"
+#include "../libraries/ferr_thread.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -16,7 +21,10 @@ using namespace DirectX;
 
 namespace sk {
 
-void mesh_update_label(mesh_t mesh);
+void mesh_update_label     (mesh_t mesh);
+void _mesh_clear_bvh       (mesh_t mesh);
+void _mesh_clear_collision (mesh_t mesh);
+void _mesh_buffer_destroy  (mesh_buffer_t *buffer);
 
 ///////////////////////////////////////////
 
@@ -29,7 +37,14 @@ void mesh_set_keep_data(mesh_t mesh, bool32_t keep_data) {
 	mesh->discard_data = !keep_data;
 	if (mesh->discard_data) {
 		sk_free(mesh->verts);
-		sk_free(mesh->inds );
+		// Collision data indexes into our index data, so if it exists, it
+		// takes ownership of the indices instead of us freeing them.
+		if (mesh->collision_data.pts != nullptr && mesh->collision_data.owned_inds == nullptr) {
+			mesh->collision_data.owned_inds = mesh->inds;
+			mesh->inds = nullptr;
+		} else {
+			sk_free(mesh->inds);
+		}
 	}
 }
 
@@ -41,46 +56,165 @@ bool32_t mesh_get_keep_data(mesh_t mesh) {
 
 ///////////////////////////////////////////
 
-void _mesh_set_verts(mesh_t mesh, const vert_t *vertices, uint32_t vertex_count, bool32_t calculate_bounds, bool update_original) {
-	// Keep track of vertex data for use on CPU side
-	if (!mesh->discard_data && update_original) {
-		if (mesh->vert_capacity < vertex_count)
-			mesh->verts = sk_realloc_t(vert_t, mesh->verts, vertex_count);
-		memcpy(mesh->verts, vertices, sizeof(vert_t) * vertex_count);
+void mesh_set_keep_verts(mesh_t mesh, bool32_t keep_verts) {
+	if (mesh_has_skin(mesh) && !keep_verts) {
+		log_warn("Skinned meshes must keep their vertices, ignoring mesh_set_keep_verts call.");
+		return;
 	}
 
-	if (!skg_buffer_is_valid( &mesh->vert_buffer )) {
-		// Create a static vertex buffer the first time we call this function!
-		mesh->vert_dynamic  = false;
-		mesh->vert_capacity = vertex_count;
-		mesh->vert_buffer   = skg_buffer_create(vertices, vertex_count, sizeof(vert_t), skg_buffer_type_vertex, skg_use_static);
-		if (!skg_buffer_is_valid(&mesh->vert_buffer))
-			log_err("mesh_set_verts: Failed to create vertex buffer");
-		skg_mesh_set_verts(&mesh->gpu_mesh, &mesh->vert_buffer);
-		mesh_update_label(mesh);
-	} else if (mesh->vert_dynamic == false || vertex_count > mesh->vert_capacity) {
-		// If they call this a second time, or they need more verts than will
-		// fit in this buffer, lets make a new dynamic buffer!
-		skg_buffer_destroy(&mesh->vert_buffer);
-		mesh->vert_dynamic  = true;
-		mesh->vert_capacity = vertex_count;
-		mesh->vert_buffer   = skg_buffer_create(vertices, vertex_count, sizeof(vert_t), skg_buffer_type_vertex, skg_use_dynamic);
-		if (!skg_buffer_is_valid(&mesh->vert_buffer))
-			log_err("mesh_set_verts: Failed to create dynamic vertex buffer");
-		skg_mesh_set_verts(&mesh->gpu_mesh, &mesh->vert_buffer);
-		mesh_update_label(mesh);
-	} else {
-		// And if they call this a third time, or their verts fit in the same
-		// buffer, just copy things over!
-		skg_buffer_set_contents(&mesh->vert_buffer, vertices, sizeof(vert_t)*vertex_count);
+	mesh->discard_verts = !keep_verts;
+	if (mesh->discard_verts) {
+		// Make sure the position-only collision copy exists before we lose
+		// the full vertices it's built from.
+		mesh_get_collision_data(mesh);
+		sk_free(mesh->verts);
+	}
+}
+
+///////////////////////////////////////////
+
+bool32_t mesh_get_keep_verts(mesh_t mesh) {
+	return !mesh->discard_verts;
+}
+
+///////////////////////////////////////////
+
+void _mesh_buffer_destroy(mesh_buffer_t *buffer) {
+	for (int32_t i = 0; i < MESH_BUFFER_RING; i++)
+		skg_buffer_destroy(&buffer->buffers[i]);
+	*buffer = {};
+}
+
+///////////////////////////////////////////
+
+// Uploads elements to the mesh's GPU buffer. `data` must hold the complete
+// current contents from 0 to `count`, while `dirty_start`/`dirty_end` marks
+// which elements actually changed. Returns the buffer that should now be
+// bound to the mesh, or nullptr if the bound buffer hasn't changed.
+const skg_buffer_t *_mesh_buffer_update(mesh_buffer_t *buffer, skg_buffer_type_ type, uint32_t stride, const void *data, uint32_t count, uint32_t dirty_start, uint32_t dirty_end) {
+	if (!skg_buffer_is_valid( &buffer->buffers[buffer->curr] )) {
+		// Create a static buffer the first time we call this function!
+		buffer->dynamic    = false;
+		buffer->capacity   = count;
+		buffer->buffers[0] = skg_buffer_create(data, count, stride, type, skg_use_static);
+		render_stats_upload((uint64_t)count * stride, true);
+		return &buffer->buffers[0];
+	}
+
+	if (buffer->dynamic == false || count > buffer->capacity) {
+		// If they call this a second time, or they need more elements than
+		// will fit in this buffer, lets make new dynamic buffers! Dynamic
+		// buffers grow geometrically, so growing meshes like text or lines
+		// don't recreate their buffers on every new element.
+		uint32_t capacity = count;
+		if (buffer->dynamic && capacity < buffer->capacity + buffer->capacity / 2)
+			capacity = buffer->capacity + buffer->capacity / 2;
+
+		_mesh_buffer_destroy(buffer);
+		buffer->dynamic    = true;
+		buffer->capacity   = capacity;
+		buffer->curr_frame = time_frame();
+		buffer->buffers[0] = skg_buffer_create(nullptr, capacity, stride, type, skg_use_dynamic);
+		if (!skg_buffer_is_valid( &buffer->buffers[0] ))
+			return &buffer->buffers[0];
+		skg_buffer_set_contents(&buffer->buffers[0], data, count * stride);
+		for (int32_t i = 1; i < MESH_BUFFER_RING; i++) {
+			buffer->dirty_start[i] = 0;
+			buffer->dirty_end  [i] = count;
+		}
+		render_stats_upload((uint64_t)count * stride, true);
+		return &buffer->buffers[0];
+	}
+
+	// All the other buffers in the ring are now missing this update too.
+	for (int32_t i = 0; i < MESH_BUFFER_RING; i++) {
+		if (buffer->dirty_start[i] >= buffer->dirty_end[i]) {
+			buffer->dirty_start[i] = dirty_start;
+			buffer->dirty_end  [i] = dirty_end;
+		} else {
+			if (dirty_start < buffer->dirty_start[i]) buffer->dirty_start[i] = dirty_start;
+			if (dirty_end   > buffer->dirty_end  [i]) buffer->dirty_end  [i] = dirty_end;
+		}
+	}
+
+	// The first update of each frame moves on to the next buffer in the
+	// ring, the previous one may still be in use by the GPU.
+	bool     created = false;
+	bool     rotated = false;
+	uint64_t frame   = time_frame();
+	if (buffer->curr_frame != frame) {
+		buffer->curr       = (buffer->curr + 1) % MESH_BUFFER_RING;
+		buffer->curr_frame = frame;
+		rotated            = true;
+	}
+	skg_buffer_t *dest = &buffer->buffers[buffer->curr];
+	if (!skg_buffer_is_valid(dest)) {
+		*dest   = skg_buffer_create(nullptr, buffer->capacity, stride, type, skg_use_dynamic);
+		created = true;
+		buffer->dirty_start[buffer->curr] = 0;
+		buffer->dirty_end  [buffer->curr] = count;
+		if (!skg_buffer_is_valid(dest))
+			return dest;
 	}
 
+	uint32_t start = buffer->dirty_start[buffer->curr];
+	uint32_t end   = buffer->dirty_end  [buffer->curr] < count ? buffer->dirty_end[buffer->curr] : count;
+	if (start < end && (start != 0 || end != count)) {
+		// The backend may refuse a partial update, such as a D3D deferred
+		// context that hasn't discarded this buffer yet this frame. Fall
+		// back to uploading the whole thing.
+		if (!skg_buffer_set_contents_range(dest, (const uint8_t*)data + start * stride, start * stride, (end - start) * stride)) {
+			start = 0;
+			end   = count;
+		}
+	}
+	if (start == 0 && end == count) {
+		skg_buffer_set_contents(dest, data, count * stride);
+	}
+	buffer->dirty_start[buffer->curr] = 0;
+	buffer->dirty_end  [buffer->curr] = 0;
+	if (start < end) render_stats_upload((uint64_t)(end - start) * stride, created);
+
+	return rotated || created ? dest : nullptr;
+}
+
+///////////////////////////////////////////
+
+void _mesh_set_verts(mesh_t mesh, const vert_t *vertices, uint32_t vertex_count, bool32_t calculate_bounds, bool update_original) {
+	uint32_t prev_capacity = mesh->vert_buffer.capacity;
+	const skg_buffer_t *bind = _mesh_buffer_update(&mesh->vert_buffer, skg_buffer_type_vertex, sizeof(vert_t), vertices, vertex_count, 0, vertex_count);
+	if (bind != nullptr) {
+		if (!skg_buffer_is_valid(bind))
+			log_err("mesh_set_verts: Failed to create vertex buffer");
+		skg_mesh_set_verts(&mesh->gpu_mesh, bind);
+		if (prev_capacity != mesh->vert_buffer.capacity)
+			mesh_update_label(mesh);
+	}
 	mesh->vert_count = vertex_count;
 
+	// Keep track of vertex data for use on CPU side, this is sized to match
+	// the GPU buffer capacity, so range updates always fit.
+	if (!mesh->discard_data && !mesh->discard_verts && update_original) {
+		if (prev_capacity != mesh->vert_buffer.capacity || mesh->verts == nullptr)
+			mesh->verts = sk_realloc_t(vert_t, mesh->verts, mesh->vert_buffer.capacity);
+		memcpy(mesh->verts, vertices, sizeof(vert_t) * vertex_count);
+	}
+	// Existing collision data gets refreshed in place, it may be the only
+	// CPU copy of the positions left.
+	mesh_collision_t &coll = mesh->collision_data;
+	if (coll.pts != nullptr && update_original) {
+		if (coll.pt_count != vertex_count)
+			coll.pts = sk_realloc_t(vec3, coll.pts, vertex_count);
+		for (uint32_t i = 0; i < vertex_count; i++) coll.pts[i] = vertices[i].pos;
+		coll.pt_count = vertex_count;
+		_mesh_clear_bvh(mesh);
+	}
+
 	if (calculate_bounds && vertex_count > 0) {
 		mesh->bounds = mesh_calculate_bounds(vertices, vertex_count);
 	}
 }
+
 ///////////////////////////////////////////
 
 void mesh_set_verts(mesh_t mesh, const vert_t *vertices, int32_t vertex_count, bool32_t calculate_bounds) {
@@ -102,6 +236,61 @@ void mesh_set_verts(mesh_t mesh, const vert_t *vertices, int32_t vertex_count, b
 
 ///////////////////////////////////////////
 
+void _mesh_set_verts_range(mesh_t mesh, uint32_t vertex_start, const vert_t *vertices, uint32_t vertex_count, bool32_t calculate_bounds) {
+	// Partial GPU updates are filled in from the CPU side copy, so that's
+	// required here.
+	if (mesh->verts == nullptr) {
+		log_err("mesh_set_verts_range: can't work with a mesh that doesn't keep data, ensure mesh_get_keep_data() is true");
+		return;
+	}
+	if (vertex_start + vertex_count > mesh->vert_count) {
+		log_errf("mesh_set_verts_range: range %u-%u is outside the mesh's %u vertices", vertex_start, vertex_start + vertex_count, mesh->vert_count);
+		return;
+	}
+
+	memcpy(&mesh->verts[vertex_start], vertices, sizeof(vert_t) * vertex_count);
+	mesh_collision_t &coll = mesh->collision_data;
+	if (coll.pts != nullptr) {
+		for (uint32_t i = 0; i < vertex_count; i++) coll.pts[vertex_start + i] = vertices[i].pos;
+		_mesh_clear_bvh(mesh);
+	}
+
+	const skg_buffer_t *bind = _mesh_buffer_update(&mesh->vert_buffer, skg_buffer_type_vertex, sizeof(vert_t), mesh->verts, mesh->vert_count, vertex_start, vertex_start + vertex_count);
+	if (bind != nullptr) {
+		if (!skg_buffer_is_valid(bind))
+			log_err("mesh_set_verts_range: Failed to create vertex buffer");
+		skg_mesh_set_verts(&mesh->gpu_mesh, bind);
+	}
+
+	if (calculate_bounds && mesh->vert_count > 0) {
+		mesh->bounds = mesh_calculate_bounds(mesh->verts, mesh->vert_count);
+	}
+}
+
+///////////////////////////////////////////
+
+void mesh_set_verts_range(mesh_t mesh, int32_t vertex_start, const vert_t *vertices, int32_t vertex_count, bool32_t calculate_bounds) {
+	if (vertex_start < 0 || vertex_count <= 0) return;
+
+	struct vert_range_job_t {
+		mesh_t        mesh;
+		int32_t       vertex_start;
+		const vert_t *vertices;
+		int32_t       vertex_count;
+		bool32_t      calculate_bounds;
+	};
+	vert_range_job_t job_data = {mesh, vertex_start, vertices, vertex_count, calculate_bounds};
+
+	assets_execute_gpu([](void *data) {
+		vert_range_job_t *job_data = (vert_range_job_t *)data;
+		_mesh_set_verts_range(job_data->mesh, job_data->vertex_start, job_data->vertices, job_data->vertex_count, job_data->calculate_bounds);
+
+		return (bool32_t)true;
+	}, &job_data);
+}
+
+///////////////////////////////////////////
+
 void mesh_get_verts(mesh_t mesh, vert_t *&out_vertices, int32_t &out_vertex_count, memory_ reference_mode) {
 	out_vertex_count = mesh->verts == nullptr ? 0 : mesh->vert_count;
 	out_vertices     = nullptr;
@@ -128,37 +317,42 @@ void _mesh_set_inds (mesh_t mesh, const vind_t *indices, uint32_t index_count) {
 		return;
 	}
 
+	// Going back to our own indices, the shared buffer is still bound, so
+	// make sure we bind a new one.
+	if (mesh->shared_inds != nullptr) {
+		mesh_release(mesh->shared_inds);
+		mesh->shared_inds = nullptr;
+		_mesh_buffer_destroy(&mesh->ind_buffer);
+	}
+
+	uint32_t prev_capacity = mesh->ind_buffer.capacity;
+	const skg_buffer_t *bind = _mesh_buffer_update(&mesh->ind_buffer, skg_buffer_type_index, sizeof(vind_t), indices, index_count, 0, index_count);
+	if (bind != nullptr) {
+		if (!skg_buffer_is_valid(bind))
+			log_err("mesh_set_inds: Failed to create index buffer");
+		skg_mesh_set_inds(&mesh->gpu_mesh, bind);
+		if (prev_capacity != mesh->ind_buffer.capacity)
+			mesh_update_label(mesh);
+	}
+
 	// Keep track of index data for use on CPU side
 	if (!mesh->discard_data) {
-		if (mesh->ind_capacity < index_count)
-			mesh->inds = sk_realloc_t(vind_t, mesh->inds, index_count);
+		if (prev_capacity != mesh->ind_buffer.capacity || mesh->inds == nullptr)
+			mesh->inds = sk_realloc_t(vind_t, mesh->inds, mesh->ind_buffer.capacity);
 		memcpy(mesh->inds, indices, sizeof(vind_t) * index_count);
 	}
-
-	if (!skg_buffer_is_valid( &mesh->ind_buffer )) {
-		// Create a static vertex buffer the first time we call this function!
-		mesh->ind_dynamic  = false;
-		mesh->ind_capacity = index_count;
-		mesh->ind_buffer   = skg_buffer_create(indices, index_count, sizeof(vind_t), skg_buffer_type_index, skg_use_static);
-		if (!skg_buffer_is_valid( &mesh->ind_buffer ))
-			log_err("mesh_set_inds: Failed to create index buffer");
-		skg_mesh_set_inds(&mesh->gpu_mesh, &mesh->ind_buffer);
-		mesh_update_label(mesh);
-	} else if (mesh->ind_dynamic == false || index_count > mesh->ind_capacity) {
-		// If they call this a second time, or they need more inds than will
-		// fit in this buffer, lets make a new dynamic buffer!
-		skg_buffer_destroy(&mesh->ind_buffer);
-		mesh->ind_dynamic  = true;
-		mesh->ind_capacity = index_count;
-		mesh->ind_buffer   = skg_buffer_create(indices, index_count, sizeof(vind_t), skg_buffer_type_index, skg_use_dynamic);
-		if (!skg_buffer_is_valid( &mesh->ind_buffer ))
-			log_err("mesh_set_inds: Failed to create dynamic index buffer");
-		skg_mesh_set_inds(&mesh->gpu_mesh, &mesh->ind_buffer);
-		mesh_update_label(mesh);
-	} else {
-		// And if they call this a third time, or their inds fit in the same
-		// buffer, just copy things over!
-		skg_buffer_set_contents(&mesh->ind_buffer, indices, sizeof(vind_t) * index_count);
+	// Collision data references our indices, so it needs to follow them.
+	mesh_collision_t &coll = mesh->collision_data;
+	if (coll.pts != nullptr) {
+		if (coll.owned_inds != nullptr) {
+			coll.owned_inds = sk_realloc_t(vind_t, coll.owned_inds, index_count);
+			memcpy(coll.owned_inds, indices, sizeof(vind_t) * index_count);
+			coll.inds = coll.owned_inds;
+		} else {
+			coll.inds = mesh->inds;
+		}
+		coll.ind_count = index_count;
+		_mesh_clear_bvh(mesh);
 	}
 
 	mesh->ind_count = index_count;
@@ -185,6 +379,44 @@ void mesh_set_inds(mesh_t mesh, const vind_t *indices,  int32_t index_count) {
 
 ///////////////////////////////////////////
 
+void _mesh_share_inds(mesh_t mesh, mesh_t ind_source, uint32_t index_count) {
+	if (index_count % 3 != 0 || index_count > ind_source->ind_count || ind_source->shared_inds != nullptr) {
+		log_err("mesh_share_inds: the source must have its own indices, and at least index_count of them!");
+		return;
+	}
+
+	mesh_addref(ind_source);
+	mesh_release(mesh->shared_inds);
+	_mesh_buffer_destroy(&mesh->ind_buffer);
+	_mesh_clear_collision(mesh);
+	sk_free(mesh->inds);
+	mesh->inds        = nullptr;
+	mesh->shared_inds = ind_source;
+	skg_mesh_set_inds(&mesh->gpu_mesh, &ind_source->ind_buffer.buffers[ind_source->ind_buffer.curr]);
+
+	mesh->ind_count = index_count;
+	mesh->ind_draw  = index_count;
+}
+
+///////////////////////////////////////////
+
+void mesh_share_inds(mesh_t mesh, mesh_t ind_source, int32_t index_count) {
+	struct ind_share_job_t {
+		mesh_t  mesh;
+		mesh_t  ind_source;
+		int32_t index_count;
+	};
+	ind_share_job_t job_data = {mesh, ind_source, index_count};
+
+	assets_execute_gpu([](void *data) {
+		ind_share_job_t *job_data = (ind_share_job_t *)data;
+		_mesh_share_inds(job_data->mesh, job_data->ind_source, job_data->index_count);
+		return (bool32_t)true;
+	}, &job_data);
+}
+
+///////////////////////////////////////////
+
 void mesh_set_data(mesh_t mesh, const vert_t *vertices, int32_t vertex_count, const vind_t *indices, int32_t index_count, bool32_t calculate_bounds) {
 	struct mesh_upload_job_t {
 		mesh_t        mesh;
@@ -207,6 +439,70 @@ void mesh_set_data(mesh_t mesh, const vert_t *vertices, int32_t vertex_count, co
 
 ///////////////////////////////////////////
 
+asset_fence_t mesh_set_data_async(mesh_t mesh, const vert_t *vertices, int32_t vertex_count, const vind_t *indices, int32_t index_count, bool32_t calculate_bounds) {
+	if (ft_id_matches(sk_main_thread())) {
+		mesh_set_data(mesh, vertices, vertex_count, indices, index_count, calculate_bounds);
+		return 0;
+	}
+
+	// The job and copies of the data share one staging allocation, so the
+	// caller is free to reuse its buffers as soon as this returns.
+	struct mesh_async_job_t {
+		mesh_t   mesh;
+		vert_t  *vertices;
+		int32_t  vertex_count;
+		vind_t  *indices;
+		int32_t  index_count;
+		bool32_t calculate_bounds;
+	};
+	size_t vert_size = sizeof(vert_t) * vertex_count;
+	size_t ind_size  = sizeof(vind_t) * index_count;
+	mesh_async_job_t *job_data = (mesh_async_job_t *)assets_staging_alloc(sizeof(mesh_async_job_t) + vert_size + ind_size);
+	job_data->mesh             = mesh;
+	job_data->vertices         = (vert_t *)(job_data + 1);
+	job_data->vertex_count     = vertex_count;
+	job_data->indices          = (vind_t *)((uint8_t *)job_data->vertices + vert_size);
+	job_data->index_count      = index_count;
+	job_data->calculate_bounds = calculate_bounds;
+	memcpy(job_data->vertices, vertices, vert_size);
+	memcpy(job_data->indices,  indices,  ind_size);
+	mesh_addref(mesh);
+
+	return assets_execute_gpu_async([](void *data) {
+		mesh_async_job_t *job_data = (mesh_async_job_t *)data;
+		_mesh_set_verts(job_data->mesh, job_data->vertices, job_data->vertex_count, job_data->calculate_bounds, true);
+		_mesh_set_inds (job_data->mesh, job_data->indices,  job_data->index_count);
+		return (bool32_t)true;
+	}, [](void *data) {
+		mesh_release(((mesh_async_job_t *)data)->mesh);
+		assets_staging_free(data);
+	}, job_data, vert_size + ind_size);
+}
+
+///////////////////////////////////////////
+
+void mesh_set_data_batch(const mesh_upload_t *uploads, int32_t upload_count) {
+	if (upload_count <= 0) return;
+
+	struct mesh_batch_job_t {
+		const mesh_upload_t *uploads;
+		int32_t              upload_count;
+	};
+	mesh_batch_job_t job_data = {uploads, upload_count};
+
+	assets_execute_gpu([](void *data) {
+		mesh_batch_job_t *job_data = (mesh_batch_job_t *)data;
+		for (int32_t i = 0; i < job_data->upload_count; i++) {
+			const mesh_upload_t *upload = &job_data->uploads[i];
+			_mesh_set_verts(upload->mesh, upload->vertices, upload->vertex_count, true, true);
+			_mesh_set_inds (upload->mesh, upload->indices,  upload->index_count);
+		}
+		return (bool32_t)true;
+	}, &job_data);
+}
+
+///////////////////////////////////////////
+
 void mesh_get_inds(mesh_t mesh, vind_t *&out_indices, int32_t &out_index_count, memory_ reference_mode) {
 	out_index_count = mesh->inds == nullptr ? 0 : (int32_t)mesh->ind_count;
 	out_indices     = nullptr;
@@ -327,6 +623,91 @@ bool32_t mesh_has_skin(mesh_t mesh) {
 
 ///////////////////////////////////////////
 
+struct mesh_optimize_t {
+	mesh_optimize_ flags;
+	vert_t        *verts;
+	uint32_t       vert_count;
+	vind_t        *inds;
+	uint32_t       ind_count;
+};
+
+bool32_t mesh_optimize_process(asset_task_t *task, asset_header_t *asset, void *job_data) {
+	mesh_optimize_t *data = (mesh_optimize_t *)job_data;
+
+	float acmr_before = mesh_opt_acmr(data->inds, data->ind_count, data->vert_count);
+	if (data->flags & mesh_optimize_vertex_cache) mesh_opt_vertex_cache(data->inds, data->ind_count, data->vert_count);
+	if (data->flags & mesh_optimize_overdraw    ) mesh_opt_overdraw    (data->inds, data->ind_count, data->verts, data->vert_count);
+	if (data->flags & mesh_optimize_vertex_fetch) data->vert_count = mesh_opt_vertex_fetch(data->inds, data->ind_count, data->verts, data->vert_count, nullptr);
+	float acmr_after = mesh_opt_acmr(data->inds, data->ind_count, data->vert_count);
+
+	log_diagf("mesh_optimize: <~grn>%s<~clr> ACMR %.3f -> %.3f", asset->id_text ? asset->id_text : "", acmr_before, acmr_after);
+
+	task->upload_bytes = data->ind_count * sizeof(vind_t);
+	if (data->flags & mesh_optimize_vertex_fetch) task->upload_bytes += data->vert_count * sizeof(vert_t);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool32_t mesh_optimize_upload(asset_task_t *, asset_header_t *asset, void *job_data) {
+	mesh_optimize_t *data = (mesh_optimize_t *)job_data;
+	mesh_t           mesh = (mesh_t)asset;
+
+	if (data->flags & mesh_optimize_vertex_fetch) _mesh_set_verts(mesh, data->verts, data->vert_count, true, true);
+	_mesh_set_inds(mesh, data->inds, data->ind_count);
+	return true;
+}
+
+///////////////////////////////////////////
+
+void mesh_optimize_free(asset_header_t *, void *job_data) {
+	mesh_optimize_t *data = (mesh_optimize_t *)job_data;
+	sk_free(data->verts);
+	sk_free(data->inds);
+	sk_free(data);
+}
+
+///////////////////////////////////////////
+
+void mesh_optimize(mesh_t mesh, mesh_optimize_ flags) {
+	if (flags == mesh_optimize_none || mesh->ind_count < 6) return;
+	if (mesh->verts == nullptr || mesh->inds == nullptr) {
+		log_err("mesh_optimize: can't work with a mesh that doesn't keep data, ensure mesh_get_keep_data() is true");
+		return;
+	}
+	// Skin weights are stored per-vertex, so the vertex order needs to stay
+	// put for those.
+	if (mesh_has_skin(mesh)) flags &= ~mesh_optimize_vertex_fetch;
+
+	// Take a snapshot of the mesh as it is now, the work itself happens on
+	// the asset threads.
+	mesh_optimize_t *data = sk_malloc_zero_t(mesh_optimize_t, 1);
+	data->flags      = flags;
+	data->vert_count = mesh->vert_count;
+	data->ind_count  = mesh->ind_count;
+	data->inds       = sk_malloc_t(vind_t, mesh->ind_count);
+	memcpy(data->inds, mesh->inds, sizeof(vind_t) * mesh->ind_count);
+	if (flags & (mesh_optimize_overdraw | mesh_optimize_vertex_fetch)) {
+		data->verts = sk_malloc_t(vert_t, mesh->vert_count);
+		memcpy(data->verts, mesh->verts, sizeof(vert_t) * mesh->vert_count);
+	}
+
+	static const asset_load_action_t actions[] = {
+		asset_load_action_t {mesh_optimize_process, asset_thread_asset},
+		asset_load_action_t {mesh_optimize_upload,  asset_thread_gpu  },
+	};
+	asset_task_t task = {};
+	task.asset        = &mesh->header;
+	task.free_data    = mesh_optimize_free;
+	task.load_data    = data;
+	task.actions      = (asset_load_action_t *)actions;
+	task.action_count = _countof(actions);
+	task.sort         = asset_sort(0, (int32_t)mesh->ind_count);
+	assets_add_task(task);
+}
+
+///////////////////////////////////////////
+
 void _mesh_set_weights(mesh_t mesh, const uint16_t* bone_ids_4, int32_t bone_id_4_count, const vec4* bone_weights, int32_t bone_weight_count) {
 	for (int32_t i = 0; i < bone_weight_count; i++) {
 		// Convert the weights to 8-bit integers, for a more memory efficient
@@ -417,52 +798,93 @@ void mesh_set_skin_inv(mesh_t mesh, const bone_weight_t* bone_weights, uint32_t
 ///////////////////////////////////////////
 
 void mesh_update_skin(mesh_t mesh, const matrix *bone_transforms, int32_t bone_count) {
-	for (int32_t i = 0; i < bone_count; i++) {
-		mesh->skin_data.bone_transforms[i] = mesh->skin_data.bone_inverse_transforms[i] * bone_transforms[i];
-	}
+	mesh_skin_deform(mesh, bone_transforms, bone_count);
+	mesh_skin_upload(mesh);
+}
 
-	XMVECTOR max = g_XMFltMin;
-	XMVECTOR min = g_XMFltMax;
-	for (uint32_t i = 0; i < mesh->vert_count; i++) {
-		XMVECTOR pos  = XMLoadFloat3((XMFLOAT3 *)&mesh->verts[i].pos);
-		XMVECTOR norm = XMLoadFloat3((XMFLOAT3 *)&mesh->verts[i].norm);
-		XMVECTOR new_pos, new_norm;
+///////////////////////////////////////////
 
-		const bone_weight_t *bone = &mesh->skin_data.bone_data[i];
+#define MESH_SKIN_MAX_BATCHES 64
+struct mesh_skin_ctx_t {
+	mesh_t   mesh;
+	int32_t  batch_size;
+	XMFLOAT3 batch_min[MESH_SKIN_MAX_BATCHES];
+	XMFLOAT3 batch_max[MESH_SKIN_MAX_BATCHES];
+};
+
+static void _mesh_skin_batch(void *context, int32_t start, int32_t end) {
+	mesh_skin_ctx_t     *ctx   = (mesh_skin_ctx_t *)context;
+	const vert_t        *src   = ctx->mesh->verts;
+	vert_t              *dest  = ctx->mesh->skin_data.deformed_verts;
+	const bone_weight_t *bones = ctx->mesh->skin_data.bone_data;
+	const matrix        *xform = ctx->mesh->skin_data.bone_transforms;
+
+	// parallel_for may hand us several batches at once, like when it runs
+	// inline without workers, so bounds are still tracked per-batch.
+	for (int32_t batch_start = start; batch_start < end; batch_start += ctx->batch_size) {
+		int32_t  batch_end = batch_start + ctx->batch_size < end ? batch_start + ctx->batch_size : end;
+		XMVECTOR max       = g_XMFltMin;
+		XMVECTOR min       = g_XMFltMax;
+		for (int32_t i = batch_start; i < batch_end; i++) {
+			const bone_weight_t *bone = &bones[i];
+
+			// Blend the bone matrices first, so each vertex only needs a
+			// single position and normal transform. Most vertices only have
+			// a single bone, so those can skip the blend entirely.
+			XMMATRIX xm = XMLoadFloat4x4((XMFLOAT4X4*)&xform[bone->bone_id[0]]);
+			if (bone->weight[0] != 255) {
+				xm = xm * (bone->weight[0] / 255.0f);
+				if (bone->weight[1] != 0) xm += XMLoadFloat4x4((XMFLOAT4X4*)&xform[bone->bone_id[1]]) * (bone->weight[1] / 255.0f);
+				if (bone->weight[2] != 0) xm += XMLoadFloat4x4((XMFLOAT4X4*)&xform[bone->bone_id[2]]) * (bone->weight[2] / 255.0f);
+				if (bone->weight[3] != 0) xm += XMLoadFloat4x4((XMFLOAT4X4*)&xform[bone->bone_id[3]]) * (bone->weight[3] / 255.0f);
+			}
 
-		{
-			float w = bone->weight[0] / 255.0f;
-			XMMATRIX xm0 = XMLoadFloat4x4((XMFLOAT4X4*)&mesh->skin_data.bone_transforms[bone->bone_id[0]]);
-			new_pos      =             XMVectorScale(XMVector3Transform      (pos,  xm0), w);
-			new_norm     =             XMVectorScale(XMVector3TransformNormal(norm, xm0), w);
-		}
-		if (bone->weight[1] != 0) {
-			float w = bone->weight[1] / 255.0f;
-			XMMATRIX xm1 = XMLoadFloat4x4((XMFLOAT4X4*)&mesh->skin_data.bone_transforms[bone->bone_id[1]]);
-			new_pos      = XMVectorAdd(XMVectorScale(XMVector3Transform      (pos,  xm1), w), new_pos);
-			new_norm     = XMVectorAdd(XMVectorScale(XMVector3TransformNormal(norm, xm1), w), new_norm);
+			XMVECTOR new_pos  = XMVector3Transform      (XMLoadFloat3((XMFLOAT3 *)&src[i].pos ), xm);
+			XMVECTOR new_norm = XMVector3TransformNormal(XMLoadFloat3((XMFLOAT3 *)&src[i].norm), xm);
+			XMStoreFloat3((XMFLOAT3 *)&dest[i].pos,  new_pos );
+			XMStoreFloat3((XMFLOAT3 *)&dest[i].norm, new_norm);
+			min = XMVectorMin(min, new_pos);
+			max = XMVectorMax(max, new_pos);
 		}
-		if (bone->weight[2] != 0) {
-			float w = bone->weight[2] / 255.0f;
-			XMMATRIX xm2 = XMLoadFloat4x4((XMFLOAT4X4*)&mesh->skin_data.bone_transforms[bone->bone_id[2]]);
-			new_pos      = XMVectorAdd(XMVectorScale(XMVector3Transform      (pos,  xm2), w), new_pos);
-			new_norm     = XMVectorAdd(XMVectorScale(XMVector3TransformNormal(norm, xm2), w), new_norm);
-		}
-		if (bone->weight[3] != 0) {
-			float w = bone->weight[3] / 255.0f;
-			XMMATRIX xm3 = XMLoadFloat4x4((XMFLOAT4X4*)&mesh->skin_data.bone_transforms[bone->bone_id[3]]);
-			new_pos      = XMVectorAdd(XMVectorScale(XMVector3Transform      (pos,  xm3), w), new_pos);
-			new_norm     = XMVectorAdd(XMVectorScale(XMVector3TransformNormal(norm, xm3), w), new_norm);
-		}
-		XMStoreFloat3((XMFLOAT3 *)&mesh->skin_data.deformed_verts[i].pos,  new_pos );
-		XMStoreFloat3((XMFLOAT3 *)&mesh->skin_data.deformed_verts[i].norm, new_norm);
-		min = XMVectorMin(min, new_pos);
-		max = XMVectorMax(max, new_pos);
+
+		int32_t batch = batch_start / ctx->batch_size;
+		XMStoreFloat3(&ctx->batch_min[batch], min);
+		XMStoreFloat3(&ctx->batch_max[batch], max);
+	}
+}
+
+///////////////////////////////////////////
+
+void mesh_skin_deform(mesh_t mesh, const matrix *bone_transforms, int32_t bone_count) {
+	for (int32_t i = 0; i < bone_count; i++) {
+		mesh->skin_data.bone_transforms[i] = mesh->skin_data.bone_inverse_transforms[i] * bone_transforms[i];
+	}
+	if (mesh->vert_count == 0) return;
+
+	// Large meshes get split across the worker threads, small ones will end
+	// up as a single batch that runs right here.
+	mesh_skin_ctx_t ctx = {};
+	ctx.mesh       = mesh;
+	ctx.batch_size = (int32_t)((mesh->vert_count + MESH_SKIN_MAX_BATCHES - 1) / MESH_SKIN_MAX_BATCHES);
+	if (ctx.batch_size < 2048) ctx.batch_size = 2048;
+	parallel_for((int32_t)mesh->vert_count, ctx.batch_size, &ctx, _mesh_skin_batch);
+
+	int32_t  batch_count = ((int32_t)mesh->vert_count + ctx.batch_size - 1) / ctx.batch_size;
+	XMVECTOR max         = g_XMFltMin;
+	XMVECTOR min         = g_XMFltMax;
+	for (int32_t i = 0; i < batch_count; i++) {
+		min = XMVectorMin(min, XMLoadFloat3(&ctx.batch_min[i]));
+		max = XMVectorMax(max, XMLoadFloat3(&ctx.batch_max[i]));
 	}
 	XMVECTOR center     = XMVectorMultiplyAdd(min, g_XMOneHalf, XMVectorMultiply(max, g_XMOneHalf));
 	XMVECTOR dimensions = XMVectorSubtract(max, min);
 	mesh->bounds.center     = math_fast_to_vec3(center);
 	mesh->bounds.dimensions = math_fast_to_vec3(dimensions);
+}
+
+///////////////////////////////////////////
+
+void mesh_skin_upload(mesh_t mesh) {
 	_mesh_set_verts(mesh, mesh->skin_data.deformed_verts, mesh->vert_count, false, false);
 }
 
@@ -528,7 +950,7 @@ mesh_t mesh_copy(mesh_t mesh) {
 	result->discard_data = mesh->discard_data;
 	result->ind_draw     = mesh->ind_draw;
 
-	if (mesh->discard_data) {
+	if (mesh->discard_data || mesh->discard_verts) {
 		log_err("mesh_copy not yet implemented for meshes with discard data set!");
 	} else {
 		mesh_set_inds (result, mesh->inds,  mesh->ind_count);
@@ -545,32 +967,45 @@ mesh_t mesh_copy(mesh_t mesh) {
 const mesh_collision_t *mesh_get_collision_data(mesh_t mesh) {
 	if (mesh->collision_data.pts != nullptr)
 		return &mesh->collision_data;
-	if (mesh->discard_data)
+	if (mesh->discard_data || mesh->verts == nullptr || mesh->inds == nullptr)
 		return nullptr;
 
+	// Positions only, one per vertex. Triangles are described by the index
+	// data we already keep, instead of duplicating shared corners.
 	mesh_collision_t &coll = mesh->collision_data;
-	coll.pts    = sk_malloc_t(vec3   , mesh->ind_count);
-	coll.planes = sk_malloc_t(plane_t, mesh->ind_count/3);
+	coll.pts       = sk_malloc_t(vec3, mesh->vert_count);
+	coll.pt_count  = mesh->vert_count;
+	coll.inds      = mesh->inds;
+	coll.ind_count = mesh->ind_count;
 
-	for (uint32_t i = 0; i < mesh->ind_count; i++) coll.pts[i] = mesh->verts[mesh->inds[i]].pos;
-
-	for (uint32_t i = 0; i < mesh->ind_count; i += 3) {
-		vec3    dir1   = coll.pts[i+1] - coll.pts[i];
-		vec3    dir2   = coll.pts[i+1] - coll.pts[i+2];
-		vec3    normal = vec3_normalize( vec3_cross(dir2, dir1) );
-		plane_t plane  = { normal, -vec3_dot(coll.pts[i + 1], normal) };
-		coll.planes[i/3] = plane;
-	}
+	for (uint32_t i = 0; i < mesh->vert_count; i++) coll.pts[i] = mesh->verts[i].pos;
 
 	return &mesh->collision_data;
 }
 
 ///////////////////////////////////////////
 
+void _mesh_clear_bvh(mesh_t mesh) {
+	if (mesh->bvh_data == nullptr) return;
+	mesh_bvh_destroy(mesh->bvh_data);
+	sk_free(mesh->bvh_data);
+}
+
+///////////////////////////////////////////
+
+void _mesh_clear_collision(mesh_t mesh) {
+	_mesh_clear_bvh(mesh);
+	sk_free(mesh->collision_data.pts);
+	sk_free(mesh->collision_data.owned_inds);
+	mesh->collision_data = {};
+}
+
+///////////////////////////////////////////
+
 const mesh_bvh_t *mesh_get_bvh_data(mesh_t mesh) {
 	if (mesh->bvh_data != nullptr)
 		return mesh->bvh_data;
-	if (mesh->discard_data)
+	if (mesh_get_collision_data(mesh) == nullptr)
 		return nullptr;
 
 	mesh->bvh_data = mesh_bvh_create(mesh, 16);
@@ -588,16 +1023,46 @@ void mesh_release(mesh_t mesh) {
 
 ///////////////////////////////////////////
 
+static uint64_t mesh_buffer_memory(const mesh_buffer_t *buffer, size_t stride) {
+	uint64_t count = 0;
+	for (int32_t i = 0; i < MESH_BUFFER_RING; i++) {
+		if (skg_buffer_is_valid(&buffer->buffers[i])) count++;
+	}
+	return count * buffer->capacity * stride;
+}
+
+///////////////////////////////////////////
+
+void mesh_memory_usage(mesh_t mesh, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	uint64_t cpu = sizeof(_mesh_t);
+	if (mesh->verts != nullptr) cpu += sizeof(vert_t) * mesh->vert_count;
+	if (mesh->inds  != nullptr) cpu += sizeof(vind_t) * mesh->ind_count;
+
+	const mesh_collision_t *coll = &mesh->collision_data;
+	if (coll->pts        != nullptr) cpu += sizeof(vec3)   * coll->pt_count;
+	if (coll->owned_inds != nullptr) cpu += sizeof(vind_t) * coll->ind_count;
+	if (mesh->bvh_data   != nullptr) cpu += mesh_bvh_memory(mesh->bvh_data);
+
+	const mesh_weights_t *skin = &mesh->skin_data;
+	if (skin->bone_data      != nullptr) cpu += sizeof(bone_weight_t) * mesh->vert_count;
+	if (skin->deformed_verts != nullptr) cpu += sizeof(vert_t)        * mesh->vert_count;
+	cpu += sizeof(matrix) * 2 * skin->bone_count;
+
+	*out_cpu_bytes = cpu;
+	*out_gpu_bytes = mesh_buffer_memory(&mesh->vert_buffer, sizeof(vert_t))
+	               + mesh_buffer_memory(&mesh->ind_buffer,  sizeof(vind_t));
+}
+
+///////////////////////////////////////////
+
 void mesh_destroy(mesh_t mesh) {
-	skg_mesh_destroy  (&mesh->gpu_mesh);
-	skg_buffer_destroy(&mesh->vert_buffer);
-	skg_buffer_destroy(&mesh->ind_buffer);
+	skg_mesh_destroy    (&mesh->gpu_mesh);
+	_mesh_buffer_destroy(&mesh->vert_buffer);
+	_mesh_buffer_destroy(&mesh->ind_buffer);
+	mesh_release(mesh->shared_inds);
 	sk_free(mesh->verts);
 	sk_free(mesh->inds);
-	sk_free(mesh->collision_data.pts   );	// XXX doesn't this fail when no colldata has been created?
-	sk_free(mesh->collision_data.planes);
-	if (mesh->bvh_data)
-		mesh_bvh_destroy(mesh->bvh_data);
+	_mesh_clear_collision(mesh);
 
 	sk_free(mesh->skin_data.bone_data);
 	sk_free(mesh->skin_data.bone_inverse_transforms);
@@ -627,9 +1092,10 @@ bool32_t mesh_ray_intersect(mesh_t mesh, ray_t model_space_ray, ray_t *out_pt, u
 
 	vec3  pt = {};
 	float nearest_dist = FLT_MAX;
-	for (uint32_t i = 0; i < mesh->ind_count; i+=3) {
-
-		const plane_t& plane = data->planes[i / 3];
+	for (uint32_t i = 0; i < data->ind_count; i+=3) {
+		vec3 a, b, c;
+		mesh_collision_triangle(data, i, &a, &b, &c);
+		const plane_t plane = mesh_collision_plane(a, b, c);
 
 		float denom = vec3_dot(model_space_ray.dir, plane.normal);
 
@@ -660,9 +1126,9 @@ bool32_t mesh_ray_intersect(mesh_t mesh, ray_t model_space_ray, ray_t *out_pt, u
 		// https://blackpawn.com/texts/pointinpoly/default.html
 
 		// Compute vectors
-		vec3 v0 = data->pts[i+1] - data->pts[i];
-		vec3 v1 = data->pts[i+2] - data->pts[i];
-		vec3 v2 = pt - data->pts[i];
+		vec3 v0 = b  - a;
+		vec3 v1 = c  - a;
+		vec3 v2 = pt - a;
 
 		// Compute dot products
 		float dot00 = vec3_dot(v0, v0);
@@ -684,7 +1150,7 @@ bool32_t mesh_ray_intersect(mesh_t mesh, ray_t model_space_ray, ray_t *out_pt, u
 				if (out_start_inds != nullptr) {
 					*out_start_inds = i;
 				}
-				*out_pt = {pt, data->planes[i / 3].normal};
+				*out_pt = {pt, plane.normal};
 			}
 		}
 	}
@@ -709,7 +1175,7 @@ bool32_t mesh_ray_intersect_bvh(mesh_t mesh, ray_t model_space_ray, ray_t *out_p
 ///////////////////////////////////////////
 
 bool32_t mesh_get_triangle(mesh_t mesh, uint32_t triangle_index, vert_t* a, vert_t* b, vert_t* c) {
-	if (mesh->discard_data) {
+	if (mesh->discard_data || mesh->verts == nullptr) {
 		log_err("mesh_get_triangle: can't work with a mesh that doesn't keep data, ensure mesh_get_keep_data() is true");
 		return false;
 	}
@@ -725,6 +1191,38 @@ bool32_t mesh_get_triangle(mesh_t mesh, uint32_t triangle_index, vert_t* a, vert
 
 ///////////////////////////////////////////
 
+bool32_t mesh_closest_point(mesh_t mesh, vec3 model_space_pt, float max_distance, ray_t *out_pt, vec3 *out_barycentric, uint32_t *out_start_inds) {
+	if (mesh->ind_count == 0)
+		return false;
+	const mesh_bvh_t *bvh = mesh_get_bvh_data(mesh);
+	if (bvh == nullptr)
+		return false;
+
+	return mesh_bvh_closest_point(bvh, model_space_pt, max_distance, out_pt, out_barycentric, out_start_inds);
+}
+
+///////////////////////////////////////////
+
+bool32_t mesh_sphere_intersect(mesh_t mesh, sphere_t model_space_sphere, ray_t *out_pt, vec3 *out_barycentric, uint32_t *out_start_inds) {
+	return mesh_closest_point(mesh, model_space_sphere.center, model_space_sphere.radius, out_pt, out_barycentric, out_start_inds);
+}
+
+///////////////////////////////////////////
+
+bool32_t mesh_capsule_intersect(mesh_t mesh, vec3 model_space_pt1, vec3 model_space_pt2, float radius, ray_t *out_pt, vec3 *out_barycentric, uint32_t *out_start_inds) {
+	if (mesh->ind_count == 0)
+		return false;
+	if (!bounds_capsule_contains(mesh->bounds, model_space_pt1, model_space_pt2, radius))
+		return false;
+	const mesh_bvh_t *bvh = mesh_get_bvh_data(mesh);
+	if (bvh == nullptr)
+		return false;
+
+	return mesh_bvh_capsule_intersect(bvh, model_space_pt1, model_space_pt2, radius, out_pt, out_barycentric, out_start_inds);
+}
+
+///////////////////////////////////////////
+
 void mesh_gen_cube_vert(int i, const vec3 &size, vec3 &pos, vec3 &norm, vec2 &uv) {
 	float neg = (float)((i / 4) % 2 ? -1 : 1);
 	int nx  = ((i+24) / 16) % 2;
@@ -19,20 +19,33 @@ struct mesh_weights_t {
 	int32_t   bone_count;
 };
 
+// Dynamic meshes cycle through a few GPU buffers, one per frame, so that an
+// update never writes to a buffer the GPU may still be drawing from. Each
+// buffer tracks the range of elements it's missing from more recent updates.
+#define MESH_BUFFER_RING 3
+
+struct mesh_buffer_t {
+	skg_buffer_t     buffers    [MESH_BUFFER_RING];
+	uint32_t         dirty_start[MESH_BUFFER_RING];
+	uint32_t         dirty_end  [MESH_BUFFER_RING];
+	int32_t          curr;
+	uint64_t         curr_frame;
+	uint32_t         capacity;
+	bool32_t         dynamic;
+};
+
 struct _mesh_t {
 	asset_header_t   header;
 	uint32_t         vert_count;
-	uint32_t         vert_capacity;
-	bool32_t         vert_dynamic;
-	skg_buffer_t     vert_buffer;
+	mesh_buffer_t    vert_buffer;
 	uint32_t         ind_count;
-	uint32_t         ind_capacity;
-	bool32_t         ind_dynamic;
-	skg_buffer_t     ind_buffer;
+	mesh_buffer_t    ind_buffer;
+	mesh_t           shared_inds;
 	uint32_t         ind_draw;
 	skg_mesh_t       gpu_mesh;
 	bounds_t         bounds;
 	bool32_t         discard_data;
+	bool32_t         discard_verts;
 	vert_t*          verts;
 	vind_t*          inds;
 	mesh_collision_t collision_data;
@@ -40,6 +53,7 @@ struct _mesh_t {
 	mesh_weights_t   skin_data;
 };
 
-void mesh_destroy(mesh_t mesh);
+void mesh_destroy     (mesh_t mesh);
+void mesh_memory_usage(mesh_t mesh, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
 
 } // namespace sk
\ No newline at end of file
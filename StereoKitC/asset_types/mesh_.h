@@ -4,19 +4,55 @@
 
 namespace sk {
 
+// CPU side collision data is a position-only copy of the mesh's vertices,
+// indexed by the mesh's own index data. Triangle planes are not stored, the
+// intersection kernels derive them from the three corners when needed.
 struct mesh_collision_t {
-	vec3*    pts;
-	plane_t* planes;
+	vec3*         pts;
+	uint32_t      pt_count;
+	const vind_t* inds;
+	uint32_t      ind_count;
+	// Only set if the mesh discarded its own index data, and collision data
+	// took ownership of it.
+	vind_t*       owned_inds;
 };
 
+inline void mesh_collision_triangle(const mesh_collision_t *coll, uint32_t start_ind, vec3 *out_a, vec3 *out_b, vec3 *out_c) {
+	*out_a = coll->pts[coll->inds[start_ind  ]];
+	*out_b = coll->pts[coll->inds[start_ind+1]];
+	*out_c = coll->pts[coll->inds[start_ind+2]];
+}
+
+inline plane_t mesh_collision_plane(vec3 a, vec3 b, vec3 c) {
+	vec3 normal = vec3_normalize( vec3_cross(b - c, b - a) );
+	return plane_t{ normal, -vec3_dot(b, normal) };
+}
+
 struct bone_weight_t {
 	uint16_t bone_id[4];
 	uint8_t  weight [4];
 };
 
+struct mesh_upload_t {
+	mesh_t        mesh;
+	const vert_t *vertices;
+	int32_t       vertex_count;
+	const vind_t *indices;
+	int32_t       index_count;
+};
+
 const mesh_collision_t* mesh_get_collision_data(mesh_t mesh);
 void                    mesh_calculate_normals (      vert_t *verts, int32_t vert_count, const vind_t *inds, int32_t ind_count);
 bounds_t                mesh_calculate_bounds  (const vert_t *verts, int32_t vert_count);
 void                    mesh_set_skin_inv      (mesh_t mesh, const bone_weight_t* bone_weights, uint32_t bone_weight_count, const matrix* bone_resting_transforms_inverted, int32_t bone_count);
+void                    mesh_skin_deform       (mesh_t mesh, const matrix *bone_transforms, int32_t bone_count);
+void                    mesh_skin_upload       (mesh_t mesh);
+// Same as mesh_set_data for a whole list of meshes, but only waits on the
+// GPU thread once.
+void                    mesh_set_data_batch    (const mesh_upload_t *uploads, int32_t upload_count);
+// Draws the mesh with the first index_count indices of another mesh's index
+// buffer, so meshes that share an index pattern only need one copy of it on
+// the GPU. The source's indices shouldn't change after this.
+void                    mesh_share_inds        (mesh_t mesh, mesh_t ind_source, int32_t index_count);
 
 } // namespace sk
\ No newline at end of file
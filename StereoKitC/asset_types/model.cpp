@@ -4,8 +4,10 @@
 #include "../sk_math_dx.h"
 #include "../sk_memory.h"
 #include "model.h"
+#include "model_cache.h"
 #include "mesh.h"
 #include "../libraries/stref.h"
+#include "../libraries/sokol_time.h"
 #include "../platforms/platform.h"
 
 using namespace DirectX;
@@ -16,6 +18,8 @@ using namespace DirectX;
 
 namespace sk {
 
+mesh_optimize_ model_load_optimize = mesh_optimize_none;
+
 ///////////////////////////////////////////
 
 model_t model_create() {
@@ -58,6 +62,7 @@ model_t model_copy(model_t model) {
 	model_t result = (model_t)assets_allocate(asset_type_model);
 	result->visuals      = model->visuals.copy();
 	result->nodes        = model->nodes  .copy();
+	result->instances    = model->instances.copy();
 	result->bounds       = model->bounds;
 	result->nodes_used   = model->nodes_used;
 	result->anim_inst.anim_id = -1;
@@ -128,27 +133,56 @@ model_t model_create_file(const char *filename, shader_t shader) {
 	if (result != nullptr)
 		return result;
 
-	void*    data;
-	size_t   length;
+	// Large model files are mapped rather than copied, and the parsers read
+	// straight from the file's pages.
+	platform_file_map_t file;
 	char*    asset_filename = assets_file(filename);
-	bool32_t loaded         = platform_read_file(asset_filename, &data, &length);
+	bool32_t loaded         = platform_file_map(asset_filename, &file);
 	sk_free(asset_filename);
 	if (!loaded) {
 		log_warnf("Model file failed to load: %s", filename);
 		return nullptr;
 	}
 
-	result = model_create_mem(filename, data, length, shader);
+	// A cached copy of the Model skips parsing the source file entirely, but
+	// it's still keyed off the source's contents.
+	bool32_t use_cache   = model_cache_enabled();
+	uint64_t source_hash = 0;
+	if (use_cache) {
+		result = model_cache_load(filename, file.data, file.size, shader, &source_hash);
+		if (result != nullptr) {
+			model_set_id(result, filename);
+			platform_file_unmap(&file);
+			return result;
+		}
+	}
+
+	uint64_t start = stm_now();
+	result = model_create_mem(filename, file.data, file.size, shader);
 	if (result != nullptr) {
 		model_set_id(result, filename);
+		if (use_cache)
+			model_cache_save(result, filename, file.data, file.size, source_hash, shader, (float)stm_ms(stm_since(start)));
 	}
 	
-	sk_free(data);
+	platform_file_unmap(&file);
 	return result;
 }
 
 ///////////////////////////////////////////
 
+void model_set_load_optimize(mesh_optimize_ flags) {
+	model_load_optimize = flags;
+}
+
+///////////////////////////////////////////
+
+mesh_optimize_ model_get_load_optimize() {
+	return model_load_optimize;
+}
+
+///////////////////////////////////////////
+
 void model_recalculate_bounds(model_t model) {
 	model->bounds_dirty = false;
 	if (model->visuals.count <= 0) {
@@ -159,21 +193,25 @@ void model_recalculate_bounds(model_t model) {
 	// Get an initial size
 	vec3 first_corner = bounds_corner(mesh_get_bounds(model->visuals[0].mesh), 0);
 	vec3 min, max;
-	min = max = matrix_transform_pt( model->visuals[0].transform_model, first_corner);
+	min = max = matrix_transform_pt(model_visual_instance(model, 0, 0), first_corner);
 	
 	// Find the corners for each bounding cube, and factor them in!
 	for (int32_t m = 0; m < model->visuals.count; m += 1) {
-		bounds_t bounds = mesh_get_bounds(model->visuals[m].mesh);
-		for (int32_t i = 0; i < 8; i += 1) {
-			vec3 corner = bounds_corner      (bounds, i);
-			vec3 pt     = matrix_transform_pt(model->visuals[m].transform_model, corner);
-			min.x = fminf(pt.x, min.x);
-			min.y = fminf(pt.y, min.y);
-			min.z = fminf(pt.z, min.z);
-
-			max.x = fmaxf(pt.x, max.x);
-			max.y = fmaxf(pt.y, max.y);
-			max.z = fmaxf(pt.z, max.z);
+		bounds_t bounds     = mesh_get_bounds(model->visuals[m].mesh);
+		int32_t  inst_count = model_visual_instance_count(model, m);
+		for (int32_t inst = 0; inst < inst_count; inst += 1) {
+			matrix transform = model_visual_instance(model, m, inst);
+			for (int32_t i = 0; i < 8; i += 1) {
+				vec3 corner = bounds_corner      (bounds, i);
+				vec3 pt     = matrix_transform_pt(transform, corner);
+				min.x = fminf(pt.x, min.x);
+				min.y = fminf(pt.y, min.y);
+				min.z = fminf(pt.z, min.z);
+
+				max.x = fmaxf(pt.x, max.x);
+				max.y = fmaxf(pt.y, max.y);
+				max.z = fmaxf(pt.z, max.z);
+			}
 		}
 	}
 	
@@ -195,30 +233,35 @@ void model_recalculate_bounds_exact(model_t model) {
 		? model->visuals[0].mesh->verts[0].pos
 		: bounds_corner(model->visuals[0].mesh->bounds, 0);
 
-	vec3     minf = matrix_transform_pt( model->visuals[0].transform_model, first_corner);
+	vec3     minf = matrix_transform_pt(model_visual_instance(model, 0, 0), first_corner);
 	XMVECTOR min  = XMLoadFloat3((XMFLOAT3*)&minf);
 	XMVECTOR max  = XMLoadFloat3((XMFLOAT3*)&minf);
 
 	// Use all the transformed vertices, and factor them in!
 	for (int32_t m = 0; m < model->visuals.count; m += 1) {
-		XMMATRIX      transform_model = XMLoadFloat4x4((XMFLOAT4X4*)&model->visuals[m].transform_model.row);
-		const mesh_t  mesh            = model->visuals[m].mesh;
-		const vert_t* verts           = mesh->verts;
+		const mesh_t  mesh       = model->visuals[m].mesh;
+		const vert_t* verts      = mesh->verts;
+		int32_t       inst_count = model_visual_instance_count(model, m);
 
-		if (verts != nullptr) {
-			for (uint32_t i = 0; i < mesh->vert_count; i += 1) {
-				XMVECTOR pt = matrix_mul_pointx(transform_model, verts[i].pos);
+		for (int32_t inst = 0; inst < inst_count; inst += 1) {
+			matrix   transform       = model_visual_instance(model, m, inst);
+			XMMATRIX transform_model = XMLoadFloat4x4((XMFLOAT4X4*)&transform.row);
 
-				min = XMVectorMin(min, pt);
-				max = XMVectorMax(max, pt);
-			}
-		} else {
-			for (int32_t i = 0; i < 8; i += 1) {
-				vec3     corner = bounds_corner(mesh->bounds, i);
-				XMVECTOR pt     = matrix_mul_pointx(transform_model, corner);
+			if (verts != nullptr) {
+				for (uint32_t i = 0; i < mesh->vert_count; i += 1) {
+					XMVECTOR pt = matrix_mul_pointx(transform_model, verts[i].pos);
 
-				min = XMVectorMin(min, pt);
-				max = XMVectorMax(max, pt);
+					min = XMVectorMin(min, pt);
+					max = XMVectorMax(max, pt);
+				}
+			} else {
+				for (int32_t i = 0; i < 8; i += 1) {
+					vec3     corner = bounds_corner(mesh->bounds, i);
+					XMVECTOR pt     = matrix_mul_pointx(transform_model, corner);
+
+					min = XMVectorMin(min, pt);
+					max = XMVectorMax(max, pt);
+				}
 			}
 		}
 	}
@@ -379,7 +422,7 @@ bounds_t model_get_bounds(model_t model) {
 
 bool32_t model_ray_intersect(model_t model, ray_t model_space_ray, ray_t *out_pt, cull_ cull_mode) {
 	vec3 bounds_at;
-	if (!bounds_ray_intersect(model->bounds, model_space_ray, &bounds_at))
+	if (!bounds_ray_intersect(model_get_bounds(model), model_space_ray, &bounds_at))
 		return false;
 
 	float closest = FLT_MAX;
@@ -389,14 +432,19 @@ bool32_t model_ray_intersect(model_t model, ray_t model_space_ray, ray_t *out_pt
 		if (!n->solid || n->visual == -1)
 			continue;
 
-		matrix inverse   = matrix_invert(n->transform_model);
-		ray_t  local_ray = matrix_transform_ray(inverse, model_space_ray);
-		ray_t  at;
-		if (mesh_ray_intersect(model->visuals[n->visual].mesh, local_ray, &at, nullptr, cull_mode)) {
-			float d = vec3_distance_sq(local_ray.pos, at.pos);
-			if (d < closest) {
-				closest = d;
-				*out_pt = matrix_transform_ray(n->transform_model, at);
+		int32_t inst_count = model_visual_instance_count(model, n->visual);
+		for (int32_t inst = 0; inst < inst_count; inst++) {
+			matrix transform = model_visual_instance(model, n->visual, inst);
+			matrix inverse   = matrix_invert(transform);
+			ray_t  local_ray = matrix_transform_ray(inverse, model_space_ray);
+			ray_t  at;
+			if (mesh_ray_intersect(model->visuals[n->visual].mesh, local_ray, &at, nullptr, cull_mode)) {
+				ray_t model_at = matrix_transform_ray(transform, at);
+				float d        = vec3_distance_sq(model_space_ray.pos, model_at.pos);
+				if (d < closest) {
+					closest = d;
+					*out_pt = model_at;
+				}
 			}
 		}
 	}
@@ -406,8 +454,15 @@ bool32_t model_ray_intersect(model_t model, ray_t model_space_ray, ray_t *out_pt
 ///////////////////////////////////////////
 
 bool32_t model_ray_intersect_bvh(model_t model, ray_t model_space_ray, ray_t *out_pt, cull_ cull_mode) {
+	return model_ray_intersect_bvh_detailed(model, model_space_ray, out_pt, nullptr, nullptr, nullptr, cull_mode);
+}
+
+///////////////////////////////////////////
+
+// Same as model_ray_intersect_bvh, but returns mesh, mesh transform and start index if intersection found
+bool32_t model_ray_intersect_bvh_detailed(model_t model, ray_t model_space_ray, ray_t *out_pt, mesh_t *out_mesh, matrix *out_matrix, uint32_t* out_start_inds, cull_ cull_mode) {
 	vec3 bounds_at;
-	if (!bounds_ray_intersect(model->bounds, model_space_ray, &bounds_at))
+	if (!bounds_ray_intersect(model_get_bounds(model), model_space_ray, &bounds_at))
 		return false;
 
 	float closest = FLT_MAX;
@@ -417,14 +472,27 @@ bool32_t model_ray_intersect_bvh(model_t model, ray_t model_space_ray, ray_t *ou
 		if (!n->solid || n->visual == -1)
 			continue;
 
-		matrix inverse   = matrix_invert(n->transform_model);
-		ray_t  local_ray = matrix_transform_ray(inverse, model_space_ray);
-		ray_t  at;
-		if (mesh_ray_intersect_bvh(model->visuals[n->visual].mesh, local_ray, &at, nullptr, cull_mode)) {
-			float d = vec3_distance_sq(local_ray.pos, at.pos);
-			if (d < closest) {
-				closest = d;
-				*out_pt = matrix_transform_ray(n->transform_model, at);
+		int32_t inst_count = model_visual_instance_count(model, n->visual);
+		for (int32_t inst = 0; inst < inst_count; inst++) {
+			matrix   transform = model_visual_instance(model, n->visual, inst);
+			matrix   inverse   = matrix_invert(transform);
+			ray_t    local_ray = matrix_transform_ray(inverse, model_space_ray);
+			ray_t    at;
+			uint32_t local_start_inds;
+			if (mesh_ray_intersect_bvh(model->visuals[n->visual].mesh, local_ray, &at, &local_start_inds, cull_mode)) {
+				// Instances may be scaled differently, so distances are
+				// compared in model space.
+				ray_t model_at = matrix_transform_ray(transform, at);
+				float d        = vec3_distance_sq(model_space_ray.pos, model_at.pos);
+				if (d < closest) {
+					closest = d;
+					if (out_mesh != nullptr && out_start_inds != nullptr) {
+						*out_mesh = model->visuals[n->visual].mesh;
+						*out_matrix = transform;
+						*out_start_inds = local_start_inds;
+					}
+					*out_pt = model_at;
+				}
 			}
 		}
 	}
@@ -433,37 +501,150 @@ bool32_t model_ray_intersect_bvh(model_t model, ray_t model_space_ray, ray_t *ou
 
 ///////////////////////////////////////////
 
-// Same as model_ray_intersect_bvh, but returns mesh, mesh transform and start index if intersection found
-bool32_t model_ray_intersect_bvh_detailed(model_t model, ray_t model_space_ray, ray_t *out_pt, mesh_t *out_mesh, matrix *out_matrix, uint32_t* out_start_inds, cull_ cull_mode) {
-	vec3 bounds_at;
-	if (!bounds_ray_intersect(model->bounds, model_space_ray, &bounds_at))
+// Proximity queries are run in each node's local space, so the search
+// distance has to be scaled into that space too. Non-uniform scale is
+// handled conservatively by using the smallest axis, and every candidate
+// is re-measured in model space before it's accepted.
+static float _model_min_scale(const matrix &transform) {
+	vec3 scale = matrix_extract_scale(transform);
+	return fminf(scale.x, fminf(scale.y, scale.z));
+}
+
+///////////////////////////////////////////
+
+bool32_t model_closest_point(model_t model, vec3 model_space_pt, float max_distance, ray_t *out_pt, mesh_t *out_mesh, matrix *out_matrix, uint32_t *out_start_inds, vec3 *out_barycentric) {
+	bool finite = max_distance < sqrtf(FLT_MAX);
+	if (finite && !bounds_capsule_contains(model_get_bounds(model), model_space_pt, model_space_pt, max_distance))
 		return false;
 
-	float closest = FLT_MAX;
-	*out_pt = {};
+	float closest = finite ? max_distance * max_distance : FLT_MAX;
+	bool  found   = false;
 	for (int32_t i = 0; i < model->nodes.count; i++) {
 		model_node_t *n = &model->nodes[i];
 		if (!n->solid || n->visual == -1)
 			continue;
 
-		matrix inverse   = matrix_invert(n->transform_model);
-		ray_t  local_ray = matrix_transform_ray(inverse, model_space_ray);
-		ray_t  at;
-		uint32_t local_start_inds;
-		if (mesh_ray_intersect_bvh(model->visuals[n->visual].mesh, local_ray, &at, &local_start_inds, cull_mode)) {
-			float d = vec3_distance_sq(local_ray.pos, at.pos);
-			if (d < closest) {
-				closest = d;
-				if (out_mesh != nullptr && out_start_inds != nullptr) {
-					*out_mesh = model->visuals[n->visual].mesh;
-					*out_matrix = n->transform_model;
-					*out_start_inds = local_start_inds;
+		int32_t inst_count = model_visual_instance_count(model, n->visual);
+		for (int32_t inst = 0; inst < inst_count; inst++) {
+			matrix transform = model_visual_instance(model, n->visual, inst);
+			float  min_scale = _model_min_scale(transform);
+			if (min_scale <= 0)
+				continue;
+
+			matrix   inverse   = matrix_invert(transform);
+			vec3     local_pt  = matrix_transform_pt(inverse, model_space_pt);
+			float    local_max = closest == FLT_MAX ? FLT_MAX : sqrtf(closest) / min_scale;
+			ray_t    at;
+			vec3     bary;
+			uint32_t start_inds;
+			if (mesh_closest_point(model->visuals[n->visual].mesh, local_pt, local_max, &at, &bary, &start_inds)) {
+				ray_t model_at = matrix_transform_ray(transform, at);
+				float d        = vec3_distance_sq(model_at.pos, model_space_pt);
+				if (d <= closest) {
+					closest = d;
+					found   = true;
+					*out_pt = model_at;
+					if (out_mesh        != nullptr) *out_mesh        = model->visuals[n->visual].mesh;
+					if (out_matrix      != nullptr) *out_matrix      = transform;
+					if (out_start_inds  != nullptr) *out_start_inds  = start_inds;
+					if (out_barycentric != nullptr) *out_barycentric = bary;
 				}
-				*out_pt = matrix_transform_ray(n->transform_model, at);
 			}
 		}
 	}
-	return closest != FLT_MAX;
+	return found;
+}
+
+///////////////////////////////////////////
+
+bool32_t model_sphere_intersect(model_t model, sphere_t model_space_sphere, ray_t *out_pt, mesh_t *out_mesh, matrix *out_matrix, uint32_t *out_start_inds, vec3 *out_barycentric) {
+	return model_closest_point(model, model_space_sphere.center, model_space_sphere.radius, out_pt, out_mesh, out_matrix, out_start_inds, out_barycentric);
+}
+
+///////////////////////////////////////////
+
+bool32_t model_capsule_intersect(model_t model, vec3 model_space_pt1, vec3 model_space_pt2, float radius, ray_t *out_pt, mesh_t *out_mesh, matrix *out_matrix, uint32_t *out_start_inds, vec3 *out_barycentric) {
+	if (!bounds_capsule_contains(model_get_bounds(model), model_space_pt1, model_space_pt2, radius))
+		return false;
+
+	vec3  seg     = model_space_pt2 - model_space_pt1;
+	float seg_sq  = vec3_magnitude_sq(seg);
+	float closest = radius * radius;
+	bool  found   = false;
+	for (int32_t i = 0; i < model->nodes.count; i++) {
+		model_node_t *n = &model->nodes[i];
+		if (!n->solid || n->visual == -1)
+			continue;
+
+		int32_t inst_count = model_visual_instance_count(model, n->visual);
+		for (int32_t inst = 0; inst < inst_count; inst++) {
+			matrix transform = model_visual_instance(model, n->visual, inst);
+			float  min_scale = _model_min_scale(transform);
+			if (min_scale <= 0)
+				continue;
+
+			matrix   inverse = matrix_invert(transform);
+			ray_t    at;
+			vec3     bary;
+			uint32_t start_inds;
+			if (mesh_capsule_intersect(model->visuals[n->visual].mesh,
+				matrix_transform_pt(inverse, model_space_pt1),
+				matrix_transform_pt(inverse, model_space_pt2),
+				sqrtf(closest) / min_scale, &at, &bary, &start_inds)) {
+
+				ray_t model_at = matrix_transform_ray(transform, at);
+				float t        = seg_sq > 0 ? math_saturate(vec3_dot(model_at.pos - model_space_pt1, seg) / seg_sq) : 0;
+				float d        = vec3_distance_sq(model_at.pos, model_space_pt1 + seg * t);
+				if (d <= closest) {
+					closest = d;
+					found   = true;
+					*out_pt = model_at;
+					if (out_mesh        != nullptr) *out_mesh        = model->visuals[n->visual].mesh;
+					if (out_matrix      != nullptr) *out_matrix      = transform;
+					if (out_start_inds  != nullptr) *out_start_inds  = start_inds;
+					if (out_barycentric != nullptr) *out_barycentric = bary;
+				}
+			}
+		}
+	}
+	return found;
+}
+
+///////////////////////////////////////////
+
+void model_memory_usage(model_t model, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	// Meshes and materials are assets of their own, and report themselves
+	uint64_t cpu = sizeof(_model_t)
+		+ sizeof(model_visual_t) * model->visuals  .capacity
+		+ sizeof(model_node_t  ) * model->nodes    .capacity
+		+ sizeof(matrix        ) * model->instances.capacity;
+
+	const anim_data_t *anim = &model->anim_data;
+	for (int32_t a = 0; a < anim->anims.count; a++) {
+		for (int32_t c = 0; c < anim->anims[a].curves.count; c++) {
+			const anim_curve_t *curve = &anim->anims[a].curves[c];
+			int32_t floats = 1;
+			switch (curve->applies_to) {
+			case anim_element_translation:
+			case anim_element_scale:    floats = 3; break;
+			case anim_element_rotation: floats = 4; break;
+			default: break;
+			}
+			// Cubic curves carry in and out tangents along with each value
+			if (curve->interpolation == anim_interpolation_cubic) floats *= 3;
+			cpu += sizeof(float) * curve->keyframe_count * (1 + floats);
+		}
+	}
+	for (int32_t s = 0; s < anim->skeletons.count; s++)
+		cpu += sizeof(int32_t) * anim->skeletons[s].bone_count;
+
+	const anim_inst_t *inst = &model->anim_inst;
+	cpu += sizeof(anim_transform_t  ) * inst->node_count
+	     + sizeof(int32_t           ) * inst->curve_last_capacity
+	     + sizeof(anim_inst_subset_t) * inst->skinned_mesh_count;
+
+	*out_cpu_bytes = cpu;
+	*out_gpu_bytes = 0;
 }
 
 ///////////////////////////////////////////
@@ -479,8 +660,9 @@ void model_destroy(model_t model) {
 		mesh_release    (model->visuals[i].mesh);
 		material_release(model->visuals[i].material);
 	}
-	model->nodes  .free();
-	model->visuals.free();
+	model->nodes    .free();
+	model->visuals  .free();
+	model->instances.free();
 	*model = {};
 }
 
@@ -754,6 +936,44 @@ void model_node_set_mesh(model_t model, model_node_id node, mesh_t mesh) {
 
 ///////////////////////////////////////////
 
+void model_node_set_instances(model_t model, model_node_id node, const matrix *transforms, int32_t count) {
+	int32_t vis = model->nodes[node].visual;
+	if (vis < 0) {
+		log_warn("model_node_set_instances: node has no mesh to instance!");
+		return;
+	}
+
+	// Instances for all visuals share one array. A visual keeps its range
+	// if the new set fits, otherwise it moves to the end of the array.
+	model_visual_t *visual = &model->visuals[vis];
+	if (count > visual->inst_count) {
+		visual->inst_start = model->instances.count;
+		model->instances.add_range(transforms, count);
+	} else if (count > 0) {
+		memcpy(&model->instances[visual->inst_start], transforms, sizeof(matrix) * count);
+	}
+	visual->inst_count  = count;
+	model->bounds_dirty = true;
+}
+
+///////////////////////////////////////////
+
+int32_t model_visual_instance_count(model_t model, int32_t visual) {
+	int32_t count = model->visuals[visual].inst_count;
+	return count > 0 ? count : 1;
+}
+
+///////////////////////////////////////////
+
+matrix model_visual_instance(model_t model, int32_t visual, int32_t instance) {
+	const model_visual_t *vis = &model->visuals[visual];
+	return vis->inst_count > 0
+		? model->instances[vis->inst_start + instance] * vis->transform_model
+		: vis->transform_model;
+}
+
+///////////////////////////////////////////
+
 void _model_node_update_transforms(model_t model, model_node_id node) {
 	if (model->nodes[node].parent >= 0)
 		model->nodes[node].transform_model = model->nodes[node].transform_local * model->nodes[model->nodes[node].parent].transform_model;
@@ -5,6 +5,8 @@
 #include "assets.h"
 #include "animation.h"
 
+struct cgltf_data;
+
 namespace sk {
 
 struct model_visual_t {
@@ -13,6 +15,8 @@ struct model_visual_t {
 	material_t    material;
 	matrix        transform_model;
 	bool32_t      visible;
+	int32_t       inst_start;
+	int32_t       inst_count;
 };
 
 struct model_node_t {
@@ -31,6 +35,7 @@ struct _model_t {
 	asset_header_t          header;
 	array_t<model_visual_t> visuals;
 	array_t<model_node_t>   nodes;
+	array_t<matrix>         instances;
 	int32_t                 nodes_used;
 	bool32_t                transforms_changed;
 	anim_data_t             anim_data;
@@ -43,6 +48,20 @@ bool modelfmt_obj (model_t model, const char *filename, void *file_data, size_t
 bool modelfmt_gltf(model_t model, const char *filename, void *file_data, size_t file_size, shader_t shader);
 bool modelfmt_stl (model_t model, const char *filename, void *file_data, size_t file_size, shader_t shader);
 bool modelfmt_ply (model_t model, const char *filename, void *file_data, size_t file_size, shader_t shader);
-void model_destroy(model_t model);
+void model_destroy     (model_t model);
+void model_memory_usage(model_t model, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
+
+// Copies out the encoded file data of a glTF image that lives inside the
+// glTF's own buffers, rather than in a separate image file. The source is
+// parsed once, and its buffers loaded once, for any number of images.
+cgltf_data *gltf_image_source_create (const char *filename, void *file_data, size_t file_size);
+void        gltf_image_source_destroy(cgltf_data *source);
+bool        gltf_image_data          (cgltf_data *source, int32_t image, void **out_data, size_t *out_size);
+
+// Instanced visuals draw once per transform, and each transform is relative
+// to the visual's node. Passing a count of 0 clears the instances.
+void     model_node_set_instances   (model_t model, model_node_id node, const matrix *transforms, int32_t count);
+int32_t  model_visual_instance_count(model_t model, int32_t visual);
+matrix   model_visual_instance      (model_t model, int32_t visual, int32_t instance);
 
 } // namespace sk
@@ -0,0 +1,863 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include "model_cache.h"
+#include "model.h"
+#include "mesh.h"
+#include "material.h"
+#include "shader.h"
+#include "texture.h"
+#include "texture_.h"
+#include "../sk_memory.h"
+#include "../libraries/array.h"
+#include "../libraries/ferr_hash.h"
+#include "../libraries/stref.h"
+#include "../libraries/sokol_time.h"
+#include "../platforms/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+// A cache file is a single blob, with a header at offset 0 and everything
+// else referenced by 16 byte aligned offsets from the start of the blob. An
+// offset of 0 means "no data". Nothing in here holds a pointer, so the blob
+// can be used directly from wherever it was read or mapped into memory.
+
+struct mc_header_t {
+	char     magic[4];
+	uint32_t version;
+	uint64_t sk_version;
+	uint64_t source_hash;
+	uint64_t source_size;
+	uint64_t settings_hash;
+	uint64_t data_size;
+	float    source_load_ms;
+	int32_t  reoptimize;
+	int32_t  tex_count;
+	int32_t  mat_count;
+	int32_t  mesh_count;
+	int32_t  node_count;
+	int32_t  anim_count;
+	int32_t  skel_count;
+	uint64_t texs;
+	uint64_t mats;
+	uint64_t meshes;
+	uint64_t nodes;
+	uint64_t anims;
+	uint64_t skels;
+};
+
+struct mc_tex_t {
+	uint64_t id;
+	uint64_t data;
+	uint64_t data_size;
+	int32_t  srgb;
+	int32_t  sample;
+	int32_t  address;
+	int32_t  anisotropy;
+};
+
+struct mc_tex_slot_t {
+	uint64_t name_hash;
+	int32_t  tex;
+	int32_t  pad;
+};
+
+struct mc_mat_t {
+	uint64_t id;
+	uint64_t shader_id;
+	uint64_t params;
+	uint64_t param_size;
+	uint64_t tex_slots;
+	int32_t  tex_slot_count;
+	int32_t  alpha_mode;
+	int32_t  cull;
+	int32_t  wireframe;
+	int32_t  depth_test;
+	int32_t  depth_write;
+	int32_t  queue_offset;
+	int32_t  pad;
+};
+
+struct mc_mesh_t {
+	uint64_t id;
+	uint64_t verts;
+	uint64_t inds;
+	uint64_t bone_data;
+	uint64_t bone_inverse;
+	int32_t  vert_count;
+	int32_t  ind_count;
+	int32_t  bone_count;
+	int32_t  pad;
+};
+
+struct mc_node_t {
+	matrix   transform;
+	uint64_t name;
+	uint64_t instances;
+	uint64_t info;
+	int32_t  parent;
+	int32_t  mesh;
+	int32_t  material;
+	int32_t  solid;
+	int32_t  visible;
+	int32_t  inst_count;
+	int32_t  info_count;
+	int32_t  pad;
+};
+
+struct mc_anim_t {
+	uint64_t name;
+	uint64_t curves;
+	float    duration;
+	int32_t  curve_count;
+};
+
+struct mc_curve_t {
+	uint64_t times;
+	uint64_t values;
+	uint64_t value_size;
+	int32_t  node_id;
+	int32_t  keyframe_count;
+	int32_t  applies_to;
+	int32_t  interpolation;
+};
+
+struct mc_skel_t {
+	uint64_t bone_map;
+	int32_t  skin_node;
+	int32_t  bone_count;
+};
+
+struct mc_blob_t {
+	const uint8_t *data;
+	size_t         size;
+};
+
+bool32_t model_cache_on     = false;
+char    *model_cache_folder = nullptr;
+
+///////////////////////////////////////////
+
+void model_set_load_cache(bool32_t enabled, const char *cache_folder_utf8) {
+	sk_free(model_cache_folder);
+	model_cache_on     = enabled;
+	model_cache_folder = enabled && cache_folder_utf8 != nullptr
+		? string_copy(cache_folder_utf8)
+		: nullptr;
+}
+
+///////////////////////////////////////////
+
+bool32_t model_get_load_cache() {
+	return model_cache_on;
+}
+
+///////////////////////////////////////////
+
+bool32_t model_cache_enabled() {
+	return model_cache_on;
+}
+
+///////////////////////////////////////////
+
+void model_cache_shutdown() {
+	sk_free(model_cache_folder);
+	model_cache_folder = nullptr;
+	model_cache_on     = false;
+}
+
+///////////////////////////////////////////
+
+static inline uint64_t mc_rotl(uint64_t x, int32_t r) { return (x << r) | (x >> (64 - r)); }
+
+// Source files can be large, so this hashes 8 bytes at a time across four
+// independent lanes rather than byte by byte like FNV. It only needs to
+// notice when a file has changed, it isn't meant for anything secure.
+static uint64_t mc_hash(const void *data, size_t size) {
+	const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+	const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+	const uint8_t *bytes  = (const uint8_t *)data;
+	uint64_t       lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		for (int32_t l = 0; l < 4; l++) {
+			uint64_t v;
+			memcpy(&v, bytes + i + l*8, sizeof(v));
+			lanes[l] = mc_rotl(lanes[l] + v * prime2, 31) * prime1;
+		}
+	}
+
+	uint64_t result = (uint64_t)size * prime1;
+	for (int32_t l = 0; l < 4; l++) {
+		result = (result ^ (mc_rotl(lanes[l] * prime2, 31) * prime1)) * prime1 + prime2;
+	}
+	result = hash_fnv64_data(bytes + i, size - i, result);
+
+	result ^= result >> 33;
+	result *= prime2;
+	result ^= result >> 29;
+	return result;
+}
+
+///////////////////////////////////////////
+
+static uint64_t mc_settings_hash(const char *filename, shader_t shader) {
+	uint64_t result = hash_fnv64_string(filename);
+	return shader != nullptr
+		? hash_fnv64_string(shader_get_id(shader), result)
+		: result;
+}
+
+///////////////////////////////////////////
+
+static char *mc_path(const char *filename) {
+	if (model_cache_folder == nullptr) {
+		char  *asset_file = assets_file(filename);
+		char  *result     = string_append(asset_file, 1, ".skcache");
+		return result;
+	}
+
+	int32_t count  = snprintf(nullptr, 0, "%s/%016llx.skcache", model_cache_folder, (unsigned long long)hash_fnv64_string(filename));
+	char   *result = sk_malloc_t(char, count + 1);
+	snprintf(result, count + 1, "%s/%016llx.skcache", model_cache_folder, (unsigned long long)hash_fnv64_string(filename));
+	return result;
+}
+
+///////////////////////////////////////////
+
+static bool mc_is_auto_id(const char *id) {
+	return id == nullptr || string_startswith(id, "auto/");
+}
+
+///////////////////////////////////////////
+// Reading                               //
+///////////////////////////////////////////
+
+static const void *mc_get(const mc_blob_t *blob, uint64_t offset, uint64_t size) {
+	if (offset == 0 || offset % 16 != 0 || offset > blob->size || size > blob->size - offset)
+		return nullptr;
+	return blob->data + offset;
+}
+
+///////////////////////////////////////////
+
+static const char *mc_str(const mc_blob_t *blob, uint64_t offset) {
+	if (offset == 0 || offset >= blob->size) return nullptr;
+	const char *str = (const char *)(blob->data + offset);
+	return memchr(str, '\0', blob->size - offset) != nullptr
+		? str
+		: nullptr;
+}
+
+///////////////////////////////////////////
+
+template <typename T>
+static const T *mc_table(const mc_blob_t *blob, uint64_t offset, int32_t count) {
+	if (count < 0) return nullptr;
+	if (count == 0) return (const T *)blob->data;
+	return (const T *)mc_get(blob, offset, sizeof(T) * (uint64_t)count);
+}
+
+///////////////////////////////////////////
+
+static size_t mc_curve_value_size(anim_element_ applies_to, anim_interpolation_ interpolation, int32_t keyframe_count) {
+	size_t size = 0;
+	switch (applies_to) {
+	case anim_element_translation:
+	case anim_element_scale:    size = sizeof(vec3); break;
+	case anim_element_rotation: size = sizeof(quat); break;
+	default: return 0;
+	}
+	// Cubic splines store an in-tangent, value, and out-tangent per key.
+	if (interpolation == anim_interpolation_cubic) size *= 3;
+	return size * keyframe_count;
+}
+
+///////////////////////////////////////////
+
+// Checks every table and offset in the blob before any assets get created,
+// this way a corrupt or truncated file is just a cache miss.
+static bool mc_validate(const mc_blob_t *blob, const mc_header_t *h) {
+	const mc_tex_t  *texs   = mc_table<mc_tex_t >(blob, h->texs,   h->tex_count);
+	const mc_mat_t  *mats   = mc_table<mc_mat_t >(blob, h->mats,   h->mat_count);
+	const mc_mesh_t *meshes = mc_table<mc_mesh_t>(blob, h->meshes, h->mesh_count);
+	const mc_node_t *nodes  = mc_table<mc_node_t>(blob, h->nodes,  h->node_count);
+	const mc_anim_t *anims  = mc_table<mc_anim_t>(blob, h->anims,  h->anim_count);
+	const mc_skel_t *skels  = mc_table<mc_skel_t>(blob, h->skels,  h->skel_count);
+	if (!texs || !mats || !meshes || !nodes || !anims || !skels) return false;
+
+	for (int32_t i = 0; i < h->tex_count; i++) {
+		if (mc_str(blob, texs[i].id) == nullptr) return false;
+		if (texs[i].data != 0 && mc_get(blob, texs[i].data, texs[i].data_size) == nullptr) return false;
+	}
+	for (int32_t i = 0; i < h->mat_count; i++) {
+		const mc_mat_t *m = &mats[i];
+		if (mc_str(blob, m->id) == nullptr || mc_str(blob, m->shader_id) == nullptr) return false;
+		if (m->param_size > 0 && mc_get(blob, m->params, m->param_size) == nullptr) return false;
+		const mc_tex_slot_t *slots = mc_table<mc_tex_slot_t>(blob, m->tex_slots, m->tex_slot_count);
+		if (slots == nullptr) return false;
+		for (int32_t s = 0; s < m->tex_slot_count; s++) {
+			if (slots[s].tex < 0 || slots[s].tex >= h->tex_count) return false;
+		}
+	}
+	for (int32_t i = 0; i < h->mesh_count; i++) {
+		const mc_mesh_t *m = &meshes[i];
+		if (mc_str(blob, m->id) == nullptr || m->vert_count < 0 || m->ind_count < 0 || m->bone_count < 0) return false;
+		// Empty arrays are fine, a mesh can be all verts and no indices.
+		const vind_t *inds = mc_table<vind_t>(blob, m->inds, m->ind_count);
+		if (mc_table<vert_t>(blob, m->verts, m->vert_count) == nullptr || inds == nullptr) return false;
+		if (m->bone_count > 0) {
+			if (mc_table<bone_weight_t>(blob, m->bone_data,    m->vert_count) == nullptr) return false;
+			if (mc_table<matrix>       (blob, m->bone_inverse, m->bone_count) == nullptr) return false;
+		}
+		for (int32_t v = 0; v < m->ind_count; v++) {
+			if (inds[v] >= (vind_t)m->vert_count) return false;
+		}
+	}
+	for (int32_t i = 0; i < h->node_count; i++) {
+		const mc_node_t *n = &nodes[i];
+		if (mc_str(blob, n->name) == nullptr) return false;
+		if (n->parent >= i || n->parent < -1) return false;
+		if ((n->mesh     < 0) != (n->material < 0))                     return false;
+		if (n->mesh     >= h->mesh_count || n->material >= h->mat_count) return false;
+		if (n->inst_count < 0 || n->info_count < 0)                     return false;
+		if (n->inst_count > 0 && (n->mesh < 0 || mc_get(blob, n->instances, sizeof(matrix) * (uint64_t)n->inst_count) == nullptr)) return false;
+		const uint64_t *info = mc_table<uint64_t>(blob, n->info, n->info_count * 2);
+		if (info == nullptr) return false;
+		for (int32_t s = 0; s < n->info_count * 2; s++) {
+			if (mc_str(blob, info[s]) == nullptr) return false;
+		}
+	}
+	for (int32_t i = 0; i < h->anim_count; i++) {
+		if (mc_str(blob, anims[i].name) == nullptr) return false;
+		const mc_curve_t *curves = mc_table<mc_curve_t>(blob, anims[i].curves, anims[i].curve_count);
+		if (curves == nullptr) return false;
+		for (int32_t c = 0; c < anims[i].curve_count; c++) {
+			const mc_curve_t *curve = &curves[c];
+			if (curve->keyframe_count <= 0 || curve->node_id < 0 || curve->node_id >= h->node_count) return false;
+			if (curve->value_size != mc_curve_value_size((anim_element_)curve->applies_to, (anim_interpolation_)curve->interpolation, curve->keyframe_count)) return false;
+			if (curve->value_size == 0) return false;
+			if (mc_get(blob, curve->times,  sizeof(float) * (uint64_t)curve->keyframe_count) == nullptr) return false;
+			if (mc_get(blob, curve->values, curve->value_size) == nullptr) return false;
+		}
+	}
+	for (int32_t i = 0; i < h->skel_count; i++) {
+		if (skels[i].bone_count < 0 || skels[i].skin_node < 0 || skels[i].skin_node >= h->node_count) return false;
+		const int32_t *map = mc_table<int32_t>(blob, skels[i].bone_map, skels[i].bone_count);
+		if (map == nullptr) return false;
+		for (int32_t b = 0; b < skels[i].bone_count; b++) {
+			if (map[b] < 0 || map[b] >= h->node_count) return false;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+static model_t mc_build(const mc_blob_t *blob, const mc_header_t *h, const char *filename) {
+	const mc_tex_t  *rec_texs   = mc_table<mc_tex_t >(blob, h->texs,   h->tex_count);
+	const mc_mat_t  *rec_mats   = mc_table<mc_mat_t >(blob, h->mats,   h->mat_count);
+	const mc_mesh_t *rec_meshes = mc_table<mc_mesh_t>(blob, h->meshes, h->mesh_count);
+	const mc_node_t *rec_nodes  = mc_table<mc_node_t>(blob, h->nodes,  h->node_count);
+	const mc_anim_t *rec_anims  = mc_table<mc_anim_t>(blob, h->anims,  h->anim_count);
+	const mc_skel_t *rec_skels  = mc_table<mc_skel_t>(blob, h->skels,  h->skel_count);
+
+	tex_t      *texs   = sk_malloc_zero_t(tex_t,      h->tex_count  + 1);
+	material_t *mats   = sk_malloc_zero_t(material_t, h->mat_count  + 1);
+	mesh_t     *meshes = sk_malloc_zero_t(mesh_t,     h->mesh_count + 1);
+	bool        valid  = true;
+
+	// Textures and materials may depend on assets from outside the cache,
+	// so resolve those first. If any are missing, nothing has touched a
+	// Model yet, and we can fall back to loading from the source file.
+	for (int32_t i = 0; valid && i < h->tex_count; i++) {
+		const mc_tex_t *rec = &rec_texs[i];
+		const char     *id  = mc_str(blob, rec->id);
+		texs[i] = tex_find(id);
+		if (texs[i] != nullptr) continue;
+
+		texs[i] = rec->data != 0
+			? tex_create_mem((void*)mc_get(blob, rec->data, rec->data_size), (size_t)rec->data_size, rec->srgb)
+			: tex_create_file(id, rec->srgb);
+		if (texs[i] == nullptr) { valid = false; break; }
+		if (rec->data != 0) tex_set_id(texs[i], id);
+		tex_set_sample    (texs[i], (tex_sample_ )rec->sample);
+		tex_set_address   (texs[i], (tex_address_)rec->address);
+		tex_set_anisotropy(texs[i], rec->anisotropy);
+	}
+
+	for (int32_t i = 0; valid && i < h->mat_count; i++) {
+		const mc_mat_t *rec = &rec_mats[i];
+		const char     *id  = mc_str(blob, rec->id);
+		if (!mc_is_auto_id(id)) {
+			mats[i] = material_find(id);
+			if (mats[i] != nullptr) continue;
+		}
+
+		shader_t shader = shader_find(mc_str(blob, rec->shader_id));
+		if (shader == nullptr) {
+			log_diagf("[%s] Model cache needs shader '%s', which isn't loaded", filename, mc_str(blob, rec->shader_id));
+			valid = false;
+			break;
+		}
+		mats[i] = material_create(shader);
+		shader_release(shader);
+		if (mats[i]->args.buffer_size != rec->param_size) { valid = false; break; }
+		if (rec->param_size > 0) {
+			memcpy(mats[i]->args.buffer, mc_get(blob, rec->params, rec->param_size), (size_t)rec->param_size);
+			mats[i]->args.buffer_dirty = true;
+		}
+		const mc_tex_slot_t *slots = mc_table<mc_tex_slot_t>(blob, rec->tex_slots, rec->tex_slot_count);
+		for (int32_t s = 0; s < rec->tex_slot_count; s++) {
+			material_set_texture_id(mats[i], slots[s].name_hash, texs[slots[s].tex]);
+		}
+		material_set_transparency(mats[i], (transparency_)rec->alpha_mode);
+		material_set_cull        (mats[i], (cull_       )rec->cull);
+		material_set_wireframe   (mats[i], rec->wireframe);
+		material_set_depth_test  (mats[i], (depth_test_ )rec->depth_test);
+		material_set_depth_write (mats[i], rec->depth_write);
+		material_set_queue_offset(mats[i], rec->queue_offset);
+		if (!mc_is_auto_id(id)) material_set_id(mats[i], id);
+	}
+
+	if (!valid) {
+		for (int32_t i = 0; i < h->tex_count; i++) tex_release     (texs[i]);
+		for (int32_t i = 0; i < h->mat_count; i++) material_release(mats[i]);
+		sk_free(texs);
+		sk_free(mats);
+		sk_free(meshes);
+		return nullptr;
+	}
+
+	// Meshes upload straight from the blob, all in one trip to the GPU
+	// thread.
+	array_t<mesh_upload_t> uploads = {};
+	array_t<int32_t>       created = {};
+	for (int32_t i = 0; i < h->mesh_count; i++) {
+		const mc_mesh_t *rec = &rec_meshes[i];
+		const char      *id  = mc_str(blob, rec->id);
+		if (!mc_is_auto_id(id)) {
+			meshes[i] = mesh_find(id);
+			if (meshes[i] != nullptr) continue;
+		}
+		meshes[i] = mesh_create();
+		if (!mc_is_auto_id(id)) mesh_set_id(meshes[i], id);
+		uploads.add({ meshes[i],
+			mc_table<vert_t>(blob, rec->verts, rec->vert_count), rec->vert_count,
+			mc_table<vind_t>(blob, rec->inds,  rec->ind_count ), rec->ind_count });
+		created.add(i);
+	}
+	mesh_set_data_batch(uploads.data, uploads.count);
+	uploads.free();
+
+	for (int32_t c = 0; c < created.count; c++) {
+		const mc_mesh_t *rec = &rec_meshes[created[c]];
+		if (rec->bone_count > 0) {
+			mesh_set_skin_inv(meshes[created[c]],
+				(const bone_weight_t *)mc_get(blob, rec->bone_data,    sizeof(bone_weight_t) * (uint64_t)rec->vert_count), rec->vert_count,
+				(const matrix        *)mc_get(blob, rec->bone_inverse, sizeof(matrix)        * (uint64_t)rec->bone_count), rec->bone_count);
+		}
+		// The cache may have been written before or after the load-time
+		// optimization got to a mesh, so formats that optimize on load get
+		// it applied again.
+		if (h->reoptimize)
+			mesh_optimize(meshes[created[c]], model_get_load_optimize());
+	}
+	created.free();
+
+	model_t model = model_create();
+	for (int32_t i = 0; i < h->node_count; i++) {
+		const mc_node_t *rec  = &rec_nodes[i];
+		model_node_id    node = model_node_add_child(model, rec->parent, mc_str(blob, rec->name), rec->transform,
+			rec->mesh     >= 0 ? meshes[rec->mesh]   : nullptr,
+			rec->material >= 0 ? mats[rec->material] : nullptr,
+			rec->solid);
+		if (rec->mesh >= 0 && !rec->visible)
+			model_node_set_visible(model, node, false);
+		if (rec->inst_count > 0)
+			model_node_set_instances(model, node, (const matrix *)mc_get(blob, rec->instances, sizeof(matrix) * (uint64_t)rec->inst_count), rec->inst_count);
+		const uint64_t *info = mc_table<uint64_t>(blob, rec->info, rec->info_count * 2);
+		for (int32_t s = 0; s < rec->info_count; s++) {
+			model_node_info_set(model, node, mc_str(blob, info[s*2]), mc_str(blob, info[s*2+1]));
+		}
+	}
+
+	for (int32_t i = 0; i < h->anim_count; i++) {
+		const mc_anim_t  *rec    = &rec_anims[i];
+		const mc_curve_t *curves = mc_table<mc_curve_t>(blob, rec->curves, rec->curve_count);
+		anim_t anim = {};
+		anim.name     = string_copy(mc_str(blob, rec->name));
+		anim.duration = rec->duration;
+		anim.curves.resize(rec->curve_count);
+		for (int32_t c = 0; c < rec->curve_count; c++) {
+			anim_curve_t curve = {};
+			curve.node_id         = curves[c].node_id;
+			curve.keyframe_count  = curves[c].keyframe_count;
+			curve.applies_to      = (anim_element_      )curves[c].applies_to;
+			curve.interpolation   = (anim_interpolation_)curves[c].interpolation;
+			curve.keyframe_times  = sk_malloc_t(float, curve.keyframe_count);
+			curve.keyframe_values = sk_malloc((size_t)curves[c].value_size);
+			memcpy(curve.keyframe_times,  mc_get(blob, curves[c].times,  sizeof(float) * (uint64_t)curve.keyframe_count), sizeof(float) * curve.keyframe_count);
+			memcpy(curve.keyframe_values, mc_get(blob, curves[c].values, curves[c].value_size), (size_t)curves[c].value_size);
+			anim.curves.add(curve);
+		}
+		model->anim_data.anims.add(anim);
+	}
+
+	for (int32_t i = 0; i < h->skel_count; i++) {
+		anim_skeleton_t skel = {};
+		skel.skin_node        = rec_skels[i].skin_node;
+		skel.bone_count       = rec_skels[i].bone_count;
+		skel.bone_to_node_map = sk_malloc_t(int32_t, skel.bone_count);
+		memcpy(skel.bone_to_node_map, mc_get(blob, rec_skels[i].bone_map, sizeof(int32_t) * (uint64_t)skel.bone_count), sizeof(int32_t) * skel.bone_count);
+		model->anim_data.skeletons.add(skel);
+	}
+
+	// The Model's nodes and materials hold their own references now.
+	for (int32_t i = 0; i < h->tex_count;  i++) tex_release     (texs  [i]);
+	for (int32_t i = 0; i < h->mat_count;  i++) material_release(mats  [i]);
+	for (int32_t i = 0; i < h->mesh_count; i++) mesh_release    (meshes[i]);
+	sk_free(texs);
+	sk_free(mats);
+	sk_free(meshes);
+	return model;
+}
+
+///////////////////////////////////////////
+
+model_t model_cache_load(const char *filename, const void *source_data, size_t source_size, shader_t shader, uint64_t *out_source_hash) {
+	uint64_t start = stm_now();
+	*out_source_hash = mc_hash(source_data, source_size);
+
+	platform_file_map_t file;
+	char *path   = mc_path(filename);
+	bool  loaded = platform_file_exists(path) && platform_file_map(path, &file);
+	sk_free(path);
+	if (!loaded) return nullptr;
+
+	void              *data = file.data;
+	size_t             size = file.size;
+	mc_blob_t          blob = { (const uint8_t *)data, size };
+	const mc_header_t *h    = size >= sizeof(mc_header_t) ? (const mc_header_t *)data : nullptr;
+	if (h == nullptr                              ||
+		memcmp(h->magic, "SKMC", 4) != 0          ||
+		h->version       != MODEL_CACHE_VERSION   ||
+		h->sk_version    != SK_VERSION_ID         ||
+		h->source_size   != source_size           ||
+		h->source_hash   != *out_source_hash      ||
+		h->settings_hash != mc_settings_hash(filename, shader) ||
+		h->data_size     != size) {
+		log_diagf("[%s] Model cache is out of date", filename);
+		platform_file_unmap(&file);
+		return nullptr;
+	}
+	if (!mc_validate(&blob, h)) {
+		log_warnf("[%s] Model cache file is invalid, ignoring it", filename);
+		platform_file_unmap(&file);
+		return nullptr;
+	}
+
+	model_t result = mc_build(&blob, h, filename);
+	if (result != nullptr) {
+		float ms = (float)stm_ms(stm_since(start));
+		log_diagf("[%s] Loaded from model cache in <~grn>%.1f<~clr>ms, source took %.1fms (saved %.1fms)", filename, ms, h->source_load_ms, h->source_load_ms - ms);
+	}
+	platform_file_unmap(&file);
+	return result;
+}
+
+///////////////////////////////////////////
+// Writing                               //
+///////////////////////////////////////////
+
+static uint64_t mc_write(array_t<uint8_t> *blob, const void *data, size_t size) {
+	while (blob->count % 16 != 0) blob->add(0);
+	uint64_t at = (uint64_t)blob->count;
+	if (size > 0) blob->add_range((const uint8_t *)data, (int32_t)size);
+	return at;
+}
+
+///////////////////////////////////////////
+
+static uint64_t mc_write_str(array_t<uint8_t> *blob, const char *str) {
+	return mc_write(blob, str, strlen(str) + 1);
+}
+
+///////////////////////////////////////////
+
+template <typename T>
+static int32_t mc_index_of(hashmap_t<T, int32_t> *map, array_t<T> *list, T item) {
+	int32_t *at = map->get(item);
+	if (at != nullptr) return *at;
+	int32_t index = list->add(item);
+	map->set(item, index);
+	return index;
+}
+
+///////////////////////////////////////////
+
+struct mc_mesh_job_t {
+	array_t<uint8_t> *blob;
+	array_t<mesh_t>  *meshes;
+	mc_mesh_t        *records;
+};
+
+// Mesh data can be swapped out by a load-time mesh_optimize, and that only
+// happens on the GPU thread, so this reads it from there too.
+static bool32_t mc_write_meshes(void *data) {
+	mc_mesh_job_t *job = (mc_mesh_job_t *)data;
+	for (int32_t i = 0; i < job->meshes->count; i++) {
+		mesh_t     mesh = (*job->meshes)[i];
+		mc_mesh_t *rec  = &job->records[i];
+		if ((mesh->verts == nullptr && mesh->vert_count > 0) ||
+			(mesh->inds  == nullptr && mesh->ind_count  > 0)) return false;
+		rec->vert_count = (int32_t)mesh->vert_count;
+		rec->ind_count  = (int32_t)mesh->ind_count;
+		rec->verts      = mc_write(job->blob, mesh->verts, sizeof(vert_t) * mesh->vert_count);
+		rec->inds       = mc_write(job->blob, mesh->inds,  sizeof(vind_t) * mesh->ind_count);
+		if (mesh->skin_data.bone_data != nullptr) {
+			rec->bone_count   = mesh->skin_data.bone_count;
+			rec->bone_data    = mc_write(job->blob, mesh->skin_data.bone_data,               sizeof(bone_weight_t) * mesh->vert_count);
+			rec->bone_inverse = mc_write(job->blob, mesh->skin_data.bone_inverse_transforms, sizeof(matrix)        * mesh->skin_data.bone_count);
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+static bool mc_write_tex(array_t<uint8_t> *blob, tex_t tex, const char *filename, void *source_data, size_t source_size, cgltf_data **ref_gltf, mc_tex_t *out_rec) {
+	const char *id = tex_get_id(tex);
+	*out_rec = {};
+	if (mc_is_auto_id(id)) return false;
+
+	// sRGB-ness isn't kept on the texture, but it's visible in the format
+	// once the image's metadata has loaded.
+	assets_block_until(&tex->header, asset_state_loaded_meta);
+	if (tex->header.state < 0) return false;
+	out_rec->srgb       = tex_format_is_srgb(tex->format);
+	out_rec->sample     = tex->sample_mode;
+	out_rec->address    = tex->address_mode;
+	out_rec->anisotropy = tex->anisotropy;
+	out_rec->id         = mc_write_str(blob, id);
+
+	// Images embedded in a glTF can't be found again by id alone, so their
+	// encoded bytes go into the cache. The glTF is parsed on the first one,
+	// and shared by the rest.
+	size_t filename_len = strlen(filename);
+	if (strncmp(id, filename, filename_len) == 0 && string_startswith(id + filename_len, "/tex/")) {
+		if (*ref_gltf == nullptr)
+			*ref_gltf = gltf_image_source_create(filename, source_data, source_size);
+		void  *data;
+		size_t size;
+		if (!gltf_image_data(*ref_gltf, atoi(id + filename_len + 5), &data, &size))
+			return false;
+		out_rec->data      = mc_write(blob, data, size);
+		out_rec->data_size = size;
+		sk_free(data);
+		return true;
+	}
+
+	if (string_startswith(id, "default/")) return true;
+
+	char *file   = assets_file(id);
+	bool  exists = platform_file_exists(file);
+	sk_free(file);
+	return exists;
+}
+
+///////////////////////////////////////////
+
+void model_cache_save(model_t model, const char *filename, void *source_data, size_t source_size, uint64_t source_hash, shader_t shader, float source_load_ms) {
+	if (model->nodes.count == 0) return;
+
+	// Morph target weights aren't something the rest of SK can use yet.
+	for (int32_t a = 0; a < model->anim_data.anims.count; a++) {
+		for (int32_t c = 0; c < model->anim_data.anims[a].curves.count; c++) {
+			if (model->anim_data.anims[a].curves[c].applies_to == anim_element_weights) {
+				log_diagf("[%s] Not cached, morph target animations aren't supported by the model cache", filename);
+				return;
+			}
+		}
+	}
+
+	array_t<uint8_t>    blob       = {};
+	array_t<mesh_t>     meshes     = {};
+	array_t<material_t> mats       = {};
+	array_t<tex_t>      texs       = {};
+	hashmap_t<mesh_t,     int32_t> mesh_map = {};
+	hashmap_t<material_t, int32_t> mat_map  = {};
+	hashmap_t<tex_t,      int32_t> tex_map  = {};
+	array_t<mc_node_t>  rec_nodes  = {};
+	array_t<mc_mat_t>   rec_mats   = {};
+	array_t<mc_tex_t>   rec_texs   = {};
+	array_t<mc_anim_t>  rec_anims  = {};
+	array_t<mc_skel_t>  rec_skels  = {};
+	mc_mesh_t          *rec_meshes = nullptr;
+	const char         *fail       = nullptr;
+
+	blob.resize(sizeof(mc_header_t));
+	blob.count = sizeof(mc_header_t);
+
+	for (int32_t i = 0; i < model->nodes.count; i++) {
+		const model_node_t *node = &model->nodes[i];
+		mc_node_t rec = {};
+		rec.transform = node->transform_local;
+		rec.name      = mc_write_str(&blob, node->name);
+		rec.parent    = node->parent;
+		rec.solid     = node->solid;
+		rec.mesh      = -1;
+		rec.material  = -1;
+		if (node->visual >= 0) {
+			const model_visual_t *vis = &model->visuals[node->visual];
+			if (vis->mesh == nullptr || vis->material == nullptr) { fail = "a node has a partial visual"; break; }
+			rec.mesh       = mc_index_of(&mesh_map, &meshes, vis->mesh);
+			rec.material   = mc_index_of(&mat_map,  &mats,   vis->material);
+			rec.visible    = vis->visible;
+			rec.inst_count = vis->inst_count;
+			if (vis->inst_count > 0)
+				rec.instances = mc_write(&blob, &model->instances[vis->inst_start], sizeof(matrix) * vis->inst_count);
+		}
+
+		array_t<uint64_t> info = {};
+		int32_t     iter = 0;
+		const char *key, *value;
+		while (model_node_info_iterate(model, i, &iter, &key, &value)) {
+			info.add(mc_write_str(&blob, key));
+			info.add(mc_write_str(&blob, value));
+		}
+		rec.info_count = info.count / 2;
+		rec.info       = mc_write(&blob, info.data, sizeof(uint64_t) * info.count);
+		info.free();
+		rec_nodes.add(rec);
+	}
+
+	for (int32_t i = 0; fail == nullptr && i < mats.count; i++) {
+		material_t mat = mats[i];
+		if (mat->shader == nullptr || mc_is_auto_id(shader_get_id(mat->shader))) { fail = "a material's shader has no id"; break; }
+
+		mc_mat_t rec = {};
+		rec.id           = mc_write_str(&blob, material_get_id(mat));
+		rec.shader_id    = mc_write_str(&blob, shader_get_id(mat->shader));
+		rec.param_size   = mat->args.buffer_size;
+		rec.params       = mc_write(&blob, mat->args.buffer, mat->args.buffer_size);
+		rec.alpha_mode   = mat->alpha_mode;
+		rec.cull         = mat->cull;
+		rec.wireframe    = mat->wireframe;
+		rec.depth_test   = mat->depth_test;
+		rec.depth_write  = mat->depth_write;
+		rec.queue_offset = mat->queue_offset;
+
+		array_t<mc_tex_slot_t> slots = {};
+		for (int32_t t = 0; t < mat->args.texture_count; t++) {
+			tex_t tex = mat->args.textures[t].tex;
+			if (tex == nullptr) continue;
+			slots.add({ mat->shader->shader.meta->resources[t].name_hash, mc_index_of(&tex_map, &texs, tex), 0 });
+		}
+		rec.tex_slot_count = slots.count;
+		rec.tex_slots      = mc_write(&blob, slots.data, sizeof(mc_tex_slot_t) * slots.count);
+		slots.free();
+		rec_mats.add(rec);
+	}
+
+	cgltf_data *gltf = nullptr;
+	for (int32_t i = 0; fail == nullptr && i < texs.count; i++) {
+		mc_tex_t rec;
+		if (!mc_write_tex(&blob, texs[i], filename, source_data, source_size, &gltf, &rec)) { fail = "a texture can't be found again by its id"; break; }
+		rec_texs.add(rec);
+	}
+	if (gltf != nullptr) gltf_image_source_destroy(gltf);
+
+	if (fail == nullptr) {
+		rec_meshes = sk_malloc_zero_t(mc_mesh_t, meshes.count + 1);
+		for (int32_t i = 0; i < meshes.count; i++)
+			rec_meshes[i].id = mc_write_str(&blob, mesh_get_id(meshes[i]));
+		mc_mesh_job_t job = { &blob, &meshes, rec_meshes };
+		if (!assets_execute_gpu(mc_write_meshes, &job))
+			fail = "a mesh doesn't keep its data";
+	}
+
+	for (int32_t a = 0; fail == nullptr && a < model->anim_data.anims.count; a++) {
+		const anim_t *anim = &model->anim_data.anims[a];
+		array_t<mc_curve_t> curves = {};
+		for (int32_t c = 0; c < anim->curves.count; c++) {
+			const anim_curve_t *curve = &anim->curves[c];
+			mc_curve_t rec = {};
+			rec.node_id        = curve->node_id;
+			rec.keyframe_count = curve->keyframe_count;
+			rec.applies_to     = curve->applies_to;
+			rec.interpolation  = curve->interpolation;
+			rec.value_size     = mc_curve_value_size(curve->applies_to, curve->interpolation, curve->keyframe_count);
+			rec.times          = mc_write(&blob, curve->keyframe_times,  sizeof(float) * curve->keyframe_count);
+			rec.values         = mc_write(&blob, curve->keyframe_values, (size_t)rec.value_size);
+			curves.add(rec);
+		}
+		mc_anim_t rec = {};
+		rec.name        = mc_write_str(&blob, anim->name);
+		rec.duration    = anim->duration;
+		rec.curve_count = curves.count;
+		rec.curves      = mc_write(&blob, curves.data, sizeof(mc_curve_t) * curves.count);
+		curves.free();
+		rec_anims.add(rec);
+	}
+
+	for (int32_t i = 0; fail == nullptr && i < model->anim_data.skeletons.count; i++) {
+		const anim_skeleton_t *skel = &model->anim_data.skeletons[i];
+		mc_skel_t rec = {};
+		rec.skin_node  = skel->skin_node;
+		rec.bone_count = skel->bone_count;
+		rec.bone_map   = mc_write(&blob, skel->bone_to_node_map, sizeof(int32_t) * skel->bone_count);
+		rec_skels.add(rec);
+	}
+
+	if (fail == nullptr) {
+		mc_header_t h = {};
+		memcpy(h.magic, "SKMC", 4);
+		h.version        = MODEL_CACHE_VERSION;
+		h.sk_version     = SK_VERSION_ID;
+		h.source_hash    = source_hash;
+		h.source_size    = source_size;
+		h.settings_hash  = mc_settings_hash(filename, shader);
+		h.source_load_ms = source_load_ms;
+		h.reoptimize     = !string_endswith(filename, ".glb",  false) && !string_endswith(filename, ".gltf", false) && !string_endswith(filename, ".vrm", false);
+		h.tex_count      = rec_texs .count; h.texs   = mc_write(&blob, rec_texs .data, sizeof(mc_tex_t ) * rec_texs .count);
+		h.mat_count      = rec_mats .count; h.mats   = mc_write(&blob, rec_mats .data, sizeof(mc_mat_t ) * rec_mats .count);
+		h.mesh_count     = meshes   .count; h.meshes = mc_write(&blob, rec_meshes,     sizeof(mc_mesh_t) * meshes   .count);
+		h.node_count     = rec_nodes.count; h.nodes  = mc_write(&blob, rec_nodes.data, sizeof(mc_node_t) * rec_nodes.count);
+		h.anim_count     = rec_anims.count; h.anims  = mc_write(&blob, rec_anims.data, sizeof(mc_anim_t) * rec_anims.count);
+		h.skel_count     = rec_skels.count; h.skels  = mc_write(&blob, rec_skels.data, sizeof(mc_skel_t) * rec_skels.count);
+		mc_write(&blob, nullptr, 0);
+		h.data_size      = (uint64_t)blob.count;
+		memcpy(blob.data, &h, sizeof(h));
+
+		char *path = mc_path(filename);
+		if (platform_write_file(path, blob.data, blob.count))
+			log_diagf("[%s] Saved model cache to %s", filename, path);
+		else
+			log_warnf("[%s] Couldn't write model cache to %s", filename, path);
+		sk_free(path);
+	} else {
+		log_diagf("[%s] Not cached, %s", filename, fail);
+	}
+
+	blob     .free();
+	meshes   .free();
+	mats     .free();
+	texs     .free();
+	mesh_map .free();
+	mat_map  .free();
+	tex_map  .free();
+	rec_nodes.free();
+	rec_mats .free();
+	rec_texs .free();
+	rec_anims.free();
+	rec_skels.free();
+	sk_free(rec_meshes);
+}
+
+} // namespace sk
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../stereokit.h"
+
+namespace sk {
+
+// The model cache stores a pre-cooked copy of a loaded Model next to its
+// source file, or in a cache folder. Cache files are keyed by a hash of the
+// source file's contents, the StereoKit version, and the cache format
+// version, so a stale cache is simply ignored and overwritten.
+
+#define MODEL_CACHE_VERSION 2
+
+bool32_t model_cache_enabled();
+model_t  model_cache_load   (const char *filename, const void *source_data, size_t source_size, shader_t shader, uint64_t *out_source_hash);
+void     model_cache_save   (model_t model, const char *filename, void *source_data, size_t source_size, uint64_t source_hash, shader_t shader, float source_load_ms);
+void     model_cache_shutdown();
+
+} // namespace sk
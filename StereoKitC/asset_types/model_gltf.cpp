@@ -3,6 +3,7 @@
 #include "model.h"
 #include "mesh_.h"
 #include "texture_.h"
+#include "asset_dedup.h"
 #include "../sk_math.h"
 #include "../sk_memory.h"
 #include "../systems/defaults.h"
@@ -10,6 +11,8 @@
 #include "../libraries/stref.h"
 #include "../platforms/platform.h"
 #include "../libraries/cgltf.h"
+#include "../systems/parallel.h"
+#include "../utils/meshopt_decode.h"
 
 #include <stdio.h>
 
@@ -22,6 +25,45 @@ namespace sk {
 // rotate the gltf matrices so that they use -Z as forward, simplifying lookat math
 matrix gltf_orientation_correction = matrix_trs(vec3_zero, quat_from_angles(0, 180, 0));
 
+struct gltf_skin_t {
+	uint16_t *bone_ids;
+	int32_t   bone_id_ct;
+	vec4     *weights;
+	int32_t   weight_ct;
+	matrix   *bone_trs;
+	int32_t   bone_tr_ct;
+};
+
+// Each mesh primitive in the file is converted on a worker thread, and the
+// results are collected here in file order, so the model assembles the same
+// way regardless of which thread finished first.
+struct gltf_prim_t {
+	cgltf_node           *node;
+	int32_t               primitive;
+	mesh_t                mesh;
+	bool                  parsed;
+	vert_t               *verts;
+	int32_t               vert_count;
+	vind_t               *inds;
+	int32_t               ind_count;
+	bool                  has_skin;
+	gltf_skin_t           skin;
+	array_t<const char *> warnings;
+	const char           *filename;
+	asset_dedup_key_t     dedup;
+};
+
+struct gltf_meshopt_t {
+	cgltf_buffer_view *view;
+	bool               decoded;
+};
+
+struct gltf_anim_ctx_t {
+	cgltf_data                            *data;
+	hashmap_t<cgltf_node*, model_node_id> *node_map;
+	anim_t                                *anims;
+};
+
 ///////////////////////////////////////////
 
 matrix gltf_build_node_matrix (cgltf_node *curr);
@@ -43,7 +85,10 @@ void gltf_add_warning(array_t<const char *> *warnings, const char *text) {
 
 ///////////////////////////////////////////
 
-bool gltf_parseskin(mesh_t sk_mesh, cgltf_node *node, int primitive_id, const char *filename) {
+// Only touches the cgltf data, so this is safe to call from worker threads.
+// The result gets applied with mesh_set_skin once the mesh has its verts.
+bool gltf_parseskin(cgltf_node *node, int primitive_id, const char *filename, gltf_skin_t *out_skin) {
+	*out_skin = {};
 	if (node->skin == nullptr)
 		return false;
 	
@@ -62,7 +107,7 @@ bool gltf_parseskin(mesh_t sk_mesh, cgltf_node *node, int primitive_id, const ch
 		cgltf_attribute   *attr      = &p->attributes[a];
 		cgltf_buffer_view *buff      = attr->data->buffer_view;
 		size_t             offset    = buff->offset + attr->data->offset;
-		uint8_t           *attr_data = ((uint8_t *)buff->buffer->data) + offset;
+		const uint8_t     *attr_data = cgltf_buffer_view_data(buff) + offset;
 
 		if (attr->type == cgltf_attribute_type_joints && attr->index == 0) {
 			int32_t _components = 4;
@@ -200,7 +245,7 @@ bool gltf_parseskin(mesh_t sk_mesh, cgltf_node *node, int primitive_id, const ch
 	if (node->skin->inverse_bind_matrices != nullptr) { 
 		cgltf_buffer_view *buff      = node->skin->inverse_bind_matrices->buffer_view;
 		size_t             offset    = buff->offset + node->skin->inverse_bind_matrices->offset;
-		uint8_t           *attr_data = ((uint8_t *)buff->buffer->data) + offset;
+		const uint8_t     *attr_data = cgltf_buffer_view_data(buff) + offset;
 
 		memcpy(bone_trs, attr_data, sizeof(matrix) *bone_tr_ct);
 		for (int32_t i = 0; i < bone_tr_ct; i++) {
@@ -212,36 +257,27 @@ bool gltf_parseskin(mesh_t sk_mesh, cgltf_node *node, int primitive_id, const ch
 		}
 	}
 
-	// And assign the skin!
-	mesh_set_skin(sk_mesh, bone_ids, bone_id_ct, weights, weight_ct, bone_trs, bone_tr_ct);
-
-	sk_free(bone_ids);
-	sk_free(weights);
-	sk_free(bone_trs);
-
+	out_skin->bone_ids   = bone_ids;
+	out_skin->bone_id_ct = bone_id_ct;
+	out_skin->weights    = weights;
+	out_skin->weight_ct  = weight_ct;
+	out_skin->bone_trs   = bone_trs;
+	out_skin->bone_tr_ct = bone_tr_ct;
 	return true;
 }
 
 ///////////////////////////////////////////
 
-mesh_t gltf_parsemesh(cgltf_mesh *mesh, int node_id, int primitive_id, const char *filename, array_t<const char *> *warnings) {
-	cgltf_mesh      *m = mesh;
-	cgltf_primitive *p = &m->primitives[primitive_id];
-
+// Converts a primitive into StereoKit verts and indices. This only touches
+// the cgltf data, so it's safe to run on worker threads.
+bool gltf_parsemesh(cgltf_primitive *p, const char *filename, array_t<const char *> *warnings, vert_t **out_verts, int32_t *out_vert_count, vind_t **out_inds, int32_t *out_ind_count) {
 	if (p->type != cgltf_primitive_type_triangles) {
 		log_errf("[%s] Unimplemented GLTF primitive mode: %d", filename, p->type);
-		return nullptr;
+		return false;
 	}
 	if (p->has_draco_mesh_compression) {
 		gltf_add_warning(warnings, "GLTF Draco Mesh Compression not currently supported");
-		return nullptr;
-	}
-
-	char id[512];
-	snprintf(id, sizeof(id), "%s/mesh/%d_%d_%s", filename, node_id, primitive_id, m->name);
-	mesh_t result = mesh_find(id);
-	if (result != nullptr) {
-		return result;
+		return false;
 	}
 
 	vert_t *verts = nullptr;
@@ -303,10 +339,11 @@ mesh_t gltf_parsemesh(cgltf_mesh *mesh, int node_id, int primitive_id, const cha
 				cgltf_float *floats = sk_malloc_t(cgltf_float, count);
 				cgltf_accessor_unpack_floats(attr->data, floats, count);
 
+				// Quantized normals won't quite be unit length anymore
 				if (attr->data->type == cgltf_type_vec3) {
 					for (size_t v = 0; v < attr->data->count; v++) {
 						vec3 *norm = (vec3*)&floats[v * 3];
-						verts[v].norm = *norm;
+						verts[v].norm = vec3_magnitude_sq(*norm) > 0 ? vec3_normalize(*norm) : *norm;
 					}
 				} else {
 					log_errf("[%s] Unimplemented vertex normal type (%d)", filename, attr->data->type);
@@ -424,13 +461,11 @@ mesh_t gltf_parsemesh(cgltf_mesh *mesh, int node_id, int primitive_id, const cha
 		mesh_calculate_normals(verts, vert_count, inds, (int32_t)ind_count);
 	}
 
-	result = mesh_create();
-	mesh_set_data(result, verts, vert_count, inds, (int32_t)ind_count);
-	mesh_set_id  (result, id);
-	sk_free(verts);
-	sk_free(inds );
-
-	return result;
+	*out_verts      = verts;
+	*out_vert_count = vert_count;
+	*out_inds       = inds;
+	*out_ind_count  = (int32_t)ind_count;
+	return true;
 }
 
 ///////////////////////////////////////////
@@ -487,7 +522,39 @@ void gltf_apply_sampler(tex_t to_tex, cgltf_sampler *sampler) {
 
 ///////////////////////////////////////////
 
-tex_t gltf_parsetexture(cgltf_data* data, cgltf_texture *tex, const char *filename, bool srgb_data, int32_t priority) {
+// Images embedded in the file can also be shared by content with images
+// embedded in other models, when asset deduplication is on. The sampler is
+// part of the key, since it's applied to the shared texture itself.
+tex_t gltf_texture_mem(const char *id, void *image_data, size_t image_size, bool srgb_data, int32_t priority, image_mip_ mip_mode, float mip_alpha_cutoff, cgltf_sampler *sampler) {
+	asset_dedup_key_t  dedup    = {};
+	int32_t            key[7]   = {};
+	asset_dedup_part_t parts[2] = {};
+	if (asset_dedup_enabled()) {
+		memcpy(&key[0], &mip_alpha_cutoff, sizeof(float));
+		key[1] = mip_mode;
+		key[2] = srgb_data ? 1 : 0;
+		key[3] = sampler ? sampler->mag_filter : -1;
+		key[4] = sampler ? sampler->min_filter : -1;
+		key[5] = sampler ? sampler->wrap_s     : -1;
+		key[6] = sampler ? sampler->wrap_t     : -1;
+		parts[0] = { key,        sizeof(key) };
+		parts[1] = { image_data, image_size  };
+		dedup = asset_dedup_key(parts, _countof(parts));
+		tex_t shared = (tex_t)asset_dedup_find(asset_type_tex, &dedup);
+		if (shared != nullptr) return shared;
+	}
+
+	tex_t result = tex_create_mem_type(tex_type_image, image_data, image_size, srgb_data, priority, mip_mode, mip_alpha_cutoff);
+	if (result == nullptr) return nullptr;
+	tex_set_id(result, id);
+	gltf_apply_sampler(result, sampler);
+	if (dedup.hash != 0) asset_dedup_add((asset_header_t *)result, &dedup);
+	return result;
+}
+
+///////////////////////////////////////////
+
+tex_t gltf_parsetexture(cgltf_data* data, cgltf_texture *tex, const char *filename, bool srgb_data, int32_t priority, image_mip_ mip_mode = image_mip_default, float mip_alpha_cutoff = 0) {
 	cgltf_image *image = tex->image;
 
 	// Check if we've already loaded this image
@@ -500,11 +567,9 @@ tex_t gltf_parsetexture(cgltf_data* data, cgltf_texture *tex, const char *filena
 
 	if (image->buffer_view != nullptr) {
 		// If it's already a loaded buffer, like in a .glb
-		result = tex_create_mem((void*)((uint8_t*)image->buffer_view->buffer->data + image->buffer_view->offset), image->buffer_view->size, srgb_data, priority);
+		result = gltf_texture_mem(id, (void*)cgltf_buffer_view_data(image->buffer_view), image->buffer_view->size, srgb_data, priority, mip_mode, mip_alpha_cutoff, tex->sampler);
 		if (result == nullptr) 
 			log_warnf("[%s] Couldn't load texture: %s", filename, image->name);
-		else
-			tex_set_id(result, id);
 	} else if (image->uri != nullptr && strncmp(image->uri, "data:", 5) == 0) {
 		// If it's an image file encoded in a base64 string
 		char* start = strchr(image->uri, ',');
@@ -525,17 +590,16 @@ tex_t gltf_parsetexture(cgltf_data* data, cgltf_texture *tex, const char *filena
 			cgltf_load_buffer_base64(&options, base64_size, base64_start, &buffer);
 
 			if (buffer != nullptr) {
-				result = tex_create_mem(buffer, base64_size, srgb_data, priority);
-				tex_set_id(result, id);
+				result = gltf_texture_mem(id, buffer, base64_size, srgb_data, priority, mip_mode, mip_alpha_cutoff, tex->sampler);
 				sk_free(buffer);
 			}
 		}
 	} else if (image->uri != nullptr && strstr(image->uri, "://") == nullptr) {
 		// If it's a file path to an external image file
-		result = tex_create_file(id, srgb_data, priority);
+		result = tex_create_file_type(id, tex_type_image, srgb_data, priority, mip_mode, mip_alpha_cutoff);
+		if (result != nullptr)
+			gltf_apply_sampler(result, tex->sampler);
 	}
-	if (result != nullptr)
-		gltf_apply_sampler(result, tex->sampler);
 
 	return result;
 }
@@ -589,12 +653,16 @@ material_t gltf_parsematerial(cgltf_data *data, cgltf_material *material, const
 	if (material == nullptr)
 		return result;
 
+	// Alpha tested materials need their cutouts to survive into the
+	// smaller mips.
+	image_mip_ color_mips = material->alpha_mode == cgltf_alpha_mode_mask ? image_mip_alpha_coverage : image_mip_default;
+
 	cgltf_texture *tex = nullptr;
 	if (material->has_pbr_metallic_roughness) {
 		tex = material->pbr_metallic_roughness.base_color_texture.texture;
 		if (tex != nullptr && material_has_param(result, "diffuse", material_param_texture)) {
 			if (material->pbr_metallic_roughness.base_color_texture.texcoord != 0) gltf_add_warning(warnings, "StereoKit doesn't support loading multiple texture coordinate channels yet.");
-			tex_t parse_tex = gltf_parsetexture(data, tex, filename, true, 10);
+			tex_t parse_tex = gltf_parsetexture(data, tex, filename, true, 10, color_mips, material->alpha_cutoff);
 			if (parse_tex != nullptr) {
 				material_set_texture(result, "diffuse", parse_tex);
 				tex_release(parse_tex);
@@ -626,7 +694,7 @@ material_t gltf_parsematerial(cgltf_data *data, cgltf_material *material, const
 		tex = material->pbr_specular_glossiness.diffuse_texture.texture;
 		if (tex != nullptr && material_has_param(result, "diffuse", material_param_texture)) {
 			if (material->pbr_specular_glossiness.diffuse_texture.texcoord != 0) gltf_add_warning(warnings, "StereoKit doesn't support multiple texture coordinate channels yet.");
-			tex_t parse_tex = gltf_parsetexture(data, tex, filename, true, 10);
+			tex_t parse_tex = gltf_parsetexture(data, tex, filename, true, 10, color_mips, material->alpha_cutoff);
 			if (parse_tex != nullptr) {
 				material_set_texture(result, "diffuse", parse_tex);
 				tex_release(parse_tex);
@@ -649,7 +717,7 @@ material_t gltf_parsematerial(cgltf_data *data, cgltf_material *material, const
 	tex = material->normal_texture.texture;
 	if (tex != nullptr && material_has_param(result, "normal", material_param_texture)) {
 		if (material->normal_texture.texcoord != 0) gltf_add_warning(warnings, "StereoKit doesn't support multiple texture coordinate channels yet.");
-		tex_t parse_tex = gltf_parsetexture(data, tex, filename, false, 13);
+		tex_t parse_tex = gltf_parsetexture(data, tex, filename, false, 13, image_mip_normal_map);
 		tex_set_fallback(parse_tex, sk_default_tex_flat);
 		if (parse_tex != nullptr) {
 			material_set_texture(result, "normal", parse_tex);
@@ -784,7 +852,59 @@ int32_t gltf_node_index(cgltf_data *data, cgltf_node *node) {
 
 ///////////////////////////////////////////
 
-void gltf_add_node(model_t model, shader_t shader, model_node_id parent, const char *filename, cgltf_data *data, cgltf_node *node, hashmap_t<cgltf_node*, model_node_id> *node_map, array_t<const char *> *warnings) {
+// Reads the per-instance TRS arrays from EXT_mesh_gpu_instancing. Any of
+// the three attributes may be missing, and they're all converted through
+// floats so quantized instance data works too.
+matrix *gltf_parseinstances(cgltf_node *node, const char *filename, int32_t *out_count) {
+	*out_count = 0;
+	if (!node->has_mesh_gpu_instancing || node->mesh == nullptr)
+		return nullptr;
+
+	const cgltf_accessor *pos   = nullptr;
+	const cgltf_accessor *rot   = nullptr;
+	const cgltf_accessor *scale = nullptr;
+	cgltf_size            count = 0;
+	for (cgltf_size i = 0; i < node->mesh_gpu_instancing.attributes_count; i++) {
+		const cgltf_attribute *attr = &node->mesh_gpu_instancing.attributes[i];
+		if      (strcmp(attr->name, "TRANSLATION") == 0 && attr->data->type == cgltf_type_vec3) pos   = attr->data;
+		else if (strcmp(attr->name, "ROTATION"   ) == 0 && attr->data->type == cgltf_type_vec4) rot   = attr->data;
+		else if (strcmp(attr->name, "SCALE"      ) == 0 && attr->data->type == cgltf_type_vec3) scale = attr->data;
+		else continue;
+
+		if (count != 0 && count != attr->data->count) {
+			log_warnf("[%s] Mismatched instance attribute counts on node %s", filename, node->name);
+			return nullptr;
+		}
+		count = attr->data->count;
+	}
+	if (count == 0) return nullptr;
+
+	vec3   *positions = sk_malloc_t(vec3, count);
+	quat   *rotations = sk_malloc_t(quat, count);
+	vec3   *scales    = sk_malloc_t(vec3, count);
+	matrix *result    = sk_malloc_t(matrix, count);
+	for (cgltf_size i = 0; i < count; i++) {
+		positions[i] = vec3_zero;
+		rotations[i] = quat_identity;
+		scales   [i] = vec3_one;
+	}
+	if (pos  ) cgltf_accessor_unpack_floats(pos,   &positions->x, count * 3);
+	if (rot  ) cgltf_accessor_unpack_floats(rot,   &rotations->x, count * 4);
+	if (scale) cgltf_accessor_unpack_floats(scale, &scales   ->x, count * 3);
+	for (cgltf_size i = 0; i < count; i++) {
+		result[i] = matrix_trs(positions[i], rot ? quat_normalize(rotations[i]) : rotations[i], scales[i]);
+	}
+	sk_free(positions);
+	sk_free(rotations);
+	sk_free(scales);
+
+	*out_count = (int32_t)count;
+	return result;
+}
+
+///////////////////////////////////////////
+
+void gltf_add_node(model_t model, shader_t shader, model_node_id parent, const char *filename, cgltf_data *data, cgltf_node *node, const gltf_prim_t *prims, const int32_t *node_prims, hashmap_t<cgltf_node*, model_node_id> *node_map, array_t<const char *> *warnings) {
 	int32_t       index   = (int32_t)(node - data->nodes);
 	model_node_id node_id = -1;
 
@@ -792,8 +912,11 @@ void gltf_add_node(model_t model, shader_t shader, model_node_id parent, const c
 	if (parent == -1)
 		transform = transform * gltf_orientation_correction;
 
+	int32_t inst_count = 0;
+	matrix *instances  = gltf_parseinstances(node, filename, &inst_count);
+
 	for (cgltf_size p = 0; node->mesh && p < node->mesh->primitives_count; p++) {
-		mesh_t mesh = gltf_parsemesh(node->mesh, index, (int)p, filename, warnings);
+		mesh_t mesh = prims[node_prims[index] + p].mesh;
 		if (mesh == nullptr) continue;
 
 		// If we're splitting this node into multiple meshes, then add the
@@ -808,15 +931,16 @@ void gltf_add_node(model_t model, shader_t shader, model_node_id parent, const c
 
 		material_t    material = gltf_parsematerial(data, node->mesh->primitives[p].material, filename, shader, warnings);
 		model_node_id new_node = model_node_add_child(model, primitive_parent, node->name, node_transform, mesh, material);
-		if (node->skin) 
-			gltf_parseskin(model_node_get_mesh(model, new_node), node, (int)p, filename);
 		if (node_id == -1)
 			node_id = new_node;
+		if (instances != nullptr)
+			model_node_set_instances(model, new_node, instances, inst_count);
 
-		mesh_release    (mesh);
 		material_release(material);
 	}
 
+	sk_free(instances);
+
 	if (node_id == -1) {
 		node_id = model_node_add_child(model, parent, node->name, transform, nullptr, nullptr);
 	}
@@ -828,13 +952,91 @@ void gltf_add_node(model_t model, shader_t shader, model_node_id parent, const c
 	}
 
 	for (size_t i = 0; i < node->children_count; i++) {
-		gltf_add_node(model, shader, node_id, filename, data, node->children[i], node_map, warnings);
+		gltf_add_node(model, shader, node_id, filename, data, node->children[i], prims, node_prims, node_map, warnings);
 	}
 }
 
 ///////////////////////////////////////////
 
-bool modelfmt_gltf(model_t model, const char *filename, void *file_data, size_t file_size, shader_t shader) {
+// Decodes an EXT_meshopt_compression buffer view into memory owned by the
+// view, so accessors read it like any other data. cgltf_free releases this
+// through our memory callbacks.
+bool gltf_decode_meshopt(cgltf_buffer_view *view) {
+	const cgltf_meshopt_compression *mc = &view->meshopt_compression;
+	if (mc->buffer == nullptr || mc->buffer->data == nullptr || mc->offset + mc->size > mc->buffer->size)
+		return false;
+
+	const uint8_t *src  = (const uint8_t *)mc->buffer->data + mc->offset;
+	size_t         size = mc->count * mc->stride;
+	uint8_t       *dest = sk_malloc_t(uint8_t, size > view->size ? size : view->size);
+	memset(dest + size, 0, size < view->size ? view->size - size : 0);
+
+	bool result = false;
+	switch (mc->mode) {
+	case cgltf_meshopt_compression_mode_attributes: result = meshopt_decode_vertices (dest, mc->count, mc->stride, src, mc->size); break;
+	case cgltf_meshopt_compression_mode_triangles:  result = meshopt_decode_triangles(dest, mc->count, mc->stride, src, mc->size); break;
+	case cgltf_meshopt_compression_mode_indices:    result = meshopt_decode_indices  (dest, mc->count, mc->stride, src, mc->size); break;
+	default: break;
+	}
+	if (result) {
+		switch (mc->filter) {
+		case cgltf_meshopt_compression_filter_octahedral:  meshopt_filter_octahedral (dest, mc->count, mc->stride); break;
+		case cgltf_meshopt_compression_filter_quaternion:  meshopt_filter_quaternion (dest, mc->count, mc->stride); break;
+		case cgltf_meshopt_compression_filter_exponential: meshopt_filter_exponential(dest, mc->count, mc->stride); break;
+		default: break;
+		}
+		view->data = dest;
+	} else {
+		sk_free(dest);
+	}
+	return result;
+}
+
+///////////////////////////////////////////
+
+void gltf_meshopt_batch(void *context, int32_t start, int32_t end) {
+	gltf_meshopt_t *views = (gltf_meshopt_t *)context;
+	for (int32_t i = start; i < end; i++) {
+		views[i].decoded = gltf_decode_meshopt(views[i].view);
+	}
+}
+
+///////////////////////////////////////////
+
+void gltf_prim_batch(void *context, int32_t start, int32_t end) {
+	gltf_prim_t *prims = (gltf_prim_t *)context;
+	for (int32_t i = start; i < end; i++) {
+		gltf_prim_t *prim = &prims[i];
+		if (prim->mesh == nullptr) {
+			prim->parsed = gltf_parsemesh(&prim->node->mesh->primitives[prim->primitive], prim->filename, &prim->warnings,
+				&prim->verts, &prim->vert_count, &prim->inds, &prim->ind_count);
+		}
+		if (prim->node->skin != nullptr)
+			prim->has_skin = gltf_parseskin(prim->node, prim->primitive, prim->filename, &prim->skin);
+
+		// Skinned meshes get their own skin data later on, so only plain
+		// geometry can be shared.
+		if (prim->parsed && !prim->has_skin && asset_dedup_enabled()) {
+			asset_dedup_part_t parts[2] = {
+				{ prim->verts, sizeof(vert_t) * prim->vert_count },
+				{ prim->inds,  sizeof(vind_t) * prim->ind_count  } };
+			prim->dedup = asset_dedup_key(parts, _countof(parts));
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+void gltf_anim_batch(void *context, int32_t start, int32_t end) {
+	gltf_anim_ctx_t *ctx = (gltf_anim_ctx_t *)context;
+	for (int32_t i = start; i < end; i++) {
+		ctx->anims[i] = gltf_parseanim(&ctx->data->animations[i], ctx->node_map);
+	}
+}
+
+///////////////////////////////////////////
+
+cgltf_options gltf_make_options() {
 	cgltf_options options = {};
 	options.file.read = [](const struct cgltf_memory_options*, const struct cgltf_file_options*, const char* path, cgltf_size* size, void** data) {
 		return platform_read_file(path, data, size)
@@ -846,6 +1048,73 @@ bool modelfmt_gltf(model_t model, const char *filename, void *file_data, size_t
 	};
 	options.memory.alloc_func = [](void *, cgltf_size size) { return sk_malloc(size); };
 	options.memory.free_func  = [](void *, void*      data) { sk_free(data); };
+	return options;
+}
+
+///////////////////////////////////////////
+
+cgltf_data *gltf_image_source_create(const char *filename, void *file_data, size_t file_size) {
+	cgltf_options options = gltf_make_options();
+	cgltf_data*   data    = nullptr;
+	if (cgltf_parse(&options, file_data, file_size, &data) != cgltf_result_success) {
+		cgltf_free(data);
+		return nullptr;
+	}
+
+	// Buffers are only needed for images stored in buffer views. If they
+	// fail to load, those images just come back empty.
+	for (cgltf_size i = 0; i < data->images_count; i++) {
+		if (data->images[i].buffer_view == nullptr) continue;
+		char *model_file = assets_file(filename);
+		cgltf_load_buffers(&options, data, model_file);
+		sk_free(model_file);
+		break;
+	}
+	return data;
+}
+
+///////////////////////////////////////////
+
+void gltf_image_source_destroy(cgltf_data *source) {
+	cgltf_free(source);
+}
+
+///////////////////////////////////////////
+
+bool gltf_image_data(cgltf_data *source, int32_t image, void **out_data, size_t *out_size) {
+	*out_data = nullptr;
+	*out_size = 0;
+	if (source == nullptr || image < 0 || image >= (int32_t)source->images_count)
+		return false;
+
+	cgltf_options options = gltf_make_options();
+	cgltf_image  *img     = &source->images[image];
+	if (img->buffer_view != nullptr) {
+		const void *view_data = cgltf_buffer_view_data(img->buffer_view);
+		if (view_data != nullptr) {
+			*out_size = img->buffer_view->size;
+			*out_data = sk_malloc(*out_size);
+			memcpy(*out_data, view_data, *out_size);
+		}
+	} else if (img->uri != nullptr && strncmp(img->uri, "data:", 5) == 0) {
+		char* start = strchr(img->uri, ',');
+		if (start != nullptr && start - img->uri >= 7 && strncmp(start - 7, ";base64", 7) == 0) {
+			char*  base64_start = start + 1;
+			size_t base64_len   = strlen(base64_start);
+			size_t base64_size  = 3 * (base64_len / 4);
+			if (base64_len >= 1 && base64_start[base64_len-1] == '=') { base64_size -= 1; }
+			if (base64_len >= 2 && base64_start[base64_len-2] == '=') { base64_size -= 1; }
+			if (cgltf_load_buffer_base64(&options, base64_size, base64_start, out_data) == cgltf_result_success)
+				*out_size = base64_size;
+		}
+	}
+	return *out_data != nullptr;
+}
+
+///////////////////////////////////////////
+
+bool modelfmt_gltf(model_t model, const char *filename, void *file_data, size_t file_size, shader_t shader) {
+	cgltf_options options = gltf_make_options();
 
 	cgltf_data*  data   = nullptr;
 	cgltf_result result = cgltf_parse(&options, file_data, file_size, &data);
@@ -866,17 +1135,104 @@ bool modelfmt_gltf(model_t model, const char *filename, void *file_data, size_t
 
 	array_t<const char *> warnings = {};
 
+	for (cgltf_size i = 0; i < data->extensions_required_count; i++) {
+		const char *ext = data->extensions_required[i];
+		if (strcmp(ext, "KHR_mesh_quantization"  ) != 0 &&
+			strcmp(ext, "EXT_meshopt_compression") != 0 &&
+			strcmp(ext, "EXT_mesh_gpu_instancing") != 0 &&
+			strcmp(ext, "KHR_materials_pbrSpecularGlossiness") != 0)
+			log_warnf("[%s] Requires unsupported GLTF extension %s, this may not load correctly", filename, ext);
+	}
+
+	// Decompress any meshopt buffer views up front, these are independent
+	// of each other, so they can spread across the worker threads.
+	array_t<gltf_meshopt_t> meshopt_views = {};
+	for (cgltf_size i = 0; i < data->buffer_views_count; i++) {
+		if (data->buffer_views[i].has_meshopt_compression)
+			meshopt_views.add({ &data->buffer_views[i], false });
+	}
+	parallel_for(meshopt_views.count, 1, meshopt_views.data, gltf_meshopt_batch);
+	bool meshopt_valid = true;
+	for (int32_t i = 0; i < meshopt_views.count; i++) {
+		meshopt_valid = meshopt_valid && meshopt_views[i].decoded;
+	}
+	meshopt_views.free();
+	if (!meshopt_valid) {
+		log_warnf("[%s] Couldn't decode EXT_meshopt_compression data", filename);
+		cgltf_free(data);
+		return false;
+	}
+
+	// List out every primitive in node order, picking up any meshes that
+	// were already loaded from this file.
+	array_t<gltf_prim_t> prims      = {};
+	int32_t             *node_prims = sk_malloc_t(int32_t, data->nodes_count);
+	for (cgltf_size i = 0; i < data->nodes_count; i++) {
+		cgltf_node *n = &data->nodes[i];
+		node_prims[i] = prims.count;
+		for (cgltf_size p = 0; n->mesh && p < n->mesh->primitives_count; p++) {
+			char id[512];
+			snprintf(id, sizeof(id), "%s/mesh/%d_%d_%s", filename, (int32_t)i, (int32_t)p, n->mesh->name);
+
+			gltf_prim_t prim = {};
+			prim.node      = n;
+			prim.primitive = (int32_t)p;
+			prim.mesh      = mesh_find(id);
+			prim.filename  = filename;
+			prims.add(prim);
+		}
+	}
+
+	// Convert primitives and skins across the worker threads
+	parallel_for(prims.count, 1, prims.data, gltf_prim_batch);
+
+	// Then create the new meshes, and upload them all in one trip to the GPU
+	// thread.
+	array_t<mesh_upload_t> uploads = {};
+	for (int32_t i = 0; i < prims.count; i++) {
+		gltf_prim_t *prim = &prims[i];
+		if (prim->mesh != nullptr || !prim->parsed) continue;
+
+		// Identical geometry, from this file or another, shares one mesh
+		if (prim->dedup.hash != 0) {
+			prim->mesh = (mesh_t)asset_dedup_find(asset_type_mesh, &prim->dedup);
+			if (prim->mesh != nullptr) continue;
+		}
+
+		char id[512];
+		snprintf(id, sizeof(id), "%s/mesh/%d_%d_%s", filename, (int32_t)(prim->node - data->nodes), prim->primitive, prim->node->mesh->name);
+		prim->mesh = mesh_create();
+		mesh_set_id(prim->mesh, id);
+		if (prim->dedup.hash != 0) asset_dedup_add((asset_header_t *)prim->mesh, &prim->dedup);
+		uploads.add({ prim->mesh, prim->verts, prim->vert_count, prim->inds, prim->ind_count });
+	}
+	mesh_set_data_batch(uploads.data, uploads.count);
+	uploads.free();
+
+	for (int32_t i = 0; i < prims.count; i++) {
+		gltf_prim_t *prim = &prims[i];
+		if (prim->has_skin && prim->mesh != nullptr)
+			mesh_set_skin(prim->mesh, prim->skin.bone_ids, prim->skin.bone_id_ct, prim->skin.weights, prim->skin.weight_ct, prim->skin.bone_trs, prim->skin.bone_tr_ct);
+		for (int32_t w = 0; w < prim->warnings.count; w++)
+			gltf_add_warning(&warnings, prim->warnings[w]);
+	}
+
 	// Load each root node
 	hashmap_t<cgltf_node*, model_node_id> node_map = {};
 	for (cgltf_size i = 0; i < data->nodes_count; i++) {
 		cgltf_node *n = &data->nodes[i];
 		if (n->parent == nullptr)
-			gltf_add_node(model, shader, -1, filename, data, n, &node_map, &warnings);
+			gltf_add_node(model, shader, -1, filename, data, n, prims.data, node_prims, &node_map, &warnings);
 	}
 
-	// Load each animation
-	for (cgltf_size i = 0; i < data->animations_count; i++) {
-		model->anim_data.anims.add( gltf_parseanim(&data->animations[i], &node_map) );
+	// Load each animation, node_map is only read from here on out
+	if (data->animations_count > 0) {
+		int32_t         anim_start = model->anim_data.anims.count;
+		gltf_anim_ctx_t anim_ctx   = { data, &node_map, nullptr };
+		model->anim_data.anims.resize(anim_start + (int32_t)data->animations_count);
+		model->anim_data.anims.count = anim_start + (int32_t)data->animations_count;
+		anim_ctx.anims = &model->anim_data.anims[anim_start];
+		parallel_for((int32_t)data->animations_count, 1, &anim_ctx, gltf_anim_batch);
 	}
 
 	// Load all the skeletons/skins
@@ -902,6 +1258,18 @@ bool modelfmt_gltf(model_t model, const char *filename, void *file_data, size_t
 		log_warnf("[%s] %s", filename, warnings[i]);
 	}
 
+	for (int32_t i = 0; i < prims.count; i++) {
+		gltf_prim_t *prim = &prims[i];
+		mesh_release(prim->mesh);
+		sk_free(prim->verts);
+		sk_free(prim->inds);
+		sk_free(prim->skin.bone_ids);
+		sk_free(prim->skin.weights);
+		sk_free(prim->skin.bone_trs);
+		prim->warnings.free();
+	}
+	prims.free();
+	sk_free(node_prims);
 	warnings.free();
 	node_map.free();
 	cgltf_free(data);
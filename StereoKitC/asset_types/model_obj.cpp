@@ -1,126 +1,649 @@
 #include "model.h"
 #include "mesh_.h"
-#include "../libraries/stref.h"
+#include "../sk_memory.h"
+#include "../sk_math.h"
 #include "../libraries/array.h"
+#include "../systems/parallel.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 namespace sk {
 
+// OBJ files are parsed in chunks split at line boundaries, so the text
+// parsing can run across the worker pool. Indices in a chunk may reference
+// data from earlier chunks, so those are resolved once every chunk knows
+// how many positions/normals/uvs came before it.
+
+const size_t  obj_chunk_min_size = 256 * 1024;
+const int32_t obj_dedup_min_size = 64 * 1024;
+
+struct obj_corner_t {
+	int32_t  ind[3];   // position, uv, normal. 0 is missing
+	uint32_t relative; // Bit per ind, set when ind is relative to the chunk start
+};
+
+struct obj_group_evt_t {
+	uint32_t    corner;
+	bool32_t    is_material;
+	const char *name;
+	int32_t     name_len;
+};
+
+struct obj_chunk_t {
+	const char              *start;
+	const char              *end;
+	array_t<vec3>            poss;
+	array_t<vec3>            norms;
+	array_t<vec2>            uvs;
+	array_t<obj_corner_t>    corners;
+	array_t<obj_group_evt_t> events;
+	int32_t                  poss_start;
+	int32_t                  norms_start;
+	int32_t                  uvs_start;
+};
+
+struct obj_group_t {
+	const char *obj_name;
+	int32_t     obj_name_len;
+	const char *mtl_name;
+	int32_t     mtl_name_len;
+	array_t<obj_corner_t> corners;
+};
+
+struct obj_range_t {
+	int32_t  chunk;
+	uint32_t start;
+	uint32_t end;
+	int32_t  group;
+};
+
+///////////////////////////////////////////
+// Tokenizing
+///////////////////////////////////////////
+
+static inline const char *obj_skip_space(const char *curr, const char *end) {
+	while (curr < end && (*curr == ' ' || *curr == '\t')) curr++;
+	return curr;
+}
+
+///////////////////////////////////////////
+
+static inline const char *obj_skip_word(const char *curr, const char *end) {
+	while (curr < end && *curr != ' ' && *curr != '\t' && *curr != '\r' && *curr != '\n') curr++;
+	return curr;
+}
+
+///////////////////////////////////////////
+
+static inline bool obj_is_digit(char c) { return c >= '0' && c <= '9'; }
+
+///////////////////////////////////////////
+
+static const double obj_pow10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Parses the float formats that OBJ exporters actually write. Anything
+// unusual like hex floats, inf, or nan falls back to strtod.
+static const char *obj_parse_float(const char *curr, const char *end, float *out_value) {
+	const char *start = curr;
+	bool negative = false;
+	if (curr < end && (*curr == '-' || *curr == '+')) {
+		negative = *curr == '-';
+		curr++;
+	}
+
+	uint64_t mantissa = 0;
+	int32_t  exponent = 0;
+	int32_t  digits   = 0;
+	for (; curr < end && obj_is_digit(*curr); curr++, digits++) {
+		if (mantissa < 1000000000000000000ull) mantissa = mantissa * 10 + (*curr - '0');
+		else                                   exponent += 1;
+	}
+	if (curr < end && *curr == '.') {
+		curr++;
+		for (; curr < end && obj_is_digit(*curr); curr++, digits++) {
+			if (mantissa < 1000000000000000000ull) {
+				mantissa = mantissa * 10 + (*curr - '0');
+				exponent -= 1;
+			}
+		}
+	}
+	if (digits == 0) {
+		char *str_end = nullptr;
+		*out_value = (float)strtod(start, &str_end);
+		return str_end > start ? str_end : obj_skip_word(start, end);
+	}
+	if (curr < end && (*curr == 'e' || *curr == 'E')) {
+		const char *exp_start = curr;
+		curr++;
+		bool exp_negative = false;
+		if (curr < end && (*curr == '-' || *curr == '+')) {
+			exp_negative = *curr == '-';
+			curr++;
+		}
+		if (curr < end && obj_is_digit(*curr)) {
+			int32_t exp_value = 0;
+			for (; curr < end && obj_is_digit(*curr); curr++) {
+				if (exp_value < 10000) exp_value = exp_value * 10 + (*curr - '0');
+			}
+			exponent += exp_negative ? -exp_value : exp_value;
+		} else {
+			curr = exp_start;
+		}
+	}
+
+	// Exponents past the table are applied in steps of 1e22, which keeps
+	// things like 1e-30 or 4e25 exact enough for a float result.
+	double value = (double)mantissa;
+	while (exponent < -22 && value != 0) {
+		value    /= 1e22;
+		exponent += 22;
+	}
+	while (exponent > 22 && value != 0 && value < HUGE_VAL) {
+		value    *= 1e22;
+		exponent -= 22;
+	}
+	if      (exponent < -22) value  = 0;
+	else if (exponent <   0) value /= obj_pow10[-exponent];
+	else if (exponent <= 22) value *= obj_pow10[ exponent];
+	*out_value = (float)(negative ? -value : value);
+	return curr;
+}
+
+///////////////////////////////////////////
+
+static inline const char *obj_parse_int(const char *curr, const char *end, int32_t *out_value) {
+	bool negative = false;
+	if (curr < end && (*curr == '-' || *curr == '+')) {
+		negative = *curr == '-';
+		curr++;
+	}
+	int32_t value = 0;
+	for (; curr < end && obj_is_digit(*curr); curr++)
+		value = value * 10 + (*curr - '0');
+	*out_value = negative ? -value : value;
+	return curr;
+}
+
 ///////////////////////////////////////////
 
-int indexof(int iV, int iT, int iN, array_t<vec3> *verts, array_t<vec3> *norms, array_t<vec2> *uvs, hashmap_t<vert_t, vind_t> *indmap, array_t<vert_t> *mesh_verts) {
-	vert_t v = vert_t{
-		iV <= verts->count ? verts->get(iV - 1) : vec3{0,0,0},
-		iN <= norms->count ? norms->get(iN - 1) : vec3{0,1,0},
-		iT <= uvs->count   ? uvs  ->get(iT - 1) : vec2{0,0},
-		{255,255,255,255} };
+static const char *obj_parse_floats(const char *curr, const char *end, float *out_values, int32_t count) {
+	for (int32_t i = 0; i < count; i++) {
+		curr = obj_skip_space(curr, end);
+		if (curr >= end || *curr == '\r' || *curr == '\n') break;
+		curr = obj_parse_float(curr, end, &out_values[i]);
+	}
+	return curr;
+}
+
+///////////////////////////////////////////
+
+static void obj_parse_chunk(obj_chunk_t *chunk) {
+	const char  *curr = chunk->start;
+	const char  *end  = chunk->end;
+	obj_corner_t face[3];
+
+	while (curr < end) {
+		curr = obj_skip_space(curr, end);
+		if (curr >= end) break;
+		const char *line_end = (const char *)memchr(curr, '\n', end - curr);
+		if (line_end == nullptr) line_end = end;
+
+		if (curr[0] == 'v' && curr + 1 < line_end) {
+			float values[3] = {};
+			if (curr[1] == ' ' || curr[1] == '\t') {
+				obj_parse_floats(curr + 2, line_end, values, 3);
+				chunk->poss.add(vec3{ values[0], values[1], values[2] });
+			} else if (curr[1] == 'n' && curr + 2 < line_end && (curr[2] == ' ' || curr[2] == '\t')) {
+				obj_parse_floats(curr + 3, line_end, values, 3);
+				chunk->norms.add(vec3{ values[0], values[1], values[2] });
+			} else if (curr[1] == 't' && curr + 2 < line_end && (curr[2] == ' ' || curr[2] == '\t')) {
+				obj_parse_floats(curr + 3, line_end, values, 2);
+				chunk->uvs.add(vec2{ values[0], values[1] });
+			}
+		} else if (curr[0] == 'f' && curr + 1 < line_end && (curr[1] == ' ' || curr[1] == '\t')) {
+			// Polygons are triangulated as a fan around the first corner
+			const char *c     = curr + 2;
+			int32_t     sides = 0;
+			while (true) {
+				c = obj_skip_space(c, line_end);
+				if (c >= line_end || *c == '\r' || !(obj_is_digit(*c) || *c == '-' || *c == '+')) break;
+
+				// Negative indices count back from this point in the file, so
+				// they're pinned to the chunk here, while we still know how
+				// much data came before them.
+				obj_corner_t corner = {};
+				for (int32_t i = 0; i < 3; i++) {
+					if (c < line_end && (obj_is_digit(*c) || *c == '-' || *c == '+')) c = obj_parse_int(c, line_end, &corner.ind[i]);
+					if (corner.ind[i] < 0) {
+						int32_t count = i == 0 ? chunk->poss.count : (i == 1 ? chunk->uvs.count : chunk->norms.count);
+						corner.ind[i]   += count;
+						corner.relative |= 1 << i;
+					}
+					if (c >= line_end || *c != '/') break;
+					c++;
+				}
+				c = obj_skip_word(c, line_end);
 
-	int32_t index = indmap->contains(v);
-	if (index < 0) {
-		index = mesh_verts->add(v);
-		indmap->set(v, (vind_t)index);
-	} else {
-		index = indmap->items[index].value;
+				if      (sides == 0) face[0] = corner;
+				else if (sides == 1) face[1] = corner;
+				else {
+					face[2] = corner;
+					chunk->corners.add(face[0]);
+					chunk->corners.add(face[1]);
+					chunk->corners.add(face[2]);
+					face[1] = corner;
+				}
+				sides += 1;
+			}
+		} else if ((curr[0] == 'o' || curr[0] == 'g') && curr + 1 < line_end && (curr[1] == ' ' || curr[1] == '\t')) {
+			const char *name = obj_skip_space(curr + 2, line_end);
+			const char *name_end = line_end;
+			while (name_end > name && (name_end[-1] == '\r' || name_end[-1] == ' ' || name_end[-1] == '\t')) name_end--;
+			chunk->events.add({ (uint32_t)chunk->corners.count, false, name, (int32_t)(name_end - name) });
+		} else if (line_end - curr > 7 && memcmp(curr, "usemtl", 6) == 0 && (curr[6] == ' ' || curr[6] == '\t')) {
+			const char *name = obj_skip_space(curr + 7, line_end);
+			const char *name_end = line_end;
+			while (name_end > name && (name_end[-1] == '\r' || name_end[-1] == ' ' || name_end[-1] == '\t')) name_end--;
+			chunk->events.add({ (uint32_t)chunk->corners.count, true, name, (int32_t)(name_end - name) });
+		}
+		curr = line_end + 1;
 	}
-	return (int)index;
 }
 
 ///////////////////////////////////////////
 
-bool modelfmt_obj(model_t model, const char *filename, void *file_data, size_t, shader_t shader) {
+static void obj_parse_chunk_batch(void *context, int32_t start, int32_t end) {
+	obj_chunk_t *chunks = (obj_chunk_t *)context;
+	for (int32_t i = start; i < end; i++) obj_parse_chunk(&chunks[i]);
+}
+
+///////////////////////////////////////////
+// Index resolution
+///////////////////////////////////////////
+
+struct obj_resolve_t {
+	obj_chunk_t *chunks;
+	int32_t      poss_count;
+	int32_t      norms_count;
+	int32_t      uvs_count;
+	vec3        *poss;
+	vec3        *norms;
+	vec2        *uvs;
+};
+
+static inline int32_t obj_resolve_ind(int32_t ind, bool relative, int32_t chunk_start, int32_t count) {
+	// Results are zero based, and -1 for missing or out of range. Relative
+	// indices were made zero based from the start of their chunk while
+	// parsing.
+	if (!relative && ind == 0) return -1;
+	int32_t result = relative ? chunk_start + ind : ind - 1;
+	return result >= 0 && result < count ? result : -1;
+}
+
+static void obj_resolve_batch(void *context, int32_t start, int32_t end) {
+	obj_resolve_t *ctx = (obj_resolve_t *)context;
+	for (int32_t c = start; c < end; c++) {
+		obj_chunk_t *chunk = &ctx->chunks[c];
+		if (chunk->poss .count > 0) memcpy(&ctx->poss [chunk->poss_start ], chunk->poss .data, sizeof(vec3) * chunk->poss .count);
+		if (chunk->norms.count > 0) memcpy(&ctx->norms[chunk->norms_start], chunk->norms.data, sizeof(vec3) * chunk->norms.count);
+		if (chunk->uvs  .count > 0) memcpy(&ctx->uvs  [chunk->uvs_start  ], chunk->uvs  .data, sizeof(vec2) * chunk->uvs  .count);
+
+		for (int32_t i = 0; i < chunk->corners.count; i++) {
+			obj_corner_t *corner = &chunk->corners[i];
+			corner->ind[0]   = obj_resolve_ind(corner->ind[0], corner->relative & 1, chunk->poss_start,  ctx->poss_count );
+			corner->ind[1]   = obj_resolve_ind(corner->ind[1], corner->relative & 2, chunk->uvs_start,   ctx->uvs_count  );
+			corner->ind[2]   = obj_resolve_ind(corner->ind[2], corner->relative & 4, chunk->norms_start, ctx->norms_count);
+			corner->relative = 0;
+		}
+	}
+}
+
+///////////////////////////////////////////
+// Vertex dedup
+///////////////////////////////////////////
+
+// Corners are deduplicated by their index triplet. They're scattered into
+// partitions by hash, each partition builds its own table in parallel, and
+// then a single linear pass gives verts their final first-use order.
+
+struct obj_dedup_entry_t {
+	obj_corner_t key;
+	uint32_t     value;
+};
+
+struct obj_dedup_t {
+	const obj_corner_t *corners;
+	int32_t             corner_count;
+	uint32_t           *hashes;
+	int32_t             batch_size;
+	int32_t             part_bits;
+	int32_t             part_count;
+	uint32_t           *histogram;    // [batch][part]
+	uint32_t           *part_start;
+	uint32_t           *part_corners;
+	uint32_t           *part_uniques;
+	uint32_t           *corner_vert;
+};
+
+static inline uint32_t obj_hash(const obj_corner_t &c) {
+	uint32_t h = (uint32_t)c.ind[0] * 0x9E3779B1u ^ (uint32_t)c.ind[1] * 0x85EBCA77u ^ (uint32_t)c.ind[2] * 0xC2B2AE3Du;
+	h ^= h >> 15; h *= 0x2C1B3C6Du;
+	h ^= h >> 12; h *= 0x297A2D39u;
+	h ^= h >> 15;
+	return h;
+}
+
+static void obj_dedup_hash_batch(void *context, int32_t start, int32_t end) {
+	obj_dedup_t *ctx   = (obj_dedup_t *)context;
+	int32_t      shift = 32 - ctx->part_bits;
+	for (int32_t b = start; b < end; b++) {
+		uint32_t *hist  = &ctx->histogram[b * ctx->part_count];
+		int32_t   first = b * ctx->batch_size;
+		int32_t   last  = mini(first + ctx->batch_size, ctx->corner_count);
+		memset(hist, 0, sizeof(uint32_t) * ctx->part_count);
+		for (int32_t i = first; i < last; i++) {
+			uint32_t h = obj_hash(ctx->corners[i]);
+			ctx->hashes[i] = h;
+			hist[ctx->part_bits > 0 ? h >> shift : 0] += 1;
+		}
+	}
+}
+
+static void obj_dedup_scatter_batch(void *context, int32_t start, int32_t end) {
+	obj_dedup_t *ctx   = (obj_dedup_t *)context;
+	int32_t      shift = 32 - ctx->part_bits;
+	for (int32_t b = start; b < end; b++) {
+		uint32_t *dest  = &ctx->histogram[b * ctx->part_count];
+		int32_t   first = b * ctx->batch_size;
+		int32_t   last  = mini(first + ctx->batch_size, ctx->corner_count);
+		for (int32_t i = first; i < last; i++) {
+			uint32_t p = ctx->part_bits > 0 ? ctx->hashes[i] >> shift : 0;
+			ctx->part_corners[dest[p]] = i;
+			dest[p] += 1;
+		}
+	}
+}
+
+static void obj_dedup_part_batch(void *context, int32_t start, int32_t end) {
+	obj_dedup_t *ctx = (obj_dedup_t *)context;
+	for (int32_t p = start; p < end; p++) {
+		uint32_t first = ctx->part_start[p];
+		uint32_t count = ctx->part_start[p + 1] - first;
+		if (count == 0) { ctx->part_uniques[p] = 0; continue; }
+
+		uint32_t capacity = 16;
+		while (capacity < count * 2) capacity *= 2;
+		uint32_t           mask  = capacity - 1;
+		obj_dedup_entry_t *table = sk_malloc_t(obj_dedup_entry_t, capacity);
+		for (uint32_t i = 0; i < capacity; i++) table[i].value = UINT32_MAX;
+
+		uint32_t uniques = 0;
+		for (uint32_t i = first; i < first + count; i++) {
+			uint32_t            c      = ctx->part_corners[i];
+			const obj_corner_t *corner = &ctx->corners[c];
+			uint32_t            slot   = ctx->hashes[c] & mask;
+			while (true) {
+				obj_dedup_entry_t *entry = &table[slot];
+				if (entry->value == UINT32_MAX) {
+					entry->key   = *corner;
+					entry->value = uniques;
+					uniques += 1;
+					break;
+				}
+				if (memcmp(&entry->key, corner, sizeof(obj_corner_t)) == 0) break;
+				slot = (slot + 1) & mask;
+			}
+			ctx->corner_vert[c] = first + table[slot].value;
+		}
+		ctx->part_uniques[p] = uniques;
+		sk_free(table);
+	}
+}
+
+///////////////////////////////////////////
+
+// Fills out_verts/out_inds, returns the number of unique verts.
+static int32_t obj_dedup(const obj_corner_t *corners, int32_t corner_count, const vec3 *poss, const vec2 *uvs, const vec3 *norms, vert_t **out_verts, vind_t **out_inds) {
+	obj_dedup_t ctx = {};
+	ctx.corners      = corners;
+	ctx.corner_count = corner_count;
+
+	// Small meshes aren't worth partitioning
+	int32_t workers = parallel_worker_count();
+	if (workers > 1 && corner_count >= obj_dedup_min_size) {
+		while ((1 << ctx.part_bits) < workers * 4 && ctx.part_bits < 6) ctx.part_bits += 1;
+	}
+	ctx.part_count   = 1 << ctx.part_bits;
+	ctx.batch_size   = maxi(obj_dedup_min_size / 4, (corner_count + workers * 4 - 1) / (workers * 4));
+	int32_t batches  = (corner_count + ctx.batch_size - 1) / ctx.batch_size;
+
+	ctx.hashes       = sk_malloc_t(uint32_t, corner_count);
+	ctx.histogram    = sk_malloc_t(uint32_t, batches * ctx.part_count);
+	ctx.part_start   = sk_malloc_t(uint32_t, ctx.part_count + 1);
+	ctx.part_uniques = sk_malloc_t(uint32_t, ctx.part_count);
+	ctx.part_corners = sk_malloc_t(uint32_t, corner_count);
+	ctx.corner_vert  = sk_malloc_t(uint32_t, corner_count);
+
+	// Counting sort corners into partitions, keeping file order inside each
+	// partition so results are deterministic.
+	parallel_for(batches, 1, &ctx, obj_dedup_hash_batch);
+	uint32_t offset = 0;
+	for (int32_t p = 0; p < ctx.part_count; p++) {
+		ctx.part_start[p] = offset;
+		for (int32_t b = 0; b < batches; b++) {
+			uint32_t count = ctx.histogram[b * ctx.part_count + p];
+			ctx.histogram[b * ctx.part_count + p] = offset;
+			offset += count;
+		}
+	}
+	ctx.part_start[ctx.part_count] = offset;
+	parallel_for(batches,        1, &ctx, obj_dedup_scatter_batch);
+	parallel_for(ctx.part_count, 1, &ctx, obj_dedup_part_batch);
+
+	// Number verts by first use. Partition local ids are offset into the
+	// partition's range, so this remap table is indexed the same way. The
+	// hash and partition lists are done with, so they get reused here.
+	uint32_t *remap = ctx.part_corners;
+	for (int32_t p = 0; p < ctx.part_count; p++) {
+		for (uint32_t i = ctx.part_start[p]; i < ctx.part_start[p] + ctx.part_uniques[p]; i++)
+			remap[i] = UINT32_MAX;
+	}
+	vind_t  *inds       = sk_malloc_t(vind_t, corner_count);
+	uint32_t vert_count = 0;
+	for (int32_t i = 0; i < corner_count; i++) {
+		uint32_t v = ctx.corner_vert[i];
+		if (remap[v] == UINT32_MAX) {
+			remap[v] = vert_count;
+			ctx.hashes[vert_count] = i;
+			vert_count += 1;
+		}
+		inds[i] = (vind_t)remap[v];
+	}
+
+	vert_t *verts = sk_malloc_t(vert_t, vert_count);
+	for (uint32_t v = 0; v < vert_count; v++) {
+		const obj_corner_t &c = corners[ctx.hashes[v]];
+		verts[v] = vert_t{
+			c.ind[0] >= 0 ? poss [c.ind[0]] : vec3{0,0,0},
+			c.ind[2] >= 0 ? norms[c.ind[2]] : vec3{0,1,0},
+			c.ind[1] >= 0 ? uvs  [c.ind[1]] : vec2{0,0},
+			{255,255,255,255} };
+	}
+
+	sk_free(ctx.hashes);
+	sk_free(ctx.histogram);
+	sk_free(ctx.part_start);
+	sk_free(ctx.part_uniques);
+	sk_free(ctx.part_corners);
+	sk_free(ctx.corner_vert);
+
+	*out_verts = verts;
+	*out_inds  = inds;
+	return (int32_t)vert_count;
+}
+
+///////////////////////////////////////////
+// Loading
+///////////////////////////////////////////
+
+static void obj_mesh_id(char *out_id, size_t id_size, const char *filename, int32_t group) {
+	if (group == 0) snprintf(out_id, id_size, "%s/mesh",    filename);
+	else            snprintf(out_id, id_size, "%s/mesh_%d", filename, group);
+}
+
+///////////////////////////////////////////
+
+bool modelfmt_obj(model_t model, const char *filename, void *file_data, size_t file_size, shader_t shader) {
 	material_t material = shader == nullptr ? material_find(default_id_material) : material_create(shader);
 	char id[512];
-	snprintf(id, sizeof(id), "%s/mesh", filename);
+	obj_mesh_id(id, sizeof(id), filename, 0);
 	mesh_t mesh = mesh_find(id);
 
+	// Each group in the file is its own mesh, and if we've loaded this file
+	// before, they'll all be in the asset list already.
 	if (mesh) {
-		model_add_subset(model, mesh, material, matrix_identity);
-
+		int32_t group = 0;
+		while (mesh) {
+			model_add_subset(model, mesh, material, matrix_identity);
+			mesh_release(mesh);
+			group += 1;
+			obj_mesh_id(id, sizeof(id), filename, group);
+			mesh = mesh_find(id);
+		}
 		material_release(material);
-		mesh_release(mesh);
 		return true;
 	}
 
-	array_t<vec3>   poss  = {};
-	array_t<vec3>   norms = {};
-	array_t<vec2>   uvs   = {};
-	array_t<vert_t> verts = {};
-	array_t<vind_t> faces = {};
-	hashmap_t<vert_t, vind_t> indmap = {};
-	
-	vec3 in;
-	int inds[12] = {};
-
-	stref_t data = stref_make((const char *)file_data);
-	stref_t line = {};
-	while (stref_nextline(data, line)) {
-		stref_t word = {};
-		if (!stref_nextword(line, word))
-			continue;
-
-		if        (stref_equals(word, "v" )) {
-			in = {};
-			if (stref_nextword(line, word)) in.x = stref_to_f(word);
-			if (stref_nextword(line, word)) in.y = stref_to_f(word);
-			if (stref_nextword(line, word)) in.z = stref_to_f(word);
-			poss.add(in);
-		} else if (stref_equals(word, "vn")) {
-			in = {};
-			if (stref_nextword(line, word)) in.x = stref_to_f(word);
-			if (stref_nextword(line, word)) in.y = stref_to_f(word);
-			if (stref_nextword(line, word)) in.z = stref_to_f(word);
-			norms.add(in);
-		} else if (stref_equals(word, "vt")) {
-			in = {};
-			if (stref_nextword(line, word)) in.x = stref_to_f(word);
-			if (stref_nextword(line, word)) in.y = stref_to_f(word);
-			uvs.add(vec2{ in.x, in.y });
-		} else if (stref_equals(word, "f" )) {
-			int sides = 0;
-			for (; sides < 4; sides++) {
-				if (!stref_nextword(line, word))
-					break;
-				stref_t ind = {};
-				inds[sides * 3  ] = stref_nextword(word, ind, '/') && ind.length > 0 ? stref_to_i(ind) : 1;
-				inds[sides * 3+1] = stref_nextword(word, ind, '/') && ind.length > 0 ? stref_to_i(ind) : 1;
-				inds[sides * 3+2] = stref_nextword(word, ind, '/') && ind.length > 0 ? stref_to_i(ind) : 1;
-			}
+	// Split the file into chunks at line boundaries
+	const char *data     = (const char *)file_data;
+	const char *data_end = data + file_size;
+	int32_t     workers  = parallel_worker_count();
+	size_t      chunk_size = file_size / (workers * 4) + 1;
+	if (chunk_size < obj_chunk_min_size) chunk_size = obj_chunk_min_size;
+
+	array_t<obj_chunk_t> chunks = {};
+	const char *curr = data;
+	while (curr < data_end) {
+		const char *end = curr + chunk_size < data_end ? curr + chunk_size : data_end;
+		const char *nl  = end < data_end ? (const char *)memchr(end, '\n', data_end - end) : nullptr;
+		end = nl ? nl + 1 : data_end;
+
+		obj_chunk_t chunk = {};
+		chunk.start = curr;
+		chunk.end   = end;
+		chunks.add(chunk);
+		curr = end;
+	}
+	parallel_for(chunks.count, 1, chunks.data, obj_parse_chunk_batch);
+
+	// Stitch the chunks together
+	obj_resolve_t resolve = {};
+	resolve.chunks = chunks.data;
+	for (int32_t i = 0; i < chunks.count; i++) {
+		chunks[i].poss_start  = resolve.poss_count;
+		chunks[i].norms_start = resolve.norms_count;
+		chunks[i].uvs_start   = resolve.uvs_count;
+		resolve.poss_count  += chunks[i].poss .count;
+		resolve.norms_count += chunks[i].norms.count;
+		resolve.uvs_count   += chunks[i].uvs  .count;
+	}
+	resolve.poss  = sk_malloc_t(vec3, maxi(1, resolve.poss_count ));
+	resolve.norms = sk_malloc_t(vec3, maxi(1, resolve.norms_count));
+	resolve.uvs   = sk_malloc_t(vec2, maxi(1, resolve.uvs_count  ));
+	parallel_for(chunks.count, 1, &resolve, obj_resolve_batch);
 
-			vind_t id1 = (vind_t)indexof(inds[0], inds[1],  inds[2], &poss, &norms, &uvs, &indmap, &verts);
-			vind_t id2 = (vind_t)indexof(inds[3], inds[4],  inds[5], &poss, &norms, &uvs, &indmap, &verts);
-			vind_t id3 = (vind_t)indexof(inds[6], inds[7],  inds[8], &poss, &norms, &uvs, &indmap, &verts);
-			faces.add(id1);
-			faces.add(id2);
-			faces.add(id3);
-			if (sides == 4) {
-				vind_t id4 = (vind_t)indexof(inds[9], inds[10], inds[11], &poss, &norms, &uvs, &indmap, &verts);
-				faces.add(id1);
-				faces.add(id3);
-				faces.add(id4);
+	// Sort face ranges into groups. A group is a unique object/material
+	// pair, so objects that switch materials become multiple groups.
+	array_t<obj_group_t> groups    = {};
+	array_t<obj_range_t> ranges    = {};
+	const char *obj_name     = nullptr;
+	int32_t     obj_name_len = 0;
+	const char *mtl_name     = nullptr;
+	int32_t     mtl_name_len = 0;
+	int32_t     curr_group   = -1;
+	for (int32_t c = 0; c < chunks.count; c++) {
+		uint32_t range_start = 0;
+		for (int32_t e = 0; e <= chunks[c].events.count; e++) {
+			uint32_t range_end = e < chunks[c].events.count ? chunks[c].events[e].corner : (uint32_t)chunks[c].corners.count;
+			if (range_end > range_start) {
+				if (curr_group < 0) {
+					for (int32_t g = 0; g < groups.count; g++) {
+						if (groups[g].obj_name_len == obj_name_len && (obj_name_len == 0 || memcmp(groups[g].obj_name, obj_name, obj_name_len) == 0) &&
+							groups[g].mtl_name_len == mtl_name_len && (mtl_name_len == 0 || memcmp(groups[g].mtl_name, mtl_name, mtl_name_len) == 0)) {
+							curr_group = g;
+							break;
+						}
+					}
+					if (curr_group < 0) curr_group = groups.add({ obj_name, obj_name_len, mtl_name, mtl_name_len, {} });
+				}
+				ranges.add({ c, range_start, range_end, curr_group });
+				range_start = range_end;
+			}
+			if (e < chunks[c].events.count) {
+				const obj_group_evt_t *evt = &chunks[c].events[e];
+				if (evt->is_material) { mtl_name = evt->name; mtl_name_len = evt->name_len; }
+				else                  { obj_name = evt->name; obj_name_len = evt->name_len; }
+				curr_group = -1;
 			}
 		}
 	}
+	for (int32_t r = 0; r < ranges.count; r++) {
+		obj_chunk_t *chunk = &chunks[ranges[r].chunk];
+		groups[ranges[r].group].corners.add_range(&chunk->corners[ranges[r].start], ranges[r].end - ranges[r].start);
+	}
+	for (int32_t i = 0; i < chunks.count; i++) {
+		chunks[i].poss   .free();
+		chunks[i].norms  .free();
+		chunks[i].uvs    .free();
+		chunks[i].corners.free();
+		chunks[i].events .free();
+	}
+	chunks.free();
+	ranges.free();
 
-	if (norms.count <= 0)
-		mesh_calculate_normals(&verts[0], verts.count, &faces[0], faces.count);
+	// Build a mesh for each group
+	int32_t mesh_count = 0;
+	for (int32_t g = 0; g < groups.count; g++) {
+		obj_group_t *group = &groups[g];
+		if (group->corners.count < 3) continue;
 
-	mesh = mesh_create();
-	mesh_set_id  (mesh, id);
-	mesh_set_data(mesh, &verts[0], verts.count, &faces[0], faces.count);
+		vert_t *verts      = nullptr;
+		vind_t *inds       = nullptr;
+		int32_t vert_count = obj_dedup(group->corners.data, group->corners.count, resolve.poss, resolve.uvs, resolve.norms, &verts, &inds);
+		if (resolve.norms_count <= 0)
+			mesh_calculate_normals(verts, vert_count, inds, group->corners.count);
 
-	model_add_subset(model, mesh, material, matrix_identity);
+		obj_mesh_id(id, sizeof(id), filename, mesh_count);
+		mesh = mesh_create();
+		mesh_set_id  (mesh, id);
+		mesh_set_data(mesh, verts, vert_count, inds, group->corners.count);
+		mesh_optimize(mesh, model_get_load_optimize());
 
-	material_release(material);
-	mesh_release(mesh);
+		char name[256];
+		if      (group->obj_name_len > 0 && group->mtl_name_len > 0) snprintf(name, sizeof(name), "%.*s/%.*s", group->obj_name_len, group->obj_name, group->mtl_name_len, group->mtl_name);
+		else if (group->obj_name_len > 0)                            snprintf(name, sizeof(name), "%.*s",      group->obj_name_len, group->obj_name);
+		else if (group->mtl_name_len > 0)                            snprintf(name, sizeof(name), "%.*s",      group->mtl_name_len, group->mtl_name);
+		if (group->obj_name_len > 0 || group->mtl_name_len > 0) model_add_named_subset(model, name, mesh, material, matrix_identity);
+		else                                                    model_add_subset      (model,       mesh, material, matrix_identity);
+
+		mesh_release(mesh);
+		sk_free(verts);
+		sk_free(inds);
+		mesh_count += 1;
+	}
 
-	poss  .free();
-	norms .free();
-	uvs   .free();
-	verts .free();
-	faces .free();
-	indmap.free();
-	return true;
+	material_release(material);
+	for (int32_t g = 0; g < groups.count; g++) groups[g].corners.free();
+	groups.free();
+	sk_free(resolve.poss);
+	sk_free(resolve.norms);
+	sk_free(resolve.uvs);
+	return mesh_count > 0;
 }
 
-}
\ No newline at end of file
+}
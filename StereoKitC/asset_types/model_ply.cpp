@@ -67,6 +67,7 @@ bool modelfmt_ply(model_t model, const char *filename, void *file_data, size_t f
 		mesh = mesh_create();
 		mesh_set_id  (mesh, id);
 		mesh_set_data(mesh, verts, vert_count, inds, ind_count);
+		mesh_optimize(mesh, model_get_load_optimize());
 
 		model_add_subset(model, mesh, material, matrix_identity);
 
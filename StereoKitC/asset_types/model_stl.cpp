@@ -1,9 +1,14 @@
 #include "model.h"
-#include "../libraries/stref.h"
-#include "../libraries/array.h"
+#include "../sk_memory.h"
 #include "../sk_math.h"
+#include "../libraries/array.h"
+#include "../systems/parallel.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 
 namespace sk {
 
@@ -12,155 +17,692 @@ struct stl_header_t {
 	uint32_t tri_count;
 };
 
-#pragma pack(1) 
+#pragma pack(push, 1)
 struct stl_triangle_t {
 	vec3     normal;
 	vec3     verts[3];
 	uint16_t attribute;
 };
+#pragma pack(pop)
+
+// Verts closer than this fraction of the model's size get welded together.
+// CAD exporters frequently write the same corner with slightly different
+// rounding, so exact matching leaves a lot of seams.
+const float   stl_weld_tolerance  = 0.000001f;
+// Faces meeting at a sharper angle than this keep separate normals, so
+// hard edges on machined parts stay hard. This is cos(60 degrees).
+const float   stl_crease_cos      = 0.5f;
+const int32_t stl_min_batch       = 16384;
+// Weld cells are this many times the tolerance wide. Bigger cells mean
+// fewer corners close enough to an edge to need neighbor lookups.
+const int32_t stl_weld_cell_scale = 8;
+const int32_t stl_weld_recent     = 1024;
+
+// Everything the weld and normal passes share, STL files are just a soup of
+// triangle corners to start with.
+struct stl_soup_t {
+	vec3    *corners;      // [tri_count * 3]
+	vec3    *facet_norms;  // [tri_count], as written in the file
+	int32_t  tri_count;
+	int32_t  batch_size;
+	int32_t  batch_count;
+	vec3    *batch_min;
+	vec3    *batch_max;
+};
 
 ///////////////////////////////////////////
 
-vind_t indexof(vec3 pt, vec3 normal, array_t<vert_t> *verts, hashmap_t<vec3, vind_t> *indmap) {
-	vind_t  result = 0;
-	int32_t id     = indmap->contains(pt);
-	if (id < 0) {
-		result = (vind_t)verts->add(vert_t{ pt, {}, {}, {255,255,255,255} });
-		indmap->set(pt, result);
-	} else {
-		result = indmap->items[id].value;
-	}
-	verts->get(result).norm += normal;
-	return result;
+static void stl_soup_batches(stl_soup_t *soup, int32_t item_count) {
+	int32_t workers = parallel_worker_count();
+	soup->batch_size  = maxi(stl_min_batch, (item_count + workers * 4 - 1) / (workers * 4));
+	soup->batch_count = maxi(1, (item_count + soup->batch_size - 1) / soup->batch_size);
 }
 
+///////////////////////////////////////////
+// Parsing
 ///////////////////////////////////////////
 
-bool modelfmt_stl_binary_smooth(void *file_data, size_t, array_t<vert_t> *verts, array_t<vind_t> *faces) {
-	stl_header_t *header = (stl_header_t *)file_data;
-	hashmap_t<vec3, vind_t> indmap = {};
+struct stl_binary_ctx_t {
+	stl_soup_t           *soup;
+	const stl_triangle_t *tris;
+};
 
-	stl_triangle_t *tris = (stl_triangle_t *)(((uint8_t *)file_data) + sizeof(stl_header_t));
-	for (uint32_t i = 0; i < header->tri_count; i++) {
-		faces->add(indexof(tris[i].verts[0], tris[i].normal, verts, &indmap));
-		faces->add(indexof(tris[i].verts[1], tris[i].normal, verts, &indmap));
-		faces->add(indexof(tris[i].verts[2], tris[i].normal, verts, &indmap));
+static void stl_binary_batch(void *context, int32_t start, int32_t end) {
+	stl_binary_ctx_t *ctx  = (stl_binary_ctx_t *)context;
+	stl_soup_t       *soup = ctx->soup;
+	for (int32_t b = start; b < end; b++) {
+		int32_t first = b * soup->batch_size;
+		int32_t last  = mini(first + soup->batch_size, soup->tri_count);
+		vec3    min   = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+		vec3    max   = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (int32_t i = first; i < last; i++) {
+			// Facets are 50 bytes, so they're only ever byte aligned
+			stl_triangle_t tri;
+			memcpy(&tri, &ctx->tris[i], sizeof(stl_triangle_t));
+			soup->facet_norms[i] = tri.normal;
+			for (int32_t c = 0; c < 3; c++) {
+				vec3 pt = tri.verts[c];
+				soup->corners[i * 3 + c] = pt;
+				min = vec3_min(min, pt);
+				max = vec3_max(max, pt);
+			}
+		}
+		soup->batch_min[b] = min;
+		soup->batch_max[b] = max;
 	}
+}
 
-	indmap.free();
+///////////////////////////////////////////
+
+static bool stl_parse_binary(const char *filename, void *file_data, size_t file_length, stl_soup_t *soup) {
+	const stl_header_t *header = (const stl_header_t *)file_data;
+	if (file_length < sizeof(stl_header_t) ||
+		(uint64_t)header->tri_count * sizeof(stl_triangle_t) > file_length - sizeof(stl_header_t)) {
+		log_warnf("[%s] STL file is shorter than its triangle count says.", filename);
+		return false;
+	}
+	if (header->tri_count > INT32_MAX / 3) {
+		log_warnf("[%s] STL file has more triangles than a mesh can hold.", filename);
+		return false;
+	}
+
+	soup->tri_count   = (int32_t)header->tri_count;
+	soup->corners     = sk_malloc_t(vec3, (size_t)soup->tri_count * 3);
+	soup->facet_norms = sk_malloc_t(vec3, soup->tri_count);
+	stl_soup_batches(soup, soup->tri_count);
+	soup->batch_min   = sk_malloc_t(vec3, soup->batch_count);
+	soup->batch_max   = sk_malloc_t(vec3, soup->batch_count);
+
+	stl_binary_ctx_t ctx = { soup, (const stl_triangle_t *)((uint8_t *)file_data + sizeof(stl_header_t)) };
+	parallel_for(soup->batch_count, 1, &ctx, stl_binary_batch);
 	return true;
 }
 
 ///////////////////////////////////////////
 
-bool modelfmt_stl_text_smooth(void *file_data, size_t, array_t<vert_t> *verts, array_t<vind_t> *faces) {
-	hashmap_t<vec3, vind_t> indmap = {};
-	
-	vec3    normal     = {};
-	vind_t  curr[4]    = {};
-	int32_t curr_count = 0;
-
-	stref_t data = stref_make((const char *)file_data);
-	stref_t line = {};
-	while (stref_nextline(data, line)) {
-		stref_t word = {};
-		if (!stref_nextword(line, word))
-			continue;
-
-		if (stref_equals(word, "facet")) {
-			if (stref_nextword(line, word) && stref_equals(word, "normal")) {
-				normal = {};
-				if (stref_nextword(line, word)) normal.x = stref_to_f(word);
-				if (stref_nextword(line, word)) normal.y = stref_to_f(word);
-				if (stref_nextword(line, word)) normal.z = stref_to_f(word);
+static const char *stl_text_word(const char *at, const char *end, const char **out_end) {
+	while (at < end && (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n')) at++;
+	const char *word_end = at;
+	while (word_end < end && !(*word_end == ' ' || *word_end == '\t' || *word_end == '\r' || *word_end == '\n')) word_end++;
+	*out_end = word_end;
+	return at;
+}
+
+static bool stl_text_is(const char *word, const char *word_end, const char *keyword) {
+	size_t len = strlen(keyword);
+	return (size_t)(word_end - word) == len && memcmp(word, keyword, len) == 0;
+}
+
+static const char *stl_text_vec3(const char *at, vec3 *out_pt) {
+	char *next = nullptr;
+	out_pt->x = strtof(at,   &next); at = next;
+	out_pt->y = strtof(at,   &next); at = next;
+	out_pt->z = strtof(at,   &next);
+	return next;
+}
+
+// Text STL is rare for large files, so this is a single pass that just
+// collects corners for the same weld as binary files.
+static bool stl_parse_text(void *file_data, size_t file_length, stl_soup_t *soup) {
+	array_t<vec3> corners = {};
+	array_t<vec3> norms   = {};
+
+	vec3        normal     = {};
+	vec3        curr[4]    = {};
+	int32_t     curr_count = 0;
+	const char *at         = (const char *)file_data;
+	const char *end        = at + file_length;
+	while (at < end) {
+		const char *word_end;
+		const char *word = stl_text_word(at, end, &word_end);
+		at = word_end;
+		if (word == word_end) break;
+
+		if (stl_text_is(word, word_end, "normal")) {
+			at = stl_text_vec3(at, &normal);
+		} else if (stl_text_is(word, word_end, "vertex")) {
+			vec3 pt;
+			at = stl_text_vec3(at, &pt);
+			if (curr_count < 4) curr[curr_count] = pt;
+			curr_count = mini(4, curr_count + 1);
+		} else if (stl_text_is(word, word_end, "endfacet")) {
+			if (curr_count >= 3) {
+				corners.add(curr[0]); corners.add(curr[1]); corners.add(curr[2]);
+				norms  .add(normal);
 			}
-		} else if (stref_equals(word, "endfacet")) {
-			faces->add(curr[0]); faces->add(curr[1]); faces->add(curr[2]);
 			if (curr_count == 4) {
-				faces->add(curr[0]); faces->add(curr[2]); faces->add(curr[3]);
+				corners.add(curr[0]); corners.add(curr[2]); corners.add(curr[3]);
+				norms  .add(normal);
 			}
 			curr_count = 0;
-		} else if (stref_equals(word, "vertex")) {
-			if (curr_count != 4) {
-				vec3 pt = {};
-				if (stref_nextword(line, word)) pt.x = stref_to_f(word);
-				if (stref_nextword(line, word)) pt.y = stref_to_f(word);
-				if (stref_nextword(line, word)) pt.z = stref_to_f(word);
-				curr[curr_count] = indexof(pt, normal, verts, &indmap);
-				curr_count = mini(4, curr_count + 1);
-			}
 		}
 	}
 
-	indmap.free();
+	soup->tri_count   = norms.count;
+	soup->corners     = corners.data;
+	soup->facet_norms = norms.data;
+	soup->batch_count = 1;
+	soup->batch_min   = sk_malloc_t(vec3, 1);
+	soup->batch_max   = sk_malloc_t(vec3, 1);
+	soup->batch_min[0] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	soup->batch_max[0] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int32_t i = 0; i < corners.count; i++) {
+		soup->batch_min[0] = vec3_min(soup->batch_min[0], corners[i]);
+		soup->batch_max[0] = vec3_max(soup->batch_max[0], corners[i]);
+	}
 	return true;
 }
 
+///////////////////////////////////////////
+// Welding
 ///////////////////////////////////////////
 
-bool modelfmt_stl_binary_flat(void *file_data, size_t, array_t<vert_t> *verts, array_t<vind_t> *faces) {
-	stl_header_t   *header = (stl_header_t *)file_data;
-	stl_triangle_t *tris   = (stl_triangle_t *)(((uint8_t *)file_data) + sizeof(stl_header_t));
-
-	verts->resize(header->tri_count * 3);
-	faces->resize(header->tri_count * 3);
-	for (uint32_t i = 0; i < header->tri_count; i++) {
-		vind_t ind1 = (vind_t)verts->add(vert_t{ tris[i].verts[0], tris[i].normal, {}, {255,255,255,255} });
-		vind_t ind2 = (vind_t)verts->add(vert_t{ tris[i].verts[1], tris[i].normal, {}, {255,255,255,255} });
-		vind_t ind3 = (vind_t)verts->add(vert_t{ tris[i].verts[2], tris[i].normal, {}, {255,255,255,255} });
-		
-		faces->add(ind1);
-		faces->add(ind2);
-		faces->add(ind3);
+// Corners are bucketed into a grid with cells several times the weld
+// tolerance, so anything within tolerance of a corner is in its own cell, or
+// a neighbor it's close to the edge of. Cells are partitioned by hash so
+// each partition builds its table in parallel, then every corner finds an
+// earlier corner within tolerance of it, or itself if there isn't one. Since
+// that always points backwards, a single forward pass resolves the chains
+// into verts, numbered by first use.
+
+// The first corner's position is kept inline, since that's nearly always
+// the one a new corner matches.
+struct stl_cell_t {
+	int32_t  x, y, z;
+	uint32_t head;
+	uint32_t tail;
+	vec3     head_pt;
+};
+
+// Slots index into a dense list of cells, so the table itself stays small
+// and the cells stay in roughly the order the file touches them.
+struct stl_weld_part_t {
+	uint32_t            *slots;
+	uint32_t             mask;
+	array_t<stl_cell_t>  cells;
+};
+
+struct stl_weld_t {
+	const vec3 *corners;
+	int32_t     corner_count;
+	int32_t     batch_size;
+	vec3        origin;
+	float       inv_cell;
+	float       tolerance_sq;
+	int32_t     part_bits;
+	int32_t     part_count;
+	uint32_t   *hashes;
+	uint32_t   *histogram;    // [batch][part]
+	uint32_t   *part_start;
+	uint32_t   *part_corners;
+	stl_weld_part_t *parts;
+	uint32_t   *prev;         // corner chain within a cell, descending
+	uint32_t   *rep;
+};
+
+static inline uint32_t stl_cell_hash(int32_t x, int32_t y, int32_t z) {
+	uint32_t h = (uint32_t)x * 0x9E3779B1u ^ (uint32_t)y * 0x85EBCA77u ^ (uint32_t)z * 0xC2B2AE3Du;
+	h ^= h >> 15; h *= 0x2C1B3C6Du;
+	h ^= h >> 12; h *= 0x297A2D39u;
+	h ^= h >> 15;
+	return h;
+}
+
+static inline void stl_cell_coord(const stl_weld_t *ctx, vec3 pt, float *out_x, float *out_y, float *out_z) {
+	*out_x = (pt.x - ctx->origin.x) * ctx->inv_cell;
+	*out_y = (pt.y - ctx->origin.y) * ctx->inv_cell;
+	*out_z = (pt.z - ctx->origin.z) * ctx->inv_cell;
+}
+
+static inline uint32_t stl_part(const stl_weld_t *ctx, uint32_t hash) {
+	return ctx->part_bits > 0 ? hash >> (32 - ctx->part_bits) : 0;
+}
+
+static const stl_cell_t *stl_cell_find(const stl_weld_t *ctx, int32_t x, int32_t y, int32_t z) {
+	uint32_t               hash = stl_cell_hash(x, y, z);
+	const stl_weld_part_t *part = &ctx->parts[stl_part(ctx, hash)];
+	if (part->slots == nullptr) return nullptr;
+	uint32_t slot = hash & part->mask;
+	while (part->slots[slot] != UINT32_MAX) {
+		const stl_cell_t *cell = &part->cells[part->slots[slot]];
+		if (cell->x == x && cell->y == y && cell->z == z)
+			return cell;
+		slot = (slot + 1) & part->mask;
 	}
-	return true;
+	return nullptr;
 }
 
 ///////////////////////////////////////////
 
-bool modelfmt_stl_text_flat(void *file_data, size_t, array_t<vert_t> *verts, array_t<vind_t> *faces) {
-	vec3    normal     = {};
-	vec3    curr[4]    = {};
-	int32_t curr_count = 0;
-
-	stref_t data = stref_make((const char *)file_data);
-	stref_t line = {};
-	while (stref_nextline(data, line)) {
-		stref_t word = {};
-		if (!stref_nextword(line, word))
-			continue;
-
-		if (stref_equals(word, "facet")) {
-			if (stref_nextword(line, word) && stref_equals(word, "normal")) {
-				normal = {};
-				if (stref_nextword(line, word)) normal.x = stref_to_f(word);
-				if (stref_nextword(line, word)) normal.y = stref_to_f(word);
-				if (stref_nextword(line, word)) normal.z = stref_to_f(word);
+static void stl_weld_hash_batch(void *context, int32_t start, int32_t end) {
+	stl_weld_t *ctx = (stl_weld_t *)context;
+	for (int32_t b = start; b < end; b++) {
+		uint32_t *hist  = &ctx->histogram[b * ctx->part_count];
+		int32_t   first = b * ctx->batch_size;
+		int32_t   last  = mini(first + ctx->batch_size, ctx->corner_count);
+		memset(hist, 0, sizeof(uint32_t) * ctx->part_count);
+		for (int32_t i = first; i < last; i++) {
+			float x, y, z;
+			stl_cell_coord(ctx, ctx->corners[i], &x, &y, &z);
+			uint32_t h = stl_cell_hash((int32_t)floorf(x), (int32_t)floorf(y), (int32_t)floorf(z));
+			ctx->hashes[i] = h;
+			hist[stl_part(ctx, h)] += 1;
+		}
+	}
+}
+
+static void stl_weld_scatter_batch(void *context, int32_t start, int32_t end) {
+	stl_weld_t *ctx = (stl_weld_t *)context;
+	for (int32_t b = start; b < end; b++) {
+		uint32_t *dest  = &ctx->histogram[b * ctx->part_count];
+		int32_t   first = b * ctx->batch_size;
+		int32_t   last  = mini(first + ctx->batch_size, ctx->corner_count);
+		for (int32_t i = first; i < last; i++) {
+			uint32_t p = stl_part(ctx, ctx->hashes[i]);
+			ctx->part_corners[dest[p]] = i;
+			dest[p] += 1;
+		}
+	}
+}
+
+static void stl_weld_part_grow(stl_weld_part_t *part, uint32_t capacity) {
+	sk_free(part->slots);
+	part->slots = sk_malloc_t(uint32_t, capacity);
+	part->mask  = capacity - 1;
+	memset(part->slots, 0xFF, sizeof(uint32_t) * capacity);
+	for (int32_t i = 0; i < part->cells.count; i++) {
+		const stl_cell_t *cell = &part->cells[i];
+		uint32_t slot = stl_cell_hash(cell->x, cell->y, cell->z) & part->mask;
+		while (part->slots[slot] != UINT32_MAX) slot = (slot + 1) & part->mask;
+		part->slots[slot] = i;
+	}
+}
+
+static void stl_weld_part_batch(void *context, int32_t start, int32_t end) {
+	stl_weld_t *ctx = (stl_weld_t *)context;
+	for (int32_t p = start; p < end; p++) {
+		stl_weld_part_t *part  = &ctx->parts[p];
+		uint32_t         first = ctx->part_start[p];
+		uint32_t         count = ctx->part_start[p + 1] - first;
+		*part = {};
+		if (count == 0) continue;
+
+		// Closed meshes share each corner between ~6 triangles, so start
+		// the table around there and grow it if the mesh is less connected.
+		uint32_t capacity = 16;
+		while (capacity < count / 4) capacity *= 2;
+		stl_weld_part_grow(part, capacity);
+		part->cells.resize(capacity / 2);
+
+		// Neighboring facets are usually next to each other in the file,
+		// so recently used cells get checked before the table.
+		uint32_t recent[stl_weld_recent];
+		memset(recent, 0xFF, sizeof(recent));
+
+		// Partition lists are in corner order, so each corner only ever
+		// links back to earlier ones.
+		for (uint32_t i = first; i < first + count; i++) {
+			uint32_t c    = ctx->part_corners[i];
+			vec3     pt   = ctx->corners[c];
+			uint32_t hash = ctx->hashes[c];
+			float    fx, fy, fz;
+			stl_cell_coord(ctx, pt, &fx, &fy, &fz);
+			int32_t  x = (int32_t)floorf(fx), y = (int32_t)floorf(fy), z = (int32_t)floorf(fz);
+
+			uint32_t   *hot  = &recent[hash & (stl_weld_recent - 1)];
+			stl_cell_t *cell = *hot != UINT32_MAX ? &part->cells[*hot] : nullptr;
+			if (cell == nullptr || cell->x != x || cell->y != y || cell->z != z) {
+				uint32_t slot = hash & part->mask;
+				while (part->slots[slot] != UINT32_MAX) {
+					cell = &part->cells[part->slots[slot]];
+					if (cell->x == x && cell->y == y && cell->z == z) break;
+					slot = (slot + 1) & part->mask;
+				}
+				if (part->slots[slot] == UINT32_MAX) {
+					part->slots[slot] = part->cells.add({ x, y, z, c, c, pt });
+					cell = nullptr;
+				}
+				*hot = part->slots[slot];
 			}
-		} else if (stref_equals(word, "endfacet")) {
-			vind_t ind1 = (vind_t)verts->add(vert_t{ curr[0], normal, {}, {255,255,255,255} });
-			vind_t ind2 = (vind_t)verts->add(vert_t{ curr[1], normal, {}, {255,255,255,255} });
-			vind_t ind3 = (vind_t)verts->add(vert_t{ curr[2], normal, {}, {255,255,255,255} });
 
-			faces->add(ind1); faces->add(ind2); faces->add(ind3);
-			if (curr_count == 4) {
-				vind_t ind4 = (vind_t)verts->add(vert_t{ curr[3], normal, {}, {255,255,255,255} });
-				faces->add(ind1); faces->add(ind3); faces->add(ind4);
+			if (cell == nullptr) {
+				ctx->prev[c] = UINT32_MAX;
+				ctx->rep [c] = c;
+			} else {
+				// Most corners have an earlier match right here in their own
+				// cell, which is all they need.
+				uint32_t match = UINT32_MAX;
+				if (vec3_distance_sq(cell->head_pt, pt) <= ctx->tolerance_sq) {
+					match = cell->head;
+				} else {
+					for (uint32_t m = cell->tail; m != UINT32_MAX; m = ctx->prev[m]) {
+						if (vec3_distance_sq(ctx->corners[m], pt) <= ctx->tolerance_sq) { match = m; break; }
+					}
+				}
+				ctx->rep [c] = match == UINT32_MAX ? c : match;
+				ctx->prev[c] = cell->tail;
+				cell->tail   = c;
 			}
-			curr_count = 0;
-		} else if (stref_equals(word, "vertex")) {
-			if (curr_count != 4) {
-				vec3 pt = {};
-				if (stref_nextword(line, word)) pt.x = stref_to_f(word);
-				if (stref_nextword(line, word)) pt.y = stref_to_f(word);
-				if (stref_nextword(line, word)) pt.z = stref_to_f(word);
-				curr[curr_count] = pt;
-				curr_count = mini(4, curr_count + 1);
+			if ((uint32_t)part->cells.count * 2 > capacity) {
+				capacity *= 2;
+				stl_weld_part_grow(part, capacity);
+			}
+		}
+	}
+}
+
+static void stl_weld_match_batch(void *context, int32_t start, int32_t end) {
+	stl_weld_t *ctx   = (stl_weld_t *)context;
+	float       edge  = (float)stl_weld_cell_scale - 1;
+	for (int32_t b = start; b < end; b++) {
+		int32_t first = b * ctx->batch_size;
+		int32_t last  = mini(first + ctx->batch_size, ctx->corner_count);
+		for (int32_t i = first; i < last; i++) {
+			// Only corners that were first in their own cell within
+			// tolerance need to look at the neighbors.
+			if (ctx->rep[i] != (uint32_t)i) continue;
+
+			vec3  pt = ctx->corners[i];
+			float fx, fy, fz;
+			stl_cell_coord(ctx, pt, &fx, &fy, &fz);
+			int32_t x = (int32_t)floorf(fx), y = (int32_t)floorf(fy), z = (int32_t)floorf(fz);
+
+			// Neighbors are only in reach if the corner is within tolerance
+			// of that side of its cell.
+			float   tx = (fx - x) * stl_weld_cell_scale, ty = (fy - y) * stl_weld_cell_scale, tz = (fz - z) * stl_weld_cell_scale;
+			int32_t dx = tx <= 1 ? -1 : (tx >= edge ? 1 : 0);
+			int32_t dy = ty <= 1 ? -1 : (ty >= edge ? 1 : 0);
+			int32_t dz = tz <= 1 ? -1 : (tz >= edge ? 1 : 0);
+			if (dx == 0 && dy == 0 && dz == 0) continue;
+
+			uint32_t best = (uint32_t)i;
+			for (int32_t n = 1; n < 8; n++) {
+				if (((n & 1) && dx == 0) || ((n & 2) && dy == 0) || ((n & 4) && dz == 0)) continue;
+				const stl_cell_t *cell = stl_cell_find(ctx,
+					x + ((n & 1) ? dx : 0),
+					y + ((n & 2) ? dy : 0),
+					z + ((n & 4) ? dz : 0));
+				if (cell == nullptr) continue;
+				for (uint32_t c = cell->tail; c != UINT32_MAX; c = ctx->prev[c]) {
+					if (c < best && vec3_distance_sq(ctx->corners[c], pt) <= ctx->tolerance_sq)
+						best = c;
+				}
 			}
+			ctx->rep[i] = best;
 		}
 	}
+}
 
-	return true;
+///////////////////////////////////////////
+
+// Fills out_corner_vert with a vert id for each corner, and out_verts with
+// the position of each vert. Returns the number of verts.
+static int32_t stl_weld(const stl_soup_t *soup, uint32_t *out_corner_vert, vec3 **out_verts) {
+	stl_weld_t ctx = {};
+	ctx.corners      = soup->corners;
+	ctx.corner_count = soup->tri_count * 3;
+
+	vec3 min = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	vec3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int32_t b = 0; b < soup->batch_count; b++) {
+		min = vec3_min(min, soup->batch_min[b]);
+		max = vec3_max(max, soup->batch_max[b]);
+	}
+	// Float rounding scales with distance from the origin as well as with
+	// the size of the model, so both count towards the tolerance.
+	vec3  extent    = max - min;
+	float magnitude = fmaxf(fmaxf(fmaxf(extent.x, extent.y), extent.z),
+	                  fmaxf(vec3_magnitude(min), vec3_magnitude(max)));
+	float tolerance = magnitude * stl_weld_tolerance;
+	if (!(tolerance > 0) || !isfinite(tolerance)) tolerance = stl_weld_tolerance;
+	ctx.origin       = min;
+	ctx.inv_cell     = 1.0f / (tolerance * stl_weld_cell_scale);
+	ctx.tolerance_sq = tolerance * tolerance;
+
+	int32_t workers = parallel_worker_count();
+	if (workers > 1 && ctx.corner_count >= stl_min_batch) {
+		while ((1 << ctx.part_bits) < workers * 4 && ctx.part_bits < 6) ctx.part_bits += 1;
+	}
+	ctx.part_count   = 1 << ctx.part_bits;
+	ctx.batch_size   = maxi(stl_min_batch, (ctx.corner_count + workers * 4 - 1) / (workers * 4));
+	int32_t batches  = (ctx.corner_count + ctx.batch_size - 1) / ctx.batch_size;
+
+	ctx.hashes       = sk_malloc_t(uint32_t,    ctx.corner_count);
+	ctx.histogram    = sk_malloc_t(uint32_t,    batches * ctx.part_count);
+	ctx.part_start   = sk_malloc_t(uint32_t,    ctx.part_count + 1);
+	ctx.part_corners = sk_malloc_t(uint32_t,    ctx.corner_count);
+	ctx.parts        = sk_malloc_t(stl_weld_part_t, ctx.part_count);
+	ctx.prev         = sk_malloc_t(uint32_t,    ctx.corner_count);
+	ctx.rep          = out_corner_vert;
+
+	parallel_for(batches, 1, &ctx, stl_weld_hash_batch);
+	uint32_t offset = 0;
+	for (int32_t p = 0; p < ctx.part_count; p++) {
+		ctx.part_start[p] = offset;
+		for (int32_t b = 0; b < batches; b++) {
+			uint32_t count = ctx.histogram[b * ctx.part_count + p];
+			ctx.histogram[b * ctx.part_count + p] = offset;
+			offset += count;
+		}
+	}
+	ctx.part_start[ctx.part_count] = offset;
+	parallel_for(batches,        1, &ctx, stl_weld_scatter_batch);
+	parallel_for(ctx.part_count, 1, &ctx, stl_weld_part_batch);
+	parallel_for(batches,        1, &ctx, stl_weld_match_batch);
+
+	// Representatives always point backwards, so by the time a corner is
+	// reached, its representative already has a vert.
+	int32_t vert_count = 0;
+	for (int32_t i = 0; i < ctx.corner_count; i++) {
+		uint32_t rep = out_corner_vert[i];
+		if (rep == (uint32_t)i) {
+			ctx.hashes[vert_count] = i;
+			out_corner_vert[i]     = vert_count;
+			vert_count += 1;
+		} else {
+			out_corner_vert[i] = out_corner_vert[rep];
+		}
+	}
+	vec3 *verts = sk_malloc_t(vec3, vert_count);
+	for (int32_t v = 0; v < vert_count; v++)
+		verts[v] = soup->corners[ctx.hashes[v]];
+
+	for (int32_t p = 0; p < ctx.part_count; p++) {
+		sk_free(ctx.parts[p].slots);
+		ctx.parts[p].cells.free();
+	}
+	sk_free(ctx.hashes);
+	sk_free(ctx.histogram);
+	sk_free(ctx.part_start);
+	sk_free(ctx.part_corners);
+	sk_free(ctx.parts);
+	sk_free(ctx.prev);
+
+	*out_verts = verts;
+	return vert_count;
+}
+
+///////////////////////////////////////////
+// Normals
+///////////////////////////////////////////
+
+// Each welded vert gathers the faces around it, and groups them by crease
+// angle against the first face of each group. Every group becomes its own
+// output vert with an area weighted normal. Gathering per vert instead of
+// scattering per face keeps all of this lock free.
+
+struct stl_normals_t {
+	const stl_soup_t *soup;
+	const uint32_t   *corner_vert;
+	const vec3       *positions;
+	int32_t           vert_count;
+	int32_t           batch_size;
+	vec3             *face_norms;   // area weighted
+	uint32_t         *vert_start;   // [vert_count+1] into vert_corners
+	uint32_t         *vert_corners;
+	uint32_t         *corner_group; // high bit marks the group's first face
+	uint32_t         *vert_base;    // first output vert, [vert_count+1]
+	vert_t           *out_verts;
+	uint32_t         *corner_out;
+};
+
+#define STL_GROUP_SEED 0x80000000u
+
+static void stl_face_norm_batch(void *context, int32_t start, int32_t end) {
+	stl_normals_t *ctx  = (stl_normals_t *)context;
+	const vec3    *pts  = ctx->soup->corners;
+	for (int32_t b = start; b < end; b++) {
+		int32_t first = b * ctx->batch_size;
+		int32_t last  = mini(first + ctx->batch_size, ctx->soup->tri_count);
+		for (int32_t t = first; t < last; t++) {
+			vec3 a = pts[t*3], bb = pts[t*3+1], c = pts[t*3+2];
+			ctx->face_norms[t] = vec3_cross(bb - a, c - a);
+		}
+	}
+}
+
+static void stl_group_batch(void *context, int32_t start, int32_t end) {
+	stl_normals_t *ctx = (stl_normals_t *)context;
+	for (int32_t b = start; b < end; b++) {
+		int32_t first = b * ctx->batch_size;
+		int32_t last  = mini(first + ctx->batch_size, ctx->vert_count);
+		for (int32_t v = first; v < last; v++) {
+			uint32_t s      = ctx->vert_start[v];
+			uint32_t e      = ctx->vert_start[v + 1];
+			uint32_t groups = 0;
+			for (uint32_t i = s; i < e; i++) {
+				uint32_t c     = ctx->vert_corners[i];
+				vec3     n     = ctx->face_norms[c / 3];
+				float    n_len = vec3_magnitude(n);
+				uint32_t group = UINT32_MAX;
+				// Degenerate faces don't add anything to a normal, so they
+				// can join whichever group is handy.
+				if (n_len <= 0 && groups > 0) group = 0;
+				for (uint32_t j = s; j < i && group == UINT32_MAX && n_len > 0; j++) {
+					uint32_t other = ctx->corner_group[ctx->vert_corners[j]];
+					if ((other & STL_GROUP_SEED) == 0) continue;
+					vec3  seed     = ctx->face_norms[ctx->vert_corners[j] / 3];
+					float seed_len = vec3_magnitude(seed);
+					if (seed_len > 0 && vec3_dot(n, seed) >= stl_crease_cos * n_len * seed_len)
+						group = other & ~STL_GROUP_SEED;
+				}
+				if (group == UINT32_MAX) {
+					ctx->corner_group[c] = groups | STL_GROUP_SEED;
+					groups += 1;
+				} else {
+					ctx->corner_group[c] = group;
+				}
+			}
+			ctx->vert_base[v] = groups;
+		}
+	}
+}
+
+static void stl_vert_batch(void *context, int32_t start, int32_t end) {
+	stl_normals_t *ctx = (stl_normals_t *)context;
+	for (int32_t b = start; b < end; b++) {
+		int32_t first = b * ctx->batch_size;
+		int32_t last  = mini(first + ctx->batch_size, ctx->vert_count);
+		for (int32_t v = first; v < last; v++) {
+			uint32_t base  = ctx->vert_base[v];
+			uint32_t count = ctx->vert_base[v + 1] - base;
+			for (uint32_t g = 0; g < count; g++)
+				ctx->out_verts[base + g] = vert_t{ ctx->positions[v], {0,0,0}, {0,0}, {255,255,255,255} };
+
+			for (uint32_t i = ctx->vert_start[v]; i < ctx->vert_start[v + 1]; i++) {
+				uint32_t c     = ctx->vert_corners[i];
+				uint32_t group = ctx->corner_group[c] & ~STL_GROUP_SEED;
+				ctx->out_verts[base + group].norm += ctx->face_norms[c / 3];
+				ctx->corner_out[c] = base + group;
+			}
+			for (uint32_t i = ctx->vert_start[v]; i < ctx->vert_start[v + 1]; i++) {
+				uint32_t c = ctx->vert_corners[i];
+				if ((ctx->corner_group[c] & STL_GROUP_SEED) == 0) continue;
+				vert_t *vert = &ctx->out_verts[ctx->corner_out[c]];
+				// Fall back to the file's normal if all the faces were
+				// degenerate.
+				vert->norm = vec3_magnitude_sq(vert->norm) > 0
+					? vec3_normalize(vert->norm)
+					: vec3_normalize(ctx->soup->facet_norms[c / 3]);
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+static bool stl_build(const stl_soup_t *soup, vert_t **out_verts, int32_t *out_vert_count, vind_t **out_inds, int32_t *out_ind_count) {
+	int32_t   corner_count = soup->tri_count * 3;
+	uint32_t *corner_vert  = sk_malloc_t(uint32_t, corner_count);
+	vec3     *positions    = nullptr;
+	int32_t   vert_count   = stl_weld(soup, corner_vert, &positions);
+
+	stl_normals_t ctx = {};
+	ctx.soup         = soup;
+	ctx.corner_vert  = corner_vert;
+	ctx.positions    = positions;
+	ctx.vert_count   = vert_count;
+	ctx.face_norms   = sk_malloc_t(vec3,     soup->tri_count);
+	ctx.vert_start   = sk_malloc_zero_t(uint32_t, vert_count + 1);
+	ctx.vert_corners = sk_malloc_t(uint32_t, corner_count);
+	ctx.corner_group = sk_malloc_t(uint32_t, corner_count);
+	ctx.vert_base    = sk_malloc_t(uint32_t, vert_count + 1);
+	ctx.corner_out   = sk_malloc_t(uint32_t, corner_count);
+
+	int32_t workers = parallel_worker_count();
+	ctx.batch_size = maxi(stl_min_batch, (soup->tri_count + workers * 4 - 1) / (workers * 4));
+	parallel_for((soup->tri_count + ctx.batch_size - 1) / ctx.batch_size, 1, &ctx, stl_face_norm_batch);
+
+	// Bucket corners by vert, in corner order
+	for (int32_t i = 0; i < corner_count; i++) ctx.vert_start[corner_vert[i] + 1] += 1;
+	for (int32_t v = 0; v < vert_count;   v++) ctx.vert_start[v + 1] += ctx.vert_start[v];
+	uint32_t *fill = ctx.vert_base;
+	memcpy(fill, ctx.vert_start, sizeof(uint32_t) * vert_count);
+	for (int32_t i = 0; i < corner_count; i++) {
+		uint32_t v = corner_vert[i];
+		ctx.vert_corners[fill[v]] = i;
+		fill[v] += 1;
+	}
+
+	ctx.batch_size = maxi(stl_min_batch, (vert_count + workers * 4 - 1) / (workers * 4));
+	int32_t vert_batches = (vert_count + ctx.batch_size - 1) / ctx.batch_size;
+	parallel_for(vert_batches, 1, &ctx, stl_group_batch);
+
+	uint32_t out_count = 0;
+	for (int32_t v = 0; v < vert_count; v++) {
+		uint32_t groups = ctx.vert_base[v];
+		ctx.vert_base[v] = out_count;
+		out_count += groups;
+	}
+	ctx.vert_base[vert_count] = out_count;
+	ctx.out_verts = sk_malloc_t(vert_t, out_count);
+	parallel_for(vert_batches, 1, &ctx, stl_vert_batch);
+
+	// Welding can collapse slivers down to nothing, so those get dropped.
+	vind_t *inds      = sk_malloc_t(vind_t, corner_count);
+	int32_t ind_count = 0;
+	for (int32_t t = 0; t < soup->tri_count; t++) {
+		uint32_t a = corner_vert[t*3], b = corner_vert[t*3+1], c = corner_vert[t*3+2];
+		if (a == b || b == c || a == c) continue;
+		inds[ind_count++] = (vind_t)ctx.corner_out[t*3  ];
+		inds[ind_count++] = (vind_t)ctx.corner_out[t*3+1];
+		inds[ind_count++] = (vind_t)ctx.corner_out[t*3+2];
+	}
+
+	sk_free(corner_vert);
+	sk_free(positions);
+	sk_free(ctx.face_norms);
+	sk_free(ctx.vert_start);
+	sk_free(ctx.vert_corners);
+	sk_free(ctx.corner_group);
+	sk_free(ctx.vert_base);
+	sk_free(ctx.corner_out);
+
+	*out_verts      = ctx.out_verts;
+	*out_vert_count = (int32_t)out_count;
+	*out_inds       = inds;
+	*out_ind_count  = ind_count;
+	return ind_count > 0;
 }
 
 ///////////////////////////////////////////
@@ -176,25 +718,43 @@ bool modelfmt_stl(model_t model, const char *filename, void *file_data, size_t f
 	if (mesh) {
 		model_add_subset(model, mesh, material, matrix_identity);
 	} else {
-		array_t<vert_t> verts = {};
-		array_t<vind_t> faces = {};
-
-		result = file_length > 5 && memcmp(file_data, "solid", sizeof(char) * 5) == 0 ?
-			modelfmt_stl_text_flat  (file_data, file_length, &verts, &faces) :
-			modelfmt_stl_binary_flat(file_data, file_length, &verts, &faces);
-
-		// Normalize all the normals
-		for (int32_t i = 0; i < verts.count; i++)
-			verts[i].norm = vec3_normalize(verts[i].norm);
-
-		mesh = mesh_create();
-		mesh_set_id  (mesh, id);
-		mesh_set_data(mesh, &verts[0], verts.count, &faces[0], faces.count);
-
-		model_add_subset(model, mesh, material, matrix_identity);
+		// Plenty of binary exporters start their header with "solid" too,
+		// so an exact size match is the more reliable test.
+		const stl_header_t *header = (const stl_header_t *)file_data;
+		bool is_binary =
+			file_length >= sizeof(stl_header_t) &&
+			sizeof(stl_header_t) + (uint64_t)header->tri_count * sizeof(stl_triangle_t) == file_length;
+		bool is_text = !is_binary && file_length > 5 && memcmp(file_data, "solid", sizeof(char) * 5) == 0;
+
+		stl_soup_t soup = {};
+		result = is_text
+			? stl_parse_text  (file_data, file_length, &soup)
+			: stl_parse_binary(filename, file_data, file_length, &soup);
+
+		vert_t *verts      = nullptr;
+		vind_t *inds       = nullptr;
+		int32_t vert_count = 0;
+		int32_t ind_count  = 0;
+		if (result && soup.tri_count > 0)
+			result = stl_build(&soup, &verts, &vert_count, &inds, &ind_count);
+		else
+			result = false;
+
+		if (result) {
+			mesh = mesh_create();
+			mesh_set_id  (mesh, id);
+			mesh_set_data(mesh, verts, vert_count, inds, ind_count);
+			mesh_optimize(mesh, model_get_load_optimize());
+
+			model_add_subset(model, mesh, material, matrix_identity);
+		}
 
-		verts.free();
-		faces.free();
+		sk_free(soup.corners);
+		sk_free(soup.facet_norms);
+		sk_free(soup.batch_min);
+		sk_free(soup.batch_max);
+		sk_free(verts);
+		sk_free(inds);
 	}
 
 	mesh_release    (mesh);
@@ -203,4 +763,4 @@ bool modelfmt_stl(model_t model, const char *filename, void *file_data, size_t f
 	return result;
 }
 
-}
\ No newline at end of file
+}
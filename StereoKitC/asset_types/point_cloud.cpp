@@ -0,0 +1,596 @@
+#include "point_cloud.h"
+#include "mesh.h"
+#include "../log.h"
+#include "../sk_math.h"
+#include "../sk_memory.h"
+#include "../libraries/stref.h"
+#include "../libraries/atomic_util.h"
+#include "../libraries/ferr_hash.h"
+#include "../systems/render.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+namespace sk {
+
+// How many node loads each cloud can have waiting on the asset threads.
+const int32_t point_cloud_max_loading = 8;
+// How long a node that failed to load waits before trying again.
+const int32_t point_cloud_retry_frames = 90;
+
+struct point_cloud_load_t {
+	char *filename;
+	char *shipped_cache_filename;
+	char *cache_filename;
+};
+
+// Points wait for their upload in the same compact form the cache stores
+// them in, and only get expanded into triangles right before they go to
+// the GPU.
+struct point_cloud_node_load_t {
+	point_cloud_file_t *file;
+	mesh_t              inds;
+	point_octree_node_t node;
+	cloud_point_t      *points;
+};
+
+///////////////////////////////////////////
+
+static void point_cloud_file_release(point_cloud_file_t *file) {
+	if (file == nullptr || atomic_decrement(&file->refs) > 0) return;
+	fclose(file->fp);
+	ft_mutex_destroy(&file->mtx);
+	sk_free(file);
+}
+
+///////////////////////////////////////////
+
+point_cloud_t point_cloud_find(const char *id) {
+	point_cloud_t result = (point_cloud_t)assets_find(id, asset_type_point_cloud);
+	if (result != nullptr) {
+		point_cloud_addref(result);
+		return result;
+	}
+	return nullptr;
+}
+
+///////////////////////////////////////////
+
+void point_cloud_set_id(point_cloud_t cloud, const char *id) {
+	assets_set_id(&cloud->header, id);
+}
+
+///////////////////////////////////////////
+
+const char *point_cloud_get_id(const point_cloud_t cloud) {
+	return cloud->header.id_text;
+}
+
+///////////////////////////////////////////
+
+void point_cloud_addref(point_cloud_t cloud) {
+	assets_addref(&cloud->header);
+}
+
+///////////////////////////////////////////
+
+void point_cloud_release(point_cloud_t cloud) {
+	if (cloud == nullptr)
+		return;
+	assets_releaseref(&cloud->header);
+}
+
+///////////////////////////////////////////
+
+void point_cloud_memory_usage(point_cloud_t cloud, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	// Resident nodes are mesh assets, so their points are counted there
+	*out_cpu_bytes = sizeof(_point_cloud_t)
+		+ (sizeof(point_octree_node_t) + sizeof(point_cloud_node_t)) * (cloud->nodes != nullptr ? cloud->info.node_count : 0)
+		+ sizeof(int32_t) * (cloud->queue.capacity + cloud->cut.capacity);
+	*out_gpu_bytes = 0;
+}
+
+///////////////////////////////////////////
+
+void point_cloud_destroy(point_cloud_t cloud) {
+	if (cloud->node_state != nullptr) {
+		for (int32_t i = 0; i < cloud->info.node_count; i++)
+			mesh_release(cloud->node_state[i].mesh);
+	}
+	point_cloud_file_release(cloud->file);
+	material_release(cloud->material);
+	mesh_release(cloud->inds);
+	sk_free(cloud->nodes);
+	sk_free(cloud->node_state);
+	cloud->queue.free();
+	cloud->cut  .free();
+	*cloud = {};
+}
+
+///////////////////////////////////////////
+// Loading the octree
+///////////////////////////////////////////
+
+static bool32_t point_cloud_load_file(asset_task_t *, asset_header_t *asset, void *job_data) {
+	point_cloud_t       cloud = (point_cloud_t)asset;
+	point_cloud_load_t *data  = (point_cloud_load_t *)job_data;
+
+	// The cache is only good if it was built from this exact version of the
+	// source. If the source is missing, we'll happily use the cache on its
+	// own, which is handy for shipping only the cache.
+	uint64_t source_size = 0;
+	uint64_t source_time = 0;
+	bool     has_source  = false;
+	FILE    *source      = platform_file_open(data->filename, "rb");
+	if (source) {
+		platform_file_seek(source, 0, SEEK_END);
+		source_size = (uint64_t)platform_file_tell(source);
+		source_time = platform_file_modified(source);
+		has_source  = true;
+		fclose(source);
+	}
+
+	// A cache shipped alongside the source is checked first, then the one
+	// we may have built on a previous run.
+	point_octree_header_t info  = {};
+	point_octree_node_t  *nodes = nullptr;
+	FILE                 *fp    = nullptr;
+	const char           *caches[2] = { data->shipped_cache_filename, data->cache_filename };
+	for (int32_t i = 0; i < _countof(caches) && fp == nullptr; i++) {
+		fp = platform_file_exists(caches[i]) ? platform_file_open(caches[i], "rb") : nullptr;
+		if (fp != nullptr && (!point_octree_read(fp, &info, &nodes) || (has_source && (info.source_size != source_size || info.source_time != source_time)))) {
+			sk_free(nodes);
+			nodes = nullptr;
+			fclose(fp);
+			fp = nullptr;
+		}
+	}
+
+	if (fp == nullptr) {
+		if (!has_source) {
+			log_warnf("Point cloud file failed to load: %s", data->filename);
+			cloud->header.state = asset_state_error_not_found;
+			return false;
+		}
+		log_diagf("Building point cloud cache for %s", data->filename);
+		if (!point_octree_build(data->filename, data->cache_filename)) {
+			cloud->header.state = asset_state_error;
+			return false;
+		}
+		fp = platform_file_open(data->cache_filename, "rb");
+		if (fp == nullptr || !point_octree_read(fp, &info, &nodes)) {
+			if (fp) fclose(fp);
+			sk_free(nodes);
+			cloud->header.state = asset_state_error;
+			return false;
+		}
+	}
+
+	point_cloud_file_t *file = sk_malloc_zero_t(point_cloud_file_t, 1);
+	file->fp   = fp;
+	file->mtx  = ft_mutex_create();
+	file->refs = 1;
+
+	point_cloud_node_t *node_state = sk_malloc_zero_t(point_cloud_node_t, info.node_count);
+	for (int32_t i = 0; i < info.node_count; i++) node_state[i].parent = -1;
+	for (int32_t i = 0; i < info.node_count; i++) {
+		for (int32_t c = 0; c < 8; c++) {
+			if (nodes[i].children[c] >= 0) node_state[nodes[i].children[c]].parent = i;
+		}
+	}
+
+	cloud->file       = file;
+	cloud->info       = info;
+	cloud->nodes      = nodes;
+	cloud->node_state = node_state;
+	return true;
+}
+
+///////////////////////////////////////////
+
+static bool32_t point_cloud_load_inds(asset_task_t *, asset_header_t *asset, void *) {
+	point_cloud_t cloud = (point_cloud_t)asset;
+
+	// Node verts are already in draw order, so one identity index buffer
+	// covers every node, they each just draw a different amount of it.
+	int32_t max_count = 1;
+	for (int32_t i = 0; i < cloud->info.node_count; i++)
+		max_count = maxi(max_count, cloud->nodes[i].count);
+	int32_t ind_count = max_count * 3;
+	vind_t *inds      = sk_malloc_t(vind_t, ind_count);
+	for (int32_t i = 0; i < ind_count; i++) inds[i] = (vind_t)i;
+
+	char id[64];
+	assets_unique_name(asset_type_mesh, "point_cloud/inds", id, sizeof(id));
+	cloud->inds = mesh_create();
+	mesh_set_id       (cloud->inds, id);
+	mesh_set_keep_data(cloud->inds, false);
+	mesh_set_inds     (cloud->inds, inds, ind_count);
+	sk_free(inds);
+
+	cloud->header.state = asset_state_loaded;
+	return true;
+}
+
+///////////////////////////////////////////
+
+static void point_cloud_load_free(asset_header_t *, void *job_data) {
+	point_cloud_load_t *data = (point_cloud_load_t *)job_data;
+	sk_free(data->filename);
+	sk_free(data->shipped_cache_filename);
+	sk_free(data->cache_filename);
+	sk_free(data);
+}
+
+///////////////////////////////////////////
+
+static void point_cloud_load_on_failure(asset_header_t *asset, void *) {
+	log_warnf("Point cloud failed to load: %s", asset->id_text);
+}
+
+///////////////////////////////////////////
+
+point_cloud_t point_cloud_create_file(const char *filename) {
+	point_cloud_t result = point_cloud_find(filename);
+	if (result != nullptr)
+		return result;
+
+	result = (point_cloud_t)assets_allocate(asset_type_point_cloud);
+	point_cloud_set_id(result, filename);
+	result->header.state = asset_state_loading;
+	result->point_budget = 1000000;
+	result->max_error    = 2;
+
+	shader_t shader = shader_find(default_id_shader_points);
+	result->material = material_create(shader);
+	shader_release(shader);
+
+	// Caches we build go in the platform's cache folder, since the source
+	// may well live somewhere read-only, like an APK or an app package.
+	point_cloud_load_t *data = sk_malloc_zero_t(point_cloud_load_t, 1);
+	data->filename               = assets_file(filename);
+	data->shipped_cache_filename = string_append(string_copy(data->filename), 1, ".skpc");
+	char   *cache_dir = platform_cache_dir();
+	int32_t count     = snprintf(nullptr, 0, "%s/%016llx.skpc", cache_dir, (unsigned long long)hash_fnv64_string(data->filename));
+	data->cache_filename = sk_malloc_t(char, count + 1);
+	snprintf(data->cache_filename, count + 1, "%s/%016llx.skpc", cache_dir, (unsigned long long)hash_fnv64_string(data->filename));
+	sk_free(cache_dir);
+
+	static const asset_load_action_t actions[] = {
+		asset_load_action_t {point_cloud_load_file, asset_thread_asset},
+		asset_load_action_t {point_cloud_load_inds, asset_thread_gpu  },
+	};
+	asset_task_t task = {};
+	task.asset        = &result->header;
+	task.free_data    = point_cloud_load_free;
+	task.on_failure   = point_cloud_load_on_failure;
+	task.load_data    = data;
+	task.actions      = (asset_load_action_t *)actions;
+	task.action_count = _countof(actions);
+	assets_add_task(task);
+
+	return result;
+}
+
+///////////////////////////////////////////
+// Loading nodes
+///////////////////////////////////////////
+
+static bool32_t point_cloud_node_read(asset_task_t *task, asset_header_t *, void *job_data) {
+	point_cloud_node_load_t *data  = (point_cloud_node_load_t *)job_data;
+	int32_t                  count = data->node.count;
+
+	data->points = sk_malloc_t(cloud_point_t, count);
+	ft_mutex_lock(data->file->mtx);
+	bool ok = point_octree_read_points(data->file->fp, &data->node, data->points);
+	ft_mutex_unlock(data->file->mtx);
+	if (!ok) return false;
+
+	task->upload_bytes = (uint64_t)count * 3 * sizeof(vert_t);
+	return true;
+}
+
+///////////////////////////////////////////
+
+static bool32_t point_cloud_node_upload(asset_task_t *, asset_header_t *asset, void *job_data) {
+	point_cloud_node_load_t *data       = (point_cloud_node_load_t *)job_data;
+	mesh_t                   mesh       = (mesh_t)asset;
+	int32_t                  vert_count = data->node.count * 3;
+
+	// Each point becomes a triangle that the points shader expands in view
+	// space. The corners circumscribe a unit circle, which the shader clips
+	// down to a round splat. Indices come from the cloud's shared buffer.
+	const vec2 corners[3] = { {0, 2}, {-1.7320508f, -1}, {1.7320508f, -1} };
+	float      radius     = data->node.spacing * 0.75f;
+	vert_t    *verts      = sk_malloc_t(vert_t, vert_count);
+	for (int32_t i = 0; i < data->node.count; i++) {
+		for (int32_t c = 0; c < 3; c++)
+			verts[i*3 + c] = vert_t{ data->points[i].pos, {radius, 0, 0}, corners[c], data->points[i].color };
+	}
+	sk_free(data->points);
+	data->points = nullptr;
+
+	bounds_t bounds = data->node.bounds;
+	bounds.dimensions += vec3_one * (data->node.spacing * 2);
+	mesh_set_keep_data(mesh, false);
+	mesh_set_verts    (mesh, verts, vert_count, false);
+	mesh_share_inds   (mesh, data->inds, vert_count);
+	mesh_set_bounds   (mesh, bounds);
+	sk_free(verts);
+	mesh->header.state = asset_state_loaded;
+	return true;
+}
+
+///////////////////////////////////////////
+
+static void point_cloud_node_free(asset_header_t *, void *job_data) {
+	point_cloud_node_load_t *data = (point_cloud_node_load_t *)job_data;
+	atomic_decrement(&data->file->loading);
+	point_cloud_file_release(data->file);
+	assets_releaseref_threadsafe(data->inds);
+	sk_free(data->points);
+	sk_free(data);
+}
+
+///////////////////////////////////////////
+
+// The cloud picks up failed nodes on the main thread, see
+// point_cloud_node_unload.
+static void point_cloud_node_on_failure(asset_header_t *asset, void *job_data) {
+	point_cloud_node_load_t *data = (point_cloud_node_load_t *)job_data;
+	log_warnf("Point cloud node at offset %llu failed to load", (unsigned long long)data->node.offset);
+	asset->state = asset_state_error;
+}
+
+///////////////////////////////////////////
+
+static void point_cloud_node_unload(point_cloud_t cloud, int32_t node_id) {
+	point_cloud_node_t *state = &cloud->node_state[node_id];
+	if (state->mesh->header.state < 0)
+		state->retry_frame = cloud->frame + point_cloud_retry_frames;
+	mesh_release(state->mesh);
+	state->mesh = nullptr;
+	cloud->points_resident -= cloud->nodes[node_id].count;
+}
+
+///////////////////////////////////////////
+
+static void point_cloud_node_request(point_cloud_t cloud, int32_t node_id, float error) {
+	point_cloud_node_t *state = &cloud->node_state[node_id];
+	if (state->mesh != nullptr && state->mesh->header.state < 0) point_cloud_node_unload(cloud, node_id);
+	if (state->mesh != nullptr || cloud->frame < state->retry_frame || cloud->file->loading >= point_cloud_max_loading) return;
+
+	// The task holds onto the mesh and the file, so if the cloud goes away
+	// while this is loading, nothing is left dangling.
+	char id[64];
+	assets_unique_name(asset_type_mesh, "point_cloud/node", id, sizeof(id));
+	state->mesh = mesh_create();
+	state->mesh->header.state = asset_state_loading;
+	mesh_set_id(state->mesh, id);
+	cloud->points_resident += cloud->nodes[node_id].count;
+
+	atomic_increment(&cloud->file->refs);
+	atomic_increment(&cloud->file->loading);
+	point_cloud_node_load_t *data = sk_malloc_zero_t(point_cloud_node_load_t, 1);
+	data->file = cloud->file;
+	data->inds = cloud->inds;
+	data->node = cloud->nodes[node_id];
+	mesh_addref(data->inds);
+
+	static const asset_load_action_t actions[] = {
+		asset_load_action_t {point_cloud_node_read,   asset_thread_asset},
+		asset_load_action_t {point_cloud_node_upload, asset_thread_gpu  },
+	};
+	asset_task_t task = {};
+	task.asset        = &state->mesh->header;
+	task.free_data    = point_cloud_node_free;
+	task.on_failure   = point_cloud_node_on_failure;
+	task.load_data    = data;
+	task.actions      = (asset_load_action_t *)actions;
+	task.action_count = _countof(actions);
+	// Nodes with the most visible error go first
+	task.sort         = asset_sort(0, (int32_t)(1000000 / fmaxf(error, 0.001f)));
+	assets_add_task(task);
+}
+
+///////////////////////////////////////////
+// Drawing
+///////////////////////////////////////////
+
+struct point_cloud_view_t {
+	vec4  planes[5];
+	vec3  cam_pos;
+	float scale;
+	float px_per_unit;
+	matrix transform;
+};
+
+///////////////////////////////////////////
+
+static vec4 point_cloud_plane(vec4 w_col, vec4 col, float sign) {
+	vec4  p   = { w_col.x + col.x*sign, w_col.y + col.y*sign, w_col.z + col.z*sign, w_col.w + col.w*sign };
+	float inv = 1.0f / sqrtf(p.x*p.x + p.y*p.y + p.z*p.z);
+	return vec4{ p.x*inv, p.y*inv, p.z*inv, p.w*inv };
+}
+
+///////////////////////////////////////////
+
+static bool point_cloud_node_visible(const point_cloud_view_t *view, const point_octree_node_t *node) {
+	float radius = vec3_magnitude(node->bounds.dimensions) * 0.5f + node->spacing;
+	for (int32_t i = 0; i < 5; i++) {
+		const vec4 *plane = &view->planes[i];
+		if (plane->x*node->bounds.center.x + plane->y*node->bounds.center.y + plane->z*node->bounds.center.z + plane->w < -radius)
+			return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+static float point_cloud_node_error(const point_cloud_view_t *view, const point_octree_node_t *node) {
+	// How many pixels apart this node's points are on screen
+	vec3  center = matrix_transform_pt(view->transform, node->bounds.center);
+	float radius = vec3_magnitude(node->bounds.dimensions) * 0.5f * view->scale;
+	float dist   = fmaxf(vec3_distance(center, view->cam_pos) - radius, 0.01f);
+	return (node->spacing * view->scale * view->px_per_unit) / dist;
+}
+
+///////////////////////////////////////////
+
+void point_cloud_draw(point_cloud_t cloud, matrix transform, color128 color_linear, render_layer_ layer) {
+	if (cloud->header.state < asset_state_loaded) return;
+	cloud->frame += 1;
+
+	// The frustum is in the cloud's local space, so nodes can be tested
+	// without transforming them. Rows here are the columns of the combined
+	// matrix, which gives us clip space planes.
+	point_cloud_view_t view = {};
+	matrix proj = render_get_projection_matrix();
+	matrix clip = transform * render_get_cam_final_inv() * proj;
+	vec4   col[4];
+	for (int32_t c = 0; c < 4; c++) col[c] = { clip.m[c], clip.m[4 + c], clip.m[8 + c], clip.m[12 + c] };
+	view.planes[0] = point_cloud_plane(col[3], col[0],  1);
+	view.planes[1] = point_cloud_plane(col[3], col[0], -1);
+	view.planes[2] = point_cloud_plane(col[3], col[1],  1);
+	view.planes[3] = point_cloud_plane(col[3], col[1], -1);
+	view.planes[4] = point_cloud_plane(col[3], col[2],  1);
+	view.transform   = transform;
+	view.cam_pos     = matrix_extract_translation(render_get_cam_final());
+	view.scale       = vec3_magnitude(matrix_transform_dir(transform, vec3_right));
+	view.px_per_unit = proj.m[5] * sk_system_info().display_height * 0.5f;
+
+	// Refine the cut through the tree, splitting whichever node has the
+	// most error, until everything is detailed enough or we run out of
+	// point budget.
+	const point_octree_node_t *nodes = cloud->nodes;
+	point_cloud_node_t        *state = cloud->node_state;
+	uint64_t                   frame = cloud->frame;
+	cloud->queue.clear();
+	cloud->cut  .clear();
+	int32_t root = cloud->info.root;
+	if (!point_cloud_node_visible(&view, &nodes[root])) return;
+	int64_t used = nodes[root].count;
+	state[root].in_cut = frame;
+	cloud->cut  .add(root);
+	cloud->queue.add(root);
+	while (cloud->queue.count > 0) {
+		int32_t best       = 0;
+		float   best_error = -1;
+		for (int32_t i = 0; i < cloud->queue.count; i++) {
+			float error = point_cloud_node_error(&view, &nodes[cloud->queue[i]]);
+			if (error > best_error) { best_error = error; best = i; }
+		}
+		int32_t id = cloud->queue[best];
+		cloud->queue.remove(best);
+		if (best_error <= cloud->max_error) break;
+
+		int64_t child_points = 0;
+		bool    has_children = false;
+		for (int32_t c = 0; c < 8; c++) {
+			int32_t child = nodes[id].children[c];
+			if (child >= 0 && point_cloud_node_visible(&view, &nodes[child])) {
+				child_points += nodes[child].count;
+				has_children  = true;
+			}
+		}
+		if (!has_children || used - nodes[id].count + child_points > cloud->point_budget) continue;
+
+		used += child_points - nodes[id].count;
+		state[id].in_cut = 0;
+		for (int32_t c = 0; c < 8; c++) {
+			int32_t child = nodes[id].children[c];
+			if (child >= 0 && point_cloud_node_visible(&view, &nodes[child])) {
+				state[child].in_cut = frame;
+				cloud->cut  .add(child);
+				cloud->queue.add(child);
+			}
+		}
+	}
+
+	// Draw the cut. Nodes that aren't loaded yet get requested, and their
+	// closest loaded ancestor draws in their place.
+	for (int32_t i = 0; i < cloud->cut.count; i++) {
+		int32_t id = cloud->cut[i];
+		if (state[id].in_cut != frame) continue;
+
+		int32_t draw_id = id;
+		while (draw_id >= 0) {
+			state[draw_id].last_used = frame;
+			if (state[draw_id].mesh != nullptr && mesh_get_ind_count(state[draw_id].mesh) > 0) break;
+			point_cloud_node_request(cloud, draw_id, point_cloud_node_error(&view, &nodes[draw_id]));
+			draw_id = state[draw_id].parent;
+		}
+		if (draw_id >= 0 && state[draw_id].drawn != frame) {
+			state[draw_id].drawn = frame;
+			render_add_mesh(state[draw_id].mesh, cloud->material, transform, color_linear, layer);
+		}
+	}
+
+	// Evict the least recently used nodes once we're holding onto a fair
+	// bit more than we're drawing. Nodes that failed to load don't hold any
+	// points, so they go first.
+	for (int32_t evict = 0; evict < 8 && cloud->points_resident > (int64_t)cloud->point_budget * 2; evict++) {
+		int32_t  oldest      = -1;
+		uint64_t oldest_used = frame;
+		for (int32_t i = 0; i < cloud->info.node_count; i++) {
+			if (state[i].mesh == nullptr) continue;
+			if (state[i].mesh->header.state < 0) {
+				oldest = i;
+				break;
+			}
+			if (state[i].last_used < oldest_used && state[i].mesh->header.state >= asset_state_loaded) {
+				oldest      = i;
+				oldest_used = state[i].last_used;
+			}
+		}
+		if (oldest < 0) break;
+		point_cloud_node_unload(cloud, oldest);
+	}
+}
+
+///////////////////////////////////////////
+// Properties
+///////////////////////////////////////////
+
+asset_state_ point_cloud_asset_state(const point_cloud_t cloud) {
+	return cloud->header.state;
+}
+
+///////////////////////////////////////////
+
+bounds_t point_cloud_get_bounds(const point_cloud_t cloud) {
+	return cloud->header.state >= asset_state_loaded ? cloud->info.bounds : bounds_t{};
+}
+
+///////////////////////////////////////////
+
+int64_t point_cloud_get_point_count(const point_cloud_t cloud) {
+	return cloud->header.state >= asset_state_loaded ? cloud->info.point_count : 0;
+}
+
+///////////////////////////////////////////
+
+void point_cloud_set_point_budget(point_cloud_t cloud, int32_t max_points) {
+	cloud->point_budget = maxi(max_points, 1);
+}
+
+///////////////////////////////////////////
+
+int32_t point_cloud_get_point_budget(const point_cloud_t cloud) {
+	return cloud->point_budget;
+}
+
+///////////////////////////////////////////
+
+void point_cloud_set_max_error(point_cloud_t cloud, float max_error_pixels) {
+	cloud->max_error = fmaxf(max_error_pixels, 0.01f);
+}
+
+///////////////////////////////////////////
+
+float point_cloud_get_max_error(const point_cloud_t cloud) {
+	return cloud->max_error;
+}
+
+} // namespace sk
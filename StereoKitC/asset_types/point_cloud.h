@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../stereokit.h"
+#include "../utils/point_octree.h"
+#include "../libraries/array.h"
+#include "../libraries/ferr_thread.h"
+#include "assets.h"
+
+namespace sk {
+
+// The cache file is shared between the cloud and any node loads that are in
+// flight, so it can outlive the cloud asset itself.
+struct point_cloud_file_t {
+	FILE            *fp;
+	ft_mutex_t       mtx;
+	volatile int32_t refs;
+	volatile int32_t loading;
+};
+
+struct point_cloud_node_t {
+	mesh_t   mesh;
+	int32_t  parent;
+	uint64_t last_used;
+	uint64_t in_cut;
+	uint64_t drawn;
+	// A node that failed to load waits until this frame to try again.
+	uint64_t retry_frame;
+};
+
+struct _point_cloud_t {
+	asset_header_t        header;
+	point_cloud_file_t   *file;
+	point_octree_header_t info;
+	point_octree_node_t  *nodes;
+	point_cloud_node_t   *node_state;
+	material_t            material;
+	// Every node draws from this one identity index buffer, sized for the
+	// largest node.
+	mesh_t                inds;
+	int32_t               point_budget;
+	float                 max_error;
+	int64_t               points_resident;
+	uint64_t              frame;
+	array_t<int32_t>      queue;
+	array_t<int32_t>      cut;
+};
+
+void point_cloud_destroy     (point_cloud_t cloud);
+void point_cloud_memory_usage(point_cloud_t cloud, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
+
+} // namespace sk
@@ -41,11 +41,12 @@ sound_t sound_create(const char *filename) {
 	if (result != nullptr)
 		return result;
 
-	
-	void*    data;
-	size_t   length;
+
+	// The decoder reads from this memory for the life of the sound, so it's
+	// mapped rather than copied, and only released with the sound.
+	platform_file_map_t file;
 	char*    sound_file = assets_file(filename);
-	bool32_t loaded     = platform_read_file(sound_file, &data, &length);
+	bool32_t loaded     = platform_file_map(sound_file, &file);
 	sk_free(sound_file);
 	if (!loaded) {
 		log_warnf("Sound file failed to load: %s", filename);
@@ -54,11 +55,12 @@ sound_t sound_create(const char *filename) {
 
 	result = (_sound_t*)assets_allocate(asset_type_sound);
 	result->type = sound_type_decode;
+	result->file = file;
 	sound_set_id(result, filename);
 
 	ma_decoder_config config = ma_decoder_config_init(AU_SAMPLE_FORMAT, 1, AU_SAMPLE_RATE);
-	if (ma_decoder_init_memory(data, length, &config, &result->decoder) != MA_SUCCESS) {
-		log_errf("Failed to parse sound '%s'.", sound_file);
+	if (ma_decoder_init_memory(result->file.data, result->file.size, &config, &result->decoder) != MA_SUCCESS) {
+		log_errf("Failed to parse sound '%s'.", filename);
 		assets_releaseref(&result->header);
 		return nullptr;
 	}
@@ -269,8 +271,19 @@ void sound_release(sound_t sound) {
 
 ///////////////////////////////////////////
 
+void sound_memory_usage(sound_t sound, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	// Streams share the decoded buffer with their ring buffer
+	*out_cpu_bytes = sizeof(_sound_t) + sound->buffer.capacity * sizeof(float) + sound->file.size;
+	*out_gpu_bytes = 0;
+}
+
+///////////////////////////////////////////
+
 void sound_destroy(sound_t sound) {
 	ma_decoder_uninit(&sound->decoder);
+	if (sound->file.data != nullptr) {
+		platform_file_unmap(&sound->file);
+	}
 	if (sound->type == sound_type_stream) {
 		ma_pcm_rb_uninit(&sound->stream_buffer);
 	}
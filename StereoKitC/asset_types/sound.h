@@ -24,11 +24,13 @@ struct _sound_t {
 	asset_header_t header;
 	sound_type_    type;
 	ma_decoder     decoder;
+	platform_file_map_t file;
 	buffer_t       buffer;
 	ma_pcm_rb      stream_buffer;
 	ft_mutex_t     data_lock;
 };
 
-void sound_destroy(sound_t sound);
+void sound_destroy     (sound_t sound);
+void sound_memory_usage(sound_t sound, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
 
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "../stereokit.h"
+#include "../_stereokit.h"
 #include "../platforms/platform.h"
 #include "../libraries/ferr_hash.h"
 #include "../libraries/qoi.h"
@@ -8,6 +9,11 @@
 #include "../spherical_harmonics.h"
 #include "texture.h"
 #include "texture_.h"
+#include "texture_compressed.h"
+#include "texture_stream.h"
+#include "../utils/image_resample.h"
+#include "../libraries/atomic_util.h"
+#include "../libraries/ferr_thread.h"
 
 #pragma warning(push)
 #pragma warning(disable : 26451 6011 6262 6308 6387 28182 26819 )
@@ -33,10 +39,9 @@
 
 namespace sk {
 
-void *tex_load_image_data(void *data, size_t data_size, bool32_t srgb_data, tex_format_ *out_format, int32_t *out_width, int32_t *out_height);
-bool  tex_load_image_info(void *data, size_t data_size, bool32_t srgb_data, int32_t *out_width, int32_t *out_height, tex_format_ *out_format);
-void  tex_update_label   (tex_t texture);
-void _tex_set_options    (skg_tex_t* texture, tex_sample_ sample, tex_address_ address_mode, int32_t anisotropy_level);
+bool  tex_load_image_info     (void *data, size_t data_size, bool32_t srgb_data, int32_t *out_width, int32_t *out_height, tex_format_ *out_format);
+void  tex_set_compressed      (tex_t texture, tex_compressed_t *images, int32_t image_count);
+void  tex_set_cubemap_lighting(tex_t cubemap_texture, const void **faces, int32_t width, int32_t height);
 
 const char *tex_msg_load_failed           = "Texture file failed to load: %s";
 const char *tex_msg_invalid_fmt           = "Texture invalid format: %s";
@@ -44,24 +49,46 @@ const char *tex_msg_mismatched_images     = "Texture array mismatched format or
 const char *tex_msg_requires_rendertarget = "Zbuffer can only be attached to a rendertarget!";
 const char *tex_msg_requires_depth        = "Zbuffer must be a depth texture!";
 
-tex_t tex_error_texture   = nullptr;
-tex_t tex_loading_texture = nullptr;
+tex_t   tex_error_texture   = nullptr;
+tex_t   tex_loading_texture = nullptr;
+int32_t tex_max_resolution  = 0;
+int64_t tex_memory_total    = 0;
 
 ///////////////////////////////////////////
 // Texture loading stages                //
 ///////////////////////////////////////////
 
+struct tex_load_t;
+
+// Images in an array or cubemap each read and decode on their own asset
+// thread, and are checked against each other once they've all finished.
+struct tex_layer_t {
+	tex_load_t      *data;
+	int32_t          index;
+	int32_t          width;
+	int32_t          height;
+	tex_format_      format;
+	asset_state_     state;
+	bool32_t         is_compressed;
+	tex_compressed_t compressed;
+};
+
 struct tex_load_t {
 	bool32_t  is_srgb;
 	char    **file_names;
 	int32_t   file_count;
 
-	void    **file_data;
-	size_t   *file_sizes;
+	platform_file_map_t *files;
 
 	void    **color_data;
 	int32_t   color_width;
 	int32_t   color_height;
+
+	tex_compressed_t *compressed;
+	tex_stream_t     *stream;
+	// Streams may hang onto the file to decode it again later
+	bool32_t          keep_files;
+	tex_layer_t      *layers;
 };
 
 ///////////////////////////////////////////
@@ -71,13 +98,17 @@ void tex_load_free(asset_header_t *, void *job_data) {
 
 	for (int32_t i = 0; i < data->file_count; i++) {
 		if (data->file_names != nullptr) sk_free(data->file_names[i]);
-		if (data->file_data  != nullptr) sk_free(data->file_data [i]);
+		if (data->files      != nullptr) platform_file_unmap(&data->files[i]);
 		if (data->color_data != nullptr) sk_free(data->color_data[i]);
+		if (data->compressed != nullptr) tex_compressed_free(&data->compressed[i]);
+		if (data->layers     != nullptr) tex_compressed_free(&data->layers[i].compressed);
 	}
+	tex_stream_destroy(data->stream);
 	sk_free(data->file_names);
-	sk_free(data->file_sizes);
-	sk_free(data->file_data);
+	sk_free(data->compressed);
+	sk_free(data->files);
 	sk_free(data->color_data);
+	sk_free(data->layers);
 	sk_free(data);
 }
 
@@ -87,8 +118,7 @@ bool32_t tex_load_arr_files(asset_task_t *task, asset_header_t *asset, void *job
 	tex_load_t* data = (tex_load_t*)job_data;
 	tex_t       tex  = (tex_t)asset;
 
-	data->file_data  = sk_malloc_t(void *, data->file_count);
-	data->file_sizes = sk_malloc_t(size_t, data->file_count);
+	data->files = sk_malloc_zero_t(platform_file_map_t, data->file_count);
 
 	// Load all files
 	int32_t     width  = 0;
@@ -98,7 +128,7 @@ bool32_t tex_load_arr_files(asset_task_t *task, asset_header_t *asset, void *job
 		// Read from file
 
 		char*    asset_filename = assets_file(data->file_names[i]);
-		bool32_t loaded         = platform_read_file(asset_filename, &data->file_data[i], &data->file_sizes[i]);
+		bool32_t loaded         = platform_file_map(asset_filename, &data->files[i]);
 		sk_free(asset_filename);
 		if (!loaded) {
 			log_warnf(tex_msg_load_failed, data->file_names[i]);
@@ -108,7 +138,7 @@ bool32_t tex_load_arr_files(asset_task_t *task, asset_header_t *asset, void *job
 
 		// Grab the image metadata
 		tex_format_ color_format = tex_format_none;
-		if (!tex_load_image_info(data->file_data[i], data->file_sizes[i], data->is_srgb, &data->color_width, &data->color_height, &color_format)) {
+		if (!tex_load_image_info(data->files[i].data, data->files[i].size, data->is_srgb, &data->color_width, &data->color_height, &color_format)) {
 			log_warnf(tex_msg_invalid_fmt, data->file_names[i]);
 			tex->header.state = asset_state_error_unsupported;
 			return false;
@@ -134,18 +164,158 @@ bool32_t tex_load_arr_files(asset_task_t *task, asset_header_t *asset, void *job
 
 ///////////////////////////////////////////
 
-bool32_t tex_load_arr_parse(asset_task_t *, asset_header_t *asset, void *job_data) {
-	tex_load_t *data = (tex_load_t *)job_data;
-	tex_t       tex  = (tex_t)asset;
+// Compressed containers bring their own mip chain, and are decoded here if
+// the GPU can't use their format directly.
+bool32_t tex_load_compressed_parse(tex_t tex, tex_load_t *data, int32_t i) {
+	if (data->compressed == nullptr)
+		data->compressed = sk_malloc_zero_t(tex_compressed_t, data->file_count);
+
+	tex_compressed_t *image = &data->compressed[i];
+	if (!tex_compressed_parse (data->files[i].data, data->files[i].size, data->is_srgb, image) ||
+		!tex_compressed_decode(image)) {
+		log_warnf(tex_msg_invalid_fmt, data->file_names[i]);
+		tex->header.state = asset_state_error_unsupported;
+		return false;
+	}
 
-	data->color_data = sk_malloc_t(void*, data->file_count);
+	if (tex->width  != image->width  ||
+		tex->height != image->height ||
+		tex->format != image->format ||
+		image->mip_count != data->compressed[0].mip_count) {
+		log_warnf(tex_msg_mismatched_images, data->file_names[i]);
+		tex->header.state = asset_state_error_unsupported;
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+// Shrinks images larger than tex_max_resolution, before they ever reach the
+// GPU. Stored mips are used when a container has them, and everything else
+// that's not block compressed is resampled.
+void tex_limit_resolution(tex_t tex, tex_load_t *data) {
+	int32_t limit = tex_max_resolution;
+	if (limit <= 0 || (tex->width <= limit && tex->height <= limit)) return;
+
+	int32_t width  = tex->width;
+	int32_t height = tex->height;
+	if (data->compressed != nullptr) {
+		for (int32_t i = 0; i < data->file_count; i++)
+			tex_compressed_skip_mips(&data->compressed[i], limit);
+		width  = data->compressed[0].width;
+		height = data->compressed[0].height;
+	}
+	if ((width <= limit && height <= limit) || !image_resize_supported(tex->format)) {
+		tex_set_meta(tex, width, height, tex->format);
+		return;
+	}
+
+	float   scale      = (float)limit / (float)maxi(width, height);
+	int32_t new_width  = maxi(1, (int32_t)(width  * scale + 0.5f));
+	int32_t new_height = maxi(1, (int32_t)(height * scale + 0.5f));
+	size_t  size       = tex_format_memory(tex->format, new_width, new_height);
+	for (int32_t i = 0; i < data->file_count; i++) {
+		if (data->compressed != nullptr) {
+			// Only CPU decoded containers land here, and resampling loses the
+			// stored chain, so the GPU will make a new one.
+			tex_compressed_t *image = &data->compressed[i];
+			for (int32_t f = 0; f < image->frame_count; f++) {
+				void *resized = sk_malloc(size);
+				image_resize(tex->format, image->frame_mips[f * image->mip_count], width, height, resized, new_width, new_height);
+				image->owned = sk_realloc_t(void *, image->owned, image->owned_count + 1);
+				image->owned[image->owned_count++] = resized;
+				image->frame_mips[f] = resized;
+			}
+			image->mip_count = 1;
+			image->width     = new_width;
+			image->height    = new_height;
+		} else {
+			void *resized = sk_malloc(size);
+			image_resize(tex->format, data->color_data[i], width, height, resized, new_width, new_height);
+			sk_free(data->color_data[i]);
+			data->color_data[i] = resized;
+		}
+	}
+	tex_set_meta(tex, new_width, new_height, tex->format);
+}
+
+///////////////////////////////////////////
+
+// Builds the mip chain here on the asset thread, rather than leaving it for
+// the GPU during upload. It then uploads all at once, the same way a
+// container file's stored mips do.
+void tex_load_build_mips(tex_t tex, tex_load_t *data) {
+	if (!(tex->type & tex_type_mips) || (tex->type & tex_type_dynamic) ||
+		data->compressed != nullptr || data->stream != nullptr ||
+		!image_resize_supported(tex->format))
+		return;
+
+	int32_t mip_count = (int32_t)skg_mip_count(tex->width, tex->height);
+	if (mip_count < 2) return;
+
+	data->compressed = sk_malloc_zero_t(tex_compressed_t, data->file_count);
+	for (int32_t i = 0; i < data->file_count; i++) {
+		tex_compressed_t *image = &data->compressed[i];
+		image->format      = tex->format;
+		image->width       = tex->width;
+		image->height      = tex->height;
+		image->mip_count   = mip_count;
+		image->frame_count = 1;
+		image->frame_mips  = sk_malloc_t(const void *, mip_count);
+		image->owned       = sk_malloc_t(void *,       mip_count);
+		image->owned_count = mip_count;
+		image->owned[0]    = data->color_data[i];
+		data->color_data[i] = nullptr;
+
+		image_mips(tex->format, image->owned[0], tex->width, tex->height, 1, mip_count - 1, tex->mip_mode, tex->mip_alpha_cutoff, &image->owned[1]);
+		for (int32_t m = 0; m < mip_count; m++)
+			image->frame_mips[m] = image->owned[m];
+	}
+}
+
+///////////////////////////////////////////
+
+// Roughly what the upload action will hand to the GPU, so the main thread's
+// upload budget can account for it.
+uint64_t tex_load_upload_bytes(tex_t tex, tex_load_t *data) {
+	int32_t first = data->stream     != nullptr ? data->stream->initial_mip      : 0;
+	int32_t mips  = data->stream     != nullptr ? data->stream->source.mip_count
+	              : data->compressed != nullptr ? data->compressed[0].mip_count : 1;
+	uint64_t result = 0;
+	for (int32_t m = first; m < mips; m++) {
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(tex->width, tex->height, m, &mip_w, &mip_h);
+		result += tex_format_memory(tex->format, mip_w, mip_h);
+	}
+	return result * data->file_count;
+}
+
+///////////////////////////////////////////
+
+bool32_t tex_set_arr_parse(tex_t tex, tex_load_t* data) {
+	data->color_data = sk_malloc_zero_t(void*, data->file_count);
 
 	// Parse all files
 	for (int32_t i = 0; i < data->file_count; i++) {
+		// Compressed images can't share an array with regular ones
+		bool compressed = tex_compressed_is(data->files[i].data, data->files[i].size);
+		if (i > 0 && compressed != (data->compressed != nullptr)) {
+			log_warnf(tex_msg_mismatched_images, data->file_names[i]);
+			tex->header.state = asset_state_error_unsupported;
+			return false;
+		}
+		if (compressed) {
+			// Parsed images may point right into the file, so it stays
+			// mapped until the load data is freed.
+			if (!tex_load_compressed_parse(tex, data, i)) return false;
+			continue;
+		}
+
 		int         width  = 0;
 		int         height = 0;
 		tex_format_ format = tex_format_none;
-		data->color_data[i] = tex_load_image_data(data->file_data[i], data->file_sizes[i], data->is_srgb, &format, &width, &height);
+		data->color_data[i] = tex_load_image_data(data->files[i].data, data->files[i].size, data->is_srgb, &format, &width, &height);
 
 		if (data->color_data[i] == nullptr) {
 			log_warnf(tex_msg_invalid_fmt, data->file_names[i]);
@@ -165,40 +335,154 @@ bool32_t tex_load_arr_parse(asset_task_t *, asset_header_t *asset, void *job_dat
 		}
 
 		// Release file memory as soon as we're done with it
-		sk_free(data->file_data[i]);
+		if (!data->keep_files)
+			platform_file_unmap(&data->files[i]);
 	}
+	tex_limit_resolution(tex, data);
 	tex->header.state = asset_state_loaded_meta;
 	return true;
 }
-bool32_t tex_set_arr_parse(tex_t tex, tex_load_t* data) {
-	data->color_data = sk_malloc_t(void*, data->file_count);
 
-	// Parse all files
-	for (int32_t i = 0; i < data->file_count; i++) {
-		int         width = 0;
-		int         height = 0;
-		tex_format_ format = tex_format_none;
-		data->color_data[i] = tex_load_image_data(data->file_data[i], data->file_sizes[i], data->is_srgb, &format, &width, &height);
+///////////////////////////////////////////
 
-		if (data->color_data[i] == nullptr) {
+bool32_t tex_load_arr_parse(asset_task_t *task, asset_header_t *asset, void *job_data) {
+	tex_load_t *data = (tex_load_t *)job_data;
+	tex_t       tex  = (tex_t)asset;
+	data->keep_files = data->file_count == 1 && tex_get_memory_budget() != 0;
+	if (!tex_set_arr_parse(tex, data)) return false;
+
+	// Large single images can start on the GPU as a small mip, and fill in
+	// the rest as they show up on screen.
+	if (data->file_count == 1)
+		data->stream = tex_stream_create(tex, data->is_srgb, data->compressed, &data->files[0], &data->color_data[0]);
+	if (data->keep_files && data->compressed == nullptr)
+		platform_file_unmap(&data->files[0]);
+	tex_load_build_mips(tex, data);
+	task->upload_bytes = tex_load_upload_bytes(tex, data);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool32_t tex_load_layer(asset_task_t *, asset_header_t *, void *job_data) {
+	tex_layer_t *layer = (tex_layer_t *)job_data;
+	tex_load_t  *data  = layer->data;
+	int32_t      i     = layer->index;
+
+	char*    asset_filename = assets_file(data->file_names[i]);
+	bool32_t loaded         = platform_file_map(asset_filename, &data->files[i]);
+	sk_free(asset_filename);
+	if (!loaded) {
+		log_warnf(tex_msg_load_failed, data->file_names[i]);
+		layer->state = asset_state_error_not_found;
+		return false;
+	}
+
+	// Parsed images may point right into the file, so it stays mapped until
+	// the load data is freed.
+	if (tex_compressed_is(data->files[i].data, data->files[i].size)) {
+		layer->is_compressed = true;
+		if (!tex_compressed_parse (data->files[i].data, data->files[i].size, data->is_srgb, &layer->compressed) ||
+			!tex_compressed_decode(&layer->compressed)) {
 			log_warnf(tex_msg_invalid_fmt, data->file_names[i]);
-			tex->header.state = asset_state_error_unsupported;
+			layer->state = asset_state_error_unsupported;
 			return false;
 		}
+		layer->width  = layer->compressed.width;
+		layer->height = layer->compressed.height;
+		layer->format = layer->compressed.format;
+		return true;
+	}
 
-		// This shouldn't happen, tex_load_image_data and tex_load_image_info
-		// should always agree with eachother
-		if (tex->width != width ||
-			tex->height != height ||
-			tex->format != format) {
-			log_warnf("Texture data mismatch: %s", data->file_names[i]);
-			tex_set_fallback(tex, tex_error_texture);
-			tex->header.state = asset_state_error;
+	data->color_data[i] = tex_load_image_data(data->files[i].data, data->files[i].size, data->is_srgb, &layer->format, &layer->width, &layer->height);
+	platform_file_unmap(&data->files[i]);
+	if (data->color_data[i] == nullptr) {
+		log_warnf(tex_msg_invalid_fmt, data->file_names[i]);
+		layer->state = asset_state_error_unsupported;
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool32_t tex_load_arr_layers(asset_task_t *task, asset_header_t *, void *job_data) {
+	tex_load_t *data = (tex_load_t *)job_data;
+
+	data->files      = sk_malloc_zero_t(platform_file_map_t, data->file_count);
+	data->color_data = sk_malloc_zero_t(void*,               data->file_count);
+	data->layers     = sk_malloc_zero_t(tex_layer_t,         data->file_count);
+
+	static const asset_load_action_t actions[] = {
+		asset_load_action_t {tex_load_layer, asset_thread_asset},
+	};
+	for (int32_t i = 0; i < data->file_count; i++) {
+		data->layers[i].data  = data;
+		data->layers[i].index = i;
+
+		asset_task_t layer_task = {};
+		layer_task.load_data    = &data->layers[i];
+		layer_task.actions      = (asset_load_action_t *)actions;
+		layer_task.action_count = _countof(actions);
+		layer_task.priority     = task->priority;
+		layer_task.sort         = task->sort;
+		assets_add_subtask(task, layer_task);
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool32_t tex_load_arr_join(asset_task_t *task, asset_header_t *asset, void *job_data) {
+	tex_load_t  *data  = (tex_load_t *)job_data;
+	tex_t        tex   = (tex_t)asset;
+	tex_layer_t *first = &data->layers[0];
+
+	// Layers have already logged their own issues
+	for (int32_t i = 0; i < data->file_count; i++) {
+		if (data->layers[i].state < 0) {
+			tex->header.state = data->layers[i].state;
 			return false;
 		}
+	}
 
-		// Release file memory as soon as we're done with it
-		sk_free(data->file_data[i]);
+	for (int32_t i = 1; i < data->file_count; i++) {
+		tex_layer_t *layer = &data->layers[i];
+		if (layer->is_compressed != first->is_compressed ||
+			layer->width         != first->width  ||
+			layer->height        != first->height ||
+			layer->format        != first->format ||
+			layer->compressed.mip_count != first->compressed.mip_count) {
+			log_warnf(tex_msg_mismatched_images, data->file_names[i]);
+			tex->header.state = asset_state_error_unsupported;
+			return false;
+		}
+	}
+
+	if (first->is_compressed) {
+		data->compressed = sk_malloc_zero_t(tex_compressed_t, data->file_count);
+		for (int32_t i = 0; i < data->file_count; i++) {
+			data->compressed[i]        = data->layers[i].compressed;
+			data->layers[i].compressed = {};
+		}
+	}
+	tex_set_meta(tex, first->width, first->height, first->format);
+	tex_limit_resolution(tex, data);
+	tex_load_build_mips (tex, data);
+	task->upload_bytes = tex_load_upload_bytes(tex, data);
+
+	// The faces are right here, so lighting doesn't need to wait on a GPU
+	// readback. Stored mip chains may already have a small enough mip.
+	if ((tex->type & tex_type_cubemap) && data->file_count == 6) {
+		const void *faces[6];
+		int32_t     mip = 0;
+		if (data->compressed != nullptr)
+			mip = mini(maxi(0, (int32_t)skg_mip_count(tex->width, tex->height) - 6), data->compressed[0].mip_count - 1);
+		for (int32_t i = 0; i < 6; i++)
+			faces[i] = data->compressed != nullptr ? data->compressed[i].frame_mips[mip] : data->color_data[i];
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(tex->width, tex->height, mip, &mip_w, &mip_h);
+		tex_set_cubemap_lighting(tex, faces, mip_w, mip_h);
 	}
 	tex->header.state = asset_state_loaded_meta;
 	return true;
@@ -210,11 +494,10 @@ bool32_t tex_load_equirect_file(asset_task_t *task, asset_header_t *asset, void
 	tex_load_t* data = (tex_load_t*)job_data;
 	tex_t       tex  = (tex_t)asset;
 
-	data->file_data  = sk_malloc_t(void *, data->file_count);
-	data->file_sizes = sk_malloc_t(size_t, data->file_count);
+	data->files = sk_malloc_zero_t(platform_file_map_t, data->file_count);
 
 	char*    asset_filename = assets_file(data->file_names[0]);
-	bool32_t loaded         = platform_read_file(asset_filename, &data->file_data[0], &data->file_sizes[0]);
+	bool32_t loaded         = platform_file_map(asset_filename, &data->files[0]);
 	sk_free(asset_filename);
 	if (!loaded) {
 		log_warnf(tex_msg_load_failed, data->file_names[0]);
@@ -223,12 +506,27 @@ bool32_t tex_load_equirect_file(asset_task_t *task, asset_header_t *asset, void
 	}
 
 	tex_format_ format;
-	if (!tex_load_image_info(data->file_data[0], data->file_sizes[0], data->is_srgb, &data->color_width, &data->color_height, &format)) {
+	if (!tex_load_image_info(data->files[0].data, data->files[0].size, data->is_srgb, &data->color_width, &data->color_height, &format)) {
 		log_warnf(tex_msg_invalid_fmt, data->file_names[0]);
 		tex->header.state = asset_state_error_unsupported;
 		return false;
 	}
 
+	// Compressed containers can hold the cubemap faces directly, no need
+	// to go through an equirect.
+	tex_compressed_t info = {};
+	if (tex_compressed_info(data->files[0].data, data->files[0].size, data->is_srgb, &info)) {
+		if (!info.cubemap) {
+			log_warnf("Compressed cubemap files need exactly 6 faces: %s", data->file_names[0]);
+			tex->header.state = asset_state_error_unsupported;
+			return false;
+		}
+		data->compressed = sk_malloc_zero_t(tex_compressed_t, 1);
+		tex_set_meta(tex, info.width, info.height, format);
+		assets_task_set_complexity(task, info.width * info.height * 6);
+		return true;
+	}
+
 	int32_t tex_size = data->color_height / 2;
 	tex_set_meta(tex, tex_size, tex_size, format);
 	assets_task_set_complexity(task, tex_size * 6);
@@ -241,10 +539,13 @@ bool32_t tex_load_equirect_parse(asset_task_t *, asset_header_t *asset, void *jo
 	tex_load_t *data = (tex_load_t *)job_data;
 	tex_t       tex  = (tex_t)asset;
 
+	if (data->compressed != nullptr)
+		return tex_load_compressed_parse(tex, data, 0);
+
 	data->color_data = sk_malloc_t(void*, 1);
 
 	tex_format_ format = tex_format_none;
-	data->color_data[0] = tex_load_image_data(data->file_data[0], data->file_sizes[0], data->is_srgb, &format, &data->color_width, &data->color_height);
+	data->color_data[0] = tex_load_image_data(data->files[0].data, data->files[0].size, data->is_srgb, &format, &data->color_width, &data->color_height);
 
 	if (data->color_data[0] == nullptr) {
 		log_warnf(tex_msg_invalid_fmt, data->file_names[0]);
@@ -253,7 +554,7 @@ bool32_t tex_load_equirect_parse(asset_task_t *, asset_header_t *asset, void *jo
 	}
 
 	// Release file memory as soon as we're done with it
-	sk_free(data->file_data[0]);
+	platform_file_unmap(&data->files[0]);
 
 	return true;
 }
@@ -264,6 +565,11 @@ bool32_t tex_load_equirect_upload(asset_task_t *, asset_header_t *asset, void *j
 	tex_load_t *data = (tex_load_t *)job_data;
 	tex_t       tex  = (tex_t)asset;
 
+	if (data->compressed != nullptr) {
+		tex_set_compressed(tex, data->compressed, data->file_count);
+		return true;
+	}
+
 	const vec3 up   [6] = { vec3_up, vec3_up, -vec3_forward, vec3_forward, vec3_up, vec3_up };
 	const vec3 fwd  [6] = { {1,0,0}, {-1,0,0}, {0,-1,0}, {0,1,0}, {0,0,1}, {0,0,-1} };
 	const vec3 right[6] = { {0,0,-1}, {0,0,1}, {1,0,0}, {1,0,0}, {1,0,0}, {-1,0,0} };
@@ -320,6 +626,7 @@ bool32_t tex_load_equirect_upload(asset_task_t *, asset_header_t *asset, void *j
 	material_release(convert_material);
 	tex_release(equirect);
 
+	tex_set_cubemap_lighting(tex, (const void **)face_data, tex->width, tex->height);
 	tex_set_color_arr(tex, tex->width, tex->height, (void**)&face_data, 6);
 	for (int32_t i = 0; i < 6; i++) {
 		sk_free(face_data[i]);
@@ -335,8 +642,20 @@ bool32_t tex_load_arr_upload(asset_task_t *, asset_header_t *asset, void *job_da
 	tex_load_t *data = (tex_load_t *)job_data;
 	tex_t       tex  = (tex_t)asset;
 
+	// Streaming textures start with their smallest mips
+	if (data->stream != nullptr) {
+		tex_stream_t *stream = data->stream;
+		data->stream = nullptr;
+		if (!tex_stream_start(tex, stream)) {
+			tex_set_fallback(tex, tex_error_texture);
+			tex->header.state = asset_state_error;
+		}
+		return true;
+	}
+
 	// Create with the data we have
-	tex_set_color_arr(tex, tex->width, tex->height, data->color_data, data->file_count);
+	if (data->compressed != nullptr) tex_set_compressed(tex, data->compressed, data->file_count);
+	else                             tex_set_color_arr (tex, tex->width, tex->height, data->color_data, data->file_count);
 
 	return true;
 }
@@ -350,6 +669,21 @@ void tex_load_on_failure(asset_header_t *asset, void *) {
 ///////////////////////////////////////////
 
 bool tex_load_image_info(void *data, size_t data_size, bool32_t srgb_data, int32_t *out_width, int32_t *out_height, tex_format_ *out_format) {
+	// Check KTX2 and DDS, these report the format they'll have once on the
+	// GPU, which may be decoded from what's in the file.
+	if (tex_compressed_is(data, data_size)) {
+		tex_compressed_t info = {};
+		if (!tex_compressed_info(data, data_size, srgb_data, &info)) return false;
+		*out_width  = info.width;
+		*out_height = info.height;
+		*out_format = tex_compressed_format(info.format);
+		if (*out_format == tex_format_none) {
+			log_warn("Compressed texture format isn't supported by this GPU, and can't be decoded on the CPU.");
+			return false;
+		}
+		return true;
+	}
+
 	// Check STB image formats
 	int32_t comp;
 	bool success = stbi_info_from_memory((const stbi_uc*)data, (int)data_size, out_width, out_height, &comp) == 1;
@@ -425,14 +759,16 @@ void tex_add_loading_task(tex_t texture, void *load_data, const asset_load_actio
 
 ///////////////////////////////////////////
 
-tex_t tex_create_file_type(const char *file, tex_type_ type, bool32_t srgb_data, int32_t priority) {
+tex_t tex_create_file_type(const char *file, tex_type_ type, bool32_t srgb_data, int32_t priority, image_mip_ mip_mode, float mip_alpha_cutoff) {
 	tex_t result = tex_find(file);
 	if (result != nullptr)
 		return result;
 
 	result = tex_create(type);
 	tex_set_id(result, file);
-	result->header.state = asset_state_loading;
+	result->header.state     = asset_state_loading;
+	result->mip_mode         = mip_mode;
+	result->mip_alpha_cutoff = mip_alpha_cutoff;
 
 	tex_load_t *load_data = sk_malloc_zero_t(tex_load_t, 1);
 	load_data->is_srgb       = srgb_data;
@@ -457,31 +793,32 @@ tex_t tex_create_file_type(const char *file, tex_type_ type, bool32_t srgb_data,
 ///////////////////////////////////////////
 
 tex_t tex_create_file(const char *file, bool32_t srgb_data, int32_t priority) {
-	return tex_create_file_type(file, tex_type_image, srgb_data, priority);
+	return tex_create_file_type(file, tex_type_image, srgb_data, priority, image_mip_default, 0);
 }
 
 ///////////////////////////////////////////
 
-tex_t tex_create_mem_type(tex_type_ type, void *data, size_t data_size, bool32_t srgb_data, int32_t priority) {
+tex_t tex_create_mem_type(tex_type_ type, void *data, size_t data_size, bool32_t srgb_data, int32_t priority, image_mip_ mip_mode, float mip_alpha_cutoff) {
 	tex_t result = tex_create(type);
+	result->mip_mode         = mip_mode;
+	result->mip_alpha_cutoff = mip_alpha_cutoff;
 
 	tex_load_t *load_data = sk_malloc_zero_t(tex_load_t, 1);
 	load_data->is_srgb       = srgb_data;
 	load_data->file_count    = 1;
 	load_data->file_names    = sk_malloc_t(char *, 1);
-	load_data->file_sizes    = sk_malloc_t(size_t, 1);
-	load_data->file_data     = sk_malloc_t(void *, 1);
+	load_data->files         = sk_malloc_zero_t(platform_file_map_t, 1);
 	load_data->file_names[0] = string_copy("(memory)");
-	load_data->file_sizes[0] = data_size;
-	load_data->file_data [0] = sk_malloc(sizeof(uint8_t) * data_size);
-	memcpy(load_data->file_data[0], data, data_size);
+	load_data->files[0].size = data_size;
+	load_data->files[0].data = sk_malloc(sizeof(uint8_t) * data_size);
+	memcpy(load_data->files[0].data, data, data_size);
 
 	// Grab the file meta right away since we already have the file data, no
 	// point in delaying that until the task.
 	int32_t     width  = 0;
 	int32_t     height = 0;
 	tex_format_ format = tex_format_none;
-	if (!tex_load_image_info(load_data->file_data[0], load_data->file_sizes[0], load_data->is_srgb, &width, &height, &format)) {
+	if (!tex_load_image_info(load_data->files[0].data, load_data->files[0].size, load_data->is_srgb, &width, &height, &format)) {
 		log_warnf(tex_msg_invalid_fmt, load_data->file_names[0]);
 		result->header.state = asset_state_error_unsupported;
 		return result;
@@ -504,7 +841,7 @@ tex_t tex_create_mem_type(tex_type_ type, void *data, size_t data_size, bool32_t
 ///////////////////////////////////////////
 
 tex_t tex_create_mem(void *data, size_t data_size, bool32_t srgb_data, int32_t priority) {
-	return tex_create_mem_type(tex_type_image, data, data_size, srgb_data, priority);
+	return tex_create_mem_type(tex_type_image, data, data_size, srgb_data, priority, image_mip_default, 0);
 }
 
 ///////////////////////////////////////////
@@ -586,7 +923,18 @@ tex_t _tex_create_file_arr(tex_type_ type, const char **files, int32_t file_coun
 		asset_load_action_t {tex_load_arr_upload, asset_thread_asset},
 #endif
 	};
-	tex_add_loading_task(result, load_data, actions, _countof(actions), priority, 0);
+	// Multiple images read and decode in parallel, one per asset thread.
+	static const asset_load_action_t layer_actions[] = {
+		asset_load_action_t {tex_load_arr_layers, asset_thread_asset},
+		asset_load_action_t {tex_load_arr_join,   asset_thread_asset},
+#if defined(SKG_OPENGL)
+		asset_load_action_t {tex_load_arr_upload, asset_thread_gpu},
+#else
+		asset_load_action_t {tex_load_arr_upload, asset_thread_asset},
+#endif
+	};
+	if (file_count > 1) tex_add_loading_task(result, load_data, layer_actions, _countof(layer_actions), priority, 0);
+	else                tex_add_loading_task(result, load_data, actions,       _countof(actions),       priority, 0);
 
 	// NOTE: this will block execution if it occurs, as it requires the cubemap
 	// to be loaded!
@@ -721,6 +1069,7 @@ void tex_set_surface(tex_t texture, void *native_surface, tex_type_ type, int64_
 	texture->tex    = native_surface == nullptr ? skg_tex_t{} : skg_tex_create_from_existing(native_surface, skg_type, skg_tex_fmt_from_native(native_fmt), width, height, surface_count);
 	texture->width  = texture->tex.width;
 	texture->height = texture->tex.height;
+	tex_memory_update(texture);
 
 	texture->header.state = skg_tex_is_valid(&texture->tex)
 		? asset_state_loaded
@@ -809,12 +1158,26 @@ void tex_release(tex_t texture) {
 
 ///////////////////////////////////////////
 
+void tex_memory_usage(tex_t texture, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes) {
+	uint64_t cpu = sizeof(_tex_t);
+	if (texture->light_info != nullptr) cpu += sizeof(spherical_harmonics_t);
+	if (texture->stream     != nullptr) cpu += tex_stream_cpu_memory(texture->stream);
+
+	// Textures that wrap someone else's surface don't own that memory
+	*out_cpu_bytes = cpu;
+	*out_gpu_bytes = texture->owned ? tex_memory_size(texture) : 0;
+}
+
+///////////////////////////////////////////
+
 void tex_destroy(tex_t tex) {
 	assets_on_load_remove(&tex->header, nullptr);
 
+	tex_stream_destroy(tex->stream);
 	sk_free(tex->light_info);
 	if(tex->owned)
 		skg_tex_destroy(&tex->tex);
+	atomic_add64(&tex_memory_total, -tex->memory_bytes);
 	if (tex->depth_buffer != nullptr) tex_release(tex->depth_buffer);
 	
 	*tex = {};
@@ -845,6 +1208,11 @@ void _tex_set_color_arr(tex_t texture, int32_t width, int32_t height, void **dat
 	bool different_size = texture->width != width || texture->height != height || texture->tex.array_count != data_count;
 	if (!different_size && (data == nullptr || *data == nullptr))
 		return;
+	if (texture->stream != nullptr) {
+		tex_stream_t *stream = texture->stream;
+		texture->stream = nullptr;
+		tex_stream_destroy(stream);
+	}
 	if (!skg_tex_is_valid(&texture->tex) || different_size || (!different_size && !dynamic)) {
 		if (!different_size && !dynamic)
 			texture->type &= tex_type_dynamic;
@@ -876,6 +1244,7 @@ void _tex_set_color_arr(tex_t texture, int32_t width, int32_t height, void **dat
 	} else {
 		log_warn("Attempting additional writes to a non-dynamic texture!");
 	}
+	tex_memory_update(texture);
 
 	if (skg_tex_is_valid(&texture->tex)) {
 		if (sh_lighting_info != nullptr)
@@ -917,24 +1286,145 @@ void tex_set_color_arr(tex_t texture, int32_t width, int32_t height, void **data
 
 ///////////////////////////////////////////
 
+asset_fence_t tex_set_color_arr_async(tex_t texture, int32_t width, int32_t height, void **data, int32_t data_count) {
+	// This goes through the main thread on every backend, same as meshes.
+	// D3D could create the texture here, but swapping it in would free the
+	// old one while this frame's draws may still be using it.
+	if (ft_id_matches(sk_main_thread())) {
+		_tex_set_color_arr(texture, width, height, data, data_count, nullptr, 1);
+		return 0;
+	}
+
+	// The job, the frame list and copies of each frame share one staging
+	// allocation, so the caller is free to reuse its buffers right away.
+	struct tex_async_job_t {
+		tex_t   texture;
+		int32_t width;
+		int32_t height;
+		void  **data;
+		int32_t data_count;
+	};
+	size_t frame_size  = tex_format_memory(texture->format, width, height);
+	size_t frames_size = data == nullptr ? 0 : data_count * frame_size;
+	tex_async_job_t *job_data = (tex_async_job_t *)assets_staging_alloc(sizeof(tex_async_job_t) + sizeof(void *) * data_count + frames_size);
+	job_data->texture    = texture;
+	job_data->width      = width;
+	job_data->height     = height;
+	job_data->data       = data == nullptr ? nullptr : (void **)(job_data + 1);
+	job_data->data_count = data_count;
+	if (data != nullptr) {
+		uint8_t *frames = (uint8_t *)(job_data->data + data_count);
+		for (int32_t i = 0; i < data_count; i++) {
+			job_data->data[i] = data[i] == nullptr ? nullptr : frames + i * frame_size;
+			if (data[i] != nullptr) memcpy(job_data->data[i], data[i], frame_size);
+		}
+	}
+	tex_addref(texture);
+
+	return assets_execute_gpu_async([](void *data) {
+		tex_async_job_t *job_data = (tex_async_job_t *)data;
+		_tex_set_color_arr(job_data->texture, job_data->width, job_data->height, job_data->data, job_data->data_count, nullptr, 1);
+		return (bool32_t)true;
+	}, [](void *data) {
+		tex_release(((tex_async_job_t *)data)->texture);
+		assets_staging_free(data);
+	}, job_data, frames_size);
+}
+
+///////////////////////////////////////////
+
+void _tex_set_compressed(tex_t texture, tex_compressed_t *images, int32_t image_count) {
+	int32_t mip_count   = images[0].mip_count;
+	int32_t frame_count = 0;
+	for (int32_t i = 0; i < image_count; i++) frame_count += images[i].frame_count;
+
+	const void **frame_mips = sk_malloc_t(const void *, frame_count * mip_count);
+	int32_t      at         = 0;
+	for (int32_t i = 0; i < image_count; i++) {
+		memcpy(&frame_mips[at], images[i].frame_mips, sizeof(void *) * images[i].frame_count * mip_count);
+		at += images[i].frame_count * mip_count;
+	}
+	if (image_count == 1 && images[0].cubemap)
+		texture->type |= tex_type_cubemap;
+	if (texture->stream != nullptr) {
+		tex_stream_t *stream = texture->stream;
+		texture->stream = nullptr;
+		tex_stream_destroy(stream);
+	}
+
+	// Without a mip chain in the file, uncompressed data can still have the
+	// GPU make one. Block compressed formats can't be rendered to, so those
+	// just go without.
+	if (mip_count == 1 && (texture->type & tex_type_mips) && !skg_tex_fmt_is_compressed((skg_tex_fmt_)texture->format)) {
+		_tex_set_color_arr(texture, images[0].width, images[0].height, (void **)frame_mips, frame_count, nullptr, 1);
+		sk_free(frame_mips);
+		return;
+	}
+	if (mip_count == 1) texture->type &= ~tex_type_mips;
+	else                texture->type |=  tex_type_mips;
+
+	skg_tex_type_ type    = texture->type & tex_type_cubemap ? skg_tex_type_cubemap : skg_tex_type_image;
+	skg_tex_t     new_tex = skg_tex_create(type, skg_use_static, (skg_tex_fmt_)texture->format, mip_count > 1 ? skg_mip_generate : skg_mip_none);
+	_tex_set_options(&new_tex, texture->sample_mode, texture->address_mode, texture->anisotropy);
+	skg_tex_set_contents_mips(&new_tex, frame_mips, frame_count, mip_count, images[0].width, images[0].height);
+	sk_free(frame_mips);
+
+	skg_tex_t old_tex = texture->tex;
+	texture->tex = new_tex;
+	skg_tex_destroy(&old_tex);
+	tex_set_meta     (texture, images[0].width, images[0].height, texture->format);
+	tex_update_label (texture);
+	tex_memory_update(texture);
+
+	if (skg_tex_is_valid(&texture->tex)) {
+		tex_set_fallback(texture, nullptr);
+		texture->header.state = asset_state_loaded;
+	} else {
+		tex_set_fallback(texture, tex_error_texture);
+		texture->header.state = asset_state_error;
+	}
+}
+
+///////////////////////////////////////////
+
+void tex_set_compressed(tex_t texture, tex_compressed_t *images, int32_t image_count) {
+	struct tex_compressed_job_t {
+		tex_t             texture;
+		tex_compressed_t *images;
+		int32_t           image_count;
+	};
+	tex_compressed_job_t job_data = { texture, images, image_count };
+
+#if defined(SKG_OPENGL)
+	assets_execute_gpu([](void *data) {
+		tex_compressed_job_t *job_data = (tex_compressed_job_t *)data;
+		_tex_set_compressed(job_data->texture, job_data->images, job_data->image_count);
+		return (bool32_t)true;
+	}, &job_data);
+#else
+	_tex_set_compressed(job_data.texture, job_data.images, job_data.image_count);
+#endif
+}
+
+///////////////////////////////////////////
+
 void tex_set_mem(tex_t texture, void* data, size_t data_size, bool32_t srgb_data, bool32_t blocking, int32_t priority) {
 	tex_load_t* load_data = sk_malloc_zero_t(tex_load_t, 1);
 	load_data->is_srgb    = srgb_data;
 	load_data->file_count = 1;
-	load_data->file_names = sk_malloc_t(char*,  1);
-	load_data->file_sizes = sk_malloc_t(size_t, 1);
-	load_data->file_data  = sk_malloc_t(void*,  1);
+	load_data->file_names = sk_malloc_t(char*, 1);
+	load_data->files      = sk_malloc_zero_t(platform_file_map_t, 1);
 	load_data->file_names[0] = string_copy("(memory)");
-	load_data->file_sizes[0] = data_size;
-	load_data->file_data [0] = sk_malloc(sizeof(uint8_t) * data_size);
-	memcpy(load_data->file_data[0], data, data_size);
+	load_data->files[0].size = data_size;
+	load_data->files[0].data = sk_malloc(sizeof(uint8_t) * data_size);
+	memcpy(load_data->files[0].data, data, data_size);
 
 	// Grab the file meta right away since we already have the file data, no
 	// point in delaying that until the task.
 	int32_t     width = 0;
 	int32_t     height = 0;
 	tex_format_ format = tex_format_none;
-	if (!tex_load_image_info(load_data->file_data[0], load_data->file_sizes[0], load_data->is_srgb, &width, &height, &format)) {
+	if (!tex_load_image_info(load_data->files[0].data, load_data->files[0].size, load_data->is_srgb, &width, &height, &format)) {
 		log_warnf(tex_msg_invalid_fmt, load_data->file_names[0]);
 		texture->header.state = asset_state_error_unsupported;
 		return;
@@ -943,8 +1433,10 @@ void tex_set_mem(tex_t texture, void* data, size_t data_size, bool32_t srgb_data
 
 	if (blocking) {
 		bool32_t success = tex_set_arr_parse(texture, load_data);
-		if (!success)	tex_set_fallback(texture, tex_error_texture);
-		else			tex_set_color_arr(texture, texture->width, texture->height, load_data->color_data, load_data->file_count);
+		if (success) tex_load_build_mips(texture, load_data);
+		if      (!success)                         tex_set_fallback  (texture, tex_error_texture);
+		else if (load_data->compressed != nullptr) tex_set_compressed(texture, load_data->compressed, load_data->file_count);
+		else                                       tex_set_color_arr (texture, texture->width, texture->height, load_data->color_data, load_data->file_count);
 		tex_load_free(nullptr, load_data);
 	} else {
 		static const asset_load_action_t actions[] = {
@@ -961,6 +1453,38 @@ void tex_set_mem(tex_t texture, void* data, size_t data_size, bool32_t srgb_data
 
 ///////////////////////////////////////////
 
+// Calculates lighting from cubemap faces that are still on the CPU, so
+// tex_get_cubemap_lighting won't need to read them back from the GPU. Faces
+// are resampled to the same small mip the GPU path reads from.
+void tex_set_cubemap_lighting(tex_t cubemap_texture, const void **faces, int32_t width, int32_t height) {
+	tex_format_ format = cubemap_texture->format;
+	if (width != height || !image_resize_supported(format)) return;
+
+	int32_t mip_level = maxi((int32_t)0, (int32_t)skg_mip_count(width, height) - 6);
+	int32_t mip_w, mip_h;
+	skg_mip_dimensions(width, height, mip_level, &mip_w, &mip_h);
+
+	void *data[6];
+	for (int32_t f = 0; f < 6; f++) {
+		if (mip_level == 0) {
+			data[f] = (void *)faces[f];
+		} else {
+			data[f] = sk_malloc(tex_format_memory(format, mip_w, mip_h));
+			image_resize(format, faces[f], width, height, data[f], mip_w, mip_h);
+		}
+	}
+
+	if (cubemap_texture->light_info == nullptr)
+		cubemap_texture->light_info = sk_malloc_t(spherical_harmonics_t, 1);
+	*cubemap_texture->light_info = sh_calculate(data, format, mip_w);
+
+	if (mip_level != 0) {
+		for (int32_t f = 0; f < 6; f++) sk_free(data[f]);
+	}
+}
+
+///////////////////////////////////////////
+
 spherical_harmonics_t tex_get_cubemap_lighting(tex_t cubemap_texture) {
 	assets_block_until(&cubemap_texture->header, asset_state_loaded);
 
@@ -1006,6 +1530,13 @@ void tex_set_colors(tex_t texture, int32_t width, int32_t height, void *data) {
 
 ///////////////////////////////////////////
 
+asset_fence_t tex_set_colors_async(tex_t texture, int32_t width, int32_t height, void *data) {
+	void *data_arr[1] = { data };
+	return tex_set_color_arr_async(texture, width, height, data_arr, 1);
+}
+
+///////////////////////////////////////////
+
 void _tex_set_options(skg_tex_t *texture, tex_sample_ sample, tex_address_ address_mode, int32_t anisotropy_level) {
 	skg_tex_address_ skg_addr;
 	switch (address_mode) {
@@ -1100,6 +1631,8 @@ int32_t tex_get_anisotropy(tex_t texture) {
 ///////////////////////////////////////////
 
 int32_t tex_get_mips(tex_t texture) {
+	if (skg_tex_is_valid(&texture->tex))
+		return maxi(1, texture->tex.mip_count);
 	return (texture->type & tex_type_mips)
 		? skg_mip_count(tex_get_width(texture), tex_get_height(texture))
 		: 1;
@@ -1124,6 +1657,58 @@ size_t tex_format_size(tex_format_ format) {
 }
 
 
+///////////////////////////////////////////
+
+size_t tex_format_memory(tex_format_ format, int32_t width, int32_t height) {
+	return skg_tex_fmt_memory((skg_tex_fmt_)format, width, height);
+}
+
+///////////////////////////////////////////
+
+bool tex_format_is_srgb(tex_format_ format) {
+	switch (format) {
+	case tex_format_rgba32:
+	case tex_format_bgra32:
+	case tex_format_bc1_rgba:
+	case tex_format_bc3_rgba:
+	case tex_format_bc7_rgba:
+	case tex_format_etc2_rgb:
+	case tex_format_etc2_rgba:
+	case tex_format_astc4x4_rgba: return true;
+	default:                      return false;
+	}
+}
+
+///////////////////////////////////////////
+
+size_t tex_memory_size(tex_t texture) {
+	const skg_tex_t *tex = &texture->tex;
+	if (!skg_tex_is_valid(tex)) return 0;
+
+	int32_t mips   = maxi(1, tex->mip_count);
+	size_t  result = 0;
+	for (int32_t m = 0; m < mips; m++) {
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(tex->width, tex->height, m, &mip_w, &mip_h);
+		result += tex_format_memory(texture->format, mip_w, mip_h);
+	}
+	return result * maxi(1, tex->array_count) * maxi(1, tex->multisample);
+}
+
+///////////////////////////////////////////
+
+void tex_memory_update(tex_t texture) {
+	int64_t bytes = texture->owned ? (int64_t)tex_memory_size(texture) : 0;
+	atomic_add64(&tex_memory_total, bytes - texture->memory_bytes);
+	texture->memory_bytes = bytes;
+}
+
+///////////////////////////////////////////
+
+uint64_t tex_memory_used() {
+	return (uint64_t)atomic_add64(&tex_memory_total, 0);
+}
+
 ///////////////////////////////////////////
 
 tex_format_ tex_get_tex_format(int64_t native_fmt) {
@@ -1177,6 +1762,17 @@ void tex_get_data_mip(tex_t texture, void* out_data, size_t out_data_size, int32
 
 	assets_block_until(&texture->header, asset_state_loaded);
 
+	if (skg_tex_fmt_is_compressed((skg_tex_fmt_)texture->format)) {
+		log_warn("Can't retrieve the contents of a block compressed texture!");
+		memset(out_data, 0, out_data_size);
+		return;
+	}
+
+	// Streaming textures may not have this mip on the GPU yet, but the CPU
+	// still has all of them.
+	if (texture->stream != nullptr && tex_stream_get_data(texture->stream, mip_level, out_data, out_data_size))
+		return;
+
 	struct tex_data_job_t {
 		tex_t   texture;
 		void*   out_data;
@@ -1228,6 +1824,18 @@ void tex_set_error_fallback(tex_t error_texture) {
 
 ///////////////////////////////////////////
 
+void tex_set_max_resolution(int32_t max_size) {
+	tex_max_resolution = max_size > 0 ? max_size : 0;
+}
+
+///////////////////////////////////////////
+
+int32_t tex_get_max_resolution() {
+	return tex_max_resolution;
+}
+
+///////////////////////////////////////////
+
 tex_t tex_gen_color(color128 color, int32_t width, int32_t height, tex_type_ type, tex_format_ format) {
 	uint8_t data[sizeof(color128)] = {};
 	size_t  data_step = 0;
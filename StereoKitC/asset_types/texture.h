@@ -3,10 +3,13 @@
 #include "../libraries/sk_gpu.h"
 
 #include "../stereokit.h"
+#include "../utils/image_resample.h"
 #include "assets.h"
 
 namespace sk {
 
+struct tex_stream_t;
+
 struct _tex_t {
 	asset_header_t header;
 	tex_t          fallback;
@@ -25,8 +28,17 @@ struct _tex_t {
 	skg_tex_t      tex;
 	tex_t          depth_buffer;
 	spherical_harmonics_t *light_info;
+	// Only set while the texture's mips are streaming in
+	tex_stream_t  *stream;
+	// GPU memory this texture is counted for in the texture budget
+	int64_t        memory_bytes;
+	uint64_t       last_bound;
+	// How mips built on the CPU should treat this texture's data
+	image_mip_     mip_mode;
+	float          mip_alpha_cutoff;
 };
 
-void tex_destroy(tex_t texture);
+void tex_destroy     (tex_t texture);
+void tex_memory_usage(tex_t texture, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
 
 } // namespace sk
\ No newline at end of file
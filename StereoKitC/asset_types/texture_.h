@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../stereokit.h"
+#include "../libraries/sk_gpu.h"
+#include "../utils/image_resample.h"
 
 namespace sk {
 
@@ -8,9 +10,19 @@ void        tex_set_zbuffer      (tex_t texture, tex_t depth_texture);
 void        tex_set_options      (tex_t texture, tex_sample_ sample = tex_sample_linear, tex_address_ address_mode = tex_address_wrap, int32_t anisotropy_level = 4);
 void        tex_set_surface_layer(tex_t texture, void *native_surface, tex_type_ type, int64_t native_fmt, int32_t width, int32_t height, int32_t surface_index);
 size_t      tex_format_size      (tex_format_ format);
+size_t      tex_format_memory    (tex_format_ format, int32_t width, int32_t height);
+bool        tex_format_is_srgb   (tex_format_ format);
+size_t      tex_memory_size      (tex_t texture);
+void        tex_memory_update    (tex_t texture);
+uint64_t    tex_memory_used      ();
+void       *tex_load_image_data  (void *data, size_t data_size, bool32_t srgb_data, tex_format_ *out_format, int32_t *out_width, int32_t *out_height);
+void        tex_update_label     (tex_t texture);
+void       _tex_set_options      (skg_tex_t *texture, tex_sample_ sample, tex_address_ address_mode, int32_t anisotropy_level);
 tex_format_ tex_get_tex_format   (int64_t native_fmt);
 void        tex_set_meta         (tex_t texture, int32_t width, int32_t height, tex_format_ format);
 uint64_t    tex_meta_hash        (tex_t texture);
+tex_t       tex_create_file_type (const char *file, tex_type_ type, bool32_t srgb_data, int32_t priority, image_mip_ mip_mode, float mip_alpha_cutoff);
+tex_t       tex_create_mem_type  (tex_type_ type, void *data, size_t data_size, bool32_t srgb_data, int32_t priority, image_mip_ mip_mode, float mip_alpha_cutoff);
 
 uint8_t* unzip_malloc(const uint8_t* buffer, int32_t len, int32_t* out_len);
 
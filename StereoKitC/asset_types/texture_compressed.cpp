@@ -0,0 +1,404 @@
+#include "texture_compressed.h"
+#include "texture_.h"
+#include "../sk_memory.h"
+#include "../libraries/sk_gpu.h"
+#include "../utils/block_decode.h"
+
+#include <string.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+static const uint8_t ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct ktx2_header_t {
+	uint8_t  identifier[12];
+	uint32_t vk_format;
+	uint32_t type_size;
+	uint32_t pixel_width;
+	uint32_t pixel_height;
+	uint32_t pixel_depth;
+	uint32_t layer_count;
+	uint32_t face_count;
+	uint32_t level_count;
+	uint32_t supercompression;
+	uint32_t dfd_offset;
+	uint32_t dfd_length;
+	uint32_t kvd_offset;
+	uint32_t kvd_length;
+	uint64_t sgd_offset;
+	uint64_t sgd_length;
+};
+
+struct ktx2_level_t {
+	uint64_t offset;
+	uint64_t length;
+	uint64_t uncompressed_length;
+};
+
+enum ktx2_supercompression_ {
+	ktx2_supercompression_none   = 0,
+	ktx2_supercompression_basis  = 1,
+	ktx2_supercompression_zstd   = 2,
+	ktx2_supercompression_zlib   = 3,
+};
+
+const uint32_t dds_magic            = 0x20534444; // "DDS "
+const uint32_t dds_header_size      = 124;
+const uint32_t dds_pf_fourcc        = 0x4;
+const uint32_t dds_pf_rgb           = 0x40;
+const uint32_t dds_caps2_cubemap    = 0x200;
+const uint32_t dds_caps2_all_faces  = 0xFC00;
+const uint32_t dds_caps2_volume     = 0x200000;
+const uint32_t dds_dx10_misc_cube   = 0x4;
+
+static inline uint32_t tex_fourcc(const char *code) {
+	return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+}
+
+static inline uint32_t tex_read_u32(const uint8_t *data, size_t offset) {
+	uint32_t result;
+	memcpy(&result, data + offset, sizeof(result));
+	return result;
+}
+
+///////////////////////////////////////////
+
+static tex_format_ ktx2_vk_format(uint32_t vk_format) {
+	switch (vk_format) {
+	case 9:   return tex_format_r8;                     // VK_FORMAT_R8_UNORM
+	case 16:  return tex_format_r8g8;                   // VK_FORMAT_R8G8_UNORM
+	case 37:  return tex_format_rgba32_linear;          // VK_FORMAT_R8G8B8A8_UNORM
+	case 43:  return tex_format_rgba32;                 // VK_FORMAT_R8G8B8A8_SRGB
+	case 44:  return tex_format_bgra32_linear;          // VK_FORMAT_B8G8R8A8_UNORM
+	case 50:  return tex_format_bgra32;                 // VK_FORMAT_B8G8R8A8_SRGB
+	case 97:  return tex_format_rgba64f;                // VK_FORMAT_R16G16B16A16_SFLOAT
+	case 109: return tex_format_rgba128;                // VK_FORMAT_R32G32B32A32_SFLOAT
+	case 131:
+	case 133: return tex_format_bc1_rgba_linear;        // VK_FORMAT_BC1_RGB(A)_UNORM_BLOCK
+	case 132:
+	case 134: return tex_format_bc1_rgba;               // VK_FORMAT_BC1_RGB(A)_SRGB_BLOCK
+	case 137: return tex_format_bc3_rgba_linear;        // VK_FORMAT_BC3_UNORM_BLOCK
+	case 138: return tex_format_bc3_rgba;               // VK_FORMAT_BC3_SRGB_BLOCK
+	case 139: return tex_format_bc4_r;                  // VK_FORMAT_BC4_UNORM_BLOCK
+	case 141: return tex_format_bc5_rg;                 // VK_FORMAT_BC5_UNORM_BLOCK
+	case 145: return tex_format_bc7_rgba_linear;        // VK_FORMAT_BC7_UNORM_BLOCK
+	case 146: return tex_format_bc7_rgba;               // VK_FORMAT_BC7_SRGB_BLOCK
+	case 147: return tex_format_etc2_rgb_linear;        // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+	case 148: return tex_format_etc2_rgb;               // VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+	case 151: return tex_format_etc2_rgba_linear;       // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+	case 152: return tex_format_etc2_rgba;              // VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+	case 153: return tex_format_etc2_r11;               // VK_FORMAT_EAC_R11_UNORM_BLOCK
+	case 155: return tex_format_etc2_rg11;              // VK_FORMAT_EAC_R11G11_UNORM_BLOCK
+	case 157: return tex_format_astc4x4_rgba_linear;    // VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+	case 158: return tex_format_astc4x4_rgba;           // VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+	default:  return tex_format_none;
+	}
+}
+
+///////////////////////////////////////////
+
+static tex_format_ dds_dxgi_format(uint32_t dxgi_format) {
+	switch (dxgi_format) {
+	case 28: return tex_format_rgba32_linear;           // DXGI_FORMAT_R8G8B8A8_UNORM
+	case 29: return tex_format_rgba32;                  // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+	case 87: return tex_format_bgra32_linear;           // DXGI_FORMAT_B8G8R8A8_UNORM
+	case 91: return tex_format_bgra32;                  // DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+	case 10: return tex_format_rgba64f;                 // DXGI_FORMAT_R16G16B16A16_FLOAT
+	case 2:  return tex_format_rgba128;                 // DXGI_FORMAT_R32G32B32A32_FLOAT
+	case 71: return tex_format_bc1_rgba_linear;         // DXGI_FORMAT_BC1_UNORM
+	case 72: return tex_format_bc1_rgba;                // DXGI_FORMAT_BC1_UNORM_SRGB
+	case 77: return tex_format_bc3_rgba_linear;         // DXGI_FORMAT_BC3_UNORM
+	case 78: return tex_format_bc3_rgba;                // DXGI_FORMAT_BC3_UNORM_SRGB
+	case 80: return tex_format_bc4_r;                   // DXGI_FORMAT_BC4_UNORM
+	case 83: return tex_format_bc5_rg;                  // DXGI_FORMAT_BC5_UNORM
+	case 98: return tex_format_bc7_rgba_linear;         // DXGI_FORMAT_BC7_UNORM
+	case 99: return tex_format_bc7_rgba;                // DXGI_FORMAT_BC7_UNORM_SRGB
+	default: return tex_format_none;
+	}
+}
+
+///////////////////////////////////////////
+
+static size_t tex_compressed_image_size(tex_format_ format, int32_t width, int32_t height, int32_t mip) {
+	int32_t mip_w, mip_h;
+	skg_mip_dimensions(width, height, mip, &mip_w, &mip_h);
+	return skg_tex_fmt_memory((skg_tex_fmt_)format, mip_w, mip_h);
+}
+
+///////////////////////////////////////////
+
+bool tex_compressed_is(const void *data, size_t data_size) {
+	if (data_size >= sizeof(ktx2_header_t) && memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) == 0)
+		return true;
+	if (data_size >= 4 + dds_header_size && tex_read_u32((const uint8_t *)data, 0) == dds_magic)
+		return true;
+	return false;
+}
+
+///////////////////////////////////////////
+
+static bool ktx2_info(const uint8_t *data, size_t data_size, ktx2_header_t *out_header, tex_compressed_t *out_info) {
+	ktx2_header_t h;
+	memcpy(&h, data, sizeof(h));
+
+	if (h.supercompression == ktx2_supercompression_basis || h.vk_format == 0) {
+		log_warn("KTX2 Basis Universal textures aren't supported, transcode them to BC or ETC2 when building assets.");
+		return false;
+	}
+	if (h.supercompression != ktx2_supercompression_none && h.supercompression != ktx2_supercompression_zlib) {
+		log_warn("KTX2 textures can only use zlib supercompression.");
+		return false;
+	}
+	if (h.pixel_height == 0 || h.pixel_depth > 1 || (h.face_count != 1 && h.face_count != 6)) {
+		log_warn("KTX2 textures must be 2D images or cubemaps.");
+		return false;
+	}
+
+	out_info->format      = ktx2_vk_format(h.vk_format);
+	out_info->width       = (int32_t)h.pixel_width;
+	out_info->height      = (int32_t)h.pixel_height;
+	out_info->mip_count   = h.level_count == 0 ? 1 : (int32_t)h.level_count;
+	out_info->frame_count = (int32_t)((h.layer_count == 0 ? 1 : h.layer_count) * h.face_count);
+	out_info->cubemap     = h.face_count == 6 && h.layer_count <= 1;
+	if (out_info->format == tex_format_none) {
+		log_warnf("KTX2 texture format %u isn't supported.", h.vk_format);
+		return false;
+	}
+	if (sizeof(ktx2_header_t) + (size_t)out_info->mip_count * sizeof(ktx2_level_t) > data_size || out_info->mip_count > 16)
+		return false;
+
+	*out_header = h;
+	return true;
+}
+
+///////////////////////////////////////////
+
+static bool ktx2_parse(const uint8_t *data, size_t data_size, tex_compressed_t *ref_image) {
+	ktx2_header_t h;
+	if (!ktx2_info(data, data_size, &h, ref_image)) return false;
+
+	ref_image->frame_mips = sk_malloc_zero_t(const void *, ref_image->frame_count * ref_image->mip_count);
+	ref_image->owned      = sk_malloc_zero_t(void *, ref_image->mip_count);
+	for (int32_t m = 0; m < ref_image->mip_count; m++) {
+		ktx2_level_t level;
+		memcpy(&level, data + sizeof(ktx2_header_t) + m * sizeof(ktx2_level_t), sizeof(level));
+		if (level.offset > data_size || level.length > data_size - level.offset) return false;
+
+		size_t         image_size = tex_compressed_image_size(ref_image->format, ref_image->width, ref_image->height, m);
+		size_t         level_size = image_size * ref_image->frame_count;
+		const uint8_t *level_data = data + level.offset;
+		if (h.supercompression == ktx2_supercompression_zlib) {
+			int32_t  inflated_size = 0;
+			uint8_t *inflated      = unzip_malloc(level_data, (int32_t)level.length, &inflated_size);
+			if (inflated == nullptr) return false;
+			ref_image->owned[ref_image->owned_count++] = inflated;
+			if ((size_t)inflated_size < level_size) return false;
+			level_data = inflated;
+		} else if (level.length < level_size) {
+			return false;
+		}
+
+		// KTX2 stores each level as layers of faces
+		for (int32_t f = 0; f < ref_image->frame_count; f++)
+			ref_image->frame_mips[f * ref_image->mip_count + m] = level_data + image_size * f;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+static bool dds_info(const uint8_t *data, size_t data_size, bool32_t srgb_data, size_t *out_data_offset, tex_compressed_t *out_info) {
+	if (tex_read_u32(data, 4) != dds_header_size) return false;
+
+	uint32_t height   = tex_read_u32(data, 12);
+	uint32_t width    = tex_read_u32(data, 16);
+	uint32_t mips     = tex_read_u32(data, 28);
+	uint32_t pf_flags = tex_read_u32(data, 80);
+	uint32_t fourcc   = tex_read_u32(data, 84);
+	uint32_t caps2    = tex_read_u32(data, 112);
+
+	if (caps2 & dds_caps2_volume) {
+		log_warn("DDS volume textures aren't supported.");
+		return false;
+	}
+
+	tex_format_ format = tex_format_none;
+	int32_t     frames = 1;
+	bool        cube   = false;
+	*out_data_offset = 4 + dds_header_size;
+	if ((pf_flags & dds_pf_fourcc) && fourcc == tex_fourcc("DX10")) {
+		if (data_size < 4 + dds_header_size + 20) return false;
+		uint32_t dxgi   = tex_read_u32(data, 128);
+		uint32_t misc   = tex_read_u32(data, 136);
+		uint32_t layers = tex_read_u32(data, 140);
+		format = dds_dxgi_format(dxgi);
+		cube   = (misc & dds_dx10_misc_cube) != 0;
+		frames = (int32_t)(layers == 0 ? 1 : layers) * (cube ? 6 : 1);
+		cube   = cube && frames == 6;
+		*out_data_offset += 20;
+		if (format == tex_format_none) {
+			log_warnf("DDS texture format %u isn't supported.", dxgi);
+			return false;
+		}
+	} else if (pf_flags & dds_pf_fourcc) {
+		// Older files can't say if they're sRGB, so we take the caller's
+		// word for it.
+		if      (fourcc == tex_fourcc("DXT1")) format = srgb_data ? tex_format_bc1_rgba : tex_format_bc1_rgba_linear;
+		else if (fourcc == tex_fourcc("DXT5")) format = srgb_data ? tex_format_bc3_rgba : tex_format_bc3_rgba_linear;
+		else if (fourcc == tex_fourcc("ATI1") || fourcc == tex_fourcc("BC4U")) format = tex_format_bc4_r;
+		else if (fourcc == tex_fourcc("ATI2") || fourcc == tex_fourcc("BC5U")) format = tex_format_bc5_rg;
+	} else if ((pf_flags & dds_pf_rgb) && tex_read_u32(data, 88) == 32) {
+		uint32_t r_mask = tex_read_u32(data, 92);
+		if      (r_mask == 0x000000FF) format = srgb_data ? tex_format_rgba32 : tex_format_rgba32_linear;
+		else if (r_mask == 0x00FF0000) format = srgb_data ? tex_format_bgra32 : tex_format_bgra32_linear;
+	}
+	if (format == tex_format_none) {
+		log_warn("DDS texture format isn't supported.");
+		return false;
+	}
+
+	if (caps2 & dds_caps2_cubemap) {
+		if ((caps2 & dds_caps2_all_faces) != dds_caps2_all_faces) {
+			log_warn("DDS cubemaps must have all 6 faces.");
+			return false;
+		}
+		frames = 6;
+		cube   = true;
+	}
+
+	out_info->format      = format;
+	out_info->width       = (int32_t)width;
+	out_info->height      = (int32_t)height;
+	out_info->mip_count   = mips == 0 ? 1 : (int32_t)mips;
+	out_info->frame_count = frames;
+	out_info->cubemap     = cube;
+	return width > 0 && height > 0 && out_info->mip_count <= 16;
+}
+
+///////////////////////////////////////////
+
+static bool dds_parse(const uint8_t *data, size_t data_size, bool32_t srgb_data, tex_compressed_t *ref_image) {
+	size_t at = 0;
+	if (!dds_info(data, data_size, srgb_data, &at, ref_image)) return false;
+
+	// DDS stores each frame with its full mip chain
+	ref_image->frame_mips = sk_malloc_zero_t(const void *, ref_image->frame_count * ref_image->mip_count);
+	for (int32_t f = 0; f < ref_image->frame_count; f++) {
+		for (int32_t m = 0; m < ref_image->mip_count; m++) {
+			size_t image_size = tex_compressed_image_size(ref_image->format, ref_image->width, ref_image->height, m);
+			if (at > data_size || image_size > data_size - at) return false;
+			ref_image->frame_mips[f * ref_image->mip_count + m] = data + at;
+			at += image_size;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool tex_compressed_info(const void *data, size_t data_size, bool32_t srgb_data, tex_compressed_t *out_info) {
+	*out_info = {};
+	const uint8_t *bytes = (const uint8_t *)data;
+	if (data_size >= sizeof(ktx2_header_t) && memcmp(bytes, ktx2_identifier, sizeof(ktx2_identifier)) == 0) {
+		ktx2_header_t header;
+		return ktx2_info(bytes, data_size, &header, out_info);
+	}
+	if (data_size >= 4 + dds_header_size && tex_read_u32(bytes, 0) == dds_magic) {
+		size_t data_offset;
+		return dds_info(bytes, data_size, srgb_data, &data_offset, out_info);
+	}
+	return false;
+}
+
+///////////////////////////////////////////
+
+bool tex_compressed_parse(const void *data, size_t data_size, bool32_t srgb_data, tex_compressed_t *out_image) {
+	*out_image = {};
+	const uint8_t *bytes  = (const uint8_t *)data;
+	bool           result = false;
+	if      (data_size >= sizeof(ktx2_header_t) && memcmp(bytes, ktx2_identifier, sizeof(ktx2_identifier)) == 0) result = ktx2_parse(bytes, data_size, out_image);
+	else if (data_size >= 4 + dds_header_size   && tex_read_u32(bytes, 0) == dds_magic)                         result = dds_parse (bytes, data_size, srgb_data, out_image);
+
+	if (!result) tex_compressed_free(out_image);
+	return result;
+}
+
+///////////////////////////////////////////
+
+tex_format_ tex_compressed_format(tex_format_ file_format) {
+	if (!skg_tex_fmt_is_compressed((skg_tex_fmt_)file_format) || skg_tex_fmt_supported((skg_tex_fmt_)file_format))
+		return file_format;
+	if (!block_decode_supported(file_format))
+		return tex_format_none;
+
+	switch (file_format) {
+	case tex_format_bc1_rgba:
+	case tex_format_bc3_rgba:
+	case tex_format_etc2_rgb:
+	case tex_format_etc2_rgba: return tex_format_rgba32;
+	default:                   return tex_format_rgba32_linear;
+	}
+}
+
+///////////////////////////////////////////
+
+bool tex_compressed_decode(tex_compressed_t *ref_image) {
+	tex_format_ format = tex_compressed_format(ref_image->format);
+	if (format == ref_image->format) return true;
+	if (format == tex_format_none) {
+		log_warn("Compressed texture format isn't supported by this GPU, and can't be decoded on the CPU.");
+		return false;
+	}
+
+	int32_t count = ref_image->frame_count * ref_image->mip_count;
+	void  **owned = sk_malloc_zero_t(void *, count);
+	bool    valid = true;
+	for (int32_t i = 0; i < count && valid; i++) {
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(ref_image->width, ref_image->height, i % ref_image->mip_count, &mip_w, &mip_h);
+		owned[i] = sk_malloc_t(color32, (size_t)mip_w * mip_h);
+		valid    = block_decode_rgba32(ref_image->format, ref_image->frame_mips[i], mip_w, mip_h, (color32 *)owned[i]);
+		ref_image->frame_mips[i] = owned[i];
+	}
+
+	for (int32_t i = 0; i < ref_image->owned_count; i++)
+		sk_free(ref_image->owned[i]);
+	sk_free(ref_image->owned);
+	ref_image->owned       = owned;
+	ref_image->owned_count = count;
+	ref_image->format      = format;
+	return valid;
+}
+
+///////////////////////////////////////////
+
+// Drops stored mips from the top of the chain until the image fits within
+// max_size, always keeping at least the last one.
+void tex_compressed_skip_mips(tex_compressed_t *ref_image, int32_t max_size) {
+	int32_t skip = 0;
+	while (skip < ref_image->mip_count - 1 && (ref_image->width >> skip > max_size || ref_image->height >> skip > max_size))
+		skip++;
+	if (skip == 0) return;
+
+	int32_t mip_count = ref_image->mip_count - skip;
+	for (int32_t f = 0; f < ref_image->frame_count; f++) {
+		for (int32_t m = 0; m < mip_count; m++)
+			ref_image->frame_mips[f * mip_count + m] = ref_image->frame_mips[f * ref_image->mip_count + m + skip];
+	}
+	ref_image->mip_count = mip_count;
+	skg_mip_dimensions(ref_image->width, ref_image->height, skip, &ref_image->width, &ref_image->height);
+}
+
+///////////////////////////////////////////
+
+void tex_compressed_free(tex_compressed_t *image) {
+	for (int32_t i = 0; i < image->owned_count; i++)
+		sk_free(image->owned[i]);
+	sk_free(image->owned);
+	sk_free(image->frame_mips);
+	*image = {};
+}
+
+} // namespace sk
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../stereokit.h"
+
+namespace sk {
+
+// KTX2 and DDS containers carry images that are already in a GPU format,
+// along with their full mip chain, array layers, and cubemap faces. Parsing
+// points into the file's memory where it can, so the file must outlive the
+// parsed image.
+
+struct tex_compressed_t {
+	tex_format_   format;
+	int32_t       width;
+	int32_t       height;
+	int32_t       mip_count;
+	int32_t       frame_count;
+	bool32_t      cubemap;
+	// Ordered [frame * mip_count + mip], matching skg_tex_set_contents_mips
+	const void  **frame_mips;
+	// Memory for inflated or decoded levels, owned by this image
+	void        **owned;
+	int32_t       owned_count;
+};
+
+bool        tex_compressed_is       (const void *data, size_t data_size);
+bool        tex_compressed_info     (const void *data, size_t data_size, bool32_t srgb_data, tex_compressed_t *out_info);
+bool        tex_compressed_parse    (const void *data, size_t data_size, bool32_t srgb_data, tex_compressed_t *out_image);
+bool        tex_compressed_decode   (tex_compressed_t *ref_image);
+void        tex_compressed_free     (tex_compressed_t *image);
+void        tex_compressed_skip_mips(tex_compressed_t *ref_image, int32_t max_size);
+tex_format_ tex_compressed_format   (tex_format_ file_format);
+
+} // namespace sk
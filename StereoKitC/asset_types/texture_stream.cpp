@@ -0,0 +1,589 @@
+#include "texture_stream.h"
+#include "texture.h"
+#include "texture_.h"
+#include "assets.h"
+#include "../sk_math.h"
+#include "../sk_memory.h"
+#include "../libraries/array.h"
+#include "../libraries/ferr_thread.h"
+#include "../libraries/sk_gpu.h"
+#include "../utils/image_resample.h"
+
+#include <string.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+// Textures show this size or smaller until they're seen on screen
+const int32_t tex_stream_initial_size    = 64;
+// Anything smaller than this just loads normally
+const int32_t tex_stream_min_size        = 256;
+// Uploads are spread over frames to keep hitches down
+const int32_t tex_stream_max_uploads     = 4;
+const int32_t tex_stream_max_evictions   = 8;
+// Frames a texture can go unbound before its mips can be evicted
+const int32_t tex_stream_unseen_frames   = 90;
+// Decoding again is background work, and shouldn't hold up new loads
+const int32_t tex_stream_decode_priority = 100;
+
+array_t<tex_stream_t*> tex_streams       = {};
+ft_mutex_t             tex_stream_lock   = {};
+uint64_t               tex_stream_budget = 0;
+int32_t                tex_stream_next   = 0;
+
+struct tex_stream_job_t {
+	tex_stream_t *stream;
+	// Held for the length of the job, the stream refers back to it
+	tex_t         tex;
+	int32_t       top_mip;
+	// Decoded mips from top_mip up to the stream's initial_mip
+	void        **levels;
+	int32_t       level_count;
+	// Built off the main thread, waiting to be swapped in on it
+	skg_tex_t     new_tex;
+	bool          has_new_tex;
+};
+
+///////////////////////////////////////////
+
+static size_t tex_stream_chain_bytes(const tex_stream_t *stream, int32_t top_mip) {
+	size_t result = 0;
+	for (int32_t m = top_mip; m < stream->source.mip_count; m++) {
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(stream->source.width, stream->source.height, m, &mip_w, &mip_h);
+		result += tex_format_memory(stream->source.format, mip_w, mip_h);
+	}
+	return result;
+}
+
+///////////////////////////////////////////
+
+// Creates GPU data for the chain starting at top_mip, where mips[0] is
+// top_mip. This doesn't touch the texture itself, so on D3D it's safe to do
+// while the main thread may be drawing with it.
+static bool tex_stream_build(tex_stream_t *stream, int32_t top_mip, const void **mips, skg_tex_t *out_tex) {
+	tex_t   tex       = stream->tex;
+	int32_t mip_count = stream->source.mip_count - top_mip;
+	int32_t width, height;
+	skg_mip_dimensions(stream->source.width, stream->source.height, top_mip, &width, &height);
+
+	*out_tex = skg_tex_create(skg_tex_type_image, skg_use_static, (skg_tex_fmt_)stream->source.format, mip_count > 1 ? skg_mip_generate : skg_mip_none);
+	_tex_set_options(out_tex, tex->sample_mode, tex->address_mode, tex->anisotropy);
+	skg_tex_set_contents_mips(out_tex, mips, 1, mip_count, width, height);
+	if (!skg_tex_is_valid(out_tex)) {
+		skg_tex_destroy(out_tex);
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+// Swaps built GPU data into the texture. The old data may be in use by
+// this frame's draws, so this must happen on the main thread.
+static void tex_stream_swap(tex_stream_t *stream, int32_t top_mip, skg_tex_t *new_tex) {
+	tex_t     tex     = stream->tex;
+	skg_tex_t old_tex = tex->tex;
+	tex->tex = *new_tex;
+	*new_tex = {};
+	skg_tex_destroy(&old_tex);
+	tex_update_label (tex);
+	tex_memory_update(tex);
+
+	stream->resident_mip   = top_mip;
+	stream->resident_bytes = tex_stream_chain_bytes(stream, top_mip);
+}
+
+///////////////////////////////////////////
+
+// Replaces the texture's GPU data with the chain starting at top_mip. The
+// texture's meta size stays at the full resolution the whole time.
+static bool tex_stream_upload(tex_stream_t *stream, int32_t top_mip, const void **mips) {
+	skg_tex_t new_tex = {};
+	if (!tex_stream_build(stream, top_mip, mips, &new_tex))
+		return false;
+	tex_stream_swap(stream, top_mip, &new_tex);
+	return true;
+}
+
+///////////////////////////////////////////
+
+// Resamples mips first_mip onward from the full size image, each one from
+// the one before it. first_mip must be at least 1.
+static void tex_stream_build_levels(const tex_stream_t *stream, const void *image, int32_t first_mip, int32_t count, void **out_levels) {
+	image_mips(stream->source.format, image, stream->source.width, stream->source.height, first_mip, count, stream->tex->mip_mode, stream->tex->mip_alpha_cutoff, out_levels);
+}
+
+///////////////////////////////////////////
+
+// Decodes an encoded stream's file again, at the size the texture was
+// originally loaded at.
+static void *tex_stream_decode(const tex_stream_t *stream) {
+	tex_format_ format = tex_format_none;
+	int32_t     width  = 0;
+	int32_t     height = 0;
+	void       *result = tex_load_image_data(stream->file.data, stream->file.size, stream->srgb, &format, &width, &height);
+	if (result == nullptr) return nullptr;
+	if (format != stream->source.format) {
+		sk_free(result);
+		return nullptr;
+	}
+
+	// tex_set_max_resolution may have shrunk it the first time through
+	if (width != stream->source.width || height != stream->source.height) {
+		void *resized = sk_malloc(tex_format_memory(format, stream->source.width, stream->source.height));
+		image_resize(format, result, width, height, resized, stream->source.width, stream->source.height);
+		sk_free(result);
+		result = resized;
+	}
+	return result;
+}
+
+///////////////////////////////////////////
+
+static void tex_stream_free(tex_stream_t *stream) {
+	tex_compressed_free(&stream->source);
+	platform_file_unmap(&stream->file);
+	sk_free(stream);
+}
+
+///////////////////////////////////////////
+
+tex_stream_t *tex_stream_create(tex_t texture, bool32_t srgb_data, tex_compressed_t *ref_compressed, platform_file_map_t *ref_file, void **ref_color_data) {
+	if (!(texture->type & tex_type_mips) ||
+		 (texture->type & (tex_type_cubemap | tex_type_dynamic | tex_type_rendertarget | tex_type_depth)) ||
+		maxi(texture->width, texture->height) < tex_stream_min_size)
+		return nullptr;
+	if (ref_compressed == nullptr && !image_resize_supported(texture->format))
+		return nullptr;
+
+	tex_stream_t     *result = sk_malloc_zero_t(tex_stream_t, 1);
+	tex_compressed_t *source = &result->source;
+	result->tex  = texture;
+	result->srgb = srgb_data;
+	if (ref_compressed != nullptr) {
+		// Streaming needs a stored mip chain to step through
+		if (ref_compressed->mip_count < 2 || ref_compressed->frame_count != 1) {
+			sk_free(result);
+			return nullptr;
+		}
+		*source         = *ref_compressed;
+		result->file    = *ref_file;
+		*ref_compressed = {};
+		*ref_file       = {};
+	} else {
+		source->format      = texture->format;
+		source->width       = texture->width;
+		source->height      = texture->height;
+		source->mip_count   = (int32_t)skg_mip_count(texture->width, texture->height);
+		source->frame_count = 1;
+		source->frame_mips  = sk_malloc_zero_t(const void *, source->mip_count);
+	}
+
+	result->initial_mip = source->mip_count - 1;
+	for (int32_t m = 0; m < source->mip_count; m++) {
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(source->width, source->height, m, &mip_w, &mip_h);
+		if (maxi(mip_w, mip_h) <= tex_stream_initial_size) {
+			result->initial_mip = m;
+			break;
+		}
+	}
+
+	if (ref_compressed == nullptr) {
+		// With a budget, only the small tail of the chain stays in memory,
+		// and the file is decoded again whenever more is needed. Otherwise
+		// the whole chain is built up front.
+		result->encoded = tex_stream_budget != 0 && ref_file->data != nullptr;
+		int32_t first   = result->encoded ? result->initial_mip : 1;
+		source->owned_count = source->mip_count - first;
+		source->owned       = sk_malloc_t(void *, source->owned_count + 1);
+		tex_stream_build_levels(result, *ref_color_data, first, source->owned_count, source->owned);
+		for (int32_t m = first; m < source->mip_count; m++)
+			source->frame_mips[m] = source->owned[m - first];
+
+		if (result->encoded) {
+			result->file = *ref_file;
+			*ref_file    = {};
+		} else {
+			source->owned[source->owned_count++] = *ref_color_data;
+			source->frame_mips[0] = *ref_color_data;
+			*ref_color_data       = nullptr;
+		}
+	}
+
+	result->resident_mip  = source->mip_count;
+	result->requested_mip = source->mip_count;
+	return result;
+}
+
+///////////////////////////////////////////
+
+bool tex_stream_start(tex_t texture, tex_stream_t *stream) {
+	struct tex_stream_start_t {
+		tex_t         texture;
+		tex_stream_t *stream;
+	};
+	tex_stream_start_t job_data = { texture, stream };
+
+	// OpenGL doesn't like multiple threads, but D3D is fine with it.
+#if defined(SKG_OPENGL)
+	bool32_t uploaded = assets_execute_gpu([](void *data) {
+		tex_stream_t *stream = ((tex_stream_start_t *)data)->stream;
+		return (bool32_t)tex_stream_upload(stream, stream->initial_mip, &stream->source.frame_mips[stream->initial_mip]);
+	}, &job_data);
+#else
+	bool32_t uploaded = tex_stream_upload(stream, stream->initial_mip, &stream->source.frame_mips[stream->initial_mip]);
+#endif
+
+	if (!uploaded) {
+		tex_stream_destroy(stream);
+		return false;
+	}
+
+	ft_mutex_lock(tex_stream_lock);
+	tex_streams.add(stream);
+	ft_mutex_unlock(tex_stream_lock);
+	texture->stream = stream;
+
+	tex_set_fallback(texture, nullptr);
+	texture->header.state = asset_state_loaded;
+	return true;
+}
+
+///////////////////////////////////////////
+
+void tex_stream_destroy(tex_stream_t *stream) {
+	if (stream == nullptr) return;
+
+	// A decode that's still in flight needs the stream, so the job takes
+	// care of freeing it when it wraps up.
+	ft_mutex_lock(tex_stream_lock);
+	int32_t idx = tex_streams.index_of(stream);
+	if (idx >= 0) tex_streams.remove(idx);
+	bool pending = stream->pending;
+	stream->orphaned = true;
+	ft_mutex_unlock(tex_stream_lock);
+
+	if (!pending) tex_stream_free(stream);
+}
+
+///////////////////////////////////////////
+
+bool tex_stream_active() {
+	return tex_streams.count > 0;
+}
+
+///////////////////////////////////////////
+
+// Picks the smallest mip that still has at least as many texels across as
+// the texture covers pixels on screen.
+void tex_stream_request(tex_t texture, float screen_pixels) {
+	tex_stream_t *stream = texture->stream;
+	if (stream == nullptr) return;
+
+	int32_t max_size = maxi(stream->source.width, stream->source.height);
+	int32_t mip      = 0;
+	while (mip < stream->initial_mip && (float)(max_size >> (mip + 1)) >= screen_pixels)
+		mip++;
+
+	if (mip < stream->requested_mip) stream->requested_mip = mip;
+}
+
+///////////////////////////////////////////
+
+bool tex_stream_get_data(tex_stream_t *stream, int32_t mip_level, void *out_data, size_t out_data_size) {
+	if (mip_level < 0 || mip_level >= stream->source.mip_count || skg_tex_fmt_is_compressed((skg_tex_fmt_)stream->source.format))
+		return false;
+
+	int32_t mip_w, mip_h;
+	skg_mip_dimensions(stream->source.width, stream->source.height, mip_level, &mip_w, &mip_h);
+	size_t size = mini(tex_format_memory(stream->source.format, mip_w, mip_h), out_data_size);
+	if (stream->source.frame_mips[mip_level] != nullptr) {
+		memcpy(out_data, stream->source.frame_mips[mip_level], size);
+		return true;
+	}
+
+	// Encoded streams only keep their smallest mips around
+	void *image = tex_stream_decode(stream);
+	if (image == nullptr) return false;
+	if (mip_level == 0) {
+		memcpy(out_data, image, size);
+	} else {
+		void *level = nullptr;
+		tex_stream_build_levels(stream, image, mip_level, 1, &level);
+		memcpy(out_data, level, size);
+		sk_free(level);
+	}
+	sk_free(image);
+	return true;
+}
+
+///////////////////////////////////////////
+
+size_t tex_stream_cpu_memory(const tex_stream_t *stream) {
+	// Levels that point into the mapped file are already counted with it
+	const uint8_t *file_start = (const uint8_t *)stream->file.data;
+	const uint8_t *file_end   = file_start + stream->file.size;
+	const tex_compressed_t *source = &stream->source;
+
+	size_t result = sizeof(tex_stream_t) + stream->file.size;
+	for (int32_t i = 0; i < source->mip_count * source->frame_count; i++) {
+		const uint8_t *level = (const uint8_t *)source->frame_mips[i];
+		if (level == nullptr || (level >= file_start && level < file_end)) continue;
+
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(source->width, source->height, i % source->mip_count, &mip_w, &mip_h);
+		result += tex_format_memory(source->format, mip_w, mip_h);
+	}
+	return result;
+}
+
+///////////////////////////////////////////
+
+static bool32_t tex_stream_job_decode(asset_task_t *, asset_header_t *, void *job_data) {
+	tex_stream_job_t *job    = (tex_stream_job_t *)job_data;
+	tex_stream_t     *stream = job->stream;
+	if (stream->orphaned) return false;
+
+	void *image = tex_stream_decode(stream);
+	if (image == nullptr) return false;
+
+	job->level_count = stream->initial_mip - job->top_mip;
+	job->levels      = sk_malloc_zero_t(void *, job->level_count);
+	if (job->top_mip == 0) {
+		job->levels[0] = image;
+		tex_stream_build_levels(stream, image, 1, job->level_count - 1, &job->levels[1]);
+	} else {
+		tex_stream_build_levels(stream, image, job->top_mip, job->level_count, job->levels);
+		sk_free(image);
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+static bool32_t tex_stream_job_build(asset_task_t *, asset_header_t *, void *job_data) {
+	tex_stream_job_t *job    = (tex_stream_job_t *)job_data;
+	tex_stream_t     *stream = job->stream;
+
+	// The job's reference keeps stream->tex alive, and pending keeps the
+	// stream alive, so the build itself doesn't need the lock. Holding it
+	// here would stall tex_stream_step on the main thread.
+	ft_mutex_lock(tex_stream_lock);
+	bool orphaned = stream->orphaned;
+	ft_mutex_unlock(tex_stream_lock);
+	if (orphaned) return false;
+
+	const void **mips = sk_malloc_t(const void *, stream->source.mip_count - job->top_mip);
+	for (int32_t i = 0; i < job->level_count; i++)
+		mips[i] = job->levels[i];
+	for (int32_t m = stream->initial_mip; m < stream->source.mip_count; m++)
+		mips[m - job->top_mip] = stream->source.frame_mips[m];
+	job->has_new_tex = tex_stream_build(stream, job->top_mip, mips, &job->new_tex);
+	sk_free(mips);
+	return job->has_new_tex;
+}
+
+///////////////////////////////////////////
+
+static bool32_t tex_stream_job_swap(asset_task_t *, asset_header_t *, void *job_data) {
+	tex_stream_job_t *job    = (tex_stream_job_t *)job_data;
+	tex_stream_t     *stream = job->stream;
+
+	ft_mutex_lock(tex_stream_lock);
+	if (!stream->orphaned && job->has_new_tex) {
+		tex_stream_swap(stream, job->top_mip, &job->new_tex);
+		job->has_new_tex = false;
+	}
+	ft_mutex_unlock(tex_stream_lock);
+	return true;
+}
+
+///////////////////////////////////////////
+
+static void tex_stream_job_free(asset_header_t *, void *job_data) {
+	tex_stream_job_t *job    = (tex_stream_job_t *)job_data;
+	tex_stream_t     *stream = job->stream;
+	tex_t             tex    = job->tex;
+
+	ft_mutex_lock(tex_stream_lock);
+	stream->pending       = false;
+	stream->pending_bytes = 0;
+	bool orphaned = stream->orphaned;
+	ft_mutex_unlock(tex_stream_lock);
+	if (orphaned) tex_stream_free(stream);
+	// After pending is cleared, so if this was the last reference, the
+	// texture can free its stream right away.
+	assets_releaseref_threadsafe(&tex->header);
+
+	if (job->has_new_tex)
+		skg_tex_destroy(&job->new_tex);
+	for (int32_t i = 0; i < job->level_count; i++)
+		sk_free(job->levels[i]);
+	sk_free(job->levels);
+	sk_free(job);
+}
+
+///////////////////////////////////////////
+
+static void tex_stream_decode_async(tex_stream_t *stream, int32_t top_mip, size_t growth, size_t upload) {
+	static const asset_load_action_t actions[] = {
+		asset_load_action_t {tex_stream_job_decode, asset_thread_asset},
+		// OpenGL doesn't like multiple threads, but D3D can build the new
+		// texture on an asset thread. Swapping it in always waits for the
+		// main thread, since the old one may be in this frame's draws.
+#if defined(SKG_OPENGL)
+		asset_load_action_t {tex_stream_job_build,  asset_thread_gpu  },
+#else
+		asset_load_action_t {tex_stream_job_build,  asset_thread_asset},
+#endif
+		asset_load_action_t {tex_stream_job_swap,   asset_thread_gpu  },
+	};
+
+	tex_stream_job_t *job = sk_malloc_zero_t(tex_stream_job_t, 1);
+	job->stream  = stream;
+	job->tex     = stream->tex;
+	job->top_mip = top_mip;
+	tex_addref(job->tex);
+	stream->pending       = true;
+	stream->pending_bytes = growth;
+
+	asset_task_t task = {};
+	task.load_data    = job;
+	task.free_data    = tex_stream_job_free;
+	task.actions      = (asset_load_action_t *)actions;
+	task.action_count = _countof(actions);
+	task.priority     = tex_stream_decode_priority;
+	task.sort         = asset_sort(tex_stream_decode_priority, stream->source.width * stream->source.height);
+	task.upload_bytes = upload;
+	assets_add_task(task);
+}
+
+///////////////////////////////////////////
+
+bool tex_stream_init() {
+	tex_stream_lock = ft_mutex_create();
+	return true;
+}
+
+///////////////////////////////////////////
+
+void tex_stream_step() {
+	if (tex_streams.count == 0) return;
+
+	ft_mutex_lock(tex_stream_lock);
+	uint64_t frame = time_frame();
+
+	// The budget covers every texture, streaming or not. Decodes that are
+	// still in flight count as if they'd already landed.
+	uint64_t total = tex_memory_used();
+	for (int32_t i = 0; i < tex_streams.count; i++)
+		total += tex_streams[i]->pending_bytes;
+
+	// Step each requested texture closer to what it wants, starting where
+	// the last frame left off so every texture gets its turn. Stored chains
+	// go one mip at a time, encoded files jump straight to the request
+	// since each step is a full decode.
+	int32_t uploads = 0;
+	bool    starved = false;
+	for (int32_t c = 0; c < tex_streams.count && uploads < tex_stream_max_uploads; c++) {
+		int32_t       idx    = (tex_stream_next + c) % tex_streams.count;
+		tex_stream_t *stream = tex_streams[idx];
+		if (stream->pending || stream->requested_mip >= stream->resident_mip) continue;
+
+		int32_t  next   = stream->encoded ? stream->requested_mip : stream->resident_mip - 1;
+		uint64_t growth = tex_stream_chain_bytes(stream, next) - stream->resident_bytes;
+		while (tex_stream_budget != 0 && total + growth > tex_stream_budget && next < stream->resident_mip - 1) {
+			next  += 1;
+			growth = tex_stream_chain_bytes(stream, next) - stream->resident_bytes;
+		}
+		if (tex_stream_budget != 0 && total + growth > tex_stream_budget) {
+			starved = true;
+			continue;
+		}
+
+		// Static textures can't take new mips, so every step rebuilds the
+		// whole chain from next down. Memory only grows by the new mips, but
+		// the upload covers all of them.
+		size_t upload = tex_stream_chain_bytes(stream, next);
+		if (stream->encoded) {
+			tex_stream_decode_async(stream, next, (size_t)growth, upload);
+			total += growth;
+		} else {
+			// Stored chains upload right here, so they share the frame's
+			// upload budget with the asset jobs, one mip at a time.
+			if (!assets_upload_budget_left()) break;
+			uint64_t prev = total;
+			if (!tex_stream_upload(stream, next, &stream->source.frame_mips[next])) continue;
+			total = prev + growth;
+			assets_upload_budget_spend(upload);
+		}
+		uploads++;
+		tex_stream_next = (idx + 1) % tex_streams.count;
+	}
+
+	// When over budget, or something couldn't fit, the textures that have
+	// gone unbound the longest give up their higher mips.
+	for (int32_t e = 0; tex_stream_budget != 0 && (starved || total > tex_stream_budget) && e < tex_stream_max_evictions; e++) {
+		tex_stream_t *oldest = nullptr;
+		for (int32_t i = 0; i < tex_streams.count; i++) {
+			tex_stream_t *stream = tex_streams[i];
+			if (stream->pending || stream->resident_mip >= stream->initial_mip || stream->tex->last_bound + tex_stream_unseen_frames > frame) continue;
+			if (oldest == nullptr || stream->tex->last_bound < oldest->tex->last_bound)
+				oldest = stream;
+		}
+		if (oldest == nullptr) break;
+
+		// Encoded streams would need a decode to step back up one at a time,
+		// so they drop straight to the mips they keep around.
+		int32_t  demote = oldest->encoded ? oldest->initial_mip : oldest->resident_mip + 1;
+		uint64_t prev   = oldest->resident_bytes;
+		if (!tex_stream_upload(oldest, demote, &oldest->source.frame_mips[demote])) break;
+		total -= prev - oldest->resident_bytes;
+		assets_upload_budget_spend(oldest->resident_bytes);
+		if (total <= tex_stream_budget) starved = false;
+	}
+
+	// Requests are gathered fresh each frame. Without a budget, nothing will
+	// ever be evicted, so fully resident textures can let go of their CPU
+	// copy and become regular textures.
+	for (int32_t i = tex_streams.count - 1; i >= 0; i--) {
+		tex_stream_t *stream = tex_streams[i];
+		stream->requested_mip = stream->source.mip_count;
+		if (tex_stream_budget == 0 && stream->resident_mip == 0 && !stream->pending) {
+			tex_streams.remove(i);
+			stream->tex->stream = nullptr;
+			tex_stream_free(stream);
+		}
+	}
+	ft_mutex_unlock(tex_stream_lock);
+}
+
+///////////////////////////////////////////
+
+void tex_stream_shutdown() {
+	for (int32_t i = 0; i < tex_streams.count; i++) {
+		tex_streams[i]->tex->stream = nullptr;
+		tex_stream_free(tex_streams[i]);
+	}
+	tex_streams.free();
+	ft_mutex_destroy(&tex_stream_lock);
+	tex_stream_budget = 0;
+	tex_stream_next   = 0;
+}
+
+///////////////////////////////////////////
+
+void tex_set_memory_budget(uint64_t budget_bytes) {
+	tex_stream_budget = budget_bytes;
+}
+
+///////////////////////////////////////////
+
+uint64_t tex_get_memory_budget() {
+	return tex_stream_budget;
+}
+
+} // namespace sk
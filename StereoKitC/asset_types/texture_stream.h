@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../stereokit.h"
+#include "../platforms/platform.h"
+#include "texture_compressed.h"
+
+namespace sk {
+
+// Large textures loaded from a single file can start out on the GPU as a
+// small mip, and have their higher mips streamed in over later frames as
+// they grow on screen. Container files keep their stored mip chain on the
+// CPU. Decoded images either keep a chain built from the image, or when a
+// memory budget is set, keep only their smallest mips and the encoded file,
+// decoding it again on the asset threads when more is needed. Either way,
+// mips of textures that haven't been bound in a while can be dropped again
+// when the texture memory budget runs short.
+
+struct tex_stream_t {
+	tex_t               tex;
+	// Full mip chain, frame_mips[0] is the top mip. Encoded streams leave
+	// everything above initial_mip null.
+	tex_compressed_t    source;
+	// Containers point into their file, and encoded streams decode it
+	// again, so it stays mapped
+	platform_file_map_t file;
+	bool32_t            srgb;
+	bool32_t            encoded;
+	int32_t             initial_mip;
+	int32_t             resident_mip;
+	int32_t             requested_mip;
+	size_t              resident_bytes;
+	// A decode is in flight on the asset threads, and will grow the
+	// texture by pending_bytes
+	bool32_t            pending;
+	size_t              pending_bytes;
+	bool32_t            orphaned;
+};
+
+bool          tex_stream_init    ();
+void          tex_stream_step    ();
+void          tex_stream_shutdown();
+
+tex_stream_t *tex_stream_create  (tex_t texture, bool32_t srgb_data, tex_compressed_t *ref_compressed, platform_file_map_t *ref_file, void **ref_color_data);
+bool          tex_stream_start   (tex_t texture, tex_stream_t *stream);
+void          tex_stream_destroy (tex_stream_t *stream);
+bool          tex_stream_active  ();
+void          tex_stream_request (tex_t texture, float screen_pixels);
+bool          tex_stream_get_data(tex_stream_t *stream, int32_t mip_level, void *out_data, size_t out_data_size);
+size_t        tex_stream_cpu_memory(const tex_stream_t *stream);
+
+} // namespace sk
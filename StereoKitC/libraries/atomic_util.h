@@ -6,8 +6,12 @@
 	#include <winnt.h>
 	#define atomic_increment(int_val_ref) InterlockedIncrement((LONG*)int_val_ref)
 	#define atomic_decrement(int_val_ref) InterlockedDecrement((LONG*)int_val_ref)
+	#define atomic_add64(int64_val_ref, amount) InterlockedAdd64((LONG64*)int64_val_ref, amount)
+	#define atomic_exchange64(int64_val_ref, value) InterlockedExchange64((LONG64*)int64_val_ref, value)
 #else
 	// gcc and clang both implement these at least
 	#define atomic_increment(int_val_ref) __sync_add_and_fetch(int_val_ref, 1)
 	#define atomic_decrement(int_val_ref) __sync_sub_and_fetch(int_val_ref, 1)
+	#define atomic_add64(int64_val_ref, amount) __sync_add_and_fetch(int64_val_ref, amount)
+	#define atomic_exchange64(int64_val_ref, value) __atomic_exchange_n(int64_val_ref, value, __ATOMIC_SEQ_CST)
 #endif
\ No newline at end of file
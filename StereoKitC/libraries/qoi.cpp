@@ -1,5 +1,8 @@
 #pragma warning(push)
 #pragma warning(disable : 4244 4267 )
+#include "../sk_memory.h"
+#define QOI_MALLOC(sz) sk::sk_malloc(sz)
+#define QOI_FREE(p)    sk::_sk_free(p)
 #define QOI_IMPLEMENTATION
 #include "qoi.h"
 #pragma warning(pop)
\ No newline at end of file
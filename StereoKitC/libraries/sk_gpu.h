@@ -148,6 +148,23 @@ typedef enum skg_tex_fmt_ {
 	skg_tex_fmt_depth32,
 	skg_tex_fmt_depth16,
 	skg_tex_fmt_r8g8,
+	// Block compressed formats, all of these use 4x4 pixel blocks.
+	skg_tex_fmt_bc1_rgba,
+	skg_tex_fmt_bc1_rgba_linear,
+	skg_tex_fmt_bc3_rgba,
+	skg_tex_fmt_bc3_rgba_linear,
+	skg_tex_fmt_bc4_r,
+	skg_tex_fmt_bc5_rg,
+	skg_tex_fmt_bc7_rgba,
+	skg_tex_fmt_bc7_rgba_linear,
+	skg_tex_fmt_etc2_rgb,
+	skg_tex_fmt_etc2_rgb_linear,
+	skg_tex_fmt_etc2_rgba,
+	skg_tex_fmt_etc2_rgba_linear,
+	skg_tex_fmt_etc2_r11,
+	skg_tex_fmt_etc2_rg11,
+	skg_tex_fmt_astc4x4_rgba,
+	skg_tex_fmt_astc4x4_rgba_linear,
 } skg_tex_fmt_;
 
 typedef enum skg_fmt_ {
@@ -322,6 +339,7 @@ typedef struct skg_buffer_t {
 	ID3D11Buffer    *_buffer;
 	ID3D11ShaderResourceView  *_resource;
 	ID3D11UnorderedAccessView *_unordered;
+	uint64_t                   _deferred_list;
 } skg_buffer_t;
 
 typedef struct skg_computebuffer_t {
@@ -376,6 +394,7 @@ typedef struct skg_tex_t {
 	skg_tex_type_              type;
 	skg_tex_fmt_               format;
 	skg_mip_                   mips;
+	int32_t                    mip_count;
 	ID3D11Texture2D           *_texture;
 	ID3D11SamplerState        *_sampler;
 	ID3D11ShaderResourceView  *_resource;
@@ -457,6 +476,7 @@ typedef struct skg_tex_t {
 	skg_tex_type_ type;
 	skg_tex_fmt_  format;
 	skg_mip_      mips;
+	int32_t       mip_count;
 	uint32_t      _texture;
 	uint32_t      _framebuffer;
 	uint32_t      _target;
@@ -553,6 +573,7 @@ typedef struct skg_tex_t {
 	skg_tex_type_      type;
 	skg_tex_fmt_       format;
 	skg_mip_           mips;
+	int32_t            mip_count;
 } skg_tex_t;
 
 typedef struct skg_swapchain_t {
@@ -591,6 +612,7 @@ SKG_API skg_buffer_t        skg_buffer_create            (const void *data, uint
 SKG_API void                skg_buffer_name              (      skg_buffer_t *buffer, const char* name);
 SKG_API bool                skg_buffer_is_valid          (const skg_buffer_t *buffer);
 SKG_API void                skg_buffer_set_contents      (      skg_buffer_t *buffer, const void *data, uint32_t size_bytes);
+SKG_API bool                skg_buffer_set_contents_range(      skg_buffer_t *buffer, const void *data, uint32_t offset_bytes, uint32_t size_bytes);
 SKG_API void                skg_buffer_get_contents      (const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size);
 SKG_API void                skg_buffer_bind              (const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset_vi);
 SKG_API void                skg_buffer_clear             (      skg_bind_t bind);
@@ -653,6 +675,7 @@ SKG_API void                skg_tex_attach_depth         (      skg_tex_t *tex,
 SKG_API void                skg_tex_settings             (      skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, int32_t anisotropy);
 SKG_API void                skg_tex_set_contents         (      skg_tex_t *tex, const void *data, int32_t width, int32_t height);
 SKG_API void                skg_tex_set_contents_arr     (      skg_tex_t *tex, const void **data_frames, int32_t data_frame_count, int32_t width, int32_t height, int32_t multisample);
+SKG_API void                skg_tex_set_contents_mips    (      skg_tex_t *tex, const void **data_frame_mips, int32_t data_frame_count, int32_t mip_count, int32_t width, int32_t height);
 SKG_API bool                skg_tex_get_contents         (      skg_tex_t *tex, void *ref_data, size_t data_size);
 SKG_API bool                skg_tex_get_mip_contents     (      skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size);
 SKG_API bool                skg_tex_get_mip_contents_arr (      skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size);
@@ -665,6 +688,9 @@ SKG_API void                skg_tex_destroy              (      skg_tex_t *tex);
 SKG_API int64_t             skg_tex_fmt_to_native        (skg_tex_fmt_ format);
 SKG_API skg_tex_fmt_        skg_tex_fmt_from_native      (int64_t      format);
 SKG_API uint32_t            skg_tex_fmt_size             (skg_tex_fmt_ format);
+SKG_API bool                skg_tex_fmt_is_compressed    (skg_tex_fmt_ format);
+SKG_API size_t              skg_tex_fmt_memory           (skg_tex_fmt_ format, int32_t width, int32_t height);
+SKG_API bool                skg_tex_fmt_supported        (skg_tex_fmt_ format);
 
 
 ///////////////////////////////////////////
@@ -779,6 +805,7 @@ char                    *d3d_adapter_name = nullptr;
 ID3D11DeviceContext     *d3d_deferred    = nullptr;
 HANDLE                   d3d_deferred_mtx= nullptr;
 DWORD                    d3d_main_thread = 0;
+uint64_t                 d3d_deferred_list = 1;
 
 #if defined(_DEBUG)
 #include <d3d11_1.h>
@@ -970,6 +997,7 @@ void skg_draw_begin() {
 	ID3D11CommandList* command_list = nullptr;
 	WaitForSingleObject(d3d_deferred_mtx, INFINITE);
 	d3d_deferred->FinishCommandList(false, &command_list);
+	d3d_deferred_list += 1;
 	ReleaseMutex(d3d_deferred_mtx);
 	d3d_context->ExecuteCommandList(command_list, false);
 	command_list->Release();
@@ -1214,6 +1242,9 @@ void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t si
 	} else {
 		WaitForSingleObject(d3d_deferred_mtx, INFINITE);
 		hr = d3d_deferred->Map(buffer->_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
+		// Remember which command list discarded this buffer, so range
+		// updates know a NO_OVERWRITE map is legal on it.
+		if (SUCCEEDED(hr)) buffer->_deferred_list = d3d_deferred_list;
 	}
 	if (FAILED(hr)) {
 		skg_logf(skg_log_critical, "Failed to set contents of buffer, may not be using a writeable buffer type: 0x%08X", hr);
@@ -1235,6 +1266,53 @@ void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t si
 
 ///////////////////////////////////////////
 
+bool skg_buffer_set_contents_range(skg_buffer_t *buffer, const void *data, uint32_t offset_bytes, uint32_t size_bytes) {
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return false;
+	}
+
+	// Unlike skg_buffer_set_contents, this leaves the rest of the buffer
+	// intact, so the caller must ensure the GPU is not still reading from
+	// this buffer.
+	HRESULT hr = E_FAIL;
+	D3D11_MAPPED_SUBRESOURCE resource = {};
+
+	bool on_main = GetCurrentThreadId() == d3d_main_thread;
+	if (on_main) {
+		hr = d3d_context->Map(buffer->_buffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &resource);
+	} else {
+		WaitForSingleObject(d3d_deferred_mtx, INFINITE);
+		// A deferred context rejects NO_OVERWRITE until the buffer has been
+		// mapped with DISCARD in the same command list. If that hasn't
+		// happened yet, the caller needs to upload the whole buffer.
+		if (buffer->_deferred_list != d3d_deferred_list) {
+			ReleaseMutex(d3d_deferred_mtx);
+			return false;
+		}
+		hr = d3d_deferred->Map(buffer->_buffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &resource);
+	}
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "Failed to set contents of buffer, may not be using a writeable buffer type: 0x%08X", hr);
+		if (!on_main) {
+			ReleaseMutex(d3d_deferred_mtx);
+		}
+		return false;
+	}
+
+	memcpy((uint8_t*)resource.pData + offset_bytes, data, size_bytes);
+
+	if (on_main) {
+		d3d_context->Unmap(buffer->_buffer, 0);
+	} else {
+		d3d_deferred->Unmap(buffer->_buffer, 0);
+		ReleaseMutex(d3d_deferred_mtx);
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
 void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
 	ID3D11Buffer* cpu_buff = nullptr;
 
@@ -1916,6 +1994,7 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 	result.array_count = color_desc.ArraySize; (void)array_count;
 	result.multisample = color_desc.SampleDesc.Count;
 	result.format      = override_format != 0 ? override_format : skg_tex_fmt_from_native(color_desc.Format);
+	result.mip_count   = color_desc.MipLevels;
 	skg_tex_make_view(&result, color_desc.MipLevels, 0, color_desc.BindFlags & D3D11_BIND_SHADER_RESOURCE);
 
 	return result;
@@ -1938,6 +2017,7 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 	result.array_count = 1;
 	result.multisample = color_desc.SampleDesc.Count;
 	result.format      = override_format != 0 ? override_format : skg_tex_fmt_from_native(color_desc.Format);
+	result.mip_count   = color_desc.MipLevels;
 	skg_tex_make_view(&result, color_desc.MipLevels, array_layer, color_desc.BindFlags & D3D11_BIND_SHADER_RESOURCE);
 
 	return result;
@@ -2291,6 +2371,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **data_frames, int32_t
 		&& skg_can_make_mips(tex->format);
 
 	uint32_t mip_levels = (mips ? skg_mip_count(width, height) : 1);
+	tex->mip_count      = (int32_t)mip_levels;
 	uint32_t px_size    = skg_tex_fmt_size(tex->format);
 	HRESULT  hr         = E_FAIL;
 
@@ -2317,7 +2398,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **data_frames, int32_t
 			for (int32_t i = 0; i < data_frame_count; i++) {
 				tex_mem[i*mip_levels] = {};
 				tex_mem[i*mip_levels].pSysMem     = data_frames[i];
-				tex_mem[i*mip_levels].SysMemPitch = (UINT)(px_size * width);
+				tex_mem[i*mip_levels].SysMemPitch = (UINT)skg_tex_fmt_memory(tex->format, width, 1);
 
 				if (mips) {
 					skg_make_mips(&tex_mem[i*mip_levels], data_frames[i], tex->format, width, height, mip_levels);
@@ -2387,6 +2468,70 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **data_frames, int32_t
 
 ///////////////////////////////////////////
 
+void skg_tex_set_contents_mips(skg_tex_t *tex, const void **data_frame_mips, int32_t data_frame_count, int32_t mip_count, int32_t width, int32_t height) {
+	if (tex->use == skg_use_dynamic || tex->_texture) {
+		skg_log(skg_log_warning, "Pre-built mip chains are only for new, static textures!");
+		return;
+	}
+
+	tex->width       = width;
+	tex->height      = height;
+	tex->array_count = data_frame_count;
+	tex->multisample = 1;
+	tex->mips        = mip_count > 1 ? skg_mip_generate : skg_mip_none;
+	tex->mip_count   = mip_count;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width            = width;
+	desc.Height           = height;
+	desc.MipLevels        = mip_count;
+	desc.ArraySize        = data_frame_count;
+	desc.SampleDesc.Count = 1;
+	desc.Format           = (DXGI_FORMAT)skg_tex_fmt_to_native(tex->format);
+	desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+	desc.Usage            = D3D11_USAGE_IMMUTABLE;
+	if (tex->type == skg_tex_type_cubemap) desc.MiscFlags |= D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+	D3D11_SUBRESOURCE_DATA *tex_mem = (D3D11_SUBRESOURCE_DATA *)malloc((size_t)data_frame_count * mip_count * sizeof(D3D11_SUBRESOURCE_DATA));
+	if (!tex_mem) { skg_log(skg_log_critical, "Out of memory"); return; }
+	for (int32_t i = 0; i < data_frame_count; i++) {
+		for (int32_t m = 0; m < mip_count; m++) {
+			int32_t mip_w, mip_h;
+			skg_mip_dimensions(width, height, m, &mip_w, &mip_h);
+			D3D11_SUBRESOURCE_DATA *sub = &tex_mem[i*mip_count + m];
+			*sub = {};
+			sub->pSysMem          = data_frame_mips[i*mip_count + m];
+			sub->SysMemPitch      = (UINT)skg_tex_fmt_memory(tex->format, mip_w, 1);
+			sub->SysMemSlicePitch = (UINT)skg_tex_fmt_memory(tex->format, mip_w, mip_h);
+		}
+	}
+
+	HRESULT hr = d3d_device->CreateTexture2D(&desc, tex_mem, &tex->_texture);
+	free(tex_mem);
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "Create texture error: 0x%08X", hr);
+		return;
+	}
+	skg_tex_make_view(tex, mip_count, 0, true);
+
+	if (tex->_sampler == nullptr) {
+		skg_tex_settings(tex, skg_tex_address_repeat, skg_tex_sample_linear, 0);
+	}
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
+	DXGI_FORMAT native = (DXGI_FORMAT)skg_tex_fmt_to_native(format);
+	if (native == DXGI_FORMAT_UNKNOWN) return false;
+
+	UINT support = 0;
+	return SUCCEEDED(d3d_device->CheckFormatSupport(native, &support))
+		&& (support & D3D11_FORMAT_SUPPORT_TEXTURE2D);
+}
+
+///////////////////////////////////////////
+
 bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
 	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
 }
@@ -2401,7 +2546,7 @@ bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data,
 
 bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
 	// Double check on mips first
-	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
+	int32_t mip_levels = tex->mip_count;
 	if (mip_level != 0) {
 		if (tex->mips != skg_mip_generate) {
 			skg_log(skg_log_critical, "Can't get mip data from a texture with no mips!");
@@ -2642,6 +2787,14 @@ int64_t skg_tex_fmt_to_native(skg_tex_fmt_ format){
 	case skg_tex_fmt_r16f:          return DXGI_FORMAT_R16_FLOAT;
 	case skg_tex_fmt_r32:           return DXGI_FORMAT_R32_FLOAT;
 	case skg_tex_fmt_r8g8:          return DXGI_FORMAT_R8G8_UNORM;
+	case skg_tex_fmt_bc1_rgba:        return DXGI_FORMAT_BC1_UNORM_SRGB;
+	case skg_tex_fmt_bc1_rgba_linear: return DXGI_FORMAT_BC1_UNORM;
+	case skg_tex_fmt_bc3_rgba:        return DXGI_FORMAT_BC3_UNORM_SRGB;
+	case skg_tex_fmt_bc3_rgba_linear: return DXGI_FORMAT_BC3_UNORM;
+	case skg_tex_fmt_bc4_r:           return DXGI_FORMAT_BC4_UNORM;
+	case skg_tex_fmt_bc5_rg:          return DXGI_FORMAT_BC5_UNORM;
+	case skg_tex_fmt_bc7_rgba:        return DXGI_FORMAT_BC7_UNORM_SRGB;
+	case skg_tex_fmt_bc7_rgba_linear: return DXGI_FORMAT_BC7_UNORM;
 	default: return DXGI_FORMAT_UNKNOWN;
 	}
 }
@@ -2669,6 +2822,14 @@ skg_tex_fmt_ skg_tex_fmt_from_native(int64_t format) {
 	case DXGI_FORMAT_R16_FLOAT:           return skg_tex_fmt_r16f;
 	case DXGI_FORMAT_R32_FLOAT:           return skg_tex_fmt_r32;
 	case DXGI_FORMAT_R8G8_UNORM:          return skg_tex_fmt_r8g8;
+	case DXGI_FORMAT_BC1_UNORM_SRGB:      return skg_tex_fmt_bc1_rgba;
+	case DXGI_FORMAT_BC1_UNORM:           return skg_tex_fmt_bc1_rgba_linear;
+	case DXGI_FORMAT_BC3_UNORM_SRGB:      return skg_tex_fmt_bc3_rgba;
+	case DXGI_FORMAT_BC3_UNORM:           return skg_tex_fmt_bc3_rgba_linear;
+	case DXGI_FORMAT_BC4_UNORM:           return skg_tex_fmt_bc4_r;
+	case DXGI_FORMAT_BC5_UNORM:           return skg_tex_fmt_bc5_rg;
+	case DXGI_FORMAT_BC7_UNORM_SRGB:      return skg_tex_fmt_bc7_rgba;
+	case DXGI_FORMAT_BC7_UNORM:           return skg_tex_fmt_bc7_rgba_linear;
 	default: return skg_tex_fmt_none;
 	}
 }
@@ -3056,6 +3217,9 @@ GLE(void,     glGetInternalformativ,     uint32_t target, uint32_t internalforma
 GLE(void,     glGetTexLevelParameteriv,  uint32_t target, int32_t level, uint32_t pname, int32_t *params) \
 GLE(void,     glTexParameterf,           uint32_t target, uint32_t pname, float param) \
 GLE(void,     glTexImage2D,              uint32_t target, int32_t level, int32_t internalformat, int32_t width, int32_t height, int32_t border, uint32_t format, uint32_t type, const void *data) \
+GLE(void,     glTexImage3D,              uint32_t target, int32_t level, int32_t internalformat, int32_t width, int32_t height, int32_t depth, int32_t border, uint32_t format, uint32_t type, const void *data) \
+GLE(void,     glCompressedTexImage2D,    uint32_t target, int32_t level, uint32_t internalformat, int32_t width, int32_t height, int32_t border, int32_t imageSize, const void *data) \
+GLE(void,     glCompressedTexImage3D,    uint32_t target, int32_t level, uint32_t internalformat, int32_t width, int32_t height, int32_t depth, int32_t border, int32_t imageSize, const void *data) \
 GLE(void,     glTexStorage2DMultisample, uint32_t target, uint32_t samples, int32_t internalformat, uint32_t width, uint32_t height, uint8_t fixedsamplelocations) \
 GLE(void,     glTexStorage3DMultisample, uint32_t target, uint32_t samples, int32_t internalformat, uint32_t width, uint32_t height, uint32_t depth, uint8_t fixedsamplelocations) \
 GLE(void,     glCopyTexSubImage2D,       uint32_t target, int32_t level, int32_t xoffset, int32_t yoffset, int32_t x, int32_t y, uint32_t width, uint32_t height) \
@@ -3128,6 +3292,41 @@ int32_t     gl_active_height       = 0;
 skg_tex_t  *gl_active_rendertarget = nullptr;
 uint32_t    gl_current_framebuffer = 0;
 char*       gl_adapter_name        = nullptr;
+bool        gl_tex_fmt_support[skg_tex_fmt_astc4x4_rgba_linear + 1] = {};
+
+// Compressed formats come from extensions, so not every header has them.
+#ifndef GL_MAJOR_VERSION
+#define GL_MAJOR_VERSION 0x821B
+#define GL_MINOR_VERSION 0x821C
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT       0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT       0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1                0x8DBB
+#define GL_COMPRESSED_RG_RGTC2                 0x8DBD
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM          0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM    0x8E8D
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_R11_EAC                  0x9270
+#define GL_COMPRESSED_RG11_EAC                 0x9272
+#define GL_COMPRESSED_RGB8_ETC2                0x9274
+#define GL_COMPRESSED_SRGB8_ETC2               0x9275
+#define GL_COMPRESSED_RGBA8_ETC2_EAC           0x9278
+#define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC    0x9279
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR          0x93B0
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR  0x93D0
+#endif
 
 ///////////////////////////////////////////
 
@@ -3428,6 +3627,62 @@ void skg_setup_xlib(void *dpy, void *vi, void *fbconfig, void *drawable) {
 
 ///////////////////////////////////////////
 
+// Compressed format support only changes with the context, and checking it
+// requires a current context, so it's done once at init. This lets asset
+// threads ask about support too.
+void gl_check_tex_fmt_support() {
+	for (int32_t i = 0; i < (int32_t)(sizeof(gl_tex_fmt_support)/sizeof(gl_tex_fmt_support[0])); i++)
+		gl_tex_fmt_support[i] = !skg_tex_fmt_is_compressed((skg_tex_fmt_)i);
+
+#if !defined(_SKG_GL_WEB)
+	int32_t ext_count = 0, major = 0, minor = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &ext_count);
+	glGetIntegerv(GL_MAJOR_VERSION,  &major);
+	glGetIntegerv(GL_MINOR_VERSION,  &minor);
+	int32_t version = major * 10 + minor;
+
+	bool s3tc = false, s3tc_srgb = false, rgtc = false, bptc = false, etc2 = false, astc = false;
+	for (int32_t i = 0; i < ext_count; i++) {
+		const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, i);
+		if      (strcmp(ext, "GL_EXT_texture_compression_s3tc"     ) == 0) s3tc      = true;
+		else if (strcmp(ext, "GL_EXT_texture_compression_s3tc_srgb") == 0) s3tc_srgb = true;
+		else if (strcmp(ext, "GL_EXT_texture_sRGB"                 ) == 0) s3tc_srgb = true;
+		else if (strcmp(ext, "GL_EXT_texture_compression_rgtc"     ) == 0) rgtc      = true;
+		else if (strcmp(ext, "GL_ARB_texture_compression_rgtc"     ) == 0) rgtc      = true;
+		else if (strcmp(ext, "GL_EXT_texture_compression_bptc"     ) == 0) bptc      = true;
+		else if (strcmp(ext, "GL_ARB_texture_compression_bptc"     ) == 0) bptc      = true;
+		else if (strcmp(ext, "GL_ARB_ES3_compatibility"            ) == 0) etc2      = true;
+		else if (strcmp(ext, "GL_KHR_texture_compression_astc_ldr" ) == 0) astc      = true;
+	}
+#if defined(_SKG_GL_ES)
+	etc2 = true;
+#else
+	rgtc = rgtc || version >= 30;
+	bptc = bptc || version >= 42;
+	etc2 = etc2 || version >= 43;
+#endif
+
+	gl_tex_fmt_support[skg_tex_fmt_bc1_rgba           ] = s3tc && s3tc_srgb;
+	gl_tex_fmt_support[skg_tex_fmt_bc1_rgba_linear    ] = s3tc;
+	gl_tex_fmt_support[skg_tex_fmt_bc3_rgba           ] = s3tc && s3tc_srgb;
+	gl_tex_fmt_support[skg_tex_fmt_bc3_rgba_linear    ] = s3tc;
+	gl_tex_fmt_support[skg_tex_fmt_bc4_r              ] = rgtc;
+	gl_tex_fmt_support[skg_tex_fmt_bc5_rg             ] = rgtc;
+	gl_tex_fmt_support[skg_tex_fmt_bc7_rgba           ] = bptc;
+	gl_tex_fmt_support[skg_tex_fmt_bc7_rgba_linear    ] = bptc;
+	gl_tex_fmt_support[skg_tex_fmt_etc2_rgb           ] = etc2;
+	gl_tex_fmt_support[skg_tex_fmt_etc2_rgb_linear    ] = etc2;
+	gl_tex_fmt_support[skg_tex_fmt_etc2_rgba          ] = etc2;
+	gl_tex_fmt_support[skg_tex_fmt_etc2_rgba_linear   ] = etc2;
+	gl_tex_fmt_support[skg_tex_fmt_etc2_r11           ] = etc2;
+	gl_tex_fmt_support[skg_tex_fmt_etc2_rg11          ] = etc2;
+	gl_tex_fmt_support[skg_tex_fmt_astc4x4_rgba       ] = astc;
+	gl_tex_fmt_support[skg_tex_fmt_astc4x4_rgba_linear] = astc;
+#endif
+}
+
+///////////////////////////////////////////
+
 int32_t skg_init(const char *app_name, void *adapter_id) {
 #if   defined(_SKG_GL_LOAD_WGL)
 	int32_t result = gl_init_wgl();
@@ -3504,6 +3759,8 @@ int32_t skg_init(const char *app_name, void *adapter_id) {
 #ifdef _SKG_GL_DESKTOP
 	glEnable   (GL_TEXTURE_CUBE_MAP_SEAMLESS);
 #endif
+
+	gl_check_tex_fmt_support();
 	
 	return 1;
 }
@@ -3737,6 +3994,19 @@ void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t si
 
 ///////////////////////////////////////////
 
+bool skg_buffer_set_contents_range(skg_buffer_t *buffer, const void *data, uint32_t offset_bytes, uint32_t size_bytes) {
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return false;
+	}
+
+	glBindBuffer   (buffer->_target, buffer->_buffer);
+	glBufferSubData(buffer->_target, offset_bytes, size_bytes, data);
+	return true;
+}
+
+///////////////////////////////////////////
+
 void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind, uint32_t offset) {
 	if (buffer->type == skg_buffer_type_constant || buffer->type == skg_buffer_type_compute)
 		glBindBufferBase(buffer->_target, bind.slot, buffer->_buffer);
@@ -4446,6 +4716,7 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 	result.type        = type;
 	result.use         = skg_use_static;
 	result.mips        = skg_mip_none;
+	result.mip_count   = 1;
 	result.format      = format;
 	result.width       = width;
 	result.height      = height;
@@ -4484,6 +4755,7 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 	result.type        = type;
 	result.use         = skg_use_static;
 	result.mips        = skg_mip_none;
+	result.mip_count   = 1;
 	result.format      = format;
 	result.width       = width;
 	result.height      = height;
@@ -4718,6 +4990,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **data_frames, int32_t
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
+	tex->mip_count = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(width, height) : 1;
 	if (tex->mips == skg_mip_generate)
 		glGenerateMipmap(tex->_target);
 
@@ -4746,6 +5019,72 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **data_frames, int32_t
 
 ///////////////////////////////////////////
 
+void skg_tex_set_contents_mips(skg_tex_t *tex, const void **data_frame_mips, int32_t data_frame_count, int32_t mip_count, int32_t width, int32_t height) {
+	if (tex->use == skg_use_dynamic) {
+		skg_log(skg_log_warning, "Pre-built mip chains are only for static textures!");
+		return;
+	}
+	if (tex->type == skg_tex_type_cubemap && data_frame_count != 6) {
+		skg_log(skg_log_warning, "Cubemaps need 6 data frames");
+		return;
+	}
+
+	tex->width       = width;
+	tex->height      = height;
+	tex->multisample = 1;
+	tex->array_count = data_frame_count;
+	tex->mips        = mip_count > 1 ? skg_mip_generate : skg_mip_none;
+	tex->mip_count   = mip_count;
+	tex->_target     = tex->type == skg_tex_type_cubemap
+		? GL_TEXTURE_CUBE_MAP
+		: (data_frame_count > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+
+	glBindTexture(tex->_target, tex->_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	tex->_format        = (uint32_t)skg_tex_fmt_to_native(tex->format);
+	bool     compressed = skg_tex_fmt_is_compressed(tex->format);
+	uint32_t layout     = skg_tex_fmt_to_gl_layout (tex->format);
+	uint32_t type       = skg_tex_fmt_to_gl_type   (tex->format);
+	for (int32_t m = 0; m < mip_count; m++) {
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(width, height, m, &mip_w, &mip_h);
+		int32_t mip_size = (int32_t)skg_tex_fmt_memory(tex->format, mip_w, mip_h);
+
+		if (tex->_target == GL_TEXTURE_2D_ARRAY) {
+			// Array layers are uploaded together, so they need to be packed
+			// into one contiguous block.
+			uint8_t *layers = (uint8_t *)malloc((size_t)mip_size * data_frame_count);
+			if (!layers) { skg_log(skg_log_critical, "Out of memory"); break; }
+			for (int32_t f = 0; f < data_frame_count; f++)
+				memcpy(layers + (size_t)mip_size * f, data_frame_mips[f*mip_count + m], mip_size);
+			if (compressed) glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, m, tex->_format, mip_w, mip_h, data_frame_count, 0, mip_size * data_frame_count, layers);
+			else            glTexImage3D          (GL_TEXTURE_2D_ARRAY, m, tex->_format, mip_w, mip_h, data_frame_count, 0, layout, type, layers);
+			free(layers);
+		} else {
+			for (int32_t f = 0; f < data_frame_count; f++) {
+				uint32_t target = tex->_target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + f : GL_TEXTURE_2D;
+				if (compressed) glCompressedTexImage2D(target, m, tex->_format, mip_w, mip_h, 0, mip_size, data_frame_mips[f*mip_count + m]);
+				else            glTexImage2D          (target, m, tex->_format, mip_w, mip_h, 0, layout, type, data_frame_mips[f*mip_count + m]);
+			}
+		}
+	}
+	glPixelStorei  (GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(tex->_target, GL_TEXTURE_MAX_LEVEL, mip_count - 1);
+
+	skg_tex_settings(tex, tex->_address, tex->_sample, tex->_anisotropy);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
+	return format >= 0 && format < (int32_t)(sizeof(gl_tex_fmt_support)/sizeof(gl_tex_fmt_support[0]))
+		? gl_tex_fmt_support[format]
+		: false;
+}
+
+///////////////////////////////////////////
+
 bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
 	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
 }
@@ -4768,7 +5107,7 @@ bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr
 	}
 	
 	// Double check on mips first
-	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
+	int32_t mip_levels = tex->mip_count;
 	if (mip_level != 0) {
 		if (tex->mips != skg_mip_generate) {
 			skg_log(skg_log_critical, "Can't get mip data from a texture with no mips!");
@@ -4899,6 +5238,22 @@ int64_t skg_tex_fmt_to_native(skg_tex_fmt_ format) {
 	case skg_tex_fmt_r16f:          return GL_R16F;
 	case skg_tex_fmt_r32:           return GL_R32F;
 	case skg_tex_fmt_r8g8:          return GL_RG8;
+	case skg_tex_fmt_bc1_rgba:            return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+	case skg_tex_fmt_bc1_rgba_linear:     return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case skg_tex_fmt_bc3_rgba:            return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	case skg_tex_fmt_bc3_rgba_linear:     return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case skg_tex_fmt_bc4_r:               return GL_COMPRESSED_RED_RGTC1;
+	case skg_tex_fmt_bc5_rg:              return GL_COMPRESSED_RG_RGTC2;
+	case skg_tex_fmt_bc7_rgba:            return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+	case skg_tex_fmt_bc7_rgba_linear:     return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	case skg_tex_fmt_etc2_rgb:            return GL_COMPRESSED_SRGB8_ETC2;
+	case skg_tex_fmt_etc2_rgb_linear:     return GL_COMPRESSED_RGB8_ETC2;
+	case skg_tex_fmt_etc2_rgba:           return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+	case skg_tex_fmt_etc2_rgba_linear:    return GL_COMPRESSED_RGBA8_ETC2_EAC;
+	case skg_tex_fmt_etc2_r11:            return GL_COMPRESSED_R11_EAC;
+	case skg_tex_fmt_etc2_rg11:           return GL_COMPRESSED_RG11_EAC;
+	case skg_tex_fmt_astc4x4_rgba:        return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR;
+	case skg_tex_fmt_astc4x4_rgba_linear: return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
 	default: return 0;
 	}
 }
@@ -4924,6 +5279,22 @@ skg_tex_fmt_ skg_tex_fmt_from_native(int64_t format) {
 	case GL_R16_SNORM:          return skg_tex_fmt_r16s;
 	case GL_R32F:               return skg_tex_fmt_r32;
 	case GL_RG8:                return skg_tex_fmt_r8g8;
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:  return skg_tex_fmt_bc1_rgba;
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:        return skg_tex_fmt_bc1_rgba_linear;
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:  return skg_tex_fmt_bc3_rgba;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:        return skg_tex_fmt_bc3_rgba_linear;
+	case GL_COMPRESSED_RED_RGTC1:                 return skg_tex_fmt_bc4_r;
+	case GL_COMPRESSED_RG_RGTC2:                  return skg_tex_fmt_bc5_rg;
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:     return skg_tex_fmt_bc7_rgba;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:           return skg_tex_fmt_bc7_rgba_linear;
+	case GL_COMPRESSED_SRGB8_ETC2:                return skg_tex_fmt_etc2_rgb;
+	case GL_COMPRESSED_RGB8_ETC2:                 return skg_tex_fmt_etc2_rgb_linear;
+	case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:     return skg_tex_fmt_etc2_rgba;
+	case GL_COMPRESSED_RGBA8_ETC2_EAC:            return skg_tex_fmt_etc2_rgba_linear;
+	case GL_COMPRESSED_R11_EAC:                   return skg_tex_fmt_etc2_r11;
+	case GL_COMPRESSED_RG11_EAC:                  return skg_tex_fmt_etc2_rg11;
+	case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR: return skg_tex_fmt_astc4x4_rgba;
+	case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:         return skg_tex_fmt_astc4x4_rgba_linear;
 	default: return skg_tex_fmt_none;
 	}
 }
@@ -5105,6 +5476,8 @@ uint32_t skg_mip_count(int32_t width, int32_t height) {
 void skg_mip_dimensions(int32_t width, int32_t height, int32_t mip_level, int32_t *out_width, int32_t *out_height) {
 	*out_width  = width  >> mip_level;
 	*out_height = height >> mip_level;
+	if (*out_width  < 1) *out_width  = 1;
+	if (*out_height < 1) *out_height = 1;
 }
 
 ///////////////////////////////////////////
@@ -5820,6 +6193,46 @@ uint32_t skg_tex_fmt_size(skg_tex_fmt_ format) {
 	default: return 0;
 	}
 }
+
+///////////////////////////////////////////
+
+// Bytes per 4x4 block for block compressed formats, 0 for everything else.
+static uint32_t skg_tex_fmt_block_size(skg_tex_fmt_ format) {
+	switch (format) {
+	case skg_tex_fmt_bc1_rgba:
+	case skg_tex_fmt_bc1_rgba_linear:
+	case skg_tex_fmt_bc4_r:
+	case skg_tex_fmt_etc2_rgb:
+	case skg_tex_fmt_etc2_rgb_linear:
+	case skg_tex_fmt_etc2_r11:            return 8;
+	case skg_tex_fmt_bc3_rgba:
+	case skg_tex_fmt_bc3_rgba_linear:
+	case skg_tex_fmt_bc5_rg:
+	case skg_tex_fmt_bc7_rgba:
+	case skg_tex_fmt_bc7_rgba_linear:
+	case skg_tex_fmt_etc2_rgba:
+	case skg_tex_fmt_etc2_rgba_linear:
+	case skg_tex_fmt_etc2_rg11:
+	case skg_tex_fmt_astc4x4_rgba:
+	case skg_tex_fmt_astc4x4_rgba_linear: return 16;
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_fmt_is_compressed(skg_tex_fmt_ format) {
+	return skg_tex_fmt_block_size(format) != 0;
+}
+
+///////////////////////////////////////////
+
+size_t skg_tex_fmt_memory(skg_tex_fmt_ format, int32_t width, int32_t height) {
+	uint32_t block_size = skg_tex_fmt_block_size(format);
+	return block_size != 0
+		? (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * block_size
+		: (size_t)width * (size_t)height * skg_tex_fmt_size(format);
+}
 #endif // SKG_IMPL
 /*
 ------------------------------------------------------------------------------
@@ -10,12 +10,14 @@
 #include "../log.h"
 #include "../device.h"
 #include "../sk_math.h"
+#include "../sk_memory.h"
 #include "../xr_backends/openxr.h"
 #include "../systems/render.h"
 #include "../systems/system.h"
 #include "../_stereokit.h"
 #include "../libraries/sk_gpu.h"
 #include "../libraries/sokol_time.h"
+#include "../libraries/stref.h"
 
 #include <android/native_activity.h>
 #include <android/native_window_jni.h>
@@ -58,6 +60,7 @@ struct platform_android_state_t {
 	jobject        activity;
 	AAssetManager *asset_manager;
 	jobject        asset_manager_obj;
+	char          *cache_dir;
 	window_t       window;
 };
 
@@ -140,6 +143,22 @@ bool platform_impl_init() {
 		log_fail_reason(95, log_error, "Couldn't get the Android asset manager!");
 		return false;
 	}
+
+	// The APK is read-only, so anything we generate at runtime goes in the
+	// app's cache folder. JNI is only usable from this thread, so we grab
+	// the path up front.
+	jmethodID   activity_class_getCacheDir = local.env->GetMethodID(activity_class, "getCacheDir", "()Ljava/io/File;");
+	jobject     cache_dir                  = local.env->CallObjectMethod(local.activity, activity_class_getCacheDir); // activity.getCacheDir();
+	jclass      file_class                 = local.env->GetObjectClass(cache_dir);
+	jmethodID   file_class_getPath         = local.env->GetMethodID(file_class, "getAbsolutePath", "()Ljava/lang/String;");
+	jstring     cache_path                 = (jstring)local.env->CallObjectMethod(cache_dir, file_class_getPath);
+	const char *cache_path_utf             = local.env->GetStringUTFChars(cache_path, nullptr);
+	local.cache_dir = string_copy(cache_path_utf);
+	local.env->ReleaseStringUTFChars(cache_path, cache_path_utf);
+	local.env->DeleteLocalRef(cache_path);
+	local.env->DeleteLocalRef(file_class);
+	local.env->DeleteLocalRef(cache_dir);
+
 	local.env->DeleteLocalRef(activity_class);
 	local.env->DeleteLocalRef(asset_manager);
 
@@ -160,6 +179,7 @@ bool platform_impl_init() {
 
 void platform_impl_shutdown() {
 	local.env->DeleteGlobalRef(local.asset_manager_obj);
+	sk_free(local.cache_dir);
 }
 
 ///////////////////////////////////////////
@@ -495,6 +515,12 @@ font_t platform_default_font() {
 
 ///////////////////////////////////////////
 
+char *platform_cache_dir() {
+	return string_copy(local.cache_dir != nullptr ? local.cache_dir : "/data/local/tmp");
+}
+
+///////////////////////////////////////////
+
 void platform_iterate_dir(const char* directory_path, void* callback_data, void (*on_item)(void* callback_data, const char* name, const platform_file_attr_t file_attr)) {}
 
 ///////////////////////////////////////////
@@ -544,7 +570,7 @@ void platform_print_callstack() {
 			(nullptr != demangled && 0 == status) ?
 			demangled : symbol);
 
-		sk_free(demangled);
+		free(demangled);
 	}
 }
 
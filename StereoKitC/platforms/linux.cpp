@@ -27,6 +27,7 @@
 #include "../device.h"
 #include "../log.h"
 #include "../sk_math.h"
+#include "../sk_memory.h"
 #include "../asset_types/texture.h"
 #include "../libraries/sk_gpu.h"
 #include "../libraries/sokol_time.h"
@@ -533,6 +534,24 @@ font_t platform_default_font() {
 
 ///////////////////////////////////////////
 
+char *platform_cache_dir() {
+	const char *xdg_cache = getenv("XDG_CACHE_HOME");
+	if (xdg_cache != nullptr && xdg_cache[0] != '\0')
+		return string_copy(xdg_cache);
+
+	const char *home = getenv("HOME");
+	if (home != nullptr && home[0] != '\0') {
+		char       *result = string_append(string_copy(home), 1, "/.cache");
+		struct stat info;
+		if (stat(result, &info) == 0 && S_ISDIR(info.st_mode))
+			return result;
+		sk_free(result);
+	}
+	return string_copy("/tmp");
+}
+
+///////////////////////////////////////////
+
 void platform_iterate_dir(const char *directory_path, void *callback_data, void (*on_item)(void *callback_data, const char *name, const platform_file_attr_t file_attr)) {
 	if (string_eq(directory_path, "")) {
 		directory_path = platform_path_separator;
@@ -19,6 +19,7 @@
 #include "../xr_backends/offscreen.h"
 #include "../xr_backends/xr.h"
 #include "../platforms/android.h"
+#include "../asset_types/asset_pack.h"
 
 #include "../systems/input_keyboard.h"
 #include "../tools/virtual_keyboard.h"
@@ -37,6 +38,14 @@
 
 #endif
 
+#if defined(SK_OS_LINUX) || defined(SK_OS_ANDROID)
+
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+
+#endif
+
 #if defined(SK_OS_WINDOWS) || defined(SK_OS_WINDOWS_UWP)
 
 	#ifndef WIN32_LEAN_AND_MEAN
@@ -275,7 +284,7 @@ bool32_t platform_keyboard_visible() {
 
 bool platform_file_exists(const char *filename) {
 	struct stat buffer;
-	return (stat (filename, &buffer) == 0);
+	return (stat (filename, &buffer) == 0) || asset_pack_exists(filename);
 }
 
 ///////////////////////////////////////////
@@ -352,7 +361,7 @@ char *platform_pop_path_new(const char *path) {
 
 ///////////////////////////////////////////
 
-bool32_t platform_read_file(const char *filename, void **out_data, size_t *out_size) {
+bool32_t _platform_read_file_disk(const char *filename, void **out_data, size_t *out_size) {
 	*out_data = nullptr;
 	*out_size = 0;
 
@@ -476,6 +485,223 @@ bool32_t platform_read_file(const char *filename, void **out_data, size_t *out_s
 
 ///////////////////////////////////////////
 
+// Swaps a shared asset pack view for a heap copy the caller can own.
+void _platform_file_map_own(platform_file_map_t *ref_map) {
+	if (ref_map->mapped || ref_map->handle == nullptr) return;
+
+	void *data = sk_malloc(ref_map->size + 1);
+	memcpy(data, ref_map->data, ref_map->size + 1);
+	size_t size = ref_map->size;
+	platform_file_unmap(ref_map);
+	ref_map->data = data;
+	ref_map->size = size;
+}
+
+///////////////////////////////////////////
+
+// Mounted asset packs take priority over everything else, but callers
+// expect to own what we give them, so views into a pack get copied.
+bool32_t platform_read_file(const char *filename, void **out_data, size_t *out_size) {
+	platform_file_map_t map = {};
+	if (asset_pack_map(filename, &map)) {
+		_platform_file_map_own(&map);
+		*out_data = map.data;
+		*out_size = map.size;
+		return true;
+	}
+	return _platform_read_file_disk(filename, out_data, out_size);
+}
+
+///////////////////////////////////////////
+
+// For streaming through files that are too large to read in one go. Unlike
+// platform_read_file, this doesn't look through asset packs, Android
+// assets or the UWP file picker cache.
+FILE *platform_file_open(const char *filename, const char *mode) {
+	char* slash_fix_filename = string_copy(filename);
+	for (char* curr = slash_fix_filename; *curr != '\0'; curr++) {
+		if (*curr == '\\' || *curr == '/') *curr = platform_path_separator_c;
+	}
+
+#if defined(SK_OS_WINDOWS) || defined(SK_OS_WINDOWS_UWP)
+	wchar_t* wfilename = platform_to_wchar(slash_fix_filename);
+	wchar_t* wmode     = platform_to_wchar(mode);
+	FILE*    fp        = _wfopen(wfilename, wmode);
+	sk_free(wfilename);
+	sk_free(wmode);
+#else
+	FILE* fp = fopen(slash_fix_filename, mode);
+#endif
+	if (fp == nullptr) log_diagf("platform_file_open can't open %s", slash_fix_filename);
+
+	sk_free(slash_fix_filename);
+	return fp;
+}
+
+///////////////////////////////////////////
+
+bool platform_file_seek(FILE *fp, int64_t offset, int32_t origin) {
+#if defined(SK_OS_WINDOWS) || defined(SK_OS_WINDOWS_UWP)
+	return _fseeki64(fp, offset, origin) == 0;
+#else
+	return fseeko(fp, (off_t)offset, origin) == 0;
+#endif
+}
+
+///////////////////////////////////////////
+
+int64_t platform_file_tell(FILE *fp) {
+#if defined(SK_OS_WINDOWS) || defined(SK_OS_WINDOWS_UWP)
+	return _ftelli64(fp);
+#else
+	return (int64_t)ftello(fp);
+#endif
+}
+
+///////////////////////////////////////////
+
+// Last write time of an open file, in seconds. Only good for noticing that
+// a file has changed, 0 if it isn't known.
+uint64_t platform_file_modified(FILE *fp) {
+#if defined(SK_OS_WINDOWS) || defined(SK_OS_WINDOWS_UWP)
+	struct _stat64 info;
+	return _fstat64(_fileno(fp), &info) == 0 ? (uint64_t)info.st_mtime : 0;
+#else
+	struct stat info;
+	return fstat(fileno(fp), &info) == 0 ? (uint64_t)info.st_mtime : 0;
+#endif
+}
+
+///////////////////////////////////////////
+
+// Small files read faster than they map, and mapping them just burns
+// address space and kernel bookkeeping.
+#define PLATFORM_MAP_MIN_SIZE (64 * 1024)
+
+bool _platform_file_map_native(const char *filename, platform_file_map_t *out_map) {
+#if defined(SK_OS_LINUX) || defined(SK_OS_ANDROID)
+	int32_t fd = open(filename, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size < PLATFORM_MAP_MIN_SIZE) {
+		close(fd);
+		return false;
+	}
+
+	// The tail of the last page is zero filled, which gives us the 0
+	// terminator for free, unless the file fills that page exactly.
+	size_t size = (size_t)info.st_size;
+	if (size % (size_t)sysconf(_SC_PAGESIZE) == 0) {
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return false;
+
+	out_map->data   = data;
+	out_map->size   = size;
+	out_map->handle = nullptr;
+	out_map->mapped = true;
+	return true;
+#elif defined(SK_OS_WINDOWS)
+	wchar_t* wfilename = platform_to_wchar(filename);
+	HANDLE   file      = CreateFileW(wfilename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	sk_free(wfilename);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER file_size;
+	SYSTEM_INFO   sys_info;
+	GetSystemInfo(&sys_info);
+	if (!GetFileSizeEx(file, &file_size) ||
+		file_size.QuadPart < PLATFORM_MAP_MIN_SIZE ||
+		(file_size.QuadPart % sys_info.dwPageSize) == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) return false;
+
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		CloseHandle(mapping);
+		return false;
+	}
+
+	out_map->data   = data;
+	out_map->size   = (size_t)file_size.QuadPart;
+	out_map->handle = mapping;
+	out_map->mapped = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+///////////////////////////////////////////
+
+bool _platform_file_map_disk(const char *filename, platform_file_map_t *out_map) {
+	*out_map = {};
+
+	char* slash_fix_filename = string_copy(filename);
+	for (char* curr = slash_fix_filename; *curr != '\0'; curr++) {
+		if (*curr == '\\' || *curr == '/') *curr = platform_path_separator_c;
+	}
+
+	// Android assets live inside the APK, so relative paths go through
+	// platform_read_file first.
+#if defined(SK_OS_ANDROID)
+	bool try_map = slash_fix_filename[0] == '/';
+#else
+	bool try_map = true;
+#endif
+	bool result = try_map && _platform_file_map_native(slash_fix_filename, out_map);
+	sk_free(slash_fix_filename);
+	if (result) return true;
+
+	// Anything that couldn't be mapped gets read the usual way, this also
+	// covers the exe relative paths and caches that platform_read_file knows
+	// about.
+	return _platform_read_file_disk(filename, &out_map->data, &out_map->size);
+}
+
+///////////////////////////////////////////
+
+bool platform_file_map(const char *filename, platform_file_map_t *out_map) {
+	*out_map = {};
+	return asset_pack_map(filename, out_map) || _platform_file_map_disk(filename, out_map);
+}
+
+///////////////////////////////////////////
+
+bool platform_file_map_disk(const char *filename, platform_file_map_t *out_map) {
+	return _platform_file_map_disk(filename, out_map);
+}
+
+///////////////////////////////////////////
+
+void platform_file_unmap(platform_file_map_t *map) {
+	if (map->mapped) {
+#if defined(SK_OS_LINUX) || defined(SK_OS_ANDROID)
+		munmap(map->data, map->size);
+#elif defined(SK_OS_WINDOWS)
+		UnmapViewOfFile(map->data);
+		CloseHandle((HANDLE)map->handle);
+#endif
+	} else if (map->handle != nullptr) {
+		asset_pack_release(map->handle);
+	} else {
+		sk_free(map->data);
+	}
+	*map = {};
+}
+
+///////////////////////////////////////////
+
 bool32_t _platform_write_file(const char* filename, void* data, size_t size, bool32_t binary) {
 #if defined(SK_OS_WINDOWS_UWP)
 	// See if we have a Handle cached from the FilePicker that matches this
@@ -7,6 +7,8 @@
 #pragma once
 #include "../stereokit.h"
 
+#include <stdio.h>
+
 ///////////////////////////////////////////
 
 #if   defined(__EMSCRIPTEN__)
@@ -133,6 +135,7 @@ void   platform_msgbox_err        (const char *text, const char *header);
 void   platform_debug_output      (log_ level, const char *text);
 void   platform_print_callstack   ();
 void   platform_sleep             (int ms);
+int32_t platform_cpu_count        ();
 font_t platform_default_font      ();
 
 bool   platform_xr_keyboard_present();
@@ -142,8 +145,29 @@ bool   platform_xr_keyboard_visible();
 void   platform_set_window        (void *window);
 void   platform_set_window_xam    (void *window);
 
+// A view of a whole file's contents. Large files are memory mapped where the
+// platform allows it, uncompressed asset pack entries point into the pack's
+// own mapping, and everything else is a heap copy. Either way, data is
+// followed by a 0 byte like platform_read_file, and must be released with
+// platform_file_unmap rather than sk_free. Views are read-only, and may be
+// shared with other readers.
+struct platform_file_map_t {
+	void   *data;
+	size_t  size;
+	void   *handle;
+	bool    mapped;
+};
+
 bool   platform_file_exists       (const char* filename);
+FILE  *platform_file_open         (const char* filename, const char *mode);
+bool   platform_file_seek         (FILE *fp, int64_t offset, int32_t origin);
+int64_t platform_file_tell        (FILE *fp);
+uint64_t platform_file_modified   (FILE *fp);
+bool   platform_file_map          (const char* filename, platform_file_map_t *out_map);
+bool   platform_file_map_disk     (const char* filename, platform_file_map_t *out_map);
+void   platform_file_unmap        (platform_file_map_t *map);
 char  *platform_working_dir       ();
+char  *platform_cache_dir         ();
 void   platform_iterate_dir       (const char *directory_path, void *callback_data, void (*on_item)(void *callback_data, const char *name, const platform_file_attr_t platform_file_attr_t));
 char  *platform_push_path_ref     (char       *path, const char *directory);
 char  *platform_pop_path_ref      (char       *path);
@@ -27,5 +27,12 @@ char *platform_working_dir() {
 	return result;
 }
 
+///////////////////////////////////////////
+
+int32_t platform_cpu_count() {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int32_t)count : 1;
+}
+
 } // namespace sk
 #endif // defined (SK_OS_ANDROID) || defined(SK_OS_LINUX)
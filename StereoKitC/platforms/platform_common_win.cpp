@@ -56,6 +56,14 @@ void platform_sleep(int ms) {
 
 ///////////////////////////////////////////
 
+int32_t platform_cpu_count() {
+	SYSTEM_INFO info = {};
+	GetNativeSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int32_t)info.dwNumberOfProcessors : 1;
+}
+
+///////////////////////////////////////////
+
 font_t platform_default_font() {
 	array_t<const char *> fonts = array_t<const char *>::make(3);
 	fonts.add(platform_file_exists("C:/Windows/Fonts/segoeui.ttf")
@@ -89,6 +97,23 @@ char *platform_working_dir() {
 
 ///////////////////////////////////////////
 
+// UWP apps get their own temp folder from this same call, so it's always
+// somewhere we're allowed to write.
+char *platform_cache_dir() {
+	int32_t  len     = GetTempPathW(0, nullptr);
+	wchar_t* wresult = sk_malloc_t(wchar_t, len + 1);
+	len = GetTempPathW(len + 1, wresult);
+	while (len > 0 && (wresult[len-1] == L'\\' || wresult[len-1] == L'/')) len -= 1;
+	wresult[len] = L'\0';
+
+	char* result = platform_from_wchar(wresult);
+
+	sk_free(wresult);
+	return result;
+}
+
+///////////////////////////////////////////
+
 wchar_t *platform_to_wchar(const char *utf8_string) {
 	int32_t  wsize  = MultiByteToWideChar(CP_UTF8, 0, utf8_string, -1, nullptr, 0);
 	wchar_t *result = sk_malloc_t(wchar_t, wsize);
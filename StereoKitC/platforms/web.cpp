@@ -441,6 +441,12 @@ char* platform_working_dir() {
 
 ///////////////////////////////////////////
 
+char* platform_cache_dir() {
+	return string_copy("/tmp");
+}
+
+///////////////////////////////////////////
+
 void platform_debug_output(log_ level, const char *text) {
 	if      (level == log_diagnostic) emscripten_console_log(text);
 	else if (level == log_inform    ) emscripten_console_log(text);
@@ -458,6 +464,12 @@ void platform_sleep(int ms) {
 	emscripten_sleep(ms);
 }
 
+///////////////////////////////////////////
+
+int32_t platform_cpu_count() {
+	return 1;
+}
+
 } // namespace sk
 
 #endif // defined(SK_OS_WEB)
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "shader_builtin_blit.hlsl.h"
 #include "shader_builtin_font.hlsl.h"
 #include "shader_builtin_lines.hlsl.h"
+#include "shader_builtin_points.hlsl.h"
 #include "shader_builtin_ui.hlsl.h"
 #include "shader_builtin_ui_box.hlsl.h"
 #include "shader_builtin_ui_quadrant.hlsl.h"
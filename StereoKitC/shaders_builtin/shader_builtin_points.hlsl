@@ -0,0 +1,40 @@
+#include "stereokit.hlsli"
+
+//--name        = sk/points
+//--color:color = 1,1,1,1
+float4 color;
+
+struct vsIn {
+	float4 pos  : SV_Position;
+	float3 norm : NORMAL0;   // x is the splat radius
+	float2 uv   : TEXCOORD0; // Corner of the splat
+	float4 col  : COLOR0;
+};
+struct psIn {
+	float4 pos   : SV_POSITION;
+	float2 uv    : TEXCOORD0;
+	float4 color : COLOR0;
+	uint view_id : SV_RenderTargetArrayIndex;
+};
+
+psIn vs(vsIn input, uint id : SV_InstanceID) {
+	psIn o;
+	o.view_id = id % sk_view_count;
+	id        = id / sk_view_count;
+
+	// Expand the splat in view space, so it always faces the viewer
+	float  scale = length(sk_inst[id].world._11_12_13);
+	float4 world = mul(float4(input.pos.xyz, 1), sk_inst[id].world);
+	float4 view  = mul(world, sk_view[o.view_id]);
+	view.xy += input.uv * input.norm.x * scale;
+
+	o.pos   = mul(view, sk_proj[o.view_id]);
+	o.uv    = input.uv;
+	o.color = input.col * color * sk_inst[id].color;
+	return o;
+}
+float4 ps(psIn input) : SV_TARGET {
+	// Round splats
+	if (dot(input.uv, input.uv) > 1) discard;
+	return input.color;
+}
@@ -4,9 +4,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(SK_TRACK_MEM)
+#include "stereokit.h"
+#include "libraries/sokol_time.h"
+#if defined(_WIN32)
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <unwind.h>
+#include <dlfcn.h>
+#endif
+#endif
+
 namespace sk {
 
-#if !defined(SK_DEBUG_MEM)
+#if !defined(SK_DEBUG_MEM) && !defined(SK_TRACK_MEM)
 
 ///////////////////////////////////////////
 
@@ -52,6 +63,468 @@ void _sk_free(void* memory) {
 void sk_mem_log_allocations() {
 }
 
+#elif defined(SK_TRACK_MEM)
+
+// Allocations are counted against "sites", the distinct type strings they're
+// made with. That's the #T from sk_malloc_t and friends, or "raw" for untyped
+// allocations. The last site collects anything past the table's capacity.
+#define MEM_SITE_MAX    512
+#define MEM_SITE_CACHE  64
+// On average, 1 in this many allocations records its call stack.
+#define MEM_SAMPLE_RATE 512
+#define MEM_STACK_DEPTH 16
+
+struct mem_header_t {
+	uint32_t site;
+	int32_t  sample; // Index into mem_samples, or -1
+	uint64_t bytes;
+};
+static_assert(sizeof(mem_header_t) == 16, "mem_header_t must preserve malloc's alignment");
+
+struct mem_counts_t {
+	int64_t allocs;
+	int64_t frees;
+	int64_t alloc_bytes;
+	int64_t free_bytes;
+};
+
+// Each thread only ever writes to its own counters, so counting needs no
+// locks. Readers may see values that are a few allocations stale. These are
+// never freed, since counts from threads that have exited still belong in
+// the totals.
+struct mem_thread_t {
+	mem_counts_t  sites     [MEM_SITE_MAX];
+	const char   *cache_type[MEM_SITE_CACHE];
+	uint32_t      cache_site[MEM_SITE_CACHE];
+	int32_t       sample_countdown;
+	uint32_t      rand;
+	mem_thread_t *next;
+};
+
+struct mem_sample_t {
+	void    *memory;
+	uint64_t bytes;
+	uint32_t site;
+	int32_t  depth;
+	void    *stack[MEM_STACK_DEPTH];
+};
+
+static const char           *mem_site_types[MEM_SITE_MAX] = { "raw" };
+static int32_t               mem_site_count   = 1;
+static volatile int32_t      mem_site_lock    = 0;
+static mem_thread_t         *mem_threads      = nullptr;
+static volatile int32_t      mem_thread_lock  = 0;
+static mem_sample_t         *mem_samples      = nullptr;
+static int32_t               mem_sample_count = 0;
+static int32_t               mem_sample_cap   = 0;
+static volatile int32_t      mem_sample_lock  = 0;
+static thread_local mem_thread_t *mem_local   = nullptr;
+static sk_mem_snapshot_t     mem_last_snapshot = {};
+
+///////////////////////////////////////////
+
+// These can't use ft_mutex, since creating one would need an allocation
+// before the allocator is ready, and they're only ever held briefly.
+static void mem_lock(volatile int32_t *lock) {
+#if defined(_MSC_VER)
+	while (InterlockedExchange((volatile LONG *)lock, 1) != 0) YieldProcessor();
+#else
+	while (__sync_lock_test_and_set(lock, 1) != 0) {}
+#endif
+}
+static void mem_unlock(volatile int32_t *lock) {
+#if defined(_MSC_VER)
+	InterlockedExchange((volatile LONG *)lock, 0);
+#else
+	__sync_lock_release(lock);
+#endif
+}
+
+///////////////////////////////////////////
+
+static void mem_fail() {
+	fprintf(stderr, "Memory alloc failed!");
+	abort();
+}
+
+///////////////////////////////////////////
+
+static int32_t mem_next_sample(mem_thread_t *thread) {
+	// xorshift32, spreading samples over [1, 2*rate] so allocation patterns
+	// with a fixed period don't always land on, or always miss, a sample.
+	uint32_t x = thread->rand;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	thread->rand = x;
+	return 1 + (int32_t)(x % (MEM_SAMPLE_RATE * 2));
+}
+
+///////////////////////////////////////////
+
+static mem_thread_t *mem_thread() {
+	mem_thread_t *result = mem_local;
+	if (result != nullptr) return result;
+
+	result = (mem_thread_t *)calloc(1, sizeof(mem_thread_t));
+	if (result == nullptr) mem_fail();
+	result->rand             = (uint32_t)((uintptr_t)result >> 4) | 1;
+	result->sample_countdown = mem_next_sample(result);
+
+	mem_lock(&mem_thread_lock);
+	result->next = mem_threads;
+	mem_threads  = result;
+	mem_unlock(&mem_thread_lock);
+
+	mem_local = result;
+	return result;
+}
+
+///////////////////////////////////////////
+
+static uint32_t mem_site_find(mem_thread_t *thread, const char *type) {
+	uint32_t slot = (uint32_t)(((uintptr_t)type >> 3) % MEM_SITE_CACHE);
+	if (thread->cache_type[slot] == type)
+		return thread->cache_site[slot];
+
+	// Identical string literals can live at different addresses in different
+	// translation units, so the shared table matches them by content.
+	mem_lock(&mem_site_lock);
+	uint32_t site = MEM_SITE_MAX - 1;
+	int32_t  i    = 0;
+	for (; i < mem_site_count; i++) {
+		if (strcmp(mem_site_types[i], type) == 0) { site = (uint32_t)i; break; }
+	}
+	if (i == mem_site_count && mem_site_count < MEM_SITE_MAX) {
+		if (mem_site_count == MEM_SITE_MAX - 1) {
+			mem_site_types[mem_site_count] = "(other)";
+		} else {
+			mem_site_types[mem_site_count] = type;
+			site = (uint32_t)mem_site_count;
+		}
+		mem_site_count += 1;
+	}
+	mem_unlock(&mem_site_lock);
+
+	thread->cache_type[slot] = type;
+	thread->cache_site[slot] = site;
+	return site;
+}
+
+///////////////////////////////////////////
+
+#if defined(_WIN32)
+
+static int32_t mem_capture_stack(void **frames, int32_t max) {
+	return (int32_t)RtlCaptureStackBackTrace(2, (DWORD)max, frames, nullptr);
+}
+
+#elif defined(__EMSCRIPTEN__)
+
+static int32_t mem_capture_stack(void **, int32_t) {
+	return 0;
+}
+
+#else
+
+struct mem_unwind_t {
+	void  **current;
+	void  **end;
+	int32_t skip;
+};
+
+static int32_t mem_capture_stack(void **frames, int32_t max) {
+	mem_unwind_t state = { frames, frames + max, 2 };
+	_Unwind_Backtrace([](struct _Unwind_Context *context, void *arg) {
+		mem_unwind_t *state = (mem_unwind_t *)arg;
+		uintptr_t     pc    = _Unwind_GetIP(context);
+		if (pc == 0)                    return (_Unwind_Reason_Code)_URC_NO_REASON;
+		if (state->skip > 0)          { state->skip -= 1; return (_Unwind_Reason_Code)_URC_NO_REASON; }
+		if (state->current == state->end) return (_Unwind_Reason_Code)_URC_END_OF_STACK;
+		*state->current++ = (void *)pc;
+		return (_Unwind_Reason_Code)_URC_NO_REASON;
+	}, &state);
+	return (int32_t)(state.current - frames);
+}
+
+#endif
+
+///////////////////////////////////////////
+
+static void mem_sample_add(mem_header_t *header) {
+	mem_sample_t sample = {};
+	sample.memory = header + 1;
+	sample.bytes  = header->bytes;
+	sample.site   = header->site;
+	sample.depth  = mem_capture_stack(sample.stack, MEM_STACK_DEPTH);
+
+	mem_lock(&mem_sample_lock);
+	if (mem_sample_count == mem_sample_cap) {
+		int32_t       cap     = mem_sample_cap == 0 ? 256 : mem_sample_cap * 2;
+		mem_sample_t *samples = (mem_sample_t *)realloc(mem_samples, cap * sizeof(mem_sample_t));
+		if (samples == nullptr) mem_fail();
+		mem_samples    = samples;
+		mem_sample_cap = cap;
+	}
+	header->sample = mem_sample_count;
+	mem_samples[mem_sample_count] = sample;
+	mem_sample_count += 1;
+	mem_unlock(&mem_sample_lock);
+}
+
+///////////////////////////////////////////
+
+static void mem_sample_remove(mem_header_t *header) {
+	// Another thread's removal may move this sample, and rewrite its index,
+	// so the index is only trustworthy while the lock is held.
+	mem_lock(&mem_sample_lock);
+	int32_t idx  = header->sample;
+	int32_t last = mem_sample_count - 1;
+	if (idx != last) {
+		mem_samples[idx] = mem_samples[last];
+		((mem_header_t *)mem_samples[idx].memory - 1)->sample = idx;
+	}
+	mem_sample_count = last;
+	header->sample   = -1;
+	mem_unlock(&mem_sample_lock);
+}
+
+///////////////////////////////////////////
+
+static void *mem_track_alloc(mem_header_t *header, size_t bytes, const char *type) {
+	mem_thread_t *thread = mem_thread();
+	uint32_t      site   = mem_site_find(thread, type);
+	header->site   = site;
+	header->sample = -1;
+	header->bytes  = bytes;
+
+	mem_counts_t *counts = &thread->sites[site];
+	counts->allocs      += 1;
+	counts->alloc_bytes += bytes;
+
+	thread->sample_countdown -= 1;
+	if (thread->sample_countdown <= 0) {
+		thread->sample_countdown = mem_next_sample(thread);
+		mem_sample_add(header);
+	}
+	return header + 1;
+}
+
+///////////////////////////////////////////
+
+static void mem_track_free(mem_header_t *header) {
+	if (header->sample >= 0)
+		mem_sample_remove(header);
+
+	mem_counts_t *counts = &mem_thread()->sites[header->site];
+	counts->frees      += 1;
+	counts->free_bytes += header->bytes;
+}
+
+///////////////////////////////////////////
+
+void *sk_malloc_s(size_t bytes, const char *type) {
+	mem_header_t *header = (mem_header_t *)malloc(bytes + sizeof(mem_header_t));
+	if (header == nullptr) mem_fail();
+	return mem_track_alloc(header, bytes, type);
+}
+
+///////////////////////////////////////////
+
+void *sk_calloc_s(size_t bytes, const char *type) {
+	mem_header_t *header = (mem_header_t *)calloc(bytes + sizeof(mem_header_t), 1);
+	if (header == nullptr) mem_fail();
+	return mem_track_alloc(header, bytes, type);
+}
+
+///////////////////////////////////////////
+
+void *sk_realloc_s(void *memory, size_t bytes, const char *type) {
+	if (memory == nullptr) return sk_malloc_s(bytes, type);
+
+	// A reallocation counts as freeing the old size and allocating the new
+	// one, which is exactly the churn this is meant to surface.
+	mem_header_t *header = (mem_header_t *)memory - 1;
+	mem_track_free(header);
+
+	header = (mem_header_t *)realloc(header, bytes + sizeof(mem_header_t));
+	if (header == nullptr) mem_fail();
+	return mem_track_alloc(header, bytes, type);
+}
+
+///////////////////////////////////////////
+
+void *sk_malloc (              size_t bytes) { return sk_malloc_s (bytes,         "raw"); }
+void *sk_calloc (              size_t bytes) { return sk_calloc_s (bytes,         "raw"); }
+void *sk_realloc(void *memory, size_t bytes) { return sk_realloc_s(memory, bytes, "raw"); }
+
+///////////////////////////////////////////
+
+void _sk_free(void *memory) {
+	if (memory == nullptr) return;
+
+	mem_header_t *header = (mem_header_t *)memory - 1;
+	mem_track_free(header);
+	free(header);
+}
+
+///////////////////////////////////////////
+
+void sk_mem_snapshot(sk_mem_snapshot_t *out_snapshot) {
+	mem_lock(&mem_site_lock);
+	int32_t count = mem_site_count;
+	mem_unlock(&mem_site_lock);
+
+	sk_mem_site_t *sites = (sk_mem_site_t *)calloc(count, sizeof(sk_mem_site_t));
+	if (sites == nullptr) mem_fail();
+	for (int32_t i = 0; i < count; i++)
+		sites[i].type = mem_site_types[i];
+
+	mem_lock(&mem_thread_lock);
+	for (mem_thread_t *thread = mem_threads; thread != nullptr; thread = thread->next) {
+		for (int32_t i = 0; i < count; i++) {
+			sites[i].allocs      += thread->sites[i].allocs;
+			sites[i].frees       += thread->sites[i].frees;
+			sites[i].alloc_bytes += thread->sites[i].alloc_bytes;
+			sites[i].free_bytes  += thread->sites[i].free_bytes;
+		}
+	}
+	mem_unlock(&mem_thread_lock);
+
+	*out_snapshot = {};
+	out_snapshot->sites      = sites;
+	out_snapshot->site_count = count;
+	out_snapshot->time       = stm_sec(stm_now());
+}
+
+///////////////////////////////////////////
+
+void sk_mem_snapshot_free(sk_mem_snapshot_t *snapshot) {
+	free(snapshot->sites);
+	*snapshot = {};
+}
+
+///////////////////////////////////////////
+
+struct mem_diff_t {
+	const char *type;
+	int64_t     live_bytes;
+	int64_t     allocs;
+	int64_t     frees;
+};
+
+static int mem_diff_compare(const void *a, const void *b) {
+	const mem_diff_t *da = (const mem_diff_t *)a;
+	const mem_diff_t *db = (const mem_diff_t *)b;
+	int64_t ma = da->live_bytes < 0 ? -da->live_bytes : da->live_bytes;
+	int64_t mb = db->live_bytes < 0 ? -db->live_bytes : db->live_bytes;
+	if (ma != mb) return ma > mb ? -1 : 1;
+	if (da->allocs != db->allocs) return da->allocs > db->allocs ? -1 : 1;
+	return 0;
+}
+
+///////////////////////////////////////////
+
+void sk_mem_log_diff(const sk_mem_snapshot_t *from, const sk_mem_snapshot_t *to) {
+	// Sites are only ever appended, so 'from' is always a prefix of 'to'.
+	mem_diff_t *diffs = (mem_diff_t *)malloc(to->site_count * sizeof(mem_diff_t));
+	if (diffs == nullptr) mem_fail();
+
+	int32_t count       = 0;
+	int64_t total_live  = 0;
+	int64_t total_alloc = 0;
+	int64_t total_free  = 0;
+	for (int32_t i = 0; i < to->site_count; i++) {
+		sk_mem_site_t prev = i < from->site_count ? from->sites[i] : sk_mem_site_t{};
+		const sk_mem_site_t *curr = &to->sites[i];
+		mem_diff_t diff = {};
+		diff.type       = curr->type;
+		diff.allocs     = curr->allocs - prev.allocs;
+		diff.frees      = curr->frees  - prev.frees;
+		diff.live_bytes = (curr->alloc_bytes - curr->free_bytes) - (prev.alloc_bytes - prev.free_bytes);
+		total_live  += diff.live_bytes;
+		total_alloc += diff.allocs;
+		total_free  += diff.frees;
+		if (diff.allocs != 0 || diff.frees != 0)
+			diffs[count++] = diff;
+	}
+	qsort(diffs, count, sizeof(mem_diff_t), mem_diff_compare);
+
+	log_infof("Memory over %.0fs: %+.2fmb live, %lld allocs, %lld frees",
+		to->time - from->time, total_live / (1024.0 * 1024.0), (long long)total_alloc, (long long)total_free);
+	const int32_t show = count < 16 ? count : 16;
+	for (int32_t i = 0; i < show; i++) {
+		log_infof("  %-32s %+10.1fkb live, %8lld allocs, %8lld frees",
+			diffs[i].type, diffs[i].live_bytes / 1024.0, (long long)diffs[i].allocs, (long long)diffs[i].frees);
+	}
+	free(diffs);
+}
+
+///////////////////////////////////////////
+
+void sk_mem_log_changes() {
+	sk_mem_snapshot_t curr;
+	sk_mem_snapshot(&curr);
+	if (mem_last_snapshot.sites != nullptr) {
+		sk_mem_log_diff(&mem_last_snapshot, &curr);
+		sk_mem_snapshot_free(&mem_last_snapshot);
+	}
+	mem_last_snapshot = curr;
+}
+
+///////////////////////////////////////////
+
+static int mem_sample_compare(const void *a, const void *b) {
+	uint64_t ba = ((const mem_sample_t *)a)->bytes;
+	uint64_t bb = ((const mem_sample_t *)b)->bytes;
+	return ba == bb ? 0 : (ba > bb ? -1 : 1);
+}
+
+///////////////////////////////////////////
+
+void sk_mem_log_allocations() {
+	sk_mem_snapshot_t snapshot;
+	sk_mem_snapshot(&snapshot);
+	int64_t total = 0;
+	for (int32_t i = 0; i < snapshot.site_count; i++) {
+		const sk_mem_site_t *site = &snapshot.sites[i];
+		int64_t live = site->alloc_bytes - site->free_bytes;
+		total += live;
+		if (site->allocs != site->frees)
+			log_infof("%-32s %8lld live, %10.1fkb", site->type, (long long)(site->allocs - site->frees), live / 1024.0);
+	}
+	log_infof("Total tracked memory: %.2fmb", total / (1024.0 * 1024.0));
+	sk_mem_snapshot_free(&snapshot);
+
+	// Copy the samples out so logging, which allocates, happens outside the
+	// lock.
+	mem_lock(&mem_sample_lock);
+	int32_t       count   = mem_sample_count;
+	mem_sample_t *samples = (mem_sample_t *)malloc((count > 0 ? count : 1) * sizeof(mem_sample_t));
+	if (samples == nullptr) mem_fail();
+	memcpy(samples, mem_samples, count * sizeof(mem_sample_t));
+	mem_unlock(&mem_sample_lock);
+
+	qsort(samples, count, sizeof(mem_sample_t), mem_sample_compare);
+	const int32_t show = count < 32 ? count : 32;
+	log_infof("%d sampled live allocations, largest %d:", count, show);
+	for (int32_t i = 0; i < show; i++) {
+		log_infof("%s - %lld bytes", mem_site_types[samples[i].site], (long long)samples[i].bytes);
+		for (int32_t f = 0; f < samples[i].depth; f++) {
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+			log_infof("  %p", samples[i].stack[f]);
+#else
+			Dl_info info;
+			if (dladdr(samples[i].stack[f], &info) && info.dli_sname)
+				log_infof("  %p %s+0x%x", samples[i].stack[f], info.dli_sname, (uint32_t)((uint8_t *)samples[i].stack[f] - (uint8_t *)info.dli_saddr));
+			else
+				log_infof("  %p", samples[i].stack[f]);
+#endif
+		}
+	}
+	free(samples);
+}
+
 #else
 
 struct mem_info_t {
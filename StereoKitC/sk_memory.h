@@ -14,7 +14,7 @@
 
 namespace sk {
 
-#if !defined(SK_DEBUG_MEM)
+#if !defined(SK_DEBUG_MEM) && !defined(SK_TRACK_MEM)
 
 // Safer memory allocation functions, will kill the app on failure.
 void *sk_malloc (              size_t bytes);
@@ -28,6 +28,25 @@ void  _sk_free  (void *memory);
 #define sk_malloc_zero_t(T, count) ((T*)sk_calloc((count) * sizeof(T)))
 #define sk_realloc_t(T, memory, count) ((T*)sk_realloc(memory, (count) * sizeof(T)))
 
+#elif defined(SK_TRACK_MEM)
+
+// Release-safe allocation telemetry. Allocations carry a small header, are
+// counted per-thread against the type string they were made with, and a
+// sampled fraction of them record a call stack.
+void *sk_malloc (              size_t bytes);
+void *sk_calloc (              size_t bytes);
+void *sk_realloc(void *memory, size_t bytes);
+void  _sk_free  (void *memory);
+void *sk_malloc_s (              size_t bytes, const char *type);
+void *sk_calloc_s (              size_t bytes, const char *type);
+void *sk_realloc_s(void *memory, size_t bytes, const char *type);
+
+#define sk_free(memory) { _sk_free(memory); memory = nullptr; };
+
+#define sk_malloc_t(T, count) ((T*)sk_malloc_s ((count) * sizeof(T), #T))
+#define sk_malloc_zero_t(T, count) ((T*)sk_calloc_s((count) * sizeof(T), #T))
+#define sk_realloc_t(T, memory, count) ((T*)sk_realloc_s(memory, (count) * sizeof(T), #T))
+
 #else
 
 // Safer memory allocation functions, will kill the app on failure.
@@ -51,6 +70,29 @@ void  _sk_free_d      (void *memory, const char* filename, int32_t line);
 
 void sk_mem_log_allocations();
 
+#if defined(SK_TRACK_MEM)
+
+typedef struct sk_mem_site_t {
+	const char *type;
+	int64_t     allocs;
+	int64_t     frees;
+	int64_t     alloc_bytes;
+	int64_t     free_bytes;
+} sk_mem_site_t;
+
+typedef struct sk_mem_snapshot_t {
+	sk_mem_site_t *sites;
+	int32_t        site_count;
+	double         time;
+} sk_mem_snapshot_t;
+
+void sk_mem_snapshot     (sk_mem_snapshot_t *out_snapshot);
+void sk_mem_snapshot_free(sk_mem_snapshot_t *snapshot);
+void sk_mem_log_diff     (const sk_mem_snapshot_t *from, const sk_mem_snapshot_t *to);
+void sk_mem_log_changes  ();
+
+#endif
+
 #pragma warning(disable : 6255) // _alloca` indicates failure by raising a stack overflow exception. Consider using _malloca instead.
 #define sk_stack_alloc(bytes) (alloca(bytes))
 #define sk_stack_alloc_t(T, count) ((T*)sk_stack_alloc ((count) * sizeof(T)))
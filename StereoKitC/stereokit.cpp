@@ -11,6 +11,7 @@
 #include "libraries/sokol_time.h"
 #include "libraries/ferr_thread.h"
 #include "utils/random.h"
+#include "utils/frame_arena.h"
 
 #include "systems/render.h"
 #include "systems/input.h"
@@ -22,6 +23,7 @@
 #include "systems/line_drawer.h"
 #include "systems/world.h"
 #include "systems/defaults.h"
+#include "systems/parallel.h"
 #include "asset_types/animation.h"
 #include "platforms/_platform.h"
 #include "platforms/web.h"
@@ -183,8 +185,13 @@ bool32_t sk_init(sk_settings_t settings) {
 	sys_renderer.func_shutdown   = render_shutdown;
 	systems_add(&sys_renderer);
 
+	system_t sys_parallel = { "Parallel" };
+	sys_parallel.func_initialize = parallel_init;
+	sys_parallel.func_shutdown   = parallel_shutdown;
+	systems_add(&sys_parallel);
+
 	system_t sys_assets = { "Assets" };
-	system_set_initialize_deps(sys_assets, "Platform");
+	system_set_initialize_deps(sys_assets, "Platform", "Parallel");
 	system_set_step_deps      (sys_assets, "FrameRender");
 	sys_assets.func_initialize       = assets_init;
 	sys_assets.func_step             = assets_step;
@@ -247,7 +254,8 @@ bool32_t sk_init(sk_settings_t settings) {
 	systems_add(&sys_tools);
 
 	system_t sys_anim = { "Animation" };
-	system_set_step_deps(sys_anim, "App");
+	system_set_initialize_deps(sys_anim, "Parallel");
+	system_set_step_deps      (sys_anim, "App");
 	sys_anim.func_step     = anim_step;
 	sys_anim.func_shutdown = anim_shutdown;
 	systems_add(&sys_anim);
@@ -290,6 +298,7 @@ void sk_shutdown_unsafe(void) {
 	log_show_any_fail_reason();
 
 	systems_shutdown();
+	frame_arena_shutdown();
 	sk_mem_log_allocations();
 	log_clear_subscribers();
 
@@ -324,6 +333,7 @@ void sk_first_step() {
 void sk_step_begin() {
 	local.in_step = true;
 	sk_step_timer();
+	frame_arena_step();
 	systems_step_partial(system_run_before, local.app_system_idx);
 	local.app_system->profile_frame_start = stm_now();
 }
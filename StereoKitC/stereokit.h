@@ -656,6 +656,8 @@ static inline vec3     vec3_abs         (vec3 a) { vec3 v = { fabsf(a.x), fabsf(
 static inline vec2     vec2_abs         (vec2 a) { vec2 v = { fabsf(a.x), fabsf(a.y) }; return v; }
 static inline vec3     vec3_min         (vec3 a, vec3 b)          { vec3 v = { fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z) }; return v; }
 static inline vec2     vec2_min         (vec2 a, vec2 b)          { vec2 v = { fminf(a.x, b.x), fminf(a.y, b.y) }; return v; }
+static inline vec3     vec3_max         (vec3 a, vec3 b)          { vec3 v = { fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z) }; return v; }
+static inline vec2     vec2_max         (vec2 a, vec2 b)          { vec2 v = { fmaxf(a.x, b.x), fmaxf(a.y, b.y) }; return v; }
 static inline vec3     vec3_lerp        (vec3 a, vec3 b, float t) { vec3 v = { a.x + (b.x - a.x)*t, a.y + (b.y - a.y)*t, a.z + (b.z - a.z)*t }; return v; }
 static inline vec2     vec2_lerp        (vec2 a, vec2 b, float t) { vec2 v = { a.x + (b.x - a.x)*t, a.y + (b.y - a.y)*t }; return v; }
 static inline bool32_t vec3_in_radius   (vec3 pt, vec3 center, float radius) { return vec3_distance_sq(center, pt) < radius*radius; }
@@ -750,6 +752,12 @@ SK_DeclarePrivateType(sprite_t);
 SK_DeclarePrivateType(sound_t);
 SK_DeclarePrivateType(solid_t);
 SK_DeclarePrivateType(anchor_t);
+SK_DeclarePrivateType(point_cloud_t);
+
+/*Identifies a GPU upload queued by one of the `_async` update functions.
+  Check on it with `assets_fence_finished`, or wait for it with
+  `assets_fence_wait`. A fence of 0 has always finished.*/
+typedef uint64_t asset_fence_t;
 
 ///////////////////////////////////////////
 
@@ -817,6 +825,27 @@ typedef enum cull_ {
 	cull_none,
 } cull_;
 
+/*Ways mesh_optimize can reorder a Mesh's data to make it faster for
+  the GPU to draw. These can be combined as bit-flags.*/
+typedef enum mesh_optimize_ {
+	/*Leave the Mesh data as-is.*/
+	mesh_optimize_none            = 0,
+	/*Reorders triangles so vertices already transformed by the GPU
+	  get re-used as much as possible, reducing vertex shader work.*/
+	mesh_optimize_vertex_cache    = 1 << 0,
+	/*Moves clusters of outward facing triangles earlier, so they're
+	  more likely to occlude the rest of the Mesh. This keeps the
+	  vertex cache benefits of the previous step.*/
+	mesh_optimize_overdraw        = 1 << 1,
+	/*Reorders vertices in the order the triangles first use them, and
+	  removes unused vertices, so fetching vertex data walks through
+	  memory in order. This is skipped for skinned Meshes.*/
+	mesh_optimize_vertex_fetch    = 1 << 2,
+	/*All of the above.*/
+	mesh_optimize_all             = mesh_optimize_vertex_cache | mesh_optimize_overdraw | mesh_optimize_vertex_fetch,
+} mesh_optimize_;
+SK_MakeFlag(mesh_optimize_);
+
 SK_API mesh_t      mesh_find            (const char *name);
 SK_API mesh_t      mesh_create          (void);
 SK_API mesh_t      mesh_copy            (mesh_t mesh);
@@ -827,8 +856,12 @@ SK_API void        mesh_release         (mesh_t mesh);
 SK_API void        mesh_draw            (mesh_t mesh, material_t material, matrix transform, color128 color_linear sk_default({1,1,1,1}), render_layer_ layer sk_default(render_layer_0));
 SK_API void        mesh_set_keep_data   (mesh_t mesh, bool32_t keep_data);
 SK_API bool32_t    mesh_get_keep_data   (mesh_t mesh);
+SK_API void        mesh_set_keep_verts  (mesh_t mesh, bool32_t keep_verts);
+SK_API bool32_t    mesh_get_keep_verts  (mesh_t mesh);
 SK_API void        mesh_set_data        (mesh_t mesh, const vert_t *in_arr_vertices, int32_t vertex_count, const vind_t *in_arr_indices, int32_t index_count, bool32_t calculate_bounds sk_default(true));
+SK_API asset_fence_t mesh_set_data_async(mesh_t mesh, const vert_t *in_arr_vertices, int32_t vertex_count, const vind_t *in_arr_indices, int32_t index_count, bool32_t calculate_bounds sk_default(true));
 SK_API void        mesh_set_verts       (mesh_t mesh, const vert_t *in_arr_vertices, int32_t vertex_count, bool32_t calculate_bounds sk_default(true));
+SK_API void        mesh_set_verts_range (mesh_t mesh, int32_t vertex_start, const vert_t *in_arr_vertices, int32_t vertex_count, bool32_t calculate_bounds sk_default(true));
 SK_API void        mesh_get_verts       (mesh_t mesh, sk_ref_arr(vert_t) out_arr_vertices, sk_ref(int32_t) out_vertex_count, memory_ reference_mode);
 SK_API int32_t     mesh_get_vert_count  (mesh_t mesh);
 SK_API void        mesh_set_inds        (mesh_t mesh, const vind_t *in_arr_indices, int32_t index_count);
@@ -838,12 +871,16 @@ SK_API void        mesh_set_draw_inds   (mesh_t mesh, int32_t index_count);
 SK_API void        mesh_set_bounds      (mesh_t mesh, const sk_ref(bounds_t) bounds);
 SK_API bounds_t    mesh_get_bounds      (mesh_t mesh);
 SK_API bool32_t    mesh_has_skin        (mesh_t mesh);
+SK_API void        mesh_optimize        (mesh_t mesh, mesh_optimize_ flags sk_default(mesh_optimize_all));
 SK_API void        mesh_set_skin        (mesh_t mesh, const uint16_t *in_arr_bone_ids_4, int32_t bone_id_4_count, const vec4 *in_arr_bone_weights, int32_t bone_weight_count, const matrix *bone_resting_transforms, int32_t bone_count);
 SK_API void        mesh_update_skin     (mesh_t mesh, const matrix *in_arr_bone_transforms, int32_t bone_count);
 // TODO: in 0.4 move cull_mode parameter up to directly after out_pt (both functions)
 SK_API bool32_t    mesh_ray_intersect   (mesh_t mesh, ray_t model_space_ray, ray_t* out_pt, uint32_t* out_start_inds sk_default(nullptr), cull_ cull_mode sk_default(cull_back));
 SK_API bool32_t    mesh_ray_intersect_bvh(mesh_t mesh, ray_t model_space_ray, ray_t* out_pt, uint32_t* out_start_inds sk_default(nullptr), cull_ cull_mode sk_default(cull_back));
 SK_API bool32_t    mesh_get_triangle    (mesh_t mesh, uint32_t triangle_index, vert_t* out_a, vert_t* out_b, vert_t* out_c);
+SK_API bool32_t    mesh_closest_point   (mesh_t mesh, vec3 model_space_pt, float max_distance, ray_t* out_pt, vec3* out_barycentric sk_default(nullptr), uint32_t* out_start_inds sk_default(nullptr));
+SK_API bool32_t    mesh_sphere_intersect(mesh_t mesh, sphere_t model_space_sphere, ray_t* out_pt, vec3* out_barycentric sk_default(nullptr), uint32_t* out_start_inds sk_default(nullptr));
+SK_API bool32_t    mesh_capsule_intersect(mesh_t mesh, vec3 model_space_pt1, vec3 model_space_pt2, float radius, ray_t* out_pt, vec3* out_barycentric sk_default(nullptr), uint32_t* out_start_inds sk_default(nullptr));
 
 SK_API mesh_t      mesh_gen_plane       (vec2 dimensions, vec3 plane_normal, vec3 plane_top_direction, int32_t subdivisions sk_default(0), bool32_t double_sided sk_default(false));
 SK_API mesh_t      mesh_gen_circle      (float diameter,  vec3 plane_normal, vec3 plane_top_direction, int32_t spokes sk_default(16), bool32_t double_sided sk_default(false));
@@ -999,6 +1036,54 @@ typedef enum tex_format_ {
 	/*A double channel of data that supports 8 bits for the red
 	  channel and 8 bits for the green channel.*/
 	tex_format_r8g8 = 19,
+	/*BC1 block compression, 4 bits per-pixel of sRGB color
+	  with 1 bit alpha. These formats are usually loaded from KTX2 or
+	  DDS files, and are decoded to rgba32 on the CPU if the GPU can't
+	  use them directly.*/
+	tex_format_bc1_rgba = 20,
+	/*BC1 block compression with linear color, see
+	  tex_format_bc1_rgba.*/
+	tex_format_bc1_rgba_linear = 21,
+	/*BC3 block compression, 8 bits per-pixel of sRGB color
+	  with smooth alpha.*/
+	tex_format_bc3_rgba = 22,
+	/*BC3 block compression with linear color, see
+	  tex_format_bc3_rgba.*/
+	tex_format_bc3_rgba_linear = 23,
+	/*BC4 block compression, a single 4 bit per-pixel channel.*/
+	tex_format_bc4_r = 24,
+	/*BC5 block compression, two channels at 8 bits per-pixel.
+	  This is a common choice for normal maps.*/
+	tex_format_bc5_rg = 25,
+	/*BC7 block compression, 8 bits per-pixel of high quality
+	  sRGB color and alpha.*/
+	tex_format_bc7_rgba = 26,
+	/*BC7 block compression with linear color, see
+	  tex_format_bc7_rgba.*/
+	tex_format_bc7_rgba_linear = 27,
+	/*ETC2 block compression, 4 bits per-pixel of sRGB color
+	  without alpha. This is the common format for mobile GPUs.*/
+	tex_format_etc2_rgb = 28,
+	/*ETC2 block compression with linear color, see
+	  tex_format_etc2_rgb.*/
+	tex_format_etc2_rgb_linear = 29,
+	/*ETC2 block compression with EAC alpha, 8 bits per-pixel
+	  of sRGB color and alpha.*/
+	tex_format_etc2_rgba = 30,
+	/*ETC2 with EAC alpha and linear color, see
+	  tex_format_etc2_rgba.*/
+	tex_format_etc2_rgba_linear = 31,
+	/*EAC block compression, a single 4 bit per-pixel channel.*/
+	tex_format_etc2_r11 = 32,
+	/*EAC block compression, two channels at 8 bits per-pixel.*/
+	tex_format_etc2_rg11 = 33,
+	/*ASTC 4x4 block compression, 8 bits per-pixel of sRGB
+	  color and alpha. StereoKit can't decode this one on the CPU, so
+	  it's only usable where the GPU supports it.*/
+	tex_format_astc4x4_rgba = 34,
+	/*ASTC 4x4 block compression with linear color, see
+	  tex_format_astc4x4_rgba.*/
+	tex_format_astc4x4_rgba_linear = 35,
 
 } tex_format_;
 
@@ -1061,6 +1146,8 @@ SK_API void         tex_on_load             (tex_t texture, void (*asset_on_load
 SK_API void         tex_on_load_remove      (tex_t texture, void (*asset_on_load_callback)(tex_t texture, void *context));
 SK_API void         tex_set_colors          (tex_t texture, int32_t width, int32_t height, void *data);
 SK_API void         tex_set_color_arr       (tex_t texture, int32_t width, int32_t height, void** data, int32_t data_count, spherical_harmonics_t *out_sh_lighting_info sk_default(nullptr), int32_t multisample sk_default(1));
+SK_API asset_fence_t tex_set_colors_async    (tex_t texture, int32_t width, int32_t height, void *data);
+SK_API asset_fence_t tex_set_color_arr_async (tex_t texture, int32_t width, int32_t height, void** data, int32_t data_count);
 SK_API void         tex_set_mem             (tex_t texture, void* data, size_t data_size, bool32_t srgb_data sk_default(true), bool32_t blocking sk_default(false), int32_t priority sk_default(10));
 // TODO: For v0.4, remove the return value here, since this needs to addref, and the texture may be ignored
 SK_API tex_t        tex_add_zbuffer         (tex_t texture, tex_format_ format sk_default(tex_format_depthstencil));
@@ -1082,6 +1169,10 @@ SK_API tex_address_ tex_get_address         (tex_t texture);
 SK_API void         tex_set_anisotropy      (tex_t texture, int32_t anisotropy_level sk_default(4));
 SK_API int32_t      tex_get_anisotropy      (tex_t texture);
 SK_API int32_t      tex_get_mips            (tex_t texture);
+SK_API void         tex_set_memory_budget   (uint64_t budget_bytes);
+SK_API uint64_t     tex_get_memory_budget   (void);
+SK_API void         tex_set_max_resolution  (int32_t max_size);
+SK_API int32_t      tex_get_max_resolution  (void);
 SK_API void         tex_set_loading_fallback(tex_t loading_texture);
 SK_API void         tex_set_error_fallback  (tex_t error_texture);
 SK_API spherical_harmonics_t tex_get_cubemap_lighting(tex_t cubemap_texture);
@@ -1439,6 +1530,10 @@ SK_API model_t       model_create                  (void);
 SK_API model_t       model_create_mesh             (mesh_t mesh, material_t material);
 SK_API model_t       model_create_mem              (const char *filename_utf8, void *data, size_t data_size, shader_t shader sk_default(nullptr));
 SK_API model_t       model_create_file             (const char *filename_utf8, shader_t shader sk_default(nullptr));
+SK_API void          model_set_load_optimize       (mesh_optimize_ flags);
+SK_API mesh_optimize_ model_get_load_optimize      (void);
+SK_API void          model_set_load_cache          (bool32_t enabled, const char *cache_folder_utf8 sk_default(nullptr));
+SK_API bool32_t      model_get_load_cache          (void);
 SK_API void          model_set_id                  (model_t model, const char *id);
 SK_API const char*   model_get_id                  (const model_t model);
 SK_API void          model_addref                  (model_t model);
@@ -1453,6 +1548,9 @@ SK_API bool32_t      model_ray_intersect           (model_t model, ray_t model_s
 SK_API bool32_t      model_ray_intersect_bvh       (model_t model, ray_t model_space_ray, ray_t *out_pt, cull_ cull_mode sk_default(cull_back));
 // TODO: in 0.4 move cull_mode parameter up to directly after out_pt
 SK_API bool32_t      model_ray_intersect_bvh_detailed(model_t model, ray_t model_space_ray, ray_t *out_pt, mesh_t *out_mesh sk_default(nullptr), matrix *out_matrix sk_default(nullptr), uint32_t* out_start_inds sk_default(nullptr), cull_ cull_mode sk_default(cull_back));
+SK_API bool32_t      model_closest_point           (model_t model, vec3 model_space_pt, float max_distance, ray_t *out_pt, mesh_t *out_mesh sk_default(nullptr), matrix *out_matrix sk_default(nullptr), uint32_t* out_start_inds sk_default(nullptr), vec3* out_barycentric sk_default(nullptr));
+SK_API bool32_t      model_sphere_intersect        (model_t model, sphere_t model_space_sphere, ray_t *out_pt, mesh_t *out_mesh sk_default(nullptr), matrix *out_matrix sk_default(nullptr), uint32_t* out_start_inds sk_default(nullptr), vec3* out_barycentric sk_default(nullptr));
+SK_API bool32_t      model_capsule_intersect       (model_t model, vec3 model_space_pt1, vec3 model_space_pt2, float radius, ray_t *out_pt, mesh_t *out_mesh sk_default(nullptr), matrix *out_matrix sk_default(nullptr), uint32_t* out_start_inds sk_default(nullptr), vec3* out_barycentric sk_default(nullptr));
 
 SK_API void          model_step_anim               (model_t model);
 SK_API bool32_t      model_play_anim               (model_t model, const char *animation_name, anim_mode_ mode);
@@ -1517,6 +1615,30 @@ SK_API bool32_t      model_node_info_iterate       (model_t model, model_node_id
 
 ///////////////////////////////////////////
 
+/*A single point in a PointCloud. This is kept small, as
+  clouds can easily run into hundreds of millions of points.*/
+typedef struct cloud_point_t {
+	vec3    pos;
+	color32 color;
+} cloud_point_t;
+
+SK_API point_cloud_t point_cloud_find            (const char *id);
+SK_API point_cloud_t point_cloud_create_file     (const char *filename_utf8);
+SK_API void          point_cloud_set_id          (point_cloud_t cloud, const char *id);
+SK_API const char*   point_cloud_get_id          (const point_cloud_t cloud);
+SK_API void          point_cloud_addref          (point_cloud_t cloud);
+SK_API void          point_cloud_release         (point_cloud_t cloud);
+SK_API asset_state_  point_cloud_asset_state     (const point_cloud_t cloud);
+SK_API bounds_t      point_cloud_get_bounds      (const point_cloud_t cloud);
+SK_API int64_t       point_cloud_get_point_count (const point_cloud_t cloud);
+SK_API void          point_cloud_set_point_budget(point_cloud_t cloud, int32_t max_points);
+SK_API int32_t       point_cloud_get_point_budget(const point_cloud_t cloud);
+SK_API void          point_cloud_set_max_error   (point_cloud_t cloud, float max_error_pixels);
+SK_API float         point_cloud_get_max_error   (const point_cloud_t cloud);
+SK_API void          point_cloud_draw            (point_cloud_t cloud, matrix transform, color128 color_linear sk_default({1,1,1,1}), render_layer_ layer sk_default(render_layer_0));
+
+///////////////////////////////////////////
+
 /*The way the Sprite is stored on the backend! Does it get
   batched and atlased for draw efficiency, or is it a single image?*/
 typedef enum sprite_type_ {
@@ -2402,10 +2524,58 @@ typedef enum asset_type_ {
 	asset_type_solid,
 	/*An Anchor.*/
 	asset_type_anchor,
+	/*A PointCloud asset.*/
+	asset_type_point_cloud,
 } asset_type_;
 
 typedef void* asset_t;
 
+/*How much GPU upload work the asset system has waiting, and how much of
+  it was done during the last frame.*/
+typedef struct assets_upload_stats_t {
+	/*Uploads that are waiting on the main thread.*/
+	int32_t  jobs_queued;
+	/*Estimated size of the waiting uploads, in bytes. Not every upload
+	  knows its size, so this can be an undercount.*/
+	uint64_t bytes_queued;
+	/*Uploads that finished during the last frame.*/
+	int32_t  jobs_done;
+	/*Bytes uploaded during the last frame.*/
+	uint64_t bytes_done;
+	/*Milliseconds the last frame spent on uploads.*/
+	float    frame_ms;
+} assets_upload_stats_t;
+
+/*How much memory a single asset is using, from
+  `assets_memory_report`. Assets that refer to other assets, like a Model's
+  Meshes or a Font's Tex, don't include them, since those report their own.*/
+typedef struct asset_memory_t {
+	/*The asset this is about. This doesn't hold a reference, so it's only
+	  safe to use until the asset is released.*/
+	asset_t     asset;
+	/*What type of asset this is.*/
+	asset_type_ type;
+	/*System memory the asset holds onto, like kept vertex data, collision
+	  data, decoded audio or animation data.*/
+	uint64_t    cpu_bytes;
+	/*Estimated GPU memory, like vertex and index buffers, texture mips and
+	  multisample surfaces.*/
+	uint64_t    gpu_bytes;
+} asset_memory_t;
+
+/*What content deduplication has saved so far, see
+  `assets_set_dedup`.*/
+typedef struct assets_dedup_stats_t {
+	/*Meshes that were shared instead of being created again.*/
+	int32_t  mesh_hits;
+	/*Textures that were shared instead of being created again.*/
+	int32_t  tex_hits;
+	/*Source data that didn't need to be decoded or uploaded again. This is
+	  vertex and index data for meshes, and encoded image data for
+	  textures.*/
+	uint64_t bytes_saved;
+} assets_dedup_stats_t;
+
 SK_API void        assets_releaseref_threadsafe(void *asset);
 SK_API int32_t     assets_current_task         (void);
 SK_API int32_t     assets_total_tasks          (void);
@@ -2414,6 +2584,18 @@ SK_API void        assets_block_for_priority   (int32_t priority);
 SK_API int32_t     assets_count                (void);
 SK_API asset_t     assets_get_index            (int32_t index);
 SK_API asset_type_ assets_get_type             (int32_t index);
+SK_API bool32_t    assets_mount_pack           (const char* pack_filename_utf8);
+SK_API bool32_t    assets_unmount_pack         (const char* pack_filename_utf8);
+SK_API void        assets_set_upload_budget    (float milliseconds);
+SK_API float       assets_get_upload_budget    (void);
+SK_API assets_upload_stats_t assets_get_upload_stats(void);
+SK_API bool32_t    assets_fence_finished       (asset_fence_t fence);
+SK_API void        assets_fence_wait           (asset_fence_t fence);
+SK_API void        assets_set_dedup            (bool32_t enabled);
+SK_API bool32_t    assets_get_dedup            (void);
+SK_API assets_dedup_stats_t assets_get_dedup_stats(void);
+SK_API int32_t     assets_memory_report        (asset_memory_t *out_arr_report, int32_t report_capacity);
+SK_API void        assets_memory_totals        (asset_type_ type, uint64_t *out_cpu_bytes, uint64_t *out_gpu_bytes);
 
 SK_API asset_type_ asset_get_type(asset_t asset);
 SK_API void        asset_set_id  (asset_t asset, const char* id);
@@ -2465,6 +2647,7 @@ SK_CONST char *default_id_shader_ui_quadrant   = "default/shader_ui_quadrant";
 SK_CONST char *default_id_shader_ui_aura       = "default/shader_ui_aura";
 SK_CONST char *default_id_shader_sky           = "default/shader_sky";
 SK_CONST char *default_id_shader_lines         = "default/shader_lines";
+SK_CONST char *default_id_shader_points        = "default/shader_points";
 SK_CONST char *default_id_sound_click          = "default/sound_click";
 SK_CONST char *default_id_sound_unclick        = "default/sound_unclick";
 SK_CONST char *default_id_sound_grab           = "default/sound_grab";
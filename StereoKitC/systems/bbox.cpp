@@ -1,5 +1,7 @@
 #include "bbox.h"
 
+#include <math.h>
+
 namespace sk {
 
 // Update the bounding box to include the point p
@@ -130,5 +132,63 @@ bbox_intersect(const boundingbox& bbox, bbox_ray_t r, float t0, float t1)
 
     return (tmin < t1 && tmax > t0);
 }
+
+// Return the squared distance from point p to the given bounding box
+
+float
+bbox_distance_sq(const boundingbox& bbox, vec3 p)
+{
+    const vec3* bounds = bbox.bounds;
+
+    float dx = fmaxf(fmaxf(bounds[0].x - p.x, 0.0f), p.x - bounds[1].x);
+    float dy = fmaxf(fmaxf(bounds[0].y - p.y, 0.0f), p.y - bounds[1].y);
+    float dz = fmaxf(fmaxf(bounds[0].z - p.z, 0.0f), p.z - bounds[1].z);
+
+    return dx*dx + dy*dy + dz*dz;
+}
+
+// Intersect the segment p1-p2 with the bounding box grown by margin.
+// Slab test on the segment's 0..1 parameter range. A bbox grown by a
+// radius r contains every point within r of the original bbox, so this
+// is a conservative test for capsule vs. bbox overlap.
+
+bool
+bbox_segment_intersect(const boundingbox& bbox, vec3 p1, vec3 p2, float margin)
+{
+    const vec3 bmin = bbox.bounds[0] - vec3{margin, margin, margin};
+    const vec3 bmax = bbox.bounds[1] + vec3{margin, margin, margin};
+    const vec3 d    = p2 - p1;
+
+    float tmin = 0.0f;
+    float tmax = 1.0f;
+
+    const float o [3] = { p1.x,   p1.y,   p1.z   };
+    const float dd[3] = { d.x,    d.y,    d.z    };
+    const float lo[3] = { bmin.x, bmin.y, bmin.z };
+    const float hi[3] = { bmax.x, bmax.y, bmax.z };
+
+    for (int a = 0; a < 3; a++)
+    {
+        if (fabsf(dd[a]) < C_EPSILON)
+        {
+            // Segment parallel to this slab, reject when outside it
+            if (o[a] < lo[a] || o[a] > hi[a])
+                return false;
+            continue;
+        }
+
+        float inv = 1.0f / dd[a];
+        float t0  = (lo[a] - o[a]) * inv;
+        float t1  = (hi[a] - o[a]) * inv;
+        if (t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+
+        if (t0 > tmin) tmin = t0;
+        if (t1 < tmax) tmax = t1;
+        if (tmin > tmax)
+            return false;
+    }
+
+    return true;
+}
     
 } // namespace sk
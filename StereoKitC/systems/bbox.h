@@ -109,4 +109,13 @@ bool bbox_intersect(const boundingbox& bbox, bbox_ray_t r, float t0, float t1);
 // returns 0 otherwise
 bool bbox_intersect_full(const boundingbox& bbox, float& t_min, float& t_max, bbox_ray_t r, float t0, float t1);
 
+// Return the squared distance from point p to the given bounding box,
+// which is 0 when p is inside the bbox
+float bbox_distance_sq(const boundingbox& bbox, vec3 p);
+
+// Intersect the line segment p1-p2 with the given bounding box, after
+// growing the bbox by margin on all sides. Returns true when the segment
+// touches the grown bbox, returns false otherwise
+bool bbox_segment_intersect(const boundingbox& bbox, vec3 p1, vec3 p2, float margin);
+
 } // namespace sk
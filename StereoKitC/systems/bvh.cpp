@@ -112,16 +112,18 @@ mesh_bvh_statistics(const mesh_bvh_t *bvh, bvh_stats_t *stats, int acc_leaf_size
 // which are specified as a sub-sequence of sorted_triangles, 
 // i.e. sorted_triangles[first..first+count-1]
 static void
-bound_triangles(boundingbox& bbox, const uint32_t *sorted_triangles, const vec3 *triangle_vertices, int first, int count)
+bound_triangles(boundingbox& bbox, const uint32_t *sorted_triangles, const mesh_collision_t *collision_data, int first, int count)
 {
     bbox_clear(bbox);
 
+    const vec3   *pts  = collision_data->pts;
+    const vind_t *inds = collision_data->inds;
     for (int t = first; t < first+count; t++)
     {
-        const vec3 *p = &triangle_vertices[3*sorted_triangles[t]];
-        bbox_update(bbox, p[0]);
-        bbox_update(bbox, p[1]);
-        bbox_update(bbox, p[2]);
+        const vind_t *tri = &inds[3*sorted_triangles[t]];
+        bbox_update(bbox, pts[tri[0]]);
+        bbox_update(bbox, pts[tri[1]]);
+        bbox_update(bbox, pts[tri[2]]);
     }
 
     // Safety margin
@@ -153,7 +155,7 @@ mesh_bvh_build_recursive(int current_node_index,
     bvh_node_t *nodes, uint32_t *next_node_index,
     uint32_t *sorted_triangles,
     int acceptable_leaf_size, 
-    const vec3* triangle_vertices, const vec3* triangle_centroids, 
+    const vec3* triangle_centroids, 
     const mesh_collision_t *collision_data)
 {
     vec3        bbox_size, bbox_center;
@@ -278,8 +280,8 @@ mesh_bvh_build_recursive(int current_node_index,
 
         // Triangles are now split into two groups, determine bboxes for each.    
 
-        bound_triangles(left_bbox, sorted_triangles, triangle_vertices, node.leaf_first, num_triangles_left);
-        bound_triangles(right_bbox, sorted_triangles, triangle_vertices, l, num_triangles_right);
+        bound_triangles(left_bbox, sorted_triangles, collision_data, node.leaf_first, num_triangles_left);
+        bound_triangles(right_bbox, sorted_triangles, collision_data, l, num_triangles_right);
 
 #ifdef VERBOSE_BUILD
         printf("left bbox:  %.6f, %.6f, %.6f .. %.6f, %.6f, %.6f\n",
@@ -313,9 +315,9 @@ mesh_bvh_build_recursive(int current_node_index,
         // XXX Could check for leaf size here and only recurse when needed, instead of
         // doing the check in build_recursive()
         mesh_bvh_build_recursive(left_child_index, nodes, next_node_index, sorted_triangles, acceptable_leaf_size, 
-            triangle_vertices, triangle_centroids, collision_data);
+            triangle_centroids, collision_data);
         mesh_bvh_build_recursive(right_child_index, nodes, next_node_index, sorted_triangles, acceptable_leaf_size, 
-            triangle_vertices, triangle_centroids, collision_data);
+            triangle_centroids, collision_data);
 
         return;
     }
@@ -373,7 +375,7 @@ mesh_bvh_create(const mesh_t mesh, int acc_leaf_size, bool show_stats)
     // on top of the array mentioned above.
     //
     // Instead, we leverage the existing mesh collision data, which provides
-    // an array of triangle vertices, to precompute triangle centroids, which
+    // indexed triangle positions, to precompute triangle centroids, which
     // are then used during BVH construction. Whenever a bounding box of a 
     // group of triangles is needed this is computed on-the-fly.
 
@@ -387,15 +389,14 @@ mesh_bvh_create(const mesh_t mesh, int acc_leaf_size, bool show_stats)
     // Compute triangle centroids, used during construction to partition
     // triangles in two groups
 
-    const uint32_t num_triangles = mesh->ind_count / 3;
+    const uint32_t num_triangles = bvh->collision_data->ind_count / 3;
 
-    const vec3* triangle_vertices = bvh->collision_data->pts;
     vec3* triangle_centroids = sk_malloc_t(vec3, num_triangles);
     
     for (uint32_t t = 0; t < num_triangles; t++) {
-        triangle_centroids[t] = 0.33333f * (
-            triangle_vertices[3*t+0] + triangle_vertices[3*t+1] + triangle_vertices[3*t+2]
-        );
+        vec3 a, b, c;
+        mesh_collision_triangle(bvh->collision_data, 3*t, &a, &b, &c);
+        triangle_centroids[t] = 0.33333f * (a + b + c);
     }
 
 #ifdef VERBOSE_BUILD
@@ -420,7 +421,7 @@ mesh_bvh_create(const mesh_t mesh, int acc_leaf_size, bool show_stats)
     // Compute mesh bounding box (could reuse what's in mesh_t, but not sure it's accurate)
 
     boundingbox mesh_bbox;
-    bound_triangles(mesh_bbox, sorted_triangles, triangle_vertices, 0, num_triangles-1);
+    bound_triangles(mesh_bbox, sorted_triangles, bvh->collision_data, 0, num_triangles);
 
 #ifdef VERBOSE_BUILD
     printf("bvh_build():\n");
@@ -454,7 +455,7 @@ mesh_bvh_create(const mesh_t mesh, int acc_leaf_size, bool show_stats)
     // Build the BVH
 
     mesh_bvh_build_recursive(0, nodes, &next_node_index, sorted_triangles,
-        acc_leaf_size, triangle_vertices, triangle_centroids, bvh->collision_data);
+        acc_leaf_size, triangle_centroids, bvh->collision_data);
 
 #if defined(VERBOSE_STATS)
     const double t1 = time_get_raw();
@@ -480,7 +481,7 @@ mesh_bvh_create(const mesh_t mesh, int acc_leaf_size, bool show_stats)
 
     // Clean up
 
-    free(triangle_centroids);
+    sk_free(triangle_centroids);
 
     return bvh;
 }
@@ -488,11 +489,19 @@ mesh_bvh_create(const mesh_t mesh, int acc_leaf_size, bool show_stats)
 void
 mesh_bvh_destroy(mesh_bvh_t *bvh)
 {
-    free(bvh->nodes);
-    free(bvh->sorted_triangles);
+    sk_free(bvh->nodes);
+    sk_free(bvh->sorted_triangles);
     *bvh = {};
 }
 
+size_t
+mesh_bvh_memory(const mesh_bvh_t *bvh)
+{
+    // Nodes are allocated for the worst case of two per triangle
+    size_t num_triangles = bvh->collision_data->ind_count / 3;
+    return sizeof(mesh_bvh_t) + num_triangles * (sizeof(uint32_t) + 2 * sizeof(bvh_node_t));
+}
+
 // Find closest triangle intersection for the given model-space ray
 bool
 mesh_bvh_intersect(const mesh_bvh_t *bvh, ray_t model_space_ray, ray_t *out_pt, uint32_t *out_start_inds, cull_ cull_mode)
@@ -620,7 +629,9 @@ mesh_bvh_intersect(const mesh_bvh_t *bvh, ray_t model_space_ray, ray_t *out_pt,
             for (uint32_t t = node.leaf_first; t < node.leaf_first+node.num_triangles; t++)
             {
                 uint32_t triangle = sorted_triangles[t];
-                const plane_t& plane = collision_data->planes[triangle];
+                vec3 a, b, c;
+                mesh_collision_triangle(collision_data, 3*triangle, &a, &b, &c);
+                const plane_t plane = mesh_collision_plane(a, b, c);
 
                 // Inline version of plane_ray_intersect(), as we need the t value
                 // XXX use cull_mode value based on dot denom
@@ -653,9 +664,9 @@ mesh_bvh_intersect(const mesh_bvh_t *bvh, ray_t model_space_ray, ray_t *out_pt,
                 // https://blackpawn.com/texts/pointinpoly/default.html
 
                 // Compute vectors
-                vec3 v0 = collision_data->pts[3*triangle+1] - collision_data->pts[3*triangle+0];
-                vec3 v1 = collision_data->pts[3*triangle+2] - collision_data->pts[3*triangle+0];
-                vec3 v2 = pt - collision_data->pts[3*triangle+0];
+                vec3 v0 = b  - a;
+                vec3 v1 = c  - a;
+                vec3 v2 = pt - a;
 
                 // Compute dot products
                 float dot00 = vec3_dot(v0, v0);
@@ -681,7 +692,7 @@ mesh_bvh_intersect(const mesh_bvh_t *bvh, ray_t model_space_ray, ray_t *out_pt,
                         if (out_start_inds != nullptr) {
                             *out_start_inds = 3*triangle;
                         }
-                        *out_pt = {pt, collision_data->planes[triangle].normal};
+                        *out_pt = {pt, plane.normal};
                     }
                 }
             }
@@ -723,5 +734,331 @@ mesh_bvh_intersect(const mesh_bvh_t *bvh, ray_t model_space_ray, ray_t *out_pt,
     }
 }
 
-} // namespace sk
+// Closest point on triangle abc to point p, with the barycentric weights
+// of a, b and c for that point. Based on Christer Ericson's "Real-Time
+// Collision Detection", section 5.1.5, which walks the Voronoi regions
+// of the triangle instead of projecting and clamping.
+static vec3
+triangle_closest_point(vec3 p, vec3 a, vec3 b, vec3 c, vec3 *out_bary)
+{
+    vec3  ab = b - a;
+    vec3  ac = c - a;
+    vec3  ap = p - a;
+    float d1 = vec3_dot(ab, ap);
+    float d2 = vec3_dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+        *out_bary = {1, 0, 0};
+        return a;
+    }
 
+    vec3  bp = p - b;
+    float d3 = vec3_dot(ab, bp);
+    float d4 = vec3_dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+    {
+        *out_bary = {0, 1, 0};
+        return b;
+    }
+
+    float vc = d1*d4 - d3*d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        float v = d1 / (d1 - d3);
+        *out_bary = {1-v, v, 0};
+        return a + ab * v;
+    }
+
+    vec3  cp = p - c;
+    float d5 = vec3_dot(ab, cp);
+    float d6 = vec3_dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+    {
+        *out_bary = {0, 0, 1};
+        return c;
+    }
+
+    float vb = d5*d2 - d1*d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        float w = d2 / (d2 - d6);
+        *out_bary = {1-w, 0, w};
+        return a + ac * w;
+    }
+
+    float va = d3*d6 - d5*d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        *out_bary = {0, 1-w, w};
+        return b + (c - b) * w;
+    }
+
+    float denom = 1.0f / (va + vb + vc);
+    float v     = vb * denom;
+    float w     = vc * denom;
+    *out_bary = {1-v-w, v, w};
+    return a + ab * v + ac * w;
+}
+
+// Closest points between segments p1-q1 and p2-q2, returns the squared
+// distance between them, and the parameter along the second segment.
+// Ericson, "Real-Time Collision Detection", section 5.1.9
+static float
+segment_closest_points(vec3 p1, vec3 q1, vec3 p2, vec3 q2, float &out_t, vec3 &out_c1, vec3 &out_c2)
+{
+    vec3  d1 = q1 - p1;
+    vec3  d2 = q2 - p2;
+    vec3  r  = p1 - p2;
+    float a  = vec3_dot(d1, d1);
+    float e  = vec3_dot(d2, d2);
+    float f  = vec3_dot(d2, r);
+    float s, t;
+
+    if (a <= C_EPSILON && e <= C_EPSILON)
+    {
+        s = t = 0.0f;
+    }
+    else if (a <= C_EPSILON)
+    {
+        s = 0.0f;
+        t = math_saturate(f / e);
+    }
+    else
+    {
+        float c = vec3_dot(d1, r);
+        if (e <= C_EPSILON)
+        {
+            t = 0.0f;
+            s = math_saturate(-c / a);
+        }
+        else
+        {
+            float b     = vec3_dot(d1, d2);
+            float denom = a*e - b*b;
+            s = denom != 0.0f ? math_saturate((b*f - c*e) / denom) : 0.0f;
+            t = (b*s + f) / e;
+            if (t < 0.0f)
+            {
+                t = 0.0f;
+                s = math_saturate(-c / a);
+            }
+            else if (t > 1.0f)
+            {
+                t = 1.0f;
+                s = math_saturate((b - c) / a);
+            }
+        }
+    }
+
+    out_t  = t;
+    out_c1 = p1 + d1 * s;
+    out_c2 = p2 + d2 * t;
+    return vec3_magnitude_sq(out_c1 - out_c2);
+}
+
+// Closest point on triangle abc to the segment p-q. Returns the squared
+// distance, which is 0 when the segment passes through the triangle.
+static float
+segment_triangle_closest(vec3 p, vec3 q, vec3 a, vec3 b, vec3 c, vec3 *out_pt, vec3 *out_bary)
+{
+    vec3 bary;
+    vec3 tri_pt;
+
+    // Does the segment pierce the triangle?
+    vec3  normal = vec3_cross(b - a, c - a);
+    float dp     = vec3_dot(normal, p - a);
+    float dq     = vec3_dot(normal, q - a);
+    if (dp * dq <= 0.0f && dp != dq)
+    {
+        vec3 x = p + (q - p) * (dp / (dp - dq));
+        tri_pt = triangle_closest_point(x, a, b, c, &bary);
+        if (vec3_magnitude_sq(tri_pt - x) <= C_EPSILON*C_EPSILON)
+        {
+            *out_pt   = tri_pt;
+            *out_bary = bary;
+            return 0.0f;
+        }
+    }
+
+    // Otherwise the closest point involves a segment end point, or one of
+    // the triangle's edges.
+    tri_pt = triangle_closest_point(p, a, b, c, &bary);
+    float best = vec3_magnitude_sq(tri_pt - p);
+    *out_pt   = tri_pt;
+    *out_bary = bary;
+
+    tri_pt = triangle_closest_point(q, a, b, c, &bary);
+    float d = vec3_magnitude_sq(tri_pt - q);
+    if (d < best) { best = d; *out_pt = tri_pt; *out_bary = bary; }
+
+    const vec3 edge_start[3] = { a, b, c };
+    const vec3 edge_end  [3] = { b, c, a };
+    for (int e = 0; e < 3; e++)
+    {
+        float t;
+        vec3  on_seg, on_edge;
+        d = segment_closest_points(p, q, edge_start[e], edge_end[e], t, on_seg, on_edge);
+        if (d < best)
+        {
+            best    = d;
+            *out_pt = on_edge;
+            switch (e)
+            {
+            case 0: *out_bary = {1-t, t,   0  }; break;
+            case 1: *out_bary = {0,   1-t, t  }; break;
+            case 2: *out_bary = {t,   0,   1-t}; break;
+            }
+        }
+    }
+    return best;
+}
+
+// Find the closest point on the mesh surface to pt, within max_distance
+bool
+mesh_bvh_closest_point(const mesh_bvh_t *bvh, vec3 pt, float max_distance, ray_t *out_pt, vec3 *out_barycentric, uint32_t *out_start_inds)
+{
+    const bvh_node_t *nodes = bvh->nodes;
+    const uint32_t *sorted_triangles = bvh->sorted_triangles;
+    const mesh_collision_t *collision_data = bvh->collision_data;
+
+    // Use local stack to avoid having to recurse. Each entry remembers the
+    // squared distance to its bbox, so stale entries can be skipped once a
+    // closer triangle has been found.
+    uint32_t traversal_node_stack[TRAVERSAL_STACK_SIZE];
+    float traversal_dist_stack[TRAVERSAL_STACK_SIZE];
+
+    float best_dist = max_distance < sqrtf(FLT_MAX)
+        ? max_distance * max_distance
+        : FLT_MAX;
+    bool found = false;
+
+    float root_dist = bbox_distance_sq(nodes[0].bbox, pt);
+    if (root_dist > best_dist)
+        return false;
+
+    short stack_top = 0;
+    traversal_node_stack[0] = 0;
+    traversal_dist_stack[0] = root_dist;
+
+    while (stack_top >= 0)
+    {
+        const uint32_t current_node_index = traversal_node_stack[stack_top];
+        const float    node_dist          = traversal_dist_stack[stack_top--];
+        if (node_dist > best_dist)
+            continue;
+
+        const bvh_node_t& node = nodes[current_node_index];
+
+        if (node.is_leaf())
+        {
+            for (uint32_t t = node.leaf_first; t < node.leaf_first+node.num_triangles; t++)
+            {
+                uint32_t triangle = sorted_triangles[t];
+                vec3 a, b, c, bary;
+                mesh_collision_triangle(collision_data, 3*triangle, &a, &b, &c);
+
+                vec3  tri_pt = triangle_closest_point(pt, a, b, c, &bary);
+                float dist   = vec3_magnitude_sq(tri_pt - pt);
+                if (dist <= best_dist)
+                {
+                    best_dist = dist;
+                    found     = true;
+                    *out_pt   = { tri_pt, mesh_collision_plane(a, b, c).normal };
+                    if (out_barycentric != nullptr) *out_barycentric = bary;
+                    if (out_start_inds  != nullptr) *out_start_inds  = 3*triangle;
+                }
+            }
+            continue;
+        }
+
+        // Push the farther child first, so the nearer one is visited next
+        const uint32_t left_child = node.leaf_first;
+        float dist_left  = bbox_distance_sq(nodes[left_child  ].bbox, pt);
+        float dist_right = bbox_distance_sq(nodes[left_child+1].bbox, pt);
+        uint32_t near_child = left_child,   far_child = left_child+1;
+        float    near_dist  = dist_left,    far_dist  = dist_right;
+        if (dist_right < dist_left)
+        {
+            near_child = left_child+1; far_child = left_child;
+            near_dist  = dist_right;   far_dist  = dist_left;
+        }
+
+        if (far_dist <= best_dist && stack_top < TRAVERSAL_STACK_SIZE-1)
+        {
+            stack_top++;
+            traversal_node_stack[stack_top] = far_child;
+            traversal_dist_stack[stack_top] = far_dist;
+        }
+        if (near_dist <= best_dist && stack_top < TRAVERSAL_STACK_SIZE-1)
+        {
+            stack_top++;
+            traversal_node_stack[stack_top] = near_child;
+            traversal_dist_stack[stack_top] = near_dist;
+        }
+    }
+
+    return found;
+}
+
+// Find the closest point on the mesh surface to the segment pt1-pt2, if it's
+// within radius of that segment
+bool
+mesh_bvh_capsule_intersect(const mesh_bvh_t *bvh, vec3 pt1, vec3 pt2, float radius, ray_t *out_pt, vec3 *out_barycentric, uint32_t *out_start_inds)
+{
+    const bvh_node_t *nodes = bvh->nodes;
+    const uint32_t *sorted_triangles = bvh->sorted_triangles;
+    const mesh_collision_t *collision_data = bvh->collision_data;
+
+    uint32_t traversal_node_stack[TRAVERSAL_STACK_SIZE];
+
+    float best_dist   = radius * radius;
+    float best_margin = radius;
+    bool  found       = false;
+
+    if (!bbox_segment_intersect(nodes[0].bbox, pt1, pt2, best_margin))
+        return false;
+
+    short stack_top = 0;
+    traversal_node_stack[0] = 0;
+
+    while (stack_top >= 0)
+    {
+        const bvh_node_t& node = nodes[traversal_node_stack[stack_top--]];
+
+        if (node.is_leaf())
+        {
+            for (uint32_t t = node.leaf_first; t < node.leaf_first+node.num_triangles; t++)
+            {
+                uint32_t triangle = sorted_triangles[t];
+                vec3 a, b, c, bary, tri_pt;
+                mesh_collision_triangle(collision_data, 3*triangle, &a, &b, &c);
+
+                float dist = segment_triangle_closest(pt1, pt2, a, b, c, &tri_pt, &bary);
+                if (dist <= best_dist)
+                {
+                    best_dist   = dist;
+                    best_margin = sqrtf(dist);
+                    found       = true;
+                    *out_pt     = { tri_pt, mesh_collision_plane(a, b, c).normal };
+                    if (out_barycentric != nullptr) *out_barycentric = bary;
+                    if (out_start_inds  != nullptr) *out_start_inds  = 3*triangle;
+                }
+            }
+            continue;
+        }
+
+        // Children are only worth visiting if the capsule, shrunk to the
+        // best distance found so far, still touches their bbox.
+        const uint32_t left_child = node.leaf_first;
+        for (uint32_t child = left_child; child <= left_child+1; child++)
+        {
+            if (stack_top < TRAVERSAL_STACK_SIZE-1 && bbox_segment_intersect(nodes[child].bbox, pt1, pt2, best_margin))
+                traversal_node_stack[++stack_top] = child;
+        }
+    }
+
+    return found;
+}
+
+} // namespace sk
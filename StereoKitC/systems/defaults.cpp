@@ -37,6 +37,7 @@ shader_t     sk_default_shader_ui_quadrant;
 shader_t     sk_default_shader_ui_aura;
 shader_t     sk_default_shader_sky;
 shader_t     sk_default_shader_lines;
+shader_t     sk_default_shader_points;
 material_t   sk_default_material;
 material_t   sk_default_material_pbr;
 material_t   sk_default_material_pbr_clip;
@@ -191,6 +192,7 @@ bool defaults_init() {
 	SHADER_DECODE(sks_shader_builtin_ui_aura_hlsl_zip    ); sk_default_shader_ui_aura     = shader_create_mem(data, size);
 	SHADER_DECODE(sks_shader_builtin_skybox_hlsl_zip     ); sk_default_shader_sky         = shader_create_mem(data, size);
 	SHADER_DECODE(sks_shader_builtin_lines_hlsl_zip      ); sk_default_shader_lines       = shader_create_mem(data, size);
+	SHADER_DECODE(sks_shader_builtin_points_hlsl_zip     ); sk_default_shader_points      = shader_create_mem(data, size);
 	SHADER_DECODE(sks_shader_builtin_pbr_hlsl_zip        ); sk_default_shader_pbr         = shader_create_mem(data, size);
 	SHADER_DECODE(sks_shader_builtin_pbr_clip_hlsl_zip   ); sk_default_shader_pbr_clip    = shader_create_mem(data, size);
 	sk_free(data);
@@ -220,7 +222,8 @@ bool defaults_init() {
 		sk_default_shader_ui_quadrant == nullptr ||
 		sk_default_shader_ui_aura     == nullptr ||
 		sk_default_shader_sky         == nullptr ||
-		sk_default_shader_lines       == nullptr)
+		sk_default_shader_lines       == nullptr ||
+		sk_default_shader_points      == nullptr)
 		return false;
 
 	shader_set_id(sk_default_shader,             default_id_shader);
@@ -237,6 +240,7 @@ bool defaults_init() {
 	shader_set_id(sk_default_shader_ui_aura,     default_id_shader_ui_aura);
 	shader_set_id(sk_default_shader_sky,         default_id_shader_sky);
 	shader_set_id(sk_default_shader_lines,       default_id_shader_lines);
+	shader_set_id(sk_default_shader_points,      default_id_shader_points);
 
 	// Materials
 	sk_default_material             = material_create(sk_default_shader);
@@ -371,6 +375,7 @@ void defaults_shutdown() {
 	shader_release  (sk_default_shader_ui_aura);
 	shader_release  (sk_default_shader_sky);
 	shader_release  (sk_default_shader_lines);
+	shader_release  (sk_default_shader_points);
 	shader_release  (sk_default_shader_pbr);
 	shader_release  (sk_default_shader_pbr_clip);
 	mesh_release    (sk_default_cube);
@@ -4,6 +4,7 @@
 #include "../sk_memory.h"
 #include "../hierarchy.h"
 #include "../libraries/array.h"
+#include "../utils/frame_arena.h"
 
 #include <stdlib.h>
 
@@ -13,10 +14,10 @@ namespace sk {
 
 struct line_drawer_state_t {
 
-	mesh_t          line_mesh;
-	material_t      line_material;
-	array_t<vert_t> line_verts;
-	array_t<vind_t> line_inds;
+	mesh_t                line_mesh;
+	material_t            line_material;
+	frame_array_t<vert_t> line_verts;
+	frame_array_t<vind_t> line_inds;
 };
 static line_drawer_state_t local = {};
 
@@ -24,6 +25,8 @@ static line_drawer_state_t local = {};
 
 bool line_drawer_init() {
 	local = {};
+	local.line_verts.track();
+	local.line_inds .track();
 
 	shader_t line_shader = shader_find(default_id_shader_lines);
 	local.line_material = material_create(line_shader);
@@ -0,0 +1,175 @@
+#include "parallel.h"
+#include "../sk_memory.h"
+#include "../libraries/array.h"
+#include "../libraries/ferr_thread.h"
+#include "../libraries/atomic_util.h"
+#include "../platforms/platform.h"
+
+namespace sk {
+
+///////////////////////////////////////////
+
+struct parallel_job_t {
+	void           (*batch)(void *context, int32_t start, int32_t end);
+	void            *context;
+	int32_t          count;
+	int32_t          batch_size;
+	int32_t          batch_count;
+	volatile int32_t batch_next;
+	volatile int32_t batch_done;
+	volatile int32_t helpers;
+};
+
+struct parallel_thread_t {
+	volatile bool32_t running;
+};
+
+struct parallel_state_t {
+	bool32_t                   enabled;
+	array_t<parallel_thread_t> threads;
+	array_t<parallel_job_t*>   jobs;
+	ft_mutex_t                 jobs_mtx;
+	ft_condition_t             jobs_available;
+};
+static parallel_state_t local = {};
+
+int32_t parallel_thread(void *thread_inst_obj);
+
+///////////////////////////////////////////
+
+bool parallel_init() {
+	local = {};
+	local.jobs_mtx       = ft_mutex_create();
+	local.jobs_available = ft_condition_create();
+
+	// The main thread participates in its own work, and the asset threads
+	// will often be busy with loading, so we leave a core for each of those.
+#if !defined(__EMSCRIPTEN__)
+	int32_t thread_count = platform_cpu_count() - 1;
+	if (thread_count > 8) thread_count = 8;
+	if (thread_count > 0) local.threads.resize(thread_count);
+#endif
+
+	local.enabled = true;
+	for (int32_t i = 0; i < local.threads.capacity; i++) {
+		local.threads.add({});
+		local.threads.last().running = true;
+		ft_thread_create(parallel_thread, &local.threads.last());
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+void parallel_shutdown() {
+	ft_mutex_lock(local.jobs_mtx);
+	local.enabled = false;
+	ft_mutex_unlock(local.jobs_mtx);
+	ft_condition_broadcast(local.jobs_available);
+
+	for (int32_t i = 0; i < local.threads.count; i++) {
+		while (local.threads[i].running) ft_yield();
+	}
+
+	local.threads.free();
+	local.jobs   .free();
+	ft_mutex_destroy    (&local.jobs_mtx);
+	ft_condition_destroy(&local.jobs_available);
+	local = {};
+}
+
+///////////////////////////////////////////
+
+int32_t parallel_worker_count() {
+	return local.threads.count + 1;
+}
+
+///////////////////////////////////////////
+
+static void parallel_job_work(parallel_job_t *job) {
+	while (true) {
+		int32_t b = atomic_increment(&job->batch_next) - 1;
+		if (b >= job->batch_count) return;
+
+		int32_t start = b * job->batch_size;
+		int32_t end   = start + job->batch_size;
+		if (end > job->count) end = job->count;
+		job->batch(job->context, start, end);
+
+		atomic_increment(&job->batch_done);
+	}
+}
+
+///////////////////////////////////////////
+
+void parallel_for(int32_t count, int32_t batch_size, void *context, void (*batch)(void *context, int32_t start, int32_t end)) {
+	if (count <= 0) return;
+	if (batch_size < 1) batch_size = 1;
+
+	int32_t batch_count = (count + batch_size - 1) / batch_size;
+	if (batch_count == 1 || local.threads.count == 0 || local.enabled == false) {
+		batch(context, 0, count);
+		return;
+	}
+
+	parallel_job_t job = {};
+	job.batch       = batch;
+	job.context     = context;
+	job.count       = count;
+	job.batch_size  = batch_size;
+	job.batch_count = batch_count;
+
+	ft_mutex_lock(local.jobs_mtx);
+	local.jobs.add(&job);
+	ft_mutex_unlock(local.jobs_mtx);
+	ft_condition_broadcast(local.jobs_available);
+
+	parallel_job_work(&job);
+
+	// Once the job is out of the list, no new helpers can pick it up, so we
+	// only need to wait on the ones that are already working on it. The job
+	// lives on this stack, so it can't go away until they're all done.
+	ft_mutex_lock(local.jobs_mtx);
+	local.jobs.remove(local.jobs.index_of(&job));
+	ft_mutex_unlock(local.jobs_mtx);
+
+	while (job.batch_done < job.batch_count || job.helpers > 0)
+		ft_yield();
+}
+
+///////////////////////////////////////////
+
+int32_t parallel_thread(void *thread_inst_obj) {
+	parallel_thread_t *thread = (parallel_thread_t *)thread_inst_obj;
+	ft_thread_name(ft_thread_current(), "StereoKit Worker");
+
+	ft_mutex_lock(local.jobs_mtx);
+	while (local.enabled) {
+		parallel_job_t *job = nullptr;
+		for (int32_t i = 0; i < local.jobs.count; i++) {
+			if (local.jobs[i]->batch_next < local.jobs[i]->batch_count) {
+				job = local.jobs[i];
+				break;
+			}
+		}
+
+		if (job == nullptr) {
+			ft_condition_wait(local.jobs_available, local.jobs_mtx);
+			continue;
+		}
+
+		atomic_increment(&job->helpers);
+		ft_mutex_unlock(local.jobs_mtx);
+
+		parallel_job_work(job);
+
+		ft_mutex_lock(local.jobs_mtx);
+		atomic_decrement(&job->helpers);
+	}
+	ft_mutex_unlock(local.jobs_mtx);
+
+	thread->running = false;
+	return 0;
+}
+
+} // namespace sk
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace sk {
+
+// Splits [0, count) into batches of batch_size items, and runs them across
+// the worker pool. The calling thread also works on batches, and does not
+// return until all batches are complete. Safe to call from any thread,
+// including from inside another parallel_for callback. If the pool isn't
+// running, or the work is only a single batch, this just runs inline.
+void    parallel_for         (int32_t count, int32_t batch_size, void *context, void (*batch)(void *context, int32_t start, int32_t end));
+int32_t parallel_worker_count();
+
+bool    parallel_init        ();
+void    parallel_shutdown    ();
+
+} // namespace sk
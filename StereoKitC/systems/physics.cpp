@@ -2,6 +2,7 @@
 #include "../stereokit.h"
 #include "../_stereokit.h"
 #include "../libraries/array.h"
+#include "../utils/frame_arena.h"
 
 #if !defined(SK_PHYSICS_PASSTHROUGH)
 #pragma warning(push)
@@ -22,7 +23,7 @@ struct solid_move_t {
 	vec3    old_velocity;
 	vec3    old_rot_velocity;
 };
-array_t<solid_move_t> solid_moves = {};
+frame_array_t<solid_move_t> solid_moves = {};
 
 double physics_sim_time  = 0;
 double physics_step_time = 1 / 90.0;
@@ -40,6 +41,7 @@ inline Quaternion quat_sk_to_rp(quat       q) { return {q.x, q.y, q.z, q.w}; }
 ///////////////////////////////////////////
 
 bool physics_init() {
+	solid_moves.track();
 #if !defined(SK_PHYSICS_PASSTHROUGH)
 	physics_world = physics_common.createPhysicsWorld();
 #endif
@@ -12,6 +12,7 @@
 #include "../hierarchy.h"
 #include "../asset_types/mesh.h"
 #include "../asset_types/texture.h"
+#include "../asset_types/texture_stream.h"
 #include "../asset_types/shader.h"
 #include "../asset_types/material.h"
 #include "../asset_types/model.h"
@@ -20,6 +21,7 @@
 #include "../platforms/platform.h"
 
 #include <limits.h>
+#include <float.h>
 
 #pragma warning(push)
 #pragma warning(disable : 26451 26819 6386 6385 )
@@ -46,10 +48,13 @@ struct render_item_t {
 	material_t  material;
 	int32_t     mesh_inds;
 	uint16_t    layer;
+	int32_t     inst_start;
+	int32_t     inst_count;
 };
 
 struct _render_list_t {
 	array_t<render_item_t> queue;
+	array_t<XMMATRIX>      instances;
 	render_stats_t         stats;
 	render_list_state_     state;
 	bool                   prepped;
@@ -158,6 +163,9 @@ struct render_state_t {
 	array_t<_render_list_t> lists;
 	render_list_t           list_active;
 
+	render_upload_stats_t   upload_stats;
+	render_upload_stats_t   upload_stats_last;
+
 };
 static render_state_t local = {};
 
@@ -174,6 +182,7 @@ skg_buffer_t *render_fill_inst_buffer (array_t<render_transform_buffer_t> &list,
 void          render_save_to_file     (color32* color_buffer, int width, int height, void* context);
 
 void          render_list_prep        (render_list_t list);
+void          render_list_request_textures(render_list_t list, render_layer_ filter, XMVECTOR cam_pos, float px_scale);
 void          render_list_add         (const render_item_t *item);
 void          render_list_add_to      (render_list_t list, const render_item_t *item);
 
@@ -297,6 +306,9 @@ void render_shutdown() {
 void render_step() {
 	hierarchy_step();
 
+	local.upload_stats_last = local.upload_stats;
+	local.upload_stats      = {};
+
 	if (local.sky_show && device_display_get_blend() == display_blend_opaque) {
 		render_add_mesh(local.sky_mesh, local.sky_mat, matrix_identity, {1,1,1,1}, render_layer_vfx);
 	}
@@ -304,6 +316,20 @@ void render_step() {
 
 ///////////////////////////////////////////
 
+void render_stats_upload(uint64_t bytes, bool buffer_created) {
+	local.upload_stats.bytes   += bytes;
+	local.upload_stats.uploads += 1;
+	if (buffer_created) local.upload_stats.buffers_created += 1;
+}
+
+///////////////////////////////////////////
+
+render_upload_stats_t render_get_upload_stats() {
+	return local.upload_stats_last;
+}
+
+///////////////////////////////////////////
+
 inline uint64_t render_sort_id(material_t material, mesh_t mesh) {
 	return ((uint64_t)(material->alpha_mode*1000 + material->queue_offset) << 32) | (material->header.index << 16) | mesh->header.index;
 }
@@ -686,10 +712,12 @@ color128 render_get_clear_color_ln() {
 
 void render_add_mesh(mesh_t mesh, material_t material, const matrix &transform, color128 color_linear, render_layer_ layer) {
 	render_item_t item;
-	item.mesh      = mesh;
-	item.mesh_inds = mesh->ind_draw;
-	item.color     = color_linear;
-	item.layer     = (uint16_t)layer;
+	item.mesh       = mesh;
+	item.mesh_inds  = mesh->ind_draw;
+	item.color      = color_linear;
+	item.layer      = (uint16_t)layer;
+	item.inst_start = 0;
+	item.inst_count = 0;
 	if (hierarchy_use_top()) {
 		matrix_mul(transform, hierarchy_top(), item.transform);
 	} else {
@@ -721,12 +749,29 @@ void render_add_model_mat(model_t model, material_t material_override, const mat
 		if (vis->visible == false) continue;
 		
 		render_item_t item;
-		item.mesh      = vis->mesh;
-		item.mesh_inds = vis->mesh->ind_count;
-		item.color     = color_linear;
-		item.layer     = (uint16_t)layer;
+		item.mesh       = vis->mesh;
+		item.mesh_inds  = vis->mesh->ind_count;
+		item.color      = color_linear;
+		item.layer      = (uint16_t)layer;
+		item.inst_start = 0;
+		item.inst_count = 0;
 		matrix_mul(vis->transform_model, root, item.transform);
 
+		// Instanced visuals go in as a single queue item, so they only sort
+		// once. Their transforms are resolved here into the list's instance
+		// array, and expanded back out when the list draws.
+		if (vis->inst_count > 0) {
+			_render_list_t *list  = &local.lists[local.list_active];
+			const matrix   *insts = &model->instances[vis->inst_start];
+			item.inst_start = list->instances.count;
+			item.inst_count = vis->inst_count;
+			for (int32_t j = 0; j < vis->inst_count; j++) {
+				XMMATRIX inst;
+				math_matrix_to_fast(insts[j], &inst);
+				list->instances.add(XMMatrixMultiply(inst, item.transform));
+			}
+		}
+
 		material_t curr = material_override == nullptr ? vis->material : material_override;
 		while (curr != nullptr) {
 			item.material = curr;
@@ -810,6 +855,14 @@ void render_draw_queue(const matrix *views, const matrix *projections, int32_t e
 		}
 	}
 
+	// Let streaming textures know how large they are on screen, measured
+	// from the first view.
+	if (tex_stream_active()) {
+		XMVECTOR cam_pos  = XMLoadFloat3((XMFLOAT3 *)&local.global_buffer.camera_pos[0]);
+		float    px_scale = projections[0].m[5] * 0.5f * device_display_get_height();
+		render_list_request_textures(local.list_primary, filter, cam_pos, px_scale);
+	}
+
 	skg_event_end();
 	skg_event_begin("Execute Render List");
 
@@ -1103,6 +1156,8 @@ void render_set_material(material_t material) {
 	for (int32_t i = 0; i < material->args.texture_count; i++) {
 		if (local.global_textures[material->args.textures[i].bind.slot] == nullptr) {
 			tex_t tex = material->args.textures[i].tex;
+			// The texture budget evicts whatever's gone unbound the longest
+			tex->last_bound = time_frame();
 			if (tex->fallback != nullptr)
 				tex = tex->fallback;
 			skg_tex_bind(&tex->tex, material->args.textures[i].bind);
@@ -1185,7 +1240,8 @@ render_list_t render_list_create() {
 ///////////////////////////////////////////
 
 void render_list_release(render_list_t list) {
-	local.lists[list].queue.free();
+	local.lists[list].queue    .free();
+	local.lists[list].instances.free();
 	local.lists[list] = {};
 	local.lists[list].state = render_list_state_destroyed;
 }
@@ -1222,6 +1278,19 @@ void render_list_add_to(render_list_t list, const render_item_t *item) {
 
 ///////////////////////////////////////////
 
+inline void render_list_add_instances(const _render_list_t *list, const render_item_t *item) {
+	if (item->inst_count == 0) {
+		local.instance_list.add(render_transform_buffer_t{ XMMatrixTranspose(item->transform), item->color });
+		return;
+	}
+	const XMMATRIX *insts = &list->instances[item->inst_start];
+	for (int32_t i = 0; i < item->inst_count; i++) {
+		local.instance_list.add(render_transform_buffer_t{ XMMatrixTranspose(insts[i]), item->color });
+	}
+}
+
+///////////////////////////////////////////
+
 inline void render_list_execute_run(_render_list_t *list, material_t material, const skg_mesh_t *mesh, int32_t mesh_inds, uint32_t view_count) {
 	render_set_material(material);
 	skg_mesh_bind      (mesh);
@@ -1277,8 +1346,7 @@ void render_list_execute(render_list_t list_id, render_layer_ filter, uint32_t v
 		}
 
 		// Add the current item to the run of instances
-		XMMATRIX transpose = XMMatrixTranspose(item->transform);
-		local.instance_list.add(render_transform_buffer_t{ transpose, item->color });
+		render_list_add_instances(list, item);
 	}
 	// Render the last remaining run, which won't be triggered by the loop's
 	// conditions
@@ -1330,8 +1398,7 @@ void render_list_execute_material(render_list_t list_id, render_layer_ filter, u
 		}
 
 		// Add the current item to the run of instances
-		XMMATRIX transpose = XMMatrixTranspose(item->transform);
-		local.instance_list.add(render_transform_buffer_t{ transpose, item->color });
+		render_list_add_instances(list, item);
 	}
 	// Render the last remaining run, which won't be triggered by the loop's
 	// conditions
@@ -1345,6 +1412,54 @@ void render_list_execute_material(render_list_t list_id, render_layer_ filter, u
 
 ///////////////////////////////////////////
 
+// Finds the largest on-screen size of each material in the list, and passes
+// that along to its textures. Sizes come from the mesh's bounding sphere, so
+// they're a rough estimate that errs on the large side.
+void render_list_request_textures(render_list_t list_id, render_layer_ filter, XMVECTOR cam_pos, float px_scale) {
+	_render_list_t *list = &local.lists[list_id];
+	if (list->queue.count == 0) return;
+	render_list_prep(list_id);
+
+	material_t curr    = nullptr;
+	float      curr_px = 0;
+	for (int32_t i = 0; i <= list->queue.count; i++) {
+		render_item_t *item = i < list->queue.count ? &list->queue[i] : nullptr;
+		if (item != nullptr && (item->layer & filter) == 0) continue;
+
+		if (item == nullptr || item->material != curr) {
+			if (curr != nullptr) {
+				for (int32_t t = 0; t < curr->args.texture_count; t++) {
+					if (curr->args.textures[t].tex != nullptr)
+						tex_stream_request(curr->args.textures[t].tex, curr_px);
+				}
+			}
+			if (item == nullptr) break;
+			curr    = item->material;
+			curr_px = 0;
+		}
+
+		const bounds_t  *bounds = &item->mesh->bounds;
+		XMVECTOR         center = XMLoadFloat3((XMFLOAT3 *)&bounds->center);
+		float            radius = vec3_magnitude(bounds->dimensions) * 0.5f;
+		int32_t          count  = item->inst_count == 0 ? 1 : item->inst_count;
+		const XMMATRIX  *mats   = item->inst_count == 0 ? &item->transform : &list->instances[item->inst_start];
+		for (int32_t m = 0; m < count; m++) {
+			float scale = fmaxf(XMVectorGetX(XMVector3LengthSq(mats[m].r[0])), fmaxf(
+			                    XMVectorGetX(XMVector3LengthSq(mats[m].r[1])),
+			                    XMVectorGetX(XMVector3LengthSq(mats[m].r[2]))));
+			float world_radius = radius * sqrtf(scale);
+			float dist         = XMVectorGetX(XMVector3Length(XMVector3Transform(center, mats[m]) - cam_pos));
+			// Inside the bounds, the texture could cover the whole screen
+			float px = dist > world_radius * 1.01f
+				? (world_radius / (dist - world_radius)) * px_scale * 2
+				: FLT_MAX;
+			curr_px = fmaxf(curr_px, px);
+		}
+	}
+}
+
+///////////////////////////////////////////
+
 void render_list_prep(render_list_t list_id) {
 	_render_list_t *list = &local.lists[list_id];
 	if (list->prepped) return;
@@ -1370,7 +1485,8 @@ void render_list_clear(render_list_t list) {
 		assets_releaseref(&local.lists[list].queue[i].material->header);
 		assets_releaseref(&local.lists[list].queue[i].mesh->header);
 	}
-	local.lists[list].queue.clear();
+	local.lists[list].queue    .clear();
+	local.lists[list].instances.clear();
 	local.lists[list].stats   = {};
 	local.lists[list].prepped = false;
 	local.lists[list].state   = render_list_state_empty;
@@ -18,6 +18,12 @@ struct render_stats_t {
 	int draw_instances;
 };
 
+struct render_upload_stats_t {
+	uint64_t bytes;
+	int32_t  uploads;
+	int32_t  buffers_created;
+};
+
 enum render_list_state_ {
 	render_list_state_destroyed = -1,
 	render_list_state_empty = 0,
@@ -47,6 +53,8 @@ void          render_set_sim_head         (pose_t pose);
 void          render_draw_queue           (const matrix* views, const matrix* projections, int32_t eye_offset, int32_t view_count, render_layer_ filter);
 void          render_check_screenshots    ();
 void          render_check_viewpoints     ();
+void          render_stats_upload         (uint64_t bytes, bool buffer_created);
+render_upload_stats_t render_get_upload_stats();
 
 bool          render_init                 ();
 void          render_step                 ();
@@ -397,7 +397,7 @@ void file_picker_click_item(fp_item_t item) {
 	else {
 		char* path = platform_push_path_new(fp_path.folder, item.name);
 		file_picker_open_folder(path);
-		free(path);
+		sk_free(path);
 	}
 }
 
@@ -2,15 +2,16 @@
 #include "ui_theming.h"
 
 #include "../libraries/array.h"
+#include "../utils/frame_arena.h"
 
 ///////////////////////////////////////////
 
 namespace sk {
 
 
-array_t<ui_window_t> skui_windows     = {};
-array_t<ui_layout_t> skui_layouts     = {};
-array_t<ui_pad_>     skui_panel_stack = {};
+array_t<ui_window_t>       skui_windows     = {};
+frame_array_t<ui_layout_t> skui_layouts     = {};
+frame_array_t<ui_pad_>     skui_panel_stack = {};
 ui_settings_t        skui_settings    = {};
 bounds_t             skui_recent_layout;
 
@@ -22,6 +23,8 @@ void ui_layout_init() {
 	skui_panel_stack   = {};
 	skui_settings      = {};
 	skui_recent_layout = {};
+	skui_layouts    .track();
+	skui_panel_stack.track();
 }
 
 ///////////////////////////////////////////
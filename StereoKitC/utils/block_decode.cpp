@@ -0,0 +1,282 @@
+#include "block_decode.h"
+
+#include <string.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+static inline uint8_t block_clamp8(int32_t v) {
+	return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline uint8_t block_extend(uint32_t v, int32_t bits) {
+	return (uint8_t)((v << (8 - bits)) | (v >> (2 * bits - 8)));
+}
+
+///////////////////////////////////////////
+// BC1-5                                 //
+///////////////////////////////////////////
+
+// BC1 color, which is also the color half of BC3. BC3 always uses the four
+// color palette, BC1 swaps to three colors and transparent black when the
+// endpoints are in descending order.
+static void block_bc1(const uint8_t *block, color32 *out_tile, bool always_4_color) {
+	uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+	uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+
+	color32 pal[4];
+	pal[0] = { block_extend((c0 >> 11) & 31, 5), block_extend((c0 >> 5) & 63, 6), block_extend(c0 & 31, 5), 255 };
+	pal[1] = { block_extend((c1 >> 11) & 31, 5), block_extend((c1 >> 5) & 63, 6), block_extend(c1 & 31, 5), 255 };
+	if (c0 > c1 || always_4_color) {
+		pal[2] = { (uint8_t)((2*pal[0].r + pal[1].r + 1) / 3), (uint8_t)((2*pal[0].g + pal[1].g + 1) / 3), (uint8_t)((2*pal[0].b + pal[1].b + 1) / 3), 255 };
+		pal[3] = { (uint8_t)((pal[0].r + 2*pal[1].r + 1) / 3), (uint8_t)((pal[0].g + 2*pal[1].g + 1) / 3), (uint8_t)((pal[0].b + 2*pal[1].b + 1) / 3), 255 };
+	} else {
+		pal[2] = { (uint8_t)((pal[0].r + pal[1].r + 1) / 2), (uint8_t)((pal[0].g + pal[1].g + 1) / 2), (uint8_t)((pal[0].b + pal[1].b + 1) / 2), 255 };
+		pal[3] = { 0, 0, 0, 0 };
+	}
+
+	uint32_t inds = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+	for (int32_t i = 0; i < 16; i++)
+		out_tile[i] = pal[(inds >> (2 * i)) & 3];
+}
+
+///////////////////////////////////////////
+
+// A single 8 bit channel, shared by BC3 alpha, BC4 and BC5.
+static void block_bc4(const uint8_t *block, uint8_t *out_tile, int32_t stride) {
+	int32_t v0 = block[0];
+	int32_t v1 = block[1];
+
+	uint8_t pal[8];
+	pal[0] = (uint8_t)v0;
+	pal[1] = (uint8_t)v1;
+	if (v0 > v1) {
+		for (int32_t i = 1; i < 7; i++) pal[i+1] = (uint8_t)(((7 - i) * v0 + i * v1 + 3) / 7);
+	} else {
+		for (int32_t i = 1; i < 5; i++) pal[i+1] = (uint8_t)(((5 - i) * v0 + i * v1 + 2) / 5);
+		pal[6] = 0;
+		pal[7] = 255;
+	}
+
+	uint64_t inds = 0;
+	for (int32_t i = 0; i < 6; i++) inds |= (uint64_t)block[2 + i] << (8 * i);
+	for (int32_t i = 0; i < 16; i++)
+		out_tile[i * stride] = pal[(inds >> (3 * i)) & 7];
+}
+
+///////////////////////////////////////////
+// ETC2 and EAC                          //
+///////////////////////////////////////////
+
+static const int32_t block_etc_modifiers[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+static const int32_t block_etc_distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+static const int32_t block_eac_modifiers[16][8] = {
+	{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+	{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+	{ -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+	{ -2, -6, -8, -10, 1, 5, 7,  9 }, { -2, -5, -8, -10, 1, 4, 7,  9 },
+	{ -2, -4, -8, -10, 1, 3, 7,  9 }, { -2, -5, -7, -10, 1, 4, 6,  9 },
+	{ -3, -4, -7, -10, 2, 3, 6,  9 }, { -1, -2, -3, -10, 0, 1, 2,  9 },
+	{ -4, -6, -8,  -9, 3, 5, 7,  8 }, { -3, -5, -7,  -9, 2, 4, 6,  8 } };
+
+static inline color32 block_etc_offset(color32 c, int32_t offset) {
+	return { block_clamp8(c.r + offset), block_clamp8(c.g + offset), block_clamp8(c.b + offset), 255 };
+}
+
+///////////////////////////////////////////
+
+// ETC2 RGB blocks are big-endian, and reuse ETC1's differential mode
+// overflow cases for the T, H and planar modes. Pixel indices are stored
+// in column order.
+static void block_etc2_rgb(const uint8_t *block, color32 *out_tile) {
+	uint32_t hi = ((uint32_t)block[0] << 24) | (block[1] << 16) | (block[2] << 8) | block[3];
+	uint32_t lo = ((uint32_t)block[4] << 24) | (block[5] << 16) | (block[6] << 8) | block[7];
+
+	bool    diff = (hi >> 1) & 1;
+	bool    flip = hi & 1;
+	color32 base[2];
+	if (!diff) {
+		base[0] = { block_extend((hi >> 28) & 15, 4), block_extend((hi >> 20) & 15, 4), block_extend((hi >> 12) & 15, 4), 255 };
+		base[1] = { block_extend((hi >> 24) & 15, 4), block_extend((hi >> 16) & 15, 4), block_extend((hi >>  8) & 15, 4), 255 };
+	} else {
+		int32_t r = (hi >> 27) & 31, dr = ((int32_t)((hi >> 24) & 7) ^ 4) - 4;
+		int32_t g = (hi >> 19) & 31, dg = ((int32_t)((hi >> 16) & 7) ^ 4) - 4;
+		int32_t b = (hi >> 11) & 31, db = ((int32_t)((hi >>  8) & 7) ^ 4) - 4;
+
+		if (r + dr < 0 || r + dr > 31) {
+			// T mode
+			color32 c1 = { block_extend((((hi >> 27) & 3) << 2) | ((hi >> 24) & 3), 4), block_extend((hi >> 20) & 15, 4), block_extend((hi >> 16) & 15, 4), 255 };
+			color32 c2 = { block_extend((hi >> 12) & 15, 4), block_extend((hi >> 8) & 15, 4), block_extend((hi >> 4) & 15, 4), 255 };
+			int32_t d  = block_etc_distances[(((hi >> 2) & 3) << 1) | (hi & 1)];
+			color32 paint[4] = { c1, block_etc_offset(c2, d), c2, block_etc_offset(c2, -d) };
+			for (int32_t i = 0; i < 16; i++) {
+				int32_t idx = (i % 4) * 4 + i / 4;
+				out_tile[i] = paint[(((lo >> (16 + idx)) & 1) << 1) | ((lo >> idx) & 1)];
+			}
+			return;
+		}
+		if (g + dg < 0 || g + dg > 31) {
+			// H mode
+			uint32_t r1 = (hi >> 27) & 15;
+			uint32_t g1 = (((hi >> 24) & 7) << 1) | ((hi >> 20) & 1);
+			uint32_t b1 = (((hi >> 19) & 1) << 3) | ((hi >> 15) & 7);
+			uint32_t r2 = (hi >> 11) & 15;
+			uint32_t g2 = (hi >>  7) & 15;
+			uint32_t b2 = (hi >>  3) & 15;
+			uint32_t di = (((hi >> 2) & 1) << 2) | ((hi & 1) << 1) | (((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2) ? 1 : 0);
+			int32_t  d  = block_etc_distances[di];
+			color32  c1 = { block_extend(r1, 4), block_extend(g1, 4), block_extend(b1, 4), 255 };
+			color32  c2 = { block_extend(r2, 4), block_extend(g2, 4), block_extend(b2, 4), 255 };
+			color32  paint[4] = { block_etc_offset(c1, d), block_etc_offset(c1, -d), block_etc_offset(c2, d), block_etc_offset(c2, -d) };
+			for (int32_t i = 0; i < 16; i++) {
+				int32_t idx = (i % 4) * 4 + i / 4;
+				out_tile[i] = paint[(((lo >> (16 + idx)) & 1) << 1) | ((lo >> idx) & 1)];
+			}
+			return;
+		}
+		if (b + db < 0 || b + db > 31) {
+			// Planar mode, a gradient from three colors with no indices
+			int32_t ro = block_extend((hi >> 25) & 63, 6);
+			int32_t go = block_extend((((hi >> 24) & 1) << 6) | ((hi >> 17) & 63), 7);
+			int32_t bo = block_extend((((hi >> 16) & 1) << 5) | (((hi >> 11) & 3) << 3) | ((hi >> 7) & 7), 6);
+			int32_t rh = block_extend((((hi >> 2) & 31) << 1) | (hi & 1), 6);
+			int32_t gh = block_extend((lo >> 25) & 127, 7);
+			int32_t bh = block_extend((lo >> 19) & 63, 6);
+			int32_t rv = block_extend((lo >> 13) & 63, 6);
+			int32_t gv = block_extend((lo >>  6) & 127, 7);
+			int32_t bv = block_extend( lo        & 63, 6);
+			for (int32_t y = 0; y < 4; y++) {
+				for (int32_t x = 0; x < 4; x++) {
+					out_tile[x + y * 4] = {
+						block_clamp8((x * (rh - ro) + y * (rv - ro) + 4 * ro + 2) >> 2),
+						block_clamp8((x * (gh - go) + y * (gv - go) + 4 * go + 2) >> 2),
+						block_clamp8((x * (bh - bo) + y * (bv - bo) + 4 * bo + 2) >> 2), 255 };
+				}
+			}
+			return;
+		}
+		base[0] = { block_extend((uint32_t)r, 5), block_extend((uint32_t)g, 5), block_extend((uint32_t)b, 5), 255 };
+		base[1] = { block_extend((uint32_t)(r + dr), 5), block_extend((uint32_t)(g + dg), 5), block_extend((uint32_t)(b + db), 5), 255 };
+	}
+
+	int32_t table[2] = { (int32_t)((hi >> 5) & 7), (int32_t)((hi >> 2) & 7) };
+	for (int32_t y = 0; y < 4; y++) {
+		for (int32_t x = 0; x < 4; x++) {
+			int32_t sub    = flip ? (y >= 2) : (x >= 2);
+			int32_t idx    = x * 4 + y;
+			int32_t offset = block_etc_modifiers[table[sub]][(lo >> idx) & 1];
+			if ((lo >> (16 + idx)) & 1) offset = -offset;
+			out_tile[x + y * 4] = block_etc_offset(base[sub], offset);
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+// EAC carries alpha for ETC2 RGBA, and the R11/RG11 formats. Values here
+// come out as 8 bit, R11 is reduced down from its full 11 bits.
+static void block_eac(const uint8_t *block, uint8_t *out_tile, int32_t stride, bool eleven_bit) {
+	int32_t        base = block[0];
+	int32_t        mul  = block[1] >> 4;
+	const int32_t *mods = block_eac_modifiers[block[1] & 15];
+
+	uint64_t inds = 0;
+	for (int32_t i = 0; i < 6; i++) inds = (inds << 8) | block[2 + i];
+
+	for (int32_t i = 0; i < 16; i++) {
+		int32_t idx = (i % 4) * 4 + i / 4;
+		int32_t mod = mods[(inds >> (45 - 3 * idx)) & 7];
+		if (eleven_bit) {
+			int32_t v = base * 8 + 4 + (mul == 0 ? mod : mod * mul * 8);
+			v = v < 0 ? 0 : (v > 2047 ? 2047 : v);
+			out_tile[i * stride] = (uint8_t)((v * 255 + 1023) / 2047);
+		} else {
+			out_tile[i * stride] = block_clamp8(base + mod * mul);
+		}
+	}
+}
+
+///////////////////////////////////////////
+// Image decoding                        //
+///////////////////////////////////////////
+
+bool block_decode_supported(tex_format_ format) {
+	switch (format) {
+	case tex_format_bc1_rgba:
+	case tex_format_bc1_rgba_linear:
+	case tex_format_bc3_rgba:
+	case tex_format_bc3_rgba_linear:
+	case tex_format_bc4_r:
+	case tex_format_bc5_rg:
+	case tex_format_etc2_rgb:
+	case tex_format_etc2_rgb_linear:
+	case tex_format_etc2_rgba:
+	case tex_format_etc2_rgba_linear:
+	case tex_format_etc2_r11:
+	case tex_format_etc2_rg11: return true;
+	default: return false;
+	}
+}
+
+///////////////////////////////////////////
+
+bool block_decode_rgba32(tex_format_ format, const void *blocks, int32_t width, int32_t height, color32 *out_pixels) {
+	if (!block_decode_supported(format)) return false;
+
+	size_t block_size = 16;
+	if (format == tex_format_bc1_rgba || format == tex_format_bc1_rgba_linear || format == tex_format_bc4_r ||
+		format == tex_format_etc2_rgb || format == tex_format_etc2_rgb_linear || format == tex_format_etc2_r11)
+		block_size = 8;
+
+	const uint8_t *block    = (const uint8_t *)blocks;
+	int32_t        blocks_x = (width  + 3) / 4;
+	int32_t        blocks_y = (height + 3) / 4;
+	color32        tile[16];
+	for (int32_t by = 0; by < blocks_y; by++) {
+		for (int32_t bx = 0; bx < blocks_x; bx++) {
+			switch (format) {
+			case tex_format_bc1_rgba:
+			case tex_format_bc1_rgba_linear: block_bc1(block, tile, false); break;
+			case tex_format_bc3_rgba:
+			case tex_format_bc3_rgba_linear:
+				block_bc1(block + 8, tile, true);
+				block_bc4(block, &tile[0].a, 4);
+				break;
+			case tex_format_bc4_r:
+			case tex_format_bc5_rg:
+			case tex_format_etc2_r11:
+			case tex_format_etc2_rg11:
+				for (int32_t i = 0; i < 16; i++) tile[i] = { 0, 0, 0, 255 };
+				if (format == tex_format_bc4_r || format == tex_format_bc5_rg) {
+					block_bc4(block, &tile[0].r, 4);
+					if (format == tex_format_bc5_rg) block_bc4(block + 8, &tile[0].g, 4);
+				} else {
+					block_eac(block, &tile[0].r, 4, true);
+					if (format == tex_format_etc2_rg11) block_eac(block + 8, &tile[0].g, 4, true);
+				}
+				break;
+			case tex_format_etc2_rgb:
+			case tex_format_etc2_rgb_linear: block_etc2_rgb(block, tile); break;
+			case tex_format_etc2_rgba:
+			case tex_format_etc2_rgba_linear:
+				block_etc2_rgb(block + 8, tile);
+				block_eac     (block, &tile[0].a, 4, false);
+				break;
+			default: break;
+			}
+			block += block_size;
+
+			// Edge blocks hang off the image when it isn't a multiple of 4
+			int32_t copy_w = width  - bx * 4 < 4 ? width  - bx * 4 : 4;
+			int32_t copy_h = height - by * 4 < 4 ? height - by * 4 : 4;
+			for (int32_t y = 0; y < copy_h; y++)
+				memcpy(&out_pixels[(by * 4 + y) * width + bx * 4], &tile[y * 4], copy_w * sizeof(color32));
+		}
+	}
+	return true;
+}
+
+}
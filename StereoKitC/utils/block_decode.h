@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../stereokit.h"
+
+namespace sk {
+
+// CPU decoders for block compressed texture formats, used when the GPU can't
+// sample a compressed texture directly. Each decodes a full image of 4x4
+// blocks into width*height RGBA8 pixels, with partial edge blocks clipped.
+// Single and dual channel formats land in R and RG, with B at 0 and A at 255.
+//
+// BC1/3/4/5 and the ETC2/EAC family are covered, BC7 and ASTC are not, since
+// they're only worth shipping to GPUs that can already read them.
+
+bool block_decode_supported(tex_format_ format);
+bool block_decode_rgba32   (tex_format_ format, const void *blocks, int32_t width, int32_t height, color32 *out_pixels);
+
+}
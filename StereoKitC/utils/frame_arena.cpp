@@ -0,0 +1,170 @@
+#include "frame_arena.h"
+#include "../stereokit.h"
+#include "../_stereokit.h"
+#include "../sk_memory.h"
+#include "../libraries/array.h"
+#include "../libraries/ferr_thread.h"
+
+#include <assert.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+// Blocks grow to fit the largest frame seen so far, plus some slack, in
+// steps of this size.
+const size_t frame_arena_block_step = 64 * 1024;
+const size_t frame_arena_align      = 16;
+
+struct frame_arena_t {
+	uint8_t        *block;
+	size_t          block_size;
+	size_t          used;
+	// Anything that doesn't fit in the block for this frame goes on the heap,
+	// and the block is grown to fit it next time around.
+	array_t<void *> overflow;
+	size_t          overflow_bytes;
+	// The most recent allocation can grow in place.
+	void           *last;
+	size_t          last_size;
+};
+
+struct frame_arena_array_t {
+	void  *array;
+	size_t item_size;
+};
+
+struct frame_arena_state_t {
+	frame_arena_t                arenas[2];
+	int32_t                      curr;
+	array_t<frame_arena_array_t> tracked;
+	size_t                       high_water;
+	int32_t                      heap_allocs;
+};
+static frame_arena_state_t local = {};
+
+///////////////////////////////////////////
+
+static void frame_arena_reset(frame_arena_t *arena) {
+	for (int32_t i = 0; i < arena->overflow.count; i++)
+		sk_free(arena->overflow[i]);
+	arena->overflow.clear();
+
+	size_t needed = arena->used + arena->overflow_bytes;
+	if (needed > arena->block_size) {
+		size_t size = needed + needed / 4;
+		size = ((size + frame_arena_block_step - 1) / frame_arena_block_step) * frame_arena_block_step;
+		sk_free(arena->block);
+		arena->block      = (uint8_t *)sk_malloc(size);
+		arena->block_size = size;
+	}
+	if (needed > local.high_water) {
+		local.high_water = needed;
+		log_diagf("Frame arena high-water mark is now %.1fkb, %d heap allocations so far", needed / 1024.0f, local.heap_allocs);
+	}
+
+	arena->used           = 0;
+	arena->overflow_bytes = 0;
+	arena->last           = nullptr;
+	arena->last_size      = 0;
+}
+
+///////////////////////////////////////////
+
+void frame_arena_step() {
+	local.curr = (local.curr + 1) % 2;
+	frame_arena_t *arena = &local.arenas[local.curr];
+	frame_arena_reset(arena);
+
+	// Items still in a tracked array live in the other arena, which is about
+	// to be reset next frame, so move them into this one.
+	for (int32_t i = 0; i < local.tracked.count; i++) {
+		frame_array_t<uint8_t> *array     = (frame_array_t<uint8_t> *)local.tracked[i].array;
+		size_t                  item_size = local.tracked[i].item_size;
+		if (array->count > 0) {
+			uint8_t *data = (uint8_t *)frame_arena_alloc(array->count * item_size);
+			memcpy(data, array->data, array->count * item_size);
+			array->data     = data;
+			array->capacity = array->count;
+		} else {
+			array->data     = nullptr;
+			array->capacity = 0;
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+void frame_arena_shutdown() {
+	for (int32_t a = 0; a < 2; a++) {
+		frame_arena_t *arena = &local.arenas[a];
+		for (int32_t i = 0; i < arena->overflow.count; i++)
+			sk_free(arena->overflow[i]);
+		arena->overflow.free();
+		sk_free(arena->block);
+	}
+	local.tracked.free();
+	local = {};
+}
+
+///////////////////////////////////////////
+
+void *frame_arena_alloc(size_t bytes) {
+	// The arena has no lock, and is reset by sk_step on the main thread, so
+	// code that can also run on user or asset threads needs the heap.
+	assert(ft_id_matches(sk_main_thread()));
+
+	frame_arena_t *arena = &local.arenas[local.curr];
+	size_t         start = (arena->used + frame_arena_align - 1) & ~(frame_arena_align - 1);
+
+	void *result;
+	if (start + bytes <= arena->block_size) {
+		result     = arena->block + start;
+		arena->used = start + bytes;
+	} else {
+		result = sk_malloc(bytes);
+		arena->overflow.add(result);
+		arena->overflow_bytes += bytes + frame_arena_align;
+		local.heap_allocs     += 1;
+	}
+	arena->last      = result;
+	arena->last_size = bytes;
+	return result;
+}
+
+///////////////////////////////////////////
+
+void *frame_arena_realloc(void *memory, size_t old_bytes, size_t new_bytes) {
+	frame_arena_t *arena = &local.arenas[local.curr];
+
+	// Growing the most recent allocation in the block just moves the end of
+	// the block along, no copy needed.
+	if (memory != nullptr && memory == arena->last && (uint8_t *)memory >= arena->block && (uint8_t *)memory < arena->block + arena->block_size) {
+		size_t start = (uint8_t *)memory - arena->block;
+		if (start + new_bytes <= arena->block_size) {
+			arena->used      = start + new_bytes;
+			arena->last_size = new_bytes;
+			return memory;
+		}
+	}
+
+	void *result = frame_arena_alloc(new_bytes);
+	if (memory != nullptr && old_bytes > 0)
+		memcpy(result, memory, old_bytes < new_bytes ? old_bytes : new_bytes);
+	return result;
+}
+
+///////////////////////////////////////////
+
+void frame_arena_track(void *array, size_t item_size) {
+	local.tracked.add({ array, item_size });
+}
+
+///////////////////////////////////////////
+
+void frame_arena_untrack(void *array) {
+	int32_t idx = local.tracked.index_where(&frame_arena_array_t::array, array);
+	if (idx >= 0) local.tracked.remove(idx);
+}
+
+} // namespace sk
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace sk {
+
+// A double-buffered linear allocator for data that only needs to live for a
+// frame. Allocations made during a frame stay valid through the end of the
+// next one, so anything still in flight from the previous frame is safe.
+// Main thread only.
+
+void  frame_arena_step    ();
+void  frame_arena_shutdown();
+void *frame_arena_alloc   (size_t bytes);
+void *frame_arena_realloc (void *memory, size_t old_bytes, size_t new_bytes);
+void  frame_arena_track   (void *array, size_t item_size);
+void  frame_arena_untrack (void *array);
+
+// An array_t lookalike that grows on the frame arena instead of the heap.
+// Call track() before use, and free() when done. Tracked arrays with items
+// in them at the end of a frame have those items carried into the next
+// frame's arena, so long-lived stacks are fine here too.
+template <typename T>
+struct frame_array_t {
+	T      *data;
+	int32_t count;
+	int32_t capacity;
+
+	int32_t     add        (const T &item)              { if (count+1   > capacity) { resize(capacity * 2 < 16        ? 16        : capacity * 2); } data[count] = item; count += 1; return count - 1; }
+	void        add_range  (const T *list, int32_t num) { if (count+num > capacity) { resize(capacity * 2 < count+num ? count+num : capacity * 2); } memcpy(&data[count], list, sizeof(T)*num); count += num; }
+	void        resize     (int32_t to_capacity)        { if (to_capacity <= capacity) return; data = (T*)frame_arena_realloc(data, sizeof(T)*count, sizeof(T)*to_capacity); capacity = to_capacity; }
+	void        pop        ()                           { count -= 1; }
+	void        clear      ()                           { count = 0; }
+	T          &last       () const                     { return data[count - 1]; }
+	inline T   &get        (int32_t id) const           { return data[id]; }
+	inline T   &operator[] (int32_t id) const           { return data[id]; }
+	void        each       (void (*e)(const T &)) const { for (int32_t i=0; i<count; i++) e(data[i]); }
+	void        track      ()                           { frame_arena_track(this, sizeof(T)); }
+	void        free       ()                           { frame_arena_untrack(this); *this = {}; }
+};
+
+} // namespace sk
@@ -0,0 +1,333 @@
+#include "image_resample.h"
+#include "../sk_math.h"
+#include "../sk_memory.h"
+#include "../libraries/sk_gpu.h"
+
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include <string.h>
+#include <math.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+// Kaiser window settings, 3 lobes with an alpha of 4 keeps ringing low
+// while staying much sharper than a box or tent.
+const float resample_radius = 3.0f;
+const float resample_alpha  = 4.0f;
+
+struct resample_tables_t {
+	float to_linear[256];
+	float to_gamma [4096];
+
+	resample_tables_t() {
+		for (int32_t i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			to_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int32_t i = 0; i < 4096; i++) {
+			float c = i / 4095.0f;
+			to_gamma[i] = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+		}
+	}
+};
+
+static const resample_tables_t &resample_tables() {
+	static resample_tables_t tables;
+	return tables;
+}
+
+struct resample_span_t {
+	int32_t start;
+	int32_t count;
+	int32_t weights;
+};
+
+///////////////////////////////////////////
+
+static float resample_bessel_i0(float x) {
+	float sum  = 1;
+	float term = 1;
+	float half = x * 0.5f;
+	for (int32_t k = 1; k < 32; k++) {
+		term *= half / k;
+		float sq = term * term;
+		sum += sq;
+		if (sq < sum * 1e-8f) break;
+	}
+	return sum;
+}
+
+///////////////////////////////////////////
+
+static float resample_kaiser(float x) {
+	float ax = fabsf(x);
+	if (ax >= resample_radius) return 0;
+
+	float sinc = ax < 0.0001f ? 1.0f : sinf(MATH_PI * ax) / (MATH_PI * ax);
+	float t    = ax / resample_radius;
+	return sinc * resample_bessel_i0(resample_alpha * sqrtf(1 - t * t)) / resample_bessel_i0(resample_alpha);
+}
+
+///////////////////////////////////////////
+
+// Finds which source texels contribute to each destination texel along one
+// axis, and how much. Weights are normalized so flat colors stay flat.
+static resample_span_t *resample_spans(int32_t src_size, int32_t dst_size, float **out_weights, int32_t *out_max_count) {
+	float   scale    = (float)src_size / (float)dst_size;
+	float   support  = fmaxf(scale, 1.0f);
+	int32_t max_taps = (int32_t)ceilf(resample_radius * support) * 2 + 1;
+
+	resample_span_t *spans   = sk_malloc_t(resample_span_t, dst_size);
+	float           *weights = sk_malloc_t(float, (size_t)dst_size * max_taps);
+	*out_max_count = 0;
+	for (int32_t i = 0; i < dst_size; i++) {
+		float   center = (i + 0.5f) * scale - 0.5f;
+		int32_t left   = (int32_t)ceilf (center - resample_radius * support);
+		int32_t right  = (int32_t)floorf(center + resample_radius * support);
+		if (right - left + 1 > max_taps) right = left + max_taps - 1;
+
+		resample_span_t *span  = &spans[i];
+		float           *w     = &weights[(size_t)i * max_taps];
+		float            total = 0;
+		span->start   = left;
+		span->count   = right - left + 1;
+		span->weights = i * max_taps;
+		for (int32_t j = 0; j < span->count; j++) {
+			w[j]   = resample_kaiser(((left + j) - center) / support);
+			total += w[j];
+		}
+		if (total != 0) {
+			for (int32_t j = 0; j < span->count; j++) w[j] /= total;
+		}
+		*out_max_count = maxi(*out_max_count, span->count);
+	}
+	*out_weights = weights;
+	return spans;
+}
+
+///////////////////////////////////////////
+
+static void resample_row_to_linear(tex_format_ format, const void *src, int32_t src_width, int32_t y, float *out_row) {
+	if (format == tex_format_rgba128) {
+		memcpy(out_row, ((const float *)src) + (size_t)y * src_width * 4, sizeof(float) * 4 * src_width);
+		return;
+	}
+
+	const resample_tables_t &tables = resample_tables();
+	const uint8_t           *row    = ((const uint8_t *)src) + (size_t)y * src_width * 4;
+	for (int32_t x = 0; x < src_width * 4; x += 4) {
+		if (format == tex_format_rgba32) {
+			out_row[x+0] = tables.to_linear[row[x+0]];
+			out_row[x+1] = tables.to_linear[row[x+1]];
+			out_row[x+2] = tables.to_linear[row[x+2]];
+		} else {
+			out_row[x+0] = row[x+0] / 255.0f;
+			out_row[x+1] = row[x+1] / 255.0f;
+			out_row[x+2] = row[x+2] / 255.0f;
+		}
+		out_row[x+3] = row[x+3] / 255.0f;
+	}
+}
+
+///////////////////////////////////////////
+
+static void resample_row_from_linear(tex_format_ format, const float *row, int32_t dst_width, int32_t y, void *dst) {
+	if (format == tex_format_rgba128) {
+		// Negative lobes can dip below zero next to bright texels
+		float *out = ((float *)dst) + (size_t)y * dst_width * 4;
+		for (int32_t x = 0; x < dst_width * 4; x++)
+			out[x] = fmaxf(row[x], 0);
+		return;
+	}
+
+	const resample_tables_t &tables = resample_tables();
+	uint8_t                 *out    = ((uint8_t *)dst) + (size_t)y * dst_width * 4;
+	for (int32_t x = 0; x < dst_width * 4; x++) {
+		float c = fminf(fmaxf(row[x], 0), 1);
+		if (format == tex_format_rgba32 && (x & 3) != 3)
+			c = tables.to_gamma[(int32_t)(c * 4095 + 0.5f)];
+		out[x] = (uint8_t)(c * 255 + 0.5f);
+	}
+}
+
+///////////////////////////////////////////
+
+bool image_resize_supported(tex_format_ format) {
+	return format == tex_format_rgba32
+		|| format == tex_format_rgba32_linear
+		|| format == tex_format_rgba128;
+}
+
+///////////////////////////////////////////
+
+bool image_resize(tex_format_ format, const void *src, int32_t src_width, int32_t src_height, void *dst, int32_t dst_width, int32_t dst_height) {
+	if (!image_resize_supported(format) || src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0)
+		return false;
+
+	float           *weights_x, *weights_y;
+	int32_t          taps_x, taps_y;
+	resample_span_t *spans_x = resample_spans(src_width,  dst_width,  &weights_x, &taps_x);
+	resample_span_t *spans_y = resample_spans(src_height, dst_height, &weights_y, &taps_y);
+
+	// Rows are filtered horizontally as they're needed, and kept in a ring
+	// just big enough to cover one vertical span. Spans only ever move down
+	// the image, so a row is never needed again after it's replaced.
+	// Each texel's 4 channels filter together as one SIMD vector.
+	int32_t   ring_count = taps_y;
+	XMFLOAT4 *ring       = sk_malloc_t(XMFLOAT4, (size_t)ring_count * dst_width);
+	int32_t  *ring_rows  = sk_malloc_t(int32_t,  ring_count);
+	XMFLOAT4 *src_row    = sk_malloc_t(XMFLOAT4, src_width);
+	XMFLOAT4 *dst_row    = sk_malloc_t(XMFLOAT4, dst_width);
+	for (int32_t i = 0; i < ring_count; i++) ring_rows[i] = -1;
+
+	for (int32_t y = 0; y < dst_height; y++) {
+		const resample_span_t *span_y = &spans_y[y];
+		memset(dst_row, 0, sizeof(XMFLOAT4) * dst_width);
+
+		for (int32_t t = 0; t < span_y->count; t++) {
+			int32_t   sy   = mini(maxi(span_y->start + t, 0), src_height - 1);
+			int32_t   slot = sy % ring_count;
+			XMFLOAT4 *row  = &ring[(size_t)slot * dst_width];
+			if (ring_rows[slot] != sy) {
+				ring_rows[slot] = sy;
+				resample_row_to_linear(format, src, src_width, sy, &src_row[0].x);
+				for (int32_t x = 0; x < dst_width; x++) {
+					const resample_span_t *span_x = &spans_x[x];
+					const float           *w      = &weights_x[span_x->weights];
+					XMVECTOR               sum    = XMVectorZero();
+					for (int32_t s = 0; s < span_x->count; s++) {
+						XMVECTOR px = XMLoadFloat4(&src_row[mini(maxi(span_x->start + s, 0), src_width - 1)]);
+						sum = XMVectorMultiplyAdd(px, XMVectorReplicate(w[s]), sum);
+					}
+					XMStoreFloat4(&row[x], sum);
+				}
+			}
+
+			XMVECTOR weight = XMVectorReplicate(weights_y[span_y->weights + t]);
+			for (int32_t x = 0; x < dst_width; x++)
+				XMStoreFloat4(&dst_row[x], XMVectorMultiplyAdd(XMLoadFloat4(&row[x]), weight, XMLoadFloat4(&dst_row[x])));
+		}
+		resample_row_from_linear(format, &dst_row[0].x, dst_width, y, dst);
+	}
+
+	sk_free(dst_row);
+	sk_free(src_row);
+	sk_free(ring_rows);
+	sk_free(ring);
+	sk_free(spans_x);
+	sk_free(spans_y);
+	sk_free(weights_x);
+	sk_free(weights_y);
+	return true;
+}
+
+///////////////////////////////////////////
+
+// Fraction of texels whose alpha passes the cutoff, after scaling by
+// alpha_scale.
+static float image_alpha_coverage(tex_format_ format, const void *image, int32_t count, float cutoff, float alpha_scale) {
+	int32_t passed = 0;
+	if (format == tex_format_rgba128) {
+		const float *px = (const float *)image;
+		for (int32_t i = 0; i < count; i++) {
+			if (px[i*4+3] * alpha_scale > cutoff) passed++;
+		}
+	} else {
+		const uint8_t *px = (const uint8_t *)image;
+		for (int32_t i = 0; i < count; i++) {
+			if (px[i*4+3] * (alpha_scale / 255.0f) > cutoff) passed++;
+		}
+	}
+	return passed / (float)count;
+}
+
+///////////////////////////////////////////
+
+// Searches for the alpha scale that brings this mip's coverage closest to
+// the top level's, and applies it.
+static void image_keep_coverage(tex_format_ format, void *image, int32_t count, float cutoff, float coverage) {
+	float lo = 0, hi = 4, scale = 1;
+	float best_diff = fabsf(image_alpha_coverage(format, image, count, cutoff, 1) - coverage);
+	for (int32_t i = 0; i < 10; i++) {
+		float mid  = (lo + hi) * 0.5f;
+		float curr = image_alpha_coverage(format, image, count, cutoff, mid);
+		float diff = fabsf(curr - coverage);
+		if (diff < best_diff) { best_diff = diff; scale = mid; }
+		if (curr < coverage) lo = mid;
+		else                 hi = mid;
+	}
+	if (scale == 1) return;
+
+	if (format == tex_format_rgba128) {
+		float *px = (float *)image;
+		for (int32_t i = 0; i < count; i++)
+			px[i*4+3] = fminf(px[i*4+3] * scale, 1);
+	} else {
+		uint8_t *px = (uint8_t *)image;
+		for (int32_t i = 0; i < count; i++)
+			px[i*4+3] = (uint8_t)fminf(px[i*4+3] * scale + 0.5f, 255);
+	}
+}
+
+///////////////////////////////////////////
+
+// Filtering shortens normals, and averages them toward the surface, so
+// they're pushed back out to unit length. Normals are stored as 0-1 colors.
+static void image_renormalize(tex_format_ format, void *image, int32_t count) {
+	XMVECTOR two = XMVectorReplicate(2);
+	XMVECTOR one = XMVectorReplicate(1);
+	for (int32_t i = 0; i < count; i++) {
+		XMFLOAT4 px;
+		if (format == tex_format_rgba128) {
+			px = ((XMFLOAT4 *)image)[i];
+		} else {
+			const uint8_t *c = &((const uint8_t *)image)[i*4];
+			px = { c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f, c[3] / 255.0f };
+		}
+
+		XMVECTOR n = XMVectorSubtract(XMVectorMultiply(XMLoadFloat4(&px), two), one);
+		n = XMVector3Normalize(XMVectorSetW(n, 0));
+		n = XMVectorMultiplyAdd(n, XMVectorReplicate(0.5f), XMVectorReplicate(0.5f));
+		XMFLOAT4 result;
+		XMStoreFloat4(&result, n);
+
+		if (format == tex_format_rgba128) {
+			((XMFLOAT4 *)image)[i] = { result.x, result.y, result.z, px.w };
+		} else {
+			uint8_t *c = &((uint8_t *)image)[i*4];
+			c[0] = (uint8_t)(result.x * 255 + 0.5f);
+			c[1] = (uint8_t)(result.y * 255 + 0.5f);
+			c[2] = (uint8_t)(result.z * 255 + 0.5f);
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+void image_mips(tex_format_ format, const void *image, int32_t width, int32_t height, int32_t first_mip, int32_t count, image_mip_ mode, float alpha_cutoff, void **out_mips) {
+	float coverage = 0;
+	if (mode & image_mip_alpha_coverage)
+		coverage = image_alpha_coverage(format, image, width * height, alpha_cutoff, 1);
+
+	const void *src   = image;
+	int32_t     src_w = width;
+	int32_t     src_h = height;
+	for (int32_t i = 0; i < count; i++) {
+		int32_t mip_w, mip_h;
+		skg_mip_dimensions(width, height, first_mip + i, &mip_w, &mip_h);
+		out_mips[i] = sk_malloc(skg_tex_fmt_memory((skg_tex_fmt_)format, mip_w, mip_h));
+		image_resize(format, src, src_w, src_h, out_mips[i], mip_w, mip_h);
+
+		if (mode & image_mip_normal_map)     image_renormalize  (format, out_mips[i], mip_w * mip_h);
+		if (mode & image_mip_alpha_coverage) image_keep_coverage(format, out_mips[i], mip_w * mip_h, alpha_cutoff, coverage);
+
+		src   = out_mips[i];
+		src_w = mip_w;
+		src_h = mip_h;
+	}
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../stereokit.h"
+
+namespace sk {
+
+// Resizes RGBA images on the CPU with a separable Kaiser windowed sinc, for
+// quality downscaling on the asset threads. sRGB data is filtered in linear
+// space and converted back. Edges clamp rather than wrap.
+//
+// Supports tex_format_rgba32, tex_format_rgba32_linear and
+// tex_format_rgba128, returns false for anything else.
+
+typedef enum image_mip_ {
+	image_mip_default        = 0,
+	// Scales each mip's alpha so the share of texels passing the alpha
+	// cutoff matches the top level, so alpha tested cutouts don't thin out
+	// and vanish in the distance.
+	image_mip_alpha_coverage = 1 << 0,
+	// The image is a tangent space normal map, so each mip's normals are
+	// renormalized after filtering.
+	image_mip_normal_map     = 1 << 1,
+} image_mip_;
+SK_MakeFlag(image_mip_);
+
+bool image_resize_supported(tex_format_ format);
+bool image_resize          (tex_format_ format, const void *src, int32_t src_width, int32_t src_height, void *dst, int32_t dst_width, int32_t dst_height);
+
+// Builds mips first_mip onward from a full size image, each one resampled
+// from the one before it. out_mips receives count newly allocated levels,
+// which the caller frees with sk_free. first_mip must be at least 1.
+void image_mips            (tex_format_ format, const void *image, int32_t width, int32_t height, int32_t first_mip, int32_t count, image_mip_ mode, float alpha_cutoff, void **out_mips);
+
+}
@@ -0,0 +1,304 @@
+#include "mesh_optimize.h"
+#include "../sk_math.h"
+#include "../sk_memory.h"
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+namespace sk {
+
+// Post-transform cache sizes. The scoring cache is larger than most real
+// hardware, which Forsyth found works well across a range of GPUs, while
+// ACMR is measured against a more conservative FIFO.
+const int32_t mesh_opt_score_cache = 32;
+const int32_t mesh_opt_fifo_cache  = 16;
+
+///////////////////////////////////////////
+
+float mesh_opt_acmr(const vind_t *inds, uint32_t ind_count, uint32_t vert_count) {
+	if (ind_count < 3) return 0;
+
+	// Vertex timestamps make for a FIFO without needing to search it
+	uint32_t *stamps = sk_malloc_t(uint32_t, vert_count);
+	memset(stamps, 0, sizeof(uint32_t) * vert_count);
+
+	uint32_t time   = mesh_opt_fifo_cache + 1;
+	uint32_t misses = 0;
+	for (uint32_t i = 0; i < ind_count; i++) {
+		vind_t v = inds[i];
+		if (time - stamps[v] > (uint32_t)mesh_opt_fifo_cache) {
+			stamps[v] = time;
+			time   += 1;
+			misses += 1;
+		}
+	}
+	sk_free(stamps);
+	return misses / (float)(ind_count / 3);
+}
+
+///////////////////////////////////////////
+// Vertex cache, Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+///////////////////////////////////////////
+
+static float mesh_opt_vert_score(int32_t cache_pos, uint32_t live_tris) {
+	if (live_tris == 0) return -1;
+
+	float score = 0;
+	if (cache_pos >= 0) {
+		// The last triangle's verts get a fixed score, so it doesn't matter
+		// which of the three the next triangle uses.
+		if (cache_pos < 3) score = 0.75f;
+		else               score = powf(1.0f - (cache_pos - 3) / (float)(mesh_opt_score_cache - 3), 1.5f);
+	}
+	// Boost verts with few triangles left, so we don't leave lone triangles
+	// behind to clean up later.
+	return score + 2.0f * powf((float)live_tris, -0.5f);
+}
+
+///////////////////////////////////////////
+
+void mesh_opt_vertex_cache(vind_t *inds, uint32_t ind_count, uint32_t vert_count) {
+	uint32_t tri_count = ind_count / 3;
+	if (tri_count < 2 || vert_count == 0) return;
+
+	// Build a triangle adjacency list for each vertex
+	uint32_t *live_tris  = sk_malloc_t(uint32_t, vert_count);
+	uint32_t *adj_start  = sk_malloc_t(uint32_t, vert_count + 1);
+	uint32_t *adj        = sk_malloc_t(uint32_t, tri_count * 3);
+	int32_t  *cache_pos  = sk_malloc_t(int32_t,  vert_count);
+	float    *vert_score = sk_malloc_t(float,    vert_count);
+	float    *tri_score  = sk_malloc_t(float,    tri_count);
+	bool     *tri_added  = sk_malloc_t(bool,     tri_count);
+	vind_t   *result     = sk_malloc_t(vind_t,   tri_count * 3);
+	memset(live_tris, 0, sizeof(uint32_t) * vert_count);
+	memset(tri_added, 0, sizeof(bool)     * tri_count);
+
+	for (uint32_t i = 0; i < tri_count * 3; i++) live_tris[inds[i]] += 1;
+	adj_start[0] = 0;
+	for (uint32_t v = 0; v < vert_count; v++) adj_start[v + 1] = adj_start[v] + live_tris[v];
+	memset(live_tris, 0, sizeof(uint32_t) * vert_count);
+	for (uint32_t t = 0; t < tri_count; t++) {
+		for (int32_t c = 0; c < 3; c++) {
+			vind_t v = inds[t * 3 + c];
+			adj[adj_start[v] + live_tris[v]] = t;
+			live_tris[v] += 1;
+		}
+	}
+
+	for (uint32_t v = 0; v < vert_count; v++) {
+		cache_pos [v] = -1;
+		vert_score[v] = mesh_opt_vert_score(-1, live_tris[v]);
+	}
+	for (uint32_t t = 0; t < tri_count; t++) {
+		tri_score[t] = vert_score[inds[t*3]] + vert_score[inds[t*3+1]] + vert_score[inds[t*3+2]];
+	}
+
+	// The cache holds a few extra slots for the verts that get pushed out by
+	// each new triangle, so their scores can be updated.
+	vind_t  cache     [mesh_opt_score_cache + 3];
+	vind_t  cache_next[mesh_opt_score_cache + 3];
+	int32_t cache_count = 0;
+
+	int64_t  best_tri  = -1;
+	uint32_t scan_tri  = 0;
+	uint32_t out_count = 0;
+	while (out_count < tri_count) {
+		// When nothing in the cache has triangles left, fall back to the
+		// next triangle we haven't used yet.
+		if (best_tri < 0) {
+			while (tri_added[scan_tri]) scan_tri++;
+			best_tri = scan_tri;
+		}
+
+		uint32_t t = (uint32_t)best_tri;
+		tri_added[t] = true;
+		tri_score[t] = -1;
+		memcpy(&result[out_count * 3], &inds[t * 3], sizeof(vind_t) * 3);
+		out_count += 1;
+
+		// Remove the triangle from its verts, and push them to the front of
+		// the cache.
+		int32_t next_count = 0;
+		for (int32_t c = 0; c < 3; c++) {
+			vind_t v = inds[t * 3 + c];
+			for (uint32_t a = adj_start[v]; a < adj_start[v] + live_tris[v]; a++) {
+				if (adj[a] == t) {
+					adj[a] = adj[adj_start[v] + live_tris[v] - 1];
+					break;
+				}
+			}
+			live_tris[v] -= 1;
+			cache_next[next_count++] = v;
+		}
+		for (int32_t i = 0; i < cache_count; i++) {
+			vind_t v = cache[i];
+			if (v != cache_next[0] && v != cache_next[1] && v != cache_next[2])
+				cache_next[next_count++] = v;
+		}
+		memcpy(cache, cache_next, sizeof(vind_t) * next_count);
+		cache_count = next_count;
+
+		// Rescore everything the cache touched, and find our next triangle
+		// from there.
+		best_tri = -1;
+		float best_score = -1;
+		for (int32_t i = 0; i < cache_count; i++) {
+			vind_t v = cache[i];
+			cache_pos[v] = i < mesh_opt_score_cache ? i : -1;
+			float score = mesh_opt_vert_score(cache_pos[v], live_tris[v]);
+			float delta = score - vert_score[v];
+			vert_score[v] = score;
+			for (uint32_t a = adj_start[v]; a < adj_start[v] + live_tris[v]; a++) {
+				uint32_t adj_tri = adj[a];
+				tri_score[adj_tri] += delta;
+				if (tri_score[adj_tri] > best_score) {
+					best_score = tri_score[adj_tri];
+					best_tri   = adj_tri;
+				}
+			}
+		}
+		if (cache_count > mesh_opt_score_cache) cache_count = mesh_opt_score_cache;
+	}
+
+	memcpy(inds, result, sizeof(vind_t) * tri_count * 3);
+
+	sk_free(live_tris);
+	sk_free(adj_start);
+	sk_free(adj);
+	sk_free(cache_pos);
+	sk_free(vert_score);
+	sk_free(tri_score);
+	sk_free(tri_added);
+	sk_free(result);
+}
+
+///////////////////////////////////////////
+// Overdraw, based on Sander et al. "Fast Triangle Reordering for Vertex
+// Locality and Reduced Overdraw"
+///////////////////////////////////////////
+
+struct mesh_opt_cluster_t {
+	uint32_t start;
+	uint32_t count;
+	float    sort;
+};
+
+static int mesh_opt_cluster_cmp(const void *a, const void *b) {
+	const mesh_opt_cluster_t *ca = (const mesh_opt_cluster_t *)a;
+	const mesh_opt_cluster_t *cb = (const mesh_opt_cluster_t *)b;
+	if (ca->sort != cb->sort) return ca->sort > cb->sort ? -1 : 1;
+	return ca->start < cb->start ? -1 : 1;
+}
+
+///////////////////////////////////////////
+
+void mesh_opt_overdraw(vind_t *inds, uint32_t ind_count, const vert_t *verts, uint32_t vert_count) {
+	uint32_t tri_count = ind_count / 3;
+	if (tri_count < 2 || vert_count == 0) return;
+
+	// Split the triangle list into clusters wherever the cache starts cold,
+	// these are places where the order can change without costing us any
+	// extra vertex transforms.
+	uint32_t *stamps = sk_malloc_t(uint32_t, vert_count);
+	memset(stamps, 0, sizeof(uint32_t) * vert_count);
+
+	mesh_opt_cluster_t *clusters      = sk_malloc_t(mesh_opt_cluster_t, tri_count);
+	uint32_t            cluster_count = 0;
+	uint32_t            time          = mesh_opt_fifo_cache + 1;
+	for (uint32_t t = 0; t < tri_count; t++) {
+		int32_t misses = 0;
+		for (int32_t c = 0; c < 3; c++) {
+			vind_t v = inds[t * 3 + c];
+			if (time - stamps[v] > (uint32_t)mesh_opt_fifo_cache) {
+				stamps[v] = time;
+				time   += 1;
+				misses += 1;
+			}
+		}
+		if (t == 0 || misses == 3) {
+			clusters[cluster_count] = { t, 0, 0 };
+			cluster_count += 1;
+		}
+		clusters[cluster_count - 1].count += 1;
+	}
+	sk_free(stamps);
+
+	if (cluster_count > 1) {
+		// Area weighted centroid and normal for each cluster, and the mesh.
+		vec3  mesh_center = {};
+		float mesh_area   = 0;
+		vec3 *centers     = sk_malloc_t(vec3, cluster_count);
+		vec3 *normals     = sk_malloc_t(vec3, cluster_count);
+		for (uint32_t c = 0; c < cluster_count; c++) {
+			vec3  center = {};
+			vec3  normal = {};
+			float area   = 0;
+			for (uint32_t t = clusters[c].start; t < clusters[c].start + clusters[c].count; t++) {
+				vec3  a = verts[inds[t*3  ]].pos;
+				vec3  b = verts[inds[t*3+1]].pos;
+				vec3  d = verts[inds[t*3+2]].pos;
+				vec3  n = vec3_cross(b - a, d - a);
+				float w = vec3_magnitude(n);
+				center += (a + b + d) * (w / 3.0f);
+				normal += n;
+				area   += w;
+			}
+			mesh_center += center;
+			mesh_area   += area;
+			centers[c] = area > 0 ? center / area : verts[inds[clusters[c].start*3]].pos;
+			normals[c] = vec3_normalize(normal);
+		}
+		if (mesh_area > 0) mesh_center = mesh_center / mesh_area;
+
+		// Clusters facing out from the center of the mesh are the most likely
+		// to occlude others, so those go first.
+		for (uint32_t c = 0; c < cluster_count; c++) {
+			clusters[c].sort = vec3_dot(centers[c] - mesh_center, normals[c]);
+		}
+		qsort(clusters, cluster_count, sizeof(mesh_opt_cluster_t), mesh_opt_cluster_cmp);
+
+		vind_t  *result = sk_malloc_t(vind_t, tri_count * 3);
+		uint32_t curr   = 0;
+		for (uint32_t c = 0; c < cluster_count; c++) {
+			memcpy(&result[curr], &inds[clusters[c].start * 3], sizeof(vind_t) * clusters[c].count * 3);
+			curr += clusters[c].count * 3;
+		}
+		memcpy(inds, result, sizeof(vind_t) * tri_count * 3);
+
+		sk_free(result);
+		sk_free(centers);
+		sk_free(normals);
+	}
+	sk_free(clusters);
+}
+
+///////////////////////////////////////////
+// Vertex fetch
+///////////////////////////////////////////
+
+uint32_t mesh_opt_vertex_fetch(vind_t *inds, uint32_t ind_count, vert_t *verts, uint32_t vert_count, vind_t *out_remap) {
+	// Lay the verts out in the order the index buffer first uses them, so
+	// vertex fetches walk through memory linearly. Unused verts are dropped.
+	vind_t *remap = out_remap != nullptr ? out_remap : sk_malloc_t(vind_t, vert_count);
+	memset(remap, 0xFF, sizeof(vind_t) * vert_count);
+
+	vert_t  *result = sk_malloc_t(vert_t, vert_count);
+	uint32_t count  = 0;
+	for (uint32_t i = 0; i < ind_count; i++) {
+		vind_t v = inds[i];
+		if (remap[v] == (vind_t)-1) {
+			remap [v]     = count;
+			result[count] = verts[v];
+			count += 1;
+		}
+		inds[i] = remap[v];
+	}
+	memcpy(verts, result, sizeof(vert_t) * count);
+
+	sk_free(result);
+	if (out_remap == nullptr) sk_free(remap);
+	return count;
+}
+
+}
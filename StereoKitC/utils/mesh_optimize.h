@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../stereokit.h"
+
+namespace sk {
+
+float    mesh_opt_acmr        (const vind_t *inds, uint32_t ind_count, uint32_t vert_count);
+void     mesh_opt_vertex_cache(      vind_t *inds, uint32_t ind_count, uint32_t vert_count);
+void     mesh_opt_overdraw    (      vind_t *inds, uint32_t ind_count, const vert_t *verts, uint32_t vert_count);
+uint32_t mesh_opt_vertex_fetch(      vind_t *inds, uint32_t ind_count,       vert_t *verts, uint32_t vert_count, vind_t *out_remap);
+
+}
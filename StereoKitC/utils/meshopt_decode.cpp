@@ -0,0 +1,418 @@
+#include "meshopt_decode.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHOPT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define MESHOPT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace sk {
+
+// Vertex data is split into blocks that fit in 8k of scratch, and each byte
+// of the vertex is stored as a channel of zigzag deltas, packed into groups
+// of 16 bytes at 0, 2, 4 or 8 bits each.
+const uint8_t meshopt_vertex_header   = 0xA0;
+const uint8_t meshopt_index_header    = 0xE0;
+const uint8_t meshopt_sequence_header = 0xD0;
+const size_t  meshopt_block_bytes     = 8192;
+const size_t  meshopt_block_max       = 256;
+const size_t  meshopt_group_size      = 16;
+const size_t  meshopt_group_max_bytes = 24;
+const size_t  meshopt_tail_max        = 32;
+
+///////////////////////////////////////////
+// Vertex codec                          //
+///////////////////////////////////////////
+
+// Groups of 2 or 4 bit values, packed high bits first. Values that hit the
+// max are escapes for a full byte stored after the packed bits.
+template <int32_t bits>
+static const uint8_t *meshopt_group_bits(const uint8_t *data, uint8_t *out) {
+	const int32_t  per_byte = 8 / bits;
+	const uint8_t  limit    = (uint8_t)((1 << bits) - 1);
+	const uint8_t *var      = data + meshopt_group_size / per_byte;
+	for (int32_t i = 0; i < (int32_t)meshopt_group_size; i++) {
+		uint8_t enc = (uint8_t)(data[i / per_byte] >> (8 - bits - (i % per_byte) * bits)) & limit;
+		out[i] = enc == limit ? *var : enc;
+		var   += enc == limit;
+	}
+	return var;
+}
+
+///////////////////////////////////////////
+
+static const uint8_t *meshopt_decode_bytes(const uint8_t *data, const uint8_t *data_end, uint8_t *out, size_t out_size) {
+	// Two bits of header for each group, rounded up to whole bytes
+	const uint8_t *header      = data;
+	size_t         header_size = (out_size / meshopt_group_size + 3) / 4;
+	if ((size_t)(data_end - data) < header_size) return nullptr;
+	data += header_size;
+
+	for (size_t i = 0; i < out_size; i += meshopt_group_size) {
+		// The encoder always leaves a tail larger than any group, so this is
+		// the only bounds check a group needs.
+		if ((size_t)(data_end - data) < meshopt_group_max_bytes) return nullptr;
+
+		size_t  group     = i / meshopt_group_size;
+		int32_t bits_log2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+		switch (bits_log2) {
+		case 0:  memset(out + i, 0, meshopt_group_size); break;
+		case 1:  data = meshopt_group_bits<2>(data, out + i); break;
+		case 2:  data = meshopt_group_bits<4>(data, out + i); break;
+		default: memcpy(out + i, data, meshopt_group_size); data += meshopt_group_size; break;
+		}
+	}
+	return data;
+}
+
+///////////////////////////////////////////
+
+// Undoes the zigzag and delta encoding for one vertex, using the previous
+// vertex as the base. Vertex strides are always a multiple of 4, so the SIMD
+// path handles 16 channels at a time and finishes the rest a dword at a time.
+static void meshopt_delta_row(const uint8_t *deltas, const uint8_t *prev, uint8_t *out, size_t stride) {
+	size_t k = 0;
+#if defined(MESHOPT_SSE2)
+	const __m128i mask = _mm_set1_epi8(0x7F);
+	const __m128i one  = _mm_set1_epi8(1);
+	for (; k + 16 <= stride; k += 16) {
+		__m128i v   = _mm_loadu_si128((const __m128i *)(deltas + k));
+		__m128i p   = _mm_loadu_si128((const __m128i *)(prev   + k));
+		__m128i sh  = _mm_and_si128(_mm_srli_epi16(v, 1), mask);
+		__m128i neg = _mm_sub_epi8 (_mm_setzero_si128(), _mm_and_si128(v, one));
+		_mm_storeu_si128((__m128i *)(out + k), _mm_add_epi8(_mm_xor_si128(sh, neg), p));
+	}
+#elif defined(MESHOPT_NEON)
+	const uint8x16_t one = vdupq_n_u8(1);
+	for (; k + 16 <= stride; k += 16) {
+		uint8x16_t v   = vld1q_u8(deltas + k);
+		uint8x16_t p   = vld1q_u8(prev   + k);
+		uint8x16_t neg = vreinterpretq_u8_s8(vnegq_s8(vreinterpretq_s8_u8(vandq_u8(v, one))));
+		vst1q_u8(out + k, vaddq_u8(veorq_u8(vshrq_n_u8(v, 1), neg), p));
+	}
+#endif
+	for (; k < stride; k++) {
+		uint8_t v = deltas[k];
+		out[k] = (uint8_t)(((v >> 1) ^ (uint8_t)-(v & 1)) + prev[k]);
+	}
+}
+
+///////////////////////////////////////////
+
+static const uint8_t *meshopt_decode_block(const uint8_t *data, const uint8_t *data_end, uint8_t *out, size_t count, size_t stride, uint8_t *last_vertex) {
+	uint8_t channel[meshopt_block_max];
+	uint8_t rows   [meshopt_block_bytes];
+	size_t  count_aligned = (count + meshopt_group_size - 1) & ~(meshopt_group_size - 1);
+
+	// Channels are stored one after another, so interleave them back into
+	// vertex order before resolving the deltas.
+	for (size_t k = 0; k < stride; k++) {
+		data = meshopt_decode_bytes(data, data_end, channel, count_aligned);
+		if (!data) return nullptr;
+		for (size_t i = 0; i < count; i++)
+			rows[i * stride + k] = channel[i];
+	}
+
+	const uint8_t *prev = last_vertex;
+	for (size_t i = 0; i < count; i++) {
+		meshopt_delta_row(&rows[i * stride], prev, &out[i * stride], stride);
+		prev = &out[i * stride];
+	}
+	memcpy(last_vertex, prev, stride);
+	return data;
+}
+
+///////////////////////////////////////////
+
+bool meshopt_decode_vertices(void *out_data, size_t count, size_t stride, const uint8_t *src, size_t src_size) {
+	if (stride == 0 || stride > 256 || stride % 4 != 0) return false;
+	if (src_size < 1 + stride) return false;
+
+	const uint8_t *data     = src;
+	const uint8_t *data_end = src + src_size;
+	if ((*data & 0xF0) != meshopt_vertex_header) return false;
+	if ((*data & 0x0F) != 0) return false;
+	data++;
+
+	// The first vertex's base values live at the very end of the stream
+	uint8_t last_vertex[256];
+	memcpy(last_vertex, data_end - stride, stride);
+
+	size_t block_size = (meshopt_block_bytes / stride) & ~(meshopt_group_size - 1);
+	if (block_size > meshopt_block_max) block_size = meshopt_block_max;
+
+	uint8_t *out = (uint8_t *)out_data;
+	for (size_t offset = 0; offset < count; offset += block_size) {
+		size_t block_count = count - offset < block_size ? count - offset : block_size;
+		data = meshopt_decode_block(data, data_end, out + offset * stride, block_count, stride, last_vertex);
+		if (!data) return false;
+	}
+
+	size_t tail_size = stride < meshopt_tail_max ? meshopt_tail_max : stride;
+	return (size_t)(data_end - data) == tail_size;
+}
+
+///////////////////////////////////////////
+// Index codecs                          //
+///////////////////////////////////////////
+
+static uint32_t meshopt_read_vbyte(const uint8_t *&data) {
+	uint8_t lead = *data++;
+	if (lead < 128) return lead;
+
+	uint32_t result = lead & 127;
+	uint32_t shift  = 7;
+	for (int32_t i = 0; i < 4; i++) {
+		uint8_t group = *data++;
+		result |= (uint32_t)(group & 127) << shift;
+		shift  += 7;
+		if (group < 128) break;
+	}
+	return result;
+}
+
+///////////////////////////////////////////
+
+inline uint32_t meshopt_read_index(const uint8_t *&data, uint32_t last) {
+	uint32_t v = meshopt_read_vbyte(data);
+	return last + ((v >> 1) ^ (uint32_t)-(int32_t)(v & 1));
+}
+
+///////////////////////////////////////////
+
+inline void meshopt_write_tri(void *out, size_t i, size_t stride, uint32_t a, uint32_t b, uint32_t c) {
+	if (stride == 2) {
+		uint16_t *inds = (uint16_t *)out;
+		inds[i] = (uint16_t)a; inds[i+1] = (uint16_t)b; inds[i+2] = (uint16_t)c;
+	} else {
+		uint32_t *inds = (uint32_t *)out;
+		inds[i] = a; inds[i+1] = b; inds[i+2] = c;
+	}
+}
+
+///////////////////////////////////////////
+
+// Triangles are coded against a 16 entry FIFO of recent edges and a 16 entry
+// FIFO of recent vertices. The push order here has to match the encoder
+// exactly, or every triangle after the first mismatch decodes wrong.
+bool meshopt_decode_triangles(void *out_inds, size_t count, size_t stride, const uint8_t *src, size_t src_size) {
+	if (count % 3 != 0 || (stride != 2 && stride != 4)) return false;
+
+	// Smallest valid stream is a header, a code per triangle, and the 16
+	// byte aux table at the end.
+	if (src_size < 1 + count / 3 + 16) return false;
+	if ((src[0] & 0xF0) != meshopt_index_header) return false;
+	int32_t version = src[0] & 0x0F;
+	if (version > 1) return false;
+
+	uint32_t edge_fifo[16][2];
+	uint32_t vert_fifo[16];
+	memset(edge_fifo, 0xFF, sizeof(edge_fifo));
+	memset(vert_fifo, 0xFF, sizeof(vert_fifo));
+	size_t   edge_at = 0;
+	size_t   vert_at = 0;
+	uint32_t next    = 0;
+	uint32_t last    = 0;
+	int32_t  fec_max = version >= 1 ? 13 : 15;
+
+	const uint8_t *code      = src + 1;
+	const uint8_t *data      = code + count / 3;
+	const uint8_t *data_end  = src + src_size - 16;
+	const uint8_t *aux_table = data_end;
+
+#define MESHOPT_PUSH_EDGE(a, b) { edge_fifo[edge_at][0] = (a); edge_fifo[edge_at][1] = (b); edge_at = (edge_at + 1) & 15; }
+#define MESHOPT_PUSH_VERT(v, cond) { vert_fifo[vert_at] = (v); vert_at = (vert_at + (cond)) & 15; }
+
+	for (size_t i = 0; i < count; i += 3) {
+		// A triangle reads at most 16 bytes, which the aux table covers
+		if (data > data_end) return false;
+
+		uint8_t code_tri = *code++;
+		if (code_tri < 0xF0) {
+			// Edge from the FIFO, plus a third vertex
+			int32_t  fe  = code_tri >> 4;
+			int32_t  fec = code_tri & 15;
+			uint32_t a   = edge_fifo[(edge_at - 1 - fe) & 15][0];
+			uint32_t b   = edge_fifo[(edge_at - 1 - fe) & 15][1];
+			uint32_t c;
+			if (fec < fec_max) {
+				c = fec == 0 ? next : vert_fifo[(vert_at - 1 - fec) & 15];
+				next += fec == 0;
+				MESHOPT_PUSH_VERT(c, fec == 0);
+			} else {
+				// Version 1 codes 13 and 14 are -1 and +1 from the last
+				// free index.
+				last = c = fec != 15
+					? last + (uint32_t)(fec - (fec ^ 3))
+					: meshopt_read_index(data, last);
+				MESHOPT_PUSH_VERT(c, 1);
+			}
+			meshopt_write_tri(out_inds, i, stride, a, b, c);
+			MESHOPT_PUSH_EDGE(c, b);
+			MESHOPT_PUSH_EDGE(a, c);
+		} else {
+			int32_t  feb, fec;
+			uint32_t a, b, c;
+			if (code_tri < 0xFE) {
+				// Common vertex patterns come from the aux table
+				uint8_t code_aux = aux_table[code_tri & 15];
+				feb = code_aux >> 4;
+				fec = code_aux & 15;
+
+				a = next++;
+				b = feb == 0 ? next : vert_fifo[(vert_at - feb) & 15];
+				next += feb == 0;
+				c = fec == 0 ? next : vert_fifo[(vert_at - fec) & 15];
+				next += fec == 0;
+			} else {
+				// Everything else reads a full aux byte, and may contain
+				// free indices.
+				uint8_t code_aux = *data++;
+				int32_t fea = code_tri == 0xFE ? 0 : 15;
+				feb = code_aux >> 4;
+				fec = code_aux & 15;
+				if (code_aux == 0) next = 0;
+
+				a = fea == 0 ? next++ : 0;
+				b = feb == 0 ? next++ : vert_fifo[(vert_at - feb) & 15];
+				c = fec == 0 ? next++ : vert_fifo[(vert_at - fec) & 15];
+				if (fea == 15) last = a = meshopt_read_index(data, last);
+				if (feb == 15) last = b = meshopt_read_index(data, last);
+				if (fec == 15) last = c = meshopt_read_index(data, last);
+			}
+			meshopt_write_tri(out_inds, i, stride, a, b, c);
+			MESHOPT_PUSH_VERT(a, 1);
+			MESHOPT_PUSH_VERT(b, feb == 0 || feb == 15);
+			MESHOPT_PUSH_VERT(c, fec == 0 || fec == 15);
+			MESHOPT_PUSH_EDGE(b, a);
+			MESHOPT_PUSH_EDGE(c, b);
+			MESHOPT_PUSH_EDGE(a, c);
+		}
+	}
+
+#undef MESHOPT_PUSH_EDGE
+#undef MESHOPT_PUSH_VERT
+
+	// All the data should be used, stopping right at the aux table
+	return data == data_end;
+}
+
+///////////////////////////////////////////
+
+// Index sequences are zigzag deltas against one of two running baselines,
+// with the low bit of each value picking the baseline.
+bool meshopt_decode_indices(void *out_inds, size_t count, size_t stride, const uint8_t *src, size_t src_size) {
+	if (stride != 2 && stride != 4) return false;
+
+	// Smallest valid stream is a header, a byte per index, and a 4 byte tail
+	if (src_size < 1 + count + 4) return false;
+	if ((src[0] & 0xF0) != meshopt_sequence_header) return false;
+	if ((src[0] & 0x0F) > 1) return false;
+
+	const uint8_t *data     = src + 1;
+	const uint8_t *data_end = src + src_size - 4;
+	uint32_t       last[2]  = {};
+	for (size_t i = 0; i < count; i++) {
+		// An index reads at most 5 bytes, which the tail covers
+		if (data >= data_end) return false;
+
+		uint32_t v       = meshopt_read_vbyte(data);
+		uint32_t current = v & 1;
+		v >>= 1;
+		uint32_t index = last[current] + ((v >> 1) ^ (uint32_t)-(int32_t)(v & 1));
+		last[current] = index;
+
+		if (stride == 2) ((uint16_t *)out_inds)[i] = (uint16_t)index;
+		else             ((uint32_t *)out_inds)[i] = index;
+	}
+	return data == data_end;
+}
+
+///////////////////////////////////////////
+// Filters                               //
+///////////////////////////////////////////
+
+template <typename T>
+static void meshopt_octahedral(T *data, size_t count) {
+	const float max = (float)((1 << (sizeof(T) * 8 - 1)) - 1);
+	for (size_t i = 0; i < count; i++) {
+		// z is stored as the octahedral 1, so reconstruct it against that,
+		// then fold the lower hemisphere back out.
+		T    *n = &data[i * 4];
+		float x = (float)n[0];
+		float y = (float)n[1];
+		float z = (float)n[2] - fabsf(x) - fabsf(y);
+		float t = z >= 0 ? 0 : z;
+		x += x >= 0 ? t : -t;
+		y += y >= 0 ? t : -t;
+
+		float s = max / sqrtf(x*x + y*y + z*z);
+		n[0] = (T)(int32_t)(x * s + (x >= 0 ? 0.5f : -0.5f));
+		n[1] = (T)(int32_t)(y * s + (y >= 0 ? 0.5f : -0.5f));
+		n[2] = (T)(int32_t)(z * s + (z >= 0 ? 0.5f : -0.5f));
+	}
+}
+
+///////////////////////////////////////////
+
+void meshopt_filter_octahedral(void *data, size_t count, size_t stride) {
+	if      (stride == 4) meshopt_octahedral((int8_t  *)data, count);
+	else if (stride == 8) meshopt_octahedral((int16_t *)data, count);
+}
+
+///////////////////////////////////////////
+
+void meshopt_filter_quaternion(void *data, size_t count, size_t stride) {
+	if (stride != 8) return;
+
+	const float    scale = 1.0f / sqrtf(2.0f);
+	int16_t       *q     = (int16_t *)data;
+	for (size_t i = 0; i < count; i++, q += 4) {
+		// The 4th component holds the scale in its high bits, and which
+		// component was dropped in its low 2.
+		int32_t sf = q[3] | 3;
+		float   ss = scale / (float)sf;
+		float   x  = q[0] * ss;
+		float   y  = q[1] * ss;
+		float   z  = q[2] * ss;
+		float   ww = 1.0f - x*x - y*y - z*z;
+		float   w  = sqrtf(ww >= 0 ? ww : 0);
+
+		int32_t xf = (int32_t)(x * 32767.0f + (x >= 0 ? 0.5f : -0.5f));
+		int32_t yf = (int32_t)(y * 32767.0f + (y >= 0 ? 0.5f : -0.5f));
+		int32_t zf = (int32_t)(z * 32767.0f + (z >= 0 ? 0.5f : -0.5f));
+		int32_t wf = (int32_t)(w * 32767.0f + 0.5f);
+
+		int32_t qc = q[3] & 3;
+		q[(qc + 1) & 3] = (int16_t)xf;
+		q[(qc + 2) & 3] = (int16_t)yf;
+		q[(qc + 3) & 3] = (int16_t)zf;
+		q[(qc + 0) & 3] = (int16_t)wf;
+	}
+}
+
+///////////////////////////////////////////
+
+// Each 32 bit value is a 24 bit signed mantissa with an 8 bit signed
+// exponent, expanded here into a regular float.
+void meshopt_filter_exponential(void *data, size_t count, size_t stride) {
+	uint32_t *values = (uint32_t *)data;
+	size_t    total  = count * (stride / 4);
+	for (size_t i = 0; i < total; i++) {
+		uint32_t v = values[i];
+		int32_t  m = (int32_t)(v << 8) >> 8;
+		int32_t  e = (int32_t)v >> 24;
+
+		union { float f; uint32_t u; } result;
+		result.u = (uint32_t)(e + 127) << 23;
+		result.f = result.f * (float)m;
+		values[i] = result.u;
+	}
+}
+
+}
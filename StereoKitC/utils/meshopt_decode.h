@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../stereokit.h"
+
+namespace sk {
+
+// Decoders for the EXT_meshopt_compression glTF extension. These match the
+// version 0 vertex codec and version 0/1 index codecs from meshoptimizer, and
+// decode into caller owned memory of count*stride bytes. Filters are applied
+// in-place after the vertex codec has run.
+
+bool meshopt_decode_vertices  (void *out_data, size_t count, size_t stride, const uint8_t *src, size_t src_size);
+bool meshopt_decode_triangles (void *out_inds, size_t count, size_t stride, const uint8_t *src, size_t src_size);
+bool meshopt_decode_indices   (void *out_inds, size_t count, size_t stride, const uint8_t *src, size_t src_size);
+
+void meshopt_filter_octahedral (void *data, size_t count, size_t stride);
+void meshopt_filter_quaternion (void *data, size_t count, size_t stride);
+void meshopt_filter_exponential(void *data, size_t count, size_t stride);
+
+}
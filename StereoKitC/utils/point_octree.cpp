@@ -0,0 +1,702 @@
+#include "point_octree.h"
+#include "../log.h"
+#include "../sk_math.h"
+#include "../sk_memory.h"
+#include "../libraries/array.h"
+#include "../libraries/stref.h"
+#include "../platforms/platform.h"
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdlib.h>
+
+namespace sk {
+
+// Leaf nodes split once they have more than this many points. This is also
+// the cap for how many points a lower LOD node can hold.
+const int32_t pt_leaf_max      = 32768;
+// Leaves at the deepest level can't split any further, so they're capped
+// here instead, keeping a random sample of their points.
+const int32_t pt_leaf_limit    = pt_leaf_max * 8;
+// How many points we pull from the PLY file at a time.
+const int32_t pt_stream_points = 65536;
+// The memory budget for buffering leaf points before they go to disk.
+const int64_t pt_buffer_bytes  = 64 * 1024 * 1024;
+
+///////////////////////////////////////////
+// Streaming PLY reader
+///////////////////////////////////////////
+
+enum ply_type_ {
+	ply_type_none,
+	ply_type_int8,
+	ply_type_uint8,
+	ply_type_int16,
+	ply_type_uint16,
+	ply_type_int32,
+	ply_type_uint32,
+	ply_type_float32,
+	ply_type_float64,
+};
+
+enum ply_attr_ {
+	ply_attr_x,
+	ply_attr_y,
+	ply_attr_z,
+	ply_attr_r,
+	ply_attr_g,
+	ply_attr_b,
+	ply_attr_a,
+	ply_attr_max,
+};
+
+struct ply_stream_t {
+	FILE    *fp;
+	bool     swap_endian;
+	int64_t  count;
+	int64_t  remaining;
+	int32_t  stride;
+	int32_t  offsets[ply_attr_max];
+	uint8_t  types  [ply_attr_max];
+	int64_t  data_start;
+	uint64_t file_size;
+	uint64_t file_time;
+	uint8_t *buffer;
+};
+
+///////////////////////////////////////////
+
+static ply_type_ ply_type_parse(const stref_t &word) {
+	if (stref_equals(word, "char"  ) || stref_equals(word, "int8"   )) return ply_type_int8;
+	if (stref_equals(word, "uchar" ) || stref_equals(word, "uint8"  )) return ply_type_uint8;
+	if (stref_equals(word, "short" ) || stref_equals(word, "int16"  )) return ply_type_int16;
+	if (stref_equals(word, "ushort") || stref_equals(word, "uint16" )) return ply_type_uint16;
+	if (stref_equals(word, "int"   ) || stref_equals(word, "int32"  )) return ply_type_int32;
+	if (stref_equals(word, "uint"  ) || stref_equals(word, "uint32" )) return ply_type_uint32;
+	if (stref_equals(word, "float" ) || stref_equals(word, "float32")) return ply_type_float32;
+	if (stref_equals(word, "double") || stref_equals(word, "float64")) return ply_type_float64;
+	return ply_type_none;
+}
+
+///////////////////////////////////////////
+
+static int32_t ply_type_size(uint8_t type) {
+	switch (type) {
+	case ply_type_int8:    case ply_type_uint8:   return 1;
+	case ply_type_int16:   case ply_type_uint16:  return 2;
+	case ply_type_int32:   case ply_type_uint32:
+	case ply_type_float32:                        return 4;
+	case ply_type_float64:                        return 8;
+	default:                                      return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+static int32_t ply_attr_parse(const stref_t &word) {
+	if (stref_equals(word, "x")) return ply_attr_x;
+	if (stref_equals(word, "y")) return ply_attr_y;
+	if (stref_equals(word, "z")) return ply_attr_z;
+	if (stref_equals(word, "red"  ) || stref_equals(word, "r") || stref_equals(word, "diffuse_red"  )) return ply_attr_r;
+	if (stref_equals(word, "green") || stref_equals(word, "g") || stref_equals(word, "diffuse_green")) return ply_attr_g;
+	if (stref_equals(word, "blue" ) || stref_equals(word, "b") || stref_equals(word, "diffuse_blue" )) return ply_attr_b;
+	if (stref_equals(word, "alpha") || stref_equals(word, "a") || stref_equals(word, "diffuse_alpha")) return ply_attr_a;
+	return -1;
+}
+
+///////////////////////////////////////////
+
+static double ply_value(const uint8_t *src, uint8_t type, bool swap_endian) {
+	uint8_t bytes[8];
+	int32_t size = ply_type_size(type);
+	if (swap_endian) { for (int32_t i = 0; i < size; i++) bytes[i] = src[size - 1 - i]; }
+	else             { memcpy(bytes, src, size); }
+
+	switch (type) {
+	case ply_type_int8:    { int8_t   v; memcpy(&v, bytes, 1); return v; }
+	case ply_type_uint8:   { uint8_t  v; memcpy(&v, bytes, 1); return v; }
+	case ply_type_int16:   { int16_t  v; memcpy(&v, bytes, 2); return v; }
+	case ply_type_uint16:  { uint16_t v; memcpy(&v, bytes, 2); return v; }
+	case ply_type_int32:   { int32_t  v; memcpy(&v, bytes, 4); return v; }
+	case ply_type_uint32:  { uint32_t v; memcpy(&v, bytes, 4); return v; }
+	case ply_type_float32: { float    v; memcpy(&v, bytes, 4); return v; }
+	case ply_type_float64: { double   v; memcpy(&v, bytes, 8); return v; }
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+static uint8_t ply_color(const uint8_t *src, uint8_t type, bool swap_endian) {
+	if (type == ply_type_uint8) return *src;
+
+	double value = ply_value(src, type, swap_endian);
+	if      (type == ply_type_uint16)                              value = value / 257.0;
+	else if (type == ply_type_float32 || type == ply_type_float64) value = value * 255.0;
+	return (uint8_t)fmax(0, fmin(255, value + 0.5));
+}
+
+///////////////////////////////////////////
+
+static void ply_stream_close(ply_stream_t *ply) {
+	if (ply->fp) fclose(ply->fp);
+	sk_free(ply->buffer);
+	*ply = {};
+}
+
+///////////////////////////////////////////
+
+static bool ply_stream_open(const char *filename, ply_stream_t *out_ply) {
+	*out_ply = {};
+	FILE *fp = platform_file_open(filename, "rb");
+	if (fp == nullptr) return false;
+
+	platform_file_seek(fp, 0, SEEK_END);
+	uint64_t file_size = (uint64_t)platform_file_tell(fp);
+	platform_file_seek(fp, 0, SEEK_SET);
+
+	// PLY headers are tiny, so we can grab a chunk that is certainly larger
+	// than it, and work from there.
+	char   header[16 * 1024 + 1];
+	size_t header_size = fread(header, 1, sizeof(header) - 1, fp);
+	header[header_size] = '\0';
+	char *header_end = strstr(header, "end_header");
+	if (header_size < 3 || memcmp(header, "ply", 3) != 0 || header_end == nullptr) {
+		log_errf("Point cloud '%s' is not a valid PLY file.", filename);
+		fclose(fp);
+		return false;
+	}
+	header_end += strlen("end_header");
+	if (*header_end == '\r') header_end++;
+	if (*header_end == '\n') header_end++;
+	int64_t data_start = header_end - header;
+	*header_end = '\0';
+
+	ply_stream_t ply = {};
+	ply.fp        = fp;
+	ply.file_size = file_size;
+	ply.file_time = platform_file_modified(fp);
+	for (int32_t i = 0; i < ply_attr_max; i++) ply.offsets[i] = -1;
+
+	// Elements come one after another, so the vertex data starts after any
+	// elements listed before it.
+	bool     binary       = false;
+	bool     found_verts  = false;
+	bool     in_verts     = false;
+	bool     elem_list    = false;
+	int64_t  elem_count   = 0;
+	int64_t  elem_stride  = 0;
+	int64_t  skip_bytes   = 0;
+	stref_t  data         = stref_make(header);
+	stref_t  line         = {};
+	while (stref_nextline(data, line)) {
+		stref_t word = {};
+		if (!stref_nextword(line, word)) continue;
+
+		if (stref_equals(word, "format")) {
+			stref_nextword(line, word);
+			binary          = !stref_equals(word, "ascii");
+			ply.swap_endian = stref_equals(word, "binary_big_endian");
+		} else if (stref_equals(word, "element")) {
+			if (!found_verts) {
+				if (elem_list && elem_count > 0) {
+					log_errf("Point cloud '%s' has variable sized elements before its vertices, which isn't supported.", filename);
+					ply_stream_close(&ply);
+					return false;
+				}
+				skip_bytes += elem_count * elem_stride;
+			}
+			in_verts    = false;
+			elem_list   = false;
+			elem_count  = 0;
+			elem_stride = 0;
+
+			stref_nextword(line, word);
+			bool is_verts = stref_equals(word, "vertex") && !found_verts;
+			if (stref_nextword(line, word)) {
+				char count_str[32];
+				stref_copy_to(word, count_str, sizeof(count_str));
+				elem_count = strtoll(count_str, nullptr, 10);
+			}
+			if (is_verts) {
+				found_verts = true;
+				in_verts    = true;
+				ply.count   = elem_count;
+			}
+		} else if (stref_equals(word, "property")) {
+			stref_nextword(line, word);
+			if (stref_equals(word, "list")) {
+				elem_list = true;
+				if (in_verts) {
+					log_errf("Point cloud '%s' has list properties on its vertices, which isn't supported.", filename);
+					ply_stream_close(&ply);
+					return false;
+				}
+				continue;
+			}
+			ply_type_ type = ply_type_parse(word);
+			if (type == ply_type_none) {
+				log_errf("Point cloud '%s' has an unknown property type.", filename);
+				ply_stream_close(&ply);
+				return false;
+			}
+			if (in_verts && stref_nextword(line, word)) {
+				int32_t attr = ply_attr_parse(word);
+				if (attr >= 0) {
+					ply.offsets[attr] = ply.stride;
+					ply.types  [attr] = (uint8_t)type;
+				}
+				ply.stride += ply_type_size(type);
+			}
+			elem_stride += ply_type_size(type);
+		}
+	}
+
+	if (!binary) {
+		log_errf("Point cloud '%s' is an ASCII PLY, only binary PLY files can be streamed.", filename);
+		ply_stream_close(&ply);
+		return false;
+	}
+	if (!found_verts || ply.count <= 0 || ply.offsets[ply_attr_x] < 0 || ply.offsets[ply_attr_y] < 0 || ply.offsets[ply_attr_z] < 0) {
+		log_errf("Point cloud '%s' has no vertex positions.", filename);
+		ply_stream_close(&ply);
+		return false;
+	}
+
+	ply.data_start = data_start + skip_bytes;
+	if ((uint64_t)(ply.data_start + ply.count * ply.stride) > file_size) {
+		log_errf("Point cloud '%s' is shorter than its header describes.", filename);
+		ply_stream_close(&ply);
+		return false;
+	}
+	ply.buffer = sk_malloc_t(uint8_t, (size_t)ply.stride * pt_stream_points);
+
+	*out_ply = ply;
+	return true;
+}
+
+///////////////////////////////////////////
+
+static void ply_stream_rewind(ply_stream_t *ply) {
+	platform_file_seek(ply->fp, ply->data_start, SEEK_SET);
+	ply->remaining = ply->count;
+}
+
+///////////////////////////////////////////
+
+// Reads the next batch of points, and returns how many were kept. Points
+// that aren't finite get dropped, so keep going until remaining is 0.
+static int32_t ply_stream_next(ply_stream_t *ply, cloud_point_t *out_points) {
+	int32_t count = (int32_t)(ply->remaining < pt_stream_points ? ply->remaining : pt_stream_points);
+	if (count <= 0) return 0;
+	count = (int32_t)fread(ply->buffer, ply->stride, count, ply->fp);
+	ply->remaining -= count;
+	if (count <= 0) { ply->remaining = 0; return 0; }
+
+	bool    has_color = ply->offsets[ply_attr_r] >= 0 && ply->offsets[ply_attr_g] >= 0 && ply->offsets[ply_attr_b] >= 0;
+	bool    has_alpha = ply->offsets[ply_attr_a] >= 0;
+	bool    fast_pos  = !ply->swap_endian &&
+		ply->types[ply_attr_x] == ply_type_float32 &&
+		ply->types[ply_attr_y] == ply_type_float32 &&
+		ply->types[ply_attr_z] == ply_type_float32;
+	int32_t kept = 0;
+	for (int32_t i = 0; i < count; i++) {
+		const uint8_t *src = &ply->buffer[i * ply->stride];
+		cloud_point_t *pt  = &out_points[kept];
+		if (fast_pos) {
+			memcpy(&pt->pos.x, &src[ply->offsets[ply_attr_x]], sizeof(float));
+			memcpy(&pt->pos.y, &src[ply->offsets[ply_attr_y]], sizeof(float));
+			memcpy(&pt->pos.z, &src[ply->offsets[ply_attr_z]], sizeof(float));
+		} else {
+			pt->pos.x = (float)ply_value(&src[ply->offsets[ply_attr_x]], ply->types[ply_attr_x], ply->swap_endian);
+			pt->pos.y = (float)ply_value(&src[ply->offsets[ply_attr_y]], ply->types[ply_attr_y], ply->swap_endian);
+			pt->pos.z = (float)ply_value(&src[ply->offsets[ply_attr_z]], ply->types[ply_attr_z], ply->swap_endian);
+		}
+		pt->color = has_color
+			? color32{
+				ply_color(&src[ply->offsets[ply_attr_r]], ply->types[ply_attr_r], ply->swap_endian),
+				ply_color(&src[ply->offsets[ply_attr_g]], ply->types[ply_attr_g], ply->swap_endian),
+				ply_color(&src[ply->offsets[ply_attr_b]], ply->types[ply_attr_b], ply->swap_endian),
+				has_alpha ? ply_color(&src[ply->offsets[ply_attr_a]], ply->types[ply_attr_a], ply->swap_endian) : (uint8_t)255 }
+			: color32{ 255, 255, 255, 255 };
+		if (isfinite(pt->pos.x) && isfinite(pt->pos.y) && isfinite(pt->pos.z))
+			kept += 1;
+	}
+	return kept;
+}
+
+///////////////////////////////////////////
+// Octree building
+///////////////////////////////////////////
+
+struct pt_build_node_t {
+	int32_t  level;
+	int32_t  x, y, z;
+	uint32_t count;
+	int32_t  children[8];
+	int32_t  leaf;
+};
+
+struct pt_leaf_t {
+	int32_t           node;
+	cloud_point_t    *buffer;
+	int32_t           buffer_count;
+	array_t<uint64_t> blocks;
+};
+
+struct pt_build_t {
+	int32_t                  levels;
+	uint32_t                *counts[9];
+	int32_t                 *cell_leaf;
+	vec3                     min;
+	float                    size;
+	array_t<pt_build_node_t> nodes;
+	array_t<pt_leaf_t>       leaves;
+	int32_t                  block_points;
+	FILE                    *temp;
+	FILE                    *out;
+	point_octree_node_t     *out_nodes;
+	uint32_t                 shuffle_seed;
+};
+
+///////////////////////////////////////////
+
+static inline int64_t pt_cell_index(int32_t level, int32_t x, int32_t y, int32_t z) {
+	int64_t res = (int64_t)1 << level;
+	return (z * res + y) * res + x;
+}
+
+///////////////////////////////////////////
+
+static inline int64_t pt_point_cell(const pt_build_t *b, vec3 pt) {
+	int32_t res   = 1 << b->levels;
+	float   scale = res / b->size;
+	int32_t x = (int32_t)((pt.x - b->min.x) * scale);
+	int32_t y = (int32_t)((pt.y - b->min.y) * scale);
+	int32_t z = (int32_t)((pt.z - b->min.z) * scale);
+	x = x < 0 ? 0 : (x >= res ? res - 1 : x);
+	y = y < 0 ? 0 : (y >= res ? res - 1 : y);
+	z = z < 0 ? 0 : (z >= res ? res - 1 : z);
+	return pt_cell_index(b->levels, x, y, z);
+}
+
+///////////////////////////////////////////
+
+static int32_t pt_subdivide(pt_build_t *b, int32_t level, int32_t x, int32_t y, int32_t z) {
+	uint32_t count = b->counts[level][pt_cell_index(level, x, y, z)];
+	if (count == 0) return -1;
+
+	int32_t id = b->nodes.add({ level, x, y, z, count, {-1,-1,-1,-1,-1,-1,-1,-1}, -1 });
+	if (count <= (uint32_t)pt_leaf_max || level == b->levels) {
+		// Map every fine cell this leaf covers over to it
+		pt_leaf_t new_leaf = {};
+		new_leaf.node = id;
+		int32_t leaf = b->leaves.add(new_leaf);
+		int32_t span = 1 << (b->levels - level);
+		for (int32_t cz = z*span; cz < (z+1)*span; cz++) {
+		for (int32_t cy = y*span; cy < (y+1)*span; cy++) {
+		for (int32_t cx = x*span; cx < (x+1)*span; cx++) {
+			b->cell_leaf[pt_cell_index(b->levels, cx, cy, cz)] = leaf;
+		} } }
+		b->nodes[id].leaf = leaf;
+		return id;
+	}
+
+	for (int32_t c = 0; c < 8; c++) {
+		int32_t child = pt_subdivide(b, level + 1, x*2 + (c&1), y*2 + ((c>>1)&1), z*2 + ((c>>2)&1));
+		b->nodes[id].children[c] = child;
+	}
+	return id;
+}
+
+///////////////////////////////////////////
+
+static void pt_shuffle(cloud_point_t *points, int32_t count, uint32_t seed) {
+	// Shuffled points mean that any prefix of the list is an even sample of
+	// the whole thing, which is what makes the lower LODs work.
+	uint32_t state = seed * 0x9E3779B9u + 1;
+	for (int32_t i = count - 1; i > 0; i--) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		int32_t       j   = (int32_t)(state % (uint32_t)(i + 1));
+		cloud_point_t tmp = points[i];
+		points[i] = points[j];
+		points[j] = tmp;
+	}
+}
+
+///////////////////////////////////////////
+
+static bounds_t pt_points_bounds(const cloud_point_t *points, int32_t count) {
+	vec3 min = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	vec3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int32_t i = 0; i < count; i++) {
+		min = vec3_min(min, points[i].pos);
+		max = vec3_max(max, points[i].pos);
+	}
+	return bounds_t{ (min + max) / 2.0f, max - min };
+}
+
+///////////////////////////////////////////
+
+static bool pt_write_points(pt_build_t *b, int32_t node_id, cloud_point_t *points, int32_t count) {
+	const pt_build_node_t *node = &b->nodes[node_id];
+	point_octree_node_t   *out  = &b->out_nodes[node_id];
+	float cell_size = b->size / (float)(1 << node->level);
+
+	out->offset  = (uint64_t)platform_file_tell(b->out);
+	out->count   = count;
+	out->spacing = cell_size / sqrtf((float)maxi(1, count));
+	for (int32_t c = 0; c < 8; c++) out->children[c] = node->children[c];
+	return (int32_t)fwrite(points, sizeof(cloud_point_t), count, b->out) == count;
+}
+
+///////////////////////////////////////////
+
+// Writes the node and everything beneath it. Returns a shuffled subsample
+// of the node's points for its parent to build its own LOD from.
+static cloud_point_t *pt_write_node(pt_build_t *b, int32_t node_id, int32_t *out_sample_count, bool *ref_ok) {
+	pt_build_node_t      *node   = &b->nodes[node_id];
+	point_octree_node_t  *out    = &b->out_nodes[node_id];
+	array_t<cloud_point_t> points = {};
+
+	if (node->leaf >= 0) {
+		pt_leaf_t *leaf  = &b->leaves[node->leaf];
+		int64_t    total = (int64_t)leaf->blocks.count * b->block_points + leaf->buffer_count;
+		if (total <= pt_leaf_limit) {
+			points.resize((int32_t)total);
+			for (int32_t i = 0; i < leaf->blocks.count; i++) {
+				platform_file_seek(b->temp, (int64_t)leaf->blocks[i], SEEK_SET);
+				if ((int32_t)fread(&points.data[points.count], sizeof(cloud_point_t), b->block_points, b->temp) != b->block_points)
+					*ref_ok = false;
+				points.count += b->block_points;
+			}
+			points.add_range(leaf->buffer, leaf->buffer_count);
+		} else {
+			// Too dense to keep everything, so this reservoir samples the
+			// leaf a block at a time, and never holds more than the limit.
+			log_diagf("Point cloud leaf has %lld points, keeping %d of them", (long long)total, pt_leaf_limit);
+			points.resize(pt_leaf_limit);
+			cloud_point_t *block = sk_malloc_t(cloud_point_t, b->block_points);
+			uint64_t       state = ((uint64_t)node_id << 32 | b->shuffle_seed) * 0x9E3779B97F4A7C15ULL + 1;
+			int64_t        seen  = 0;
+			for (int32_t i = 0; i <= leaf->blocks.count; i++) {
+				const cloud_point_t *src   = leaf->buffer;
+				int32_t              count = leaf->buffer_count;
+				if (i < leaf->blocks.count) {
+					platform_file_seek(b->temp, (int64_t)leaf->blocks[i], SEEK_SET);
+					if ((int32_t)fread(block, sizeof(cloud_point_t), b->block_points, b->temp) != b->block_points)
+						*ref_ok = false;
+					src   = block;
+					count = b->block_points;
+				}
+				for (int32_t p = 0; p < count; p++, seen++) {
+					if (points.count < pt_leaf_limit) { points.add(src[p]); continue; }
+					state ^= state << 13;
+					state ^= state >> 7;
+					state ^= state << 17;
+					int64_t j = (int64_t)(state % (uint64_t)(seen + 1));
+					if (j < pt_leaf_limit) points[(int32_t)j] = src[p];
+				}
+			}
+			sk_free(block);
+		}
+		leaf->blocks.free();
+
+		pt_shuffle(points.data, points.count, node_id + b->shuffle_seed);
+		out->bounds = pt_points_bounds(points.data, points.count);
+	} else {
+		bool has_bounds = false;
+		for (int32_t c = 0; c < 8; c++) {
+			int32_t child = node->children[c];
+			if (child < 0) continue;
+
+			int32_t        sample_count = 0;
+			cloud_point_t *sample       = pt_write_node(b, child, &sample_count, ref_ok);
+			points.add_range(sample, sample_count);
+			sk_free(sample);
+			bounds_t child_bounds = b->out_nodes[child].bounds;
+			out->bounds = has_bounds ? bounds_grow_to_fit_box(out->bounds, child_bounds) : child_bounds;
+			has_bounds  = true;
+		}
+		pt_shuffle(points.data, points.count, node_id + b->shuffle_seed);
+		if (points.count > pt_leaf_max) points.count = pt_leaf_max;
+	}
+
+	if (!pt_write_points(b, node_id, points.data, points.count))
+		*ref_ok = false;
+
+	// Point clouds are mostly surfaces, so each level up has about a
+	// quarter of the points.
+	*out_sample_count = (points.count + 3) / 4;
+	cloud_point_t *result = sk_malloc_t(cloud_point_t, maxi(1, *out_sample_count));
+	memcpy(result, points.data, sizeof(cloud_point_t) * *out_sample_count);
+	points.free();
+	return result;
+}
+
+///////////////////////////////////////////
+
+bool point_octree_build(const char *ply_filename, const char *out_filename) {
+	ply_stream_t ply = {};
+	if (!ply_stream_open(ply_filename, &ply))
+		return false;
+
+	cloud_point_t *points = sk_malloc_t(cloud_point_t, pt_stream_points);
+	int32_t        count  = 0;
+
+	// Pass 1: find the bounds of the cloud
+	vec3 min = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	vec3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	ply_stream_rewind(&ply);
+	while (ply.remaining > 0) {
+		count = ply_stream_next(&ply, points);
+		for (int32_t i = 0; i < count; i++) {
+			min = vec3_min(min, points[i].pos);
+			max = vec3_max(max, points[i].pos);
+		}
+	}
+
+	// Pass 2: count points into a grid, and use that to figure out where
+	// the octree needs to split. Scans are mostly surfaces, so each level
+	// down splits a node's points about 4 ways.
+	pt_build_t b = {};
+	b.min    = min;
+	b.size   = fmaxf(fmaxf(max.x - min.x, max.y - min.y), fmaxf(max.z - min.z, 0.0001f)) * 1.001f;
+	b.levels = 3;
+	while (b.levels < 8 && ((int64_t)pt_leaf_max << (2 * (b.levels - 1))) < ply.count) b.levels += 1;
+
+	for (int32_t l = 0; l <= b.levels; l++) {
+		int64_t cells = (int64_t)1 << (3 * l);
+		b.counts[l] = sk_malloc_t(uint32_t, cells);
+		memset(b.counts[l], 0, sizeof(uint32_t) * cells);
+	}
+	ply_stream_rewind(&ply);
+	while (ply.remaining > 0) {
+		count = ply_stream_next(&ply, points);
+		for (int32_t i = 0; i < count; i++)
+			b.counts[b.levels][pt_point_cell(&b, points[i].pos)] += 1;
+	}
+	for (int32_t l = b.levels - 1; l >= 0; l--) {
+		int32_t res = 1 << l;
+		for (int32_t z = 0; z < res; z++) {
+		for (int32_t y = 0; y < res; y++) {
+		for (int32_t x = 0; x < res; x++) {
+			uint32_t sum = 0;
+			for (int32_t c = 0; c < 8; c++)
+				sum += b.counts[l+1][pt_cell_index(l+1, x*2 + (c&1), y*2 + ((c>>1)&1), z*2 + ((c>>2)&1))];
+			b.counts[l][pt_cell_index(l, x, y, z)] = sum;
+		} } }
+	}
+
+	b.cell_leaf = sk_malloc_t(int32_t, (size_t)1 << (3 * b.levels));
+	pt_subdivide(&b, 0, 0, 0, 0);
+	for (int32_t l = 0; l <= b.levels; l++) sk_free(b.counts[l]);
+
+	// Pass 3: sort points into their leaves. Leaves buffer points in memory,
+	// and spill them out to a temporary file when the buffer fills up.
+	char temp_filename[1024];
+	snprintf(temp_filename, sizeof(temp_filename), "%s.tmp", out_filename);
+	b.temp         = platform_file_open(temp_filename, "w+b");
+	b.out          = platform_file_open(out_filename,  "wb");
+	b.block_points = (int32_t)(pt_buffer_bytes / sizeof(cloud_point_t) / maxi(1, b.leaves.count));
+	b.block_points = mini(maxi(b.block_points, 256), 16384);
+	b.shuffle_seed = (uint32_t)ply.count;
+	bool ok = b.temp != nullptr && b.out != nullptr;
+
+	cloud_point_t *leaf_buffers = nullptr;
+	int64_t        point_count  = 0;
+	if (ok) {
+		leaf_buffers = sk_malloc_t(cloud_point_t, (size_t)b.block_points * b.leaves.count);
+		for (int32_t i = 0; i < b.leaves.count; i++) b.leaves[i].buffer = &leaf_buffers[(size_t)i * b.block_points];
+
+		ply_stream_rewind(&ply);
+		while (ok && ply.remaining > 0) {
+			count = ply_stream_next(&ply, points);
+			point_count += count;
+			for (int32_t i = 0; i < count; i++) {
+				pt_leaf_t *leaf = &b.leaves[b.cell_leaf[pt_point_cell(&b, points[i].pos)]];
+				leaf->buffer[leaf->buffer_count] = points[i];
+				leaf->buffer_count += 1;
+				if (leaf->buffer_count == b.block_points) {
+					leaf->blocks.add((uint64_t)platform_file_tell(b.temp));
+					ok = (int32_t)fwrite(leaf->buffer, sizeof(cloud_point_t), b.block_points, b.temp) == b.block_points;
+					leaf->buffer_count = 0;
+				}
+			}
+		}
+	}
+	sk_free(b.cell_leaf);
+	sk_free(points);
+
+	// Pass 4: write out the final octree, leaves first, then each parent's
+	// LOD built from their children.
+	if (ok) {
+		point_octree_header_t header = {};
+		memcpy(header.magic, "SKPC", 4);
+		header.version     = POINT_OCTREE_VERSION;
+		header.source_size = ply.file_size;
+		header.source_time = ply.file_time;
+		header.point_count = point_count;
+		header.bounds      = bounds_t{ (min + max) / 2.0f, max - min };
+		header.node_count  = b.nodes.count;
+		header.root        = 0;
+		ok = fwrite(&header, sizeof(header), 1, b.out) == 1;
+
+		b.out_nodes = sk_malloc_zero_t(point_octree_node_t, b.nodes.count);
+		int32_t        sample_count = 0;
+		cloud_point_t *sample       = pt_write_node(&b, 0, &sample_count, &ok);
+		sk_free(sample);
+
+		header.node_offset = (uint64_t)platform_file_tell(b.out);
+		ok = ok && (int32_t)fwrite(b.out_nodes, sizeof(point_octree_node_t), b.nodes.count, b.out) == b.nodes.count;
+		ok = ok && platform_file_seek(b.out, 0, SEEK_SET);
+		ok = ok && fwrite(&header, sizeof(header), 1, b.out) == 1;
+		sk_free(b.out_nodes);
+	}
+
+	for (int32_t i = 0; i < b.leaves.count; i++) b.leaves[i].blocks.free();
+	sk_free(leaf_buffers);
+	b.leaves.free();
+	b.nodes .free();
+	if (b.temp) { fclose(b.temp); remove(temp_filename); }
+	if (b.out ) { fclose(b.out); if (!ok) remove(out_filename); }
+	ply_stream_close(&ply);
+
+	if (!ok) log_errf("Failed to build point cloud cache '%s'", out_filename);
+	return ok;
+}
+
+///////////////////////////////////////////
+// Reading
+///////////////////////////////////////////
+
+bool point_octree_read(FILE *fp, point_octree_header_t *out_header, point_octree_node_t **out_nodes) {
+	*out_nodes = nullptr;
+	if (!platform_file_seek(fp, 0, SEEK_SET) ||
+		fread(out_header, sizeof(point_octree_header_t), 1, fp) != 1 ||
+		memcmp(out_header->magic, "SKPC", 4) != 0 ||
+		out_header->version    != POINT_OCTREE_VERSION ||
+		out_header->node_count <= 0)
+		return false;
+
+	point_octree_node_t *nodes = sk_malloc_t(point_octree_node_t, out_header->node_count);
+	if (!platform_file_seek(fp, (int64_t)out_header->node_offset, SEEK_SET) ||
+		(int32_t)fread(nodes, sizeof(point_octree_node_t), out_header->node_count, fp) != out_header->node_count) {
+		sk_free(nodes);
+		return false;
+	}
+	*out_nodes = nodes;
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool point_octree_read_points(FILE *fp, const point_octree_node_t *node, cloud_point_t *out_points) {
+	return platform_file_seek(fp, (int64_t)node->offset, SEEK_SET)
+		&& (int32_t)fread(out_points, sizeof(cloud_point_t), node->count, fp) == node->count;
+}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../stereokit.h"
+
+#include <stdio.h>
+
+namespace sk {
+
+// Point cloud cache files are an octree of nodes, where each node holds a
+// shuffled subsample of everything beneath it, so any node can be drawn as
+// a stand-in for its children. Leaf nodes hold the original points.
+
+#define POINT_OCTREE_VERSION 2
+
+struct point_octree_header_t {
+	char     magic[4];
+	uint32_t version;
+	uint64_t source_size;
+	uint64_t source_time;
+	int64_t  point_count;
+	bounds_t bounds;
+	int32_t  node_count;
+	int32_t  root;
+	uint64_t node_offset;
+};
+
+struct point_octree_node_t {
+	bounds_t bounds;
+	uint64_t offset;
+	int32_t  count;
+	float    spacing;
+	int32_t  children[8];
+};
+
+bool point_octree_build      (const char *ply_filename, const char *out_filename);
+bool point_octree_read       (FILE *fp, point_octree_header_t *out_header, point_octree_node_t **out_nodes);
+bool point_octree_read_points(FILE *fp, const point_octree_node_t *node, cloud_point_t *out_points);
+
+}
@@ -0,0 +1,177 @@
+#include "skpack.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace sk {
+
+///////////////////////////////////////////
+
+uint64_t skpack_hash_path(const char *path, char *out_normalized) {
+	while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path += 2;
+	while (path[0] == '/' || path[0] == '\\') path += 1;
+
+	uint64_t hash = 14695981039346656037ULL;
+	size_t   i    = 0;
+	for (; path[i] != '\0'; i++) {
+		char c = path[i] == '\\' ? '/' : path[i];
+		if (out_normalized) out_normalized[i] = c;
+		hash = (hash ^ (uint8_t)c) * 1099511628211ULL;
+	}
+	if (out_normalized) out_normalized[i] = '\0';
+	return hash;
+}
+
+///////////////////////////////////////////
+
+#define SKPACK_LZ4_HASH_BITS  16
+#define SKPACK_LZ4_MIN_MATCH  4
+#define SKPACK_LZ4_MAX_OFFSET 65535
+// LZ4 requires the last 5 bytes to be literals, and the last match to start
+// at least 12 bytes from the end.
+#define SKPACK_LZ4_LAST_LITERALS 5
+#define SKPACK_LZ4_MATCH_LIMIT   12
+
+static inline uint32_t skpack_read32(const uint8_t *at) {
+	uint32_t result;
+	memcpy(&result, at, sizeof(result));
+	return result;
+}
+
+static inline uint8_t *skpack_write_len(uint8_t *op, size_t len) {
+	while (len >= 255) { *op++ = 255; len -= 255; }
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+///////////////////////////////////////////
+
+size_t skpack_lz4_bound(size_t src_size) {
+	return src_size + src_size / 255 + 16;
+}
+
+///////////////////////////////////////////
+
+size_t skpack_lz4_compress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity) {
+	uint32_t *table = (uint32_t *)calloc((size_t)1 << SKPACK_LZ4_HASH_BITS, sizeof(uint32_t));
+	if (table == nullptr) return 0;
+
+	const uint8_t *ip          = src;
+	const uint8_t *anchor      = src;
+	const uint8_t *end         = src + src_size;
+	const uint8_t *match_limit = src_size > SKPACK_LZ4_MATCH_LIMIT ? end - SKPACK_LZ4_MATCH_LIMIT    : src;
+	const uint8_t *last_lits   = src_size > SKPACK_LZ4_LAST_LITERALS ? end - SKPACK_LZ4_LAST_LITERALS : src;
+	uint8_t       *op          = dst;
+	uint8_t       *oend        = dst + dst_capacity;
+
+	while (ip < match_limit) {
+		uint32_t       seq  = skpack_read32(ip);
+		uint32_t       hash = (seq * 2654435761u) >> (32 - SKPACK_LZ4_HASH_BITS);
+		const uint8_t *ref  = src + table[hash];
+		table[hash] = (uint32_t)(ip - src);
+		if (ref >= ip || ip - ref > SKPACK_LZ4_MAX_OFFSET || skpack_read32(ref) != seq) {
+			ip++;
+			continue;
+		}
+
+		// Grow the match in both directions
+		while (ip > anchor && ref > src && ip[-1] == ref[-1]) { ip--; ref--; }
+		const uint8_t *match_end = ip  + SKPACK_LZ4_MIN_MATCH;
+		const uint8_t *ref_end   = ref + SKPACK_LZ4_MIN_MATCH;
+		while (match_end < last_lits && *match_end == *ref_end) { match_end++; ref_end++; }
+
+		size_t lit_len   = (size_t)(ip - anchor);
+		size_t match_len = (size_t)(match_end - ip) - SKPACK_LZ4_MIN_MATCH;
+		if ((size_t)(oend - op) < 1 + lit_len + lit_len / 255 + 1 + 2 + match_len / 255 + 1) {
+			free(table);
+			return 0;
+		}
+
+		uint8_t *token = op++;
+		*token = (uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+		if (lit_len >= 15) op = skpack_write_len(op, lit_len - 15);
+		memcpy(op, anchor, lit_len);
+		op += lit_len;
+
+		uint16_t offset = (uint16_t)(ip - ref);
+		*op++ = (uint8_t)(offset & 0xFF);
+		*op++ = (uint8_t)(offset >> 8);
+
+		*token |= (uint8_t)(match_len >= 15 ? 15 : match_len);
+		if (match_len >= 15) op = skpack_write_len(op, match_len - 15);
+
+		ip     = match_end;
+		anchor = ip;
+	}
+	free(table);
+
+	// Everything left over goes out as one final run of literals
+	size_t lit_len = (size_t)(end - anchor);
+	if ((size_t)(oend - op) < 1 + lit_len + lit_len / 255 + 1) return 0;
+	uint8_t *token = op++;
+	*token = (uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+	if (lit_len >= 15) op = skpack_write_len(op, lit_len - 15);
+	memcpy(op, anchor, lit_len);
+	op += lit_len;
+
+	return (size_t)(op - dst);
+}
+
+///////////////////////////////////////////
+
+bool skpack_lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size) {
+	const uint8_t *ip   = src;
+	const uint8_t *iend = src + src_size;
+	uint8_t       *op   = dst;
+	uint8_t       *oend = dst + dst_size;
+
+	while (ip < iend) {
+		uint8_t token   = *ip++;
+		size_t  lit_len = token >> 4;
+		if (lit_len == 15) {
+			uint8_t b;
+			do {
+				if (ip >= iend) return false;
+				b = *ip++;
+				lit_len += b;
+			} while (b == 255);
+		}
+		if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) return false;
+		memcpy(op, ip, lit_len);
+		ip += lit_len;
+		op += lit_len;
+
+		// The last sequence is only literals
+		if (ip >= iend) break;
+
+		if (iend - ip < 2) return false;
+		size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst)) return false;
+
+		size_t match_len = token & 15;
+		if (match_len == 15) {
+			uint8_t b;
+			do {
+				if (ip >= iend) return false;
+				b = *ip++;
+				match_len += b;
+			} while (b == 255);
+		}
+		match_len += SKPACK_LZ4_MIN_MATCH;
+		if (match_len > (size_t)(oend - op)) return false;
+
+		// Matches may overlap the bytes they're producing, which is how
+		// LZ4 encodes runs.
+		const uint8_t *ref = op - offset;
+		if (offset >= match_len) {
+			memcpy(op, ref, match_len);
+			op += match_len;
+		} else {
+			for (size_t i = 0; i < match_len; i++) *op++ = *ref++;
+		}
+	}
+	return op == oend;
+}
+
+} // namespace sk
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sk {
+
+// StereoKit asset packs are a single file with a header, entry data, a table
+// of contents sorted by path hash, and a block of entry names:
+//
+//   skpack_header_t | entry data... | skpack_entry_t[entry_count] | names
+//
+// Each entry's data starts on a multiple of the pack's alignment, and
+// uncompressed entries are always followed by at least one 0 byte so they
+// can be handed out in place, just like a file from platform_read_file.
+// Paths are relative to the assets folder, and always use '/'.
+//
+// This file has no dependencies on the rest of StereoKit, so the skpack
+// tool can build it on its own.
+
+#define SKPACK_VERSION 1
+
+typedef enum skpack_compression_ {
+	skpack_compression_none = 0,
+	skpack_compression_lz4  = 1,
+} skpack_compression_;
+
+struct skpack_header_t {
+	char     magic[4];
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t alignment;
+	uint64_t toc_offset;
+	uint64_t names_offset;
+	uint64_t names_size;
+};
+
+struct skpack_entry_t {
+	uint64_t path_hash;
+	uint64_t offset;
+	uint64_t stored_size;
+	uint64_t size;
+	uint32_t name_offset;
+	uint32_t compression;
+};
+
+// Normalizes slashes and leading "./" or "/" from a path, and hashes what's
+// left. out_normalized is optional, and must hold strlen(path)+1 chars.
+uint64_t skpack_hash_path(const char *path, char *out_normalized);
+
+// LZ4 block format, without the frame. Compress returns 0 if the result
+// wouldn't fit in dst_capacity, and decompress only succeeds if it fills
+// exactly dst_size bytes.
+size_t   skpack_lz4_bound     (size_t src_size);
+size_t   skpack_lz4_compress  (const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity);
+bool     skpack_lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+} // namespace sk
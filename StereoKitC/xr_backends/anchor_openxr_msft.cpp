@@ -175,7 +175,7 @@ void anchor_oxr_msft_destroy(anchor_t anchor) {
 	oxr_msft_world_anchor_t* data = (oxr_msft_world_anchor_t*)anchor->data;
 	xrDestroySpace(data->space);
 	xr_extensions.xrDestroySpatialAnchorMSFT(data->anchor);
-	free(data);
+	sk_free(data);
 }
 
 ///////////////////////////////////////////
@@ -0,0 +1,194 @@
+// skpack - bundles a folder of assets into a single StereoKit asset pack.
+//
+//   skpack -o <out.skpack> [-a <alignment>] [-c] <asset folder>
+//
+// -a  Alignment of each entry's data in bytes, a power of two. Defaults to
+//     16, larger values like 4096 line entries up with pages.
+// -c  LZ4 compress entries when it saves at least 1/8th of their size.
+//     Formats that are already compressed are always stored as-is.
+//
+// Paths inside the pack are relative to the asset folder, so mount the pack
+// in place of that folder's contents.
+
+#include "../../StereoKitC/utils/skpack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+using namespace sk;
+namespace fs = std::filesystem;
+
+///////////////////////////////////////////
+
+struct pack_file_t {
+	std::string          name;
+	std::vector<uint8_t> data;
+	skpack_entry_t       entry;
+};
+
+///////////////////////////////////////////
+
+static bool read_file(const fs::path &path, std::vector<uint8_t> *out_data) {
+	FILE *fp = fopen(path.string().c_str(), "rb");
+	if (fp == nullptr) return false;
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	out_data->resize((size_t)size);
+	size_t read = size > 0 ? fread(out_data->data(), 1, (size_t)size, fp) : 0;
+	fclose(fp);
+	return read == (size_t)size;
+}
+
+///////////////////////////////////////////
+
+static bool already_compressed(const std::string &name) {
+	const char *types[] = { ".png", ".jpg", ".jpeg", ".ktx2", ".basis", ".ogg", ".mp3", ".zip", ".skpack" };
+	std::string ext     = fs::path(name).extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)tolower(c); });
+	for (size_t i = 0; i < sizeof(types)/sizeof(types[0]); i++) {
+		if (ext == types[i]) return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////
+
+static void write_padding(FILE *fp, uint64_t *at, uint64_t alignment) {
+	uint64_t target = ((*at + alignment - 1) / alignment) * alignment;
+	for (; *at < target; *at += 1) fputc(0, fp);
+}
+
+///////////////////////////////////////////
+
+static int usage() {
+	printf("skpack -o <out.skpack> [-a <alignment>] [-c] <asset folder>\n");
+	return 1;
+}
+
+///////////////////////////////////////////
+
+int main(int argc, char **argv) {
+	const char *out_filename = nullptr;
+	const char *folder       = nullptr;
+	uint32_t    alignment    = 16;
+	bool        compress     = false;
+	for (int i = 1; i < argc; i++) {
+		if      (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_filename = argv[++i];
+		else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) alignment    = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-c") == 0)                 compress     = true;
+		else if (argv[i][0] != '-' && folder == nullptr)     folder       = argv[i];
+		else return usage();
+	}
+	if (out_filename == nullptr || folder == nullptr) return usage();
+	if (alignment < 8 || (alignment & (alignment - 1)) != 0) {
+		printf("Alignment must be a power of two, and at least 8\n");
+		return 1;
+	}
+
+	// Gather everything in the folder, skipping the output in case it lands
+	// inside the folder itself.
+	std::vector<pack_file_t> files;
+	std::error_code          err;
+	fs::path                 out_path = fs::absolute(out_filename, err);
+	for (const fs::directory_entry &item : fs::recursive_directory_iterator(folder, err)) {
+		if (!item.is_regular_file()) continue;
+		std::error_code same_err;
+		if (fs::equivalent(item.path(), out_path, same_err)) continue;
+
+		pack_file_t file = {};
+		std::string rel  = fs::relative(item.path(), folder).generic_string();
+		file.name.resize(rel.size());
+		file.entry.path_hash = skpack_hash_path(rel.c_str(), &file.name[0]);
+		file.name.resize(strlen(file.name.c_str()));
+		if (!read_file(item.path(), &file.data)) {
+			printf("Couldn't read %s\n", item.path().string().c_str());
+			return 1;
+		}
+		file.entry.size        = file.data.size();
+		file.entry.stored_size = file.data.size();
+		file.entry.compression = skpack_compression_none;
+
+		if (compress && file.data.size() > 0 && !already_compressed(file.name)) {
+			std::vector<uint8_t> packed(skpack_lz4_bound(file.data.size()));
+			size_t               packed_size = skpack_lz4_compress(file.data.data(), file.data.size(), packed.data(), packed.size());
+			if (packed_size > 0 && packed_size <= file.data.size() - file.data.size() / 8) {
+				packed.resize(packed_size);
+				file.data              = std::move(packed);
+				file.entry.stored_size = packed_size;
+				file.entry.compression = skpack_compression_lz4;
+			}
+		}
+		files.push_back(std::move(file));
+	}
+	if (err) {
+		printf("Couldn't read folder %s: %s\n", folder, err.message().c_str());
+		return 1;
+	}
+
+	// The table of contents is binary searched by hash at runtime
+	std::sort(files.begin(), files.end(), [](const pack_file_t &a, const pack_file_t &b) {
+		return a.entry.path_hash != b.entry.path_hash
+			? a.entry.path_hash < b.entry.path_hash
+			: a.name < b.name; });
+
+	FILE *fp = fopen(out_filename, "wb");
+	if (fp == nullptr) {
+		printf("Couldn't write %s\n", out_filename);
+		return 1;
+	}
+
+	skpack_header_t header = {};
+	memcpy(header.magic, "SKPK", 4);
+	header.version     = SKPACK_VERSION;
+	header.entry_count = (uint32_t)files.size();
+	header.alignment   = alignment;
+	fwrite(&header, sizeof(header), 1, fp);
+	uint64_t at = sizeof(header);
+
+	// Entry data, uncompressed entries always get a 0 byte after them so
+	// they can be used in place.
+	std::string names;
+	for (size_t i = 0; i < files.size(); i++) {
+		write_padding(fp, &at, alignment);
+		files[i].entry.offset      = at;
+		files[i].entry.name_offset = (uint32_t)names.size();
+		names.append(files[i].name);
+		names.push_back('\0');
+
+		fwrite(files[i].data.data(), 1, files[i].data.size(), fp);
+		at += files[i].data.size();
+		if (files[i].entry.compression == skpack_compression_none) {
+			fputc(0, fp);
+			at += 1;
+		}
+	}
+
+	write_padding(fp, &at, 8);
+	header.toc_offset = at;
+	for (size_t i = 0; i < files.size(); i++)
+		fwrite(&files[i].entry, sizeof(skpack_entry_t), 1, fp);
+	at += files.size() * sizeof(skpack_entry_t);
+
+	if (names.empty()) names.push_back('\0');
+	header.names_offset = at;
+	header.names_size   = names.size();
+	fwrite(names.data(), 1, names.size(), fp);
+
+	fseek(fp, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, fp);
+	bool success = ferror(fp) == 0;
+	fclose(fp);
+	if (!success) {
+		printf("Couldn't write %s\n", out_filename);
+		return 1;
+	}
+
+	printf("Packed %d files into %s\n", (int)files.size(), out_filename);
+	return 0;
+}